@@ -0,0 +1,123 @@
+#include <cstdlib>
+#include <new>
+#include "AllocationCounter.h"
+
+/*
+Replacements of the global allocation functions that count each allocation in a per-thread counter, so that the
+count doesn't depend on, or contend with, other threads. Memory comes from malloc and is returned to free, as with
+the default functions.
+
+They're compiled only into a benchmark build, with GLR_COUNT_ALLOCATIONS defined, so that the shipping program
+keeps the runtime's allocator and its debugging aids, and so that sanitizers and leak checkers can replace them.
+*/
+
+#ifdef GLR_COUNT_ALLOCATIONS
+
+static thread_local uint64_t t_nAllocations = 0;
+
+bool AllocationCountingEnabled()
+{
+    return true;
+}
+
+uint64_t ThreadAllocationCount()
+{
+    return t_nAllocations;
+}
+
+/// <summary>
+/// Allocates as the default operator new does: retries through the new-handler, and throws std::bad_alloc if
+/// there isn't one.
+/// </summary>
+static void* CountedAllocate(size_t cb)
+{
+    ++t_nAllocations;
+    if (0 == cb)
+        cb = 1;
+    for (;;)
+    {
+        void* p = malloc(cb);
+        if (nullptr != p)
+            return p;
+        const std::new_handler handler = std::get_new_handler();
+        if (nullptr == handler)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+
+static void* CountedAllocateNoThrow(size_t cb) noexcept
+{
+    try
+    {
+        return CountedAllocate(cb);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return nullptr;
+    }
+}
+
+void* operator new(size_t cb)
+{
+    return CountedAllocate(cb);
+}
+
+void* operator new[](size_t cb)
+{
+    return CountedAllocate(cb);
+}
+
+void* operator new(size_t cb, const std::nothrow_t&) noexcept
+{
+    return CountedAllocateNoThrow(cb);
+}
+
+void* operator new[](size_t cb, const std::nothrow_t&) noexcept
+{
+    return CountedAllocateNoThrow(cb);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    free(p);
+}
+
+#else
+
+bool AllocationCountingEnabled()
+{
+    return false;
+}
+
+uint64_t ThreadAllocationCount()
+{
+    return 0;
+}
+
+#endif
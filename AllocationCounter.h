@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+
+/// <summary>
+/// Indicates whether allocations are counted: only in a benchmark build, with GLR_COUNT_ALLOCATIONS defined, does this
+/// program replace the global operator new with a counting version (see AllocationCounter.cpp).
+/// </summary>
+bool AllocationCountingEnabled();
+
+/// <summary>
+/// Number of heap allocations the calling thread has made: calls to the global operator new, in a build that counts
+/// them (see AllocationCountingEnabled); otherwise 0. Allocations made directly with malloc, and by the operating
+/// system, aren't counted.
+/// The benchmarks report the difference across an extraction as allocations per item of text.
+/// </summary>
+uint64_t ThreadAllocationCount();
@@ -0,0 +1,737 @@
+#include "PlatformDefs.h"
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include "ArrowExport.h"
+#include "LanguageNames.h"
+#include "ResourceExtraction.h"
+#include "StringUtils.h"
+#include "UtilityFunctions.h"
+
+// --------------------------------------------------------------------------------------------------------------
+// Minimal FlatBuffers serialization, enough for Arrow's IPC metadata: tables with scalar and offset fields,
+// strings, vectors of structs, and vectors of tables. Objects are built as a tree and then serialized front to
+// back: each object is written before the objects it refers to, since FlatBuffers offsets point forward.
+// Scalars are written in the machine's byte order, which must be little-endian, as FlatBuffers and Arrow's
+// "Little" endianness require.
+
+/// <summary>
+/// A FlatBuffers object to serialize.
+/// </summary>
+struct fbobject_t
+{
+    enum class kind_t { eTable, eString, eStructVector, eTableVector };
+
+    /// <summary>
+    /// A table field: either scalar bytes or a child object.
+    /// </summary>
+    struct field_t
+    {
+        uint16_t ixField;
+        std::vector<uint8_t> vScalar;
+        std::shared_ptr<fbobject_t> pChild;
+    };
+
+    explicit fbobject_t(kind_t k) : kind(k) {}
+
+    kind_t kind;
+    // eTable
+    std::vector<field_t> vFields;
+    // eString and eStructVector: contents; eStructVector: element count and alignment
+    std::vector<uint8_t> vBytes;
+    uint32_t nElements = 0;
+    size_t alignment = 1;
+    // eTableVector
+    std::vector<std::shared_ptr<fbobject_t>> vElements;
+};
+
+typedef std::shared_ptr<fbobject_t> fbptr_t;
+
+static fbptr_t FbTable()
+{
+    return std::make_shared<fbobject_t>(fbobject_t::kind_t::eTable);
+}
+
+template <typename T>
+static void FbScalar(const fbptr_t& pTable, uint16_t ixField, T value)
+{
+    fbobject_t::field_t field;
+    field.ixField = ixField;
+    field.vScalar.resize(sizeof(T));
+    memcpy(&field.vScalar[0], &value, sizeof(T));
+    pTable->vFields.push_back(std::move(field));
+}
+
+static void FbChild(const fbptr_t& pTable, uint16_t ixField, const fbptr_t& pChild)
+{
+    fbobject_t::field_t field;
+    field.ixField = ixField;
+    field.pChild = pChild;
+    pTable->vFields.push_back(std::move(field));
+}
+
+static fbptr_t FbString(const std::string& s)
+{
+    fbptr_t pString = std::make_shared<fbobject_t>(fbobject_t::kind_t::eString);
+    pString->vBytes.assign(s.begin(), s.end());
+    return pString;
+}
+
+static fbptr_t FbStructVector(const void* pElements, size_t cbElement, size_t nElements, size_t alignment)
+{
+    fbptr_t pVector = std::make_shared<fbobject_t>(fbobject_t::kind_t::eStructVector);
+    const uint8_t* pBytes = (const uint8_t*)pElements;
+    pVector->vBytes.assign(pBytes, pBytes + cbElement * nElements);
+    pVector->nElements = (uint32_t)nElements;
+    pVector->alignment = alignment;
+    return pVector;
+}
+
+static fbptr_t FbTableVector(const std::vector<fbptr_t>& vElements)
+{
+    fbptr_t pVector = std::make_shared<fbobject_t>(fbobject_t::kind_t::eTableVector);
+    pVector->vElements = vElements;
+    return pVector;
+}
+
+static void PadTo(std::vector<uint8_t>& vBuf, size_t alignment)
+{
+    while (0 != vBuf.size() % alignment)
+        vBuf.push_back(0);
+}
+
+template <typename T>
+static void Append(std::vector<uint8_t>& vBuf, T value)
+{
+    const size_t ix = vBuf.size();
+    vBuf.resize(ix + sizeof(T));
+    memcpy(&vBuf[ix], &value, sizeof(T));
+}
+
+template <typename T>
+static void Patch(std::vector<uint8_t>& vBuf, size_t ix, T value)
+{
+    memcpy(&vBuf[ix], &value, sizeof(T));
+}
+
+/// <summary>
+/// Writes the object and the objects it refers to; returns the object's position in the buffer.
+/// </summary>
+static size_t FbWrite(std::vector<uint8_t>& vBuf, const fbobject_t& obj)
+{
+    switch (obj.kind)
+    {
+    case fbobject_t::kind_t::eString:
+    {
+        PadTo(vBuf, 4);
+        const size_t ixString = vBuf.size();
+        Append(vBuf, (uint32_t)obj.vBytes.size());
+        vBuf.insert(vBuf.end(), obj.vBytes.begin(), obj.vBytes.end());
+        vBuf.push_back(0);
+        return ixString;
+    }
+
+    case fbobject_t::kind_t::eStructVector:
+    {
+        // The length precedes the elements, which must be aligned.
+        PadTo(vBuf, 4);
+        while (0 != (vBuf.size() + 4) % obj.alignment)
+            Append(vBuf, (uint32_t)0);
+        const size_t ixVector = vBuf.size();
+        Append(vBuf, obj.nElements);
+        vBuf.insert(vBuf.end(), obj.vBytes.begin(), obj.vBytes.end());
+        return ixVector;
+    }
+
+    case fbobject_t::kind_t::eTableVector:
+    {
+        PadTo(vBuf, 4);
+        const size_t ixVector = vBuf.size();
+        Append(vBuf, (uint32_t)obj.vElements.size());
+        for (size_t ixElement = 0; ixElement < obj.vElements.size(); ++ixElement)
+            Append(vBuf, (uint32_t)0);
+        for (size_t ixElement = 0; ixElement < obj.vElements.size(); ++ixElement)
+        {
+            const size_t ixOffset = ixVector + 4 + 4 * ixElement;
+            const size_t ixElementPos = FbWrite(vBuf, *obj.vElements[ixElement]);
+            Patch(vBuf, ixOffset, (uint32_t)(ixElementPos - ixOffset));
+        }
+        return ixVector;
+    }
+
+    case fbobject_t::kind_t::eTable:
+    default:
+    {
+        // Lay out the fields after the vtable offset, largest first so that each is aligned to its size.
+        std::vector<const fbobject_t::field_t*> vByLayout;
+        uint16_t nSlots = 0;
+        for (const fbobject_t::field_t& field : obj.vFields)
+        {
+            vByLayout.push_back(&field);
+            if (field.ixField + 1 > nSlots)
+                nSlots = (uint16_t)(field.ixField + 1);
+        }
+        auto fieldSize = [](const fbobject_t::field_t* pField) { return pField->pChild ? (size_t)4 : pField->vScalar.size(); };
+        std::stable_sort(vByLayout.begin(), vByLayout.end(), [&](const fbobject_t::field_t* p1, const fbobject_t::field_t* p2) { return fieldSize(p1) > fieldSize(p2); });
+        std::vector<uint16_t> vSlots(nSlots, 0);
+        std::vector<size_t> vFieldOffsets;
+        size_t cbTable = 4;
+        size_t tableAlignment = 4;
+        for (const fbobject_t::field_t* pField : vByLayout)
+        {
+            const size_t cbField = fieldSize(pField);
+            while (0 != cbTable % cbField)
+                ++cbTable;
+            vSlots[pField->ixField] = (uint16_t)cbTable;
+            vFieldOffsets.push_back(cbTable);
+            cbTable += cbField;
+            if (cbField > tableAlignment)
+                tableAlignment = cbField;
+        }
+
+        // The vtable goes just before the table; the table's first field is the signed distance back to it.
+        PadTo(vBuf, 2);
+        const size_t ixVtable = vBuf.size();
+        Append(vBuf, (uint16_t)(4 + 2 * nSlots));
+        Append(vBuf, (uint16_t)cbTable);
+        for (uint16_t slot : vSlots)
+            Append(vBuf, slot);
+        PadTo(vBuf, tableAlignment);
+        const size_t ixTable = vBuf.size();
+        vBuf.resize(ixTable + cbTable, 0);
+        Patch(vBuf, ixTable, (int32_t)(ixTable - ixVtable));
+        for (size_t ixField = 0; ixField < vByLayout.size(); ++ixField)
+        {
+            if (!vByLayout[ixField]->pChild)
+                memcpy(&vBuf[ixTable + vFieldOffsets[ixField]], &vByLayout[ixField]->vScalar[0], vByLayout[ixField]->vScalar.size());
+        }
+        for (size_t ixField = 0; ixField < vByLayout.size(); ++ixField)
+        {
+            if (vByLayout[ixField]->pChild)
+            {
+                const size_t ixOffset = ixTable + vFieldOffsets[ixField];
+                const size_t ixChild = FbWrite(vBuf, *vByLayout[ixField]->pChild);
+                Patch(vBuf, ixOffset, (uint32_t)(ixChild - ixOffset));
+            }
+        }
+        return ixTable;
+    }
+    }
+}
+
+/// <summary>
+/// Serializes a FlatBuffers buffer with the table as its root, padded to a multiple of 8 bytes.
+/// </summary>
+static std::vector<uint8_t> FbFinish(const fbptr_t& pRoot)
+{
+    std::vector<uint8_t> vBuf;
+    Append(vBuf, (uint32_t)0);
+    const size_t ixRoot = FbWrite(vBuf, *pRoot);
+    Patch(vBuf, 0, (uint32_t)ixRoot);
+    PadTo(vBuf, 8);
+    return vBuf;
+}
+
+// --------------------------------------------------------------------------------------------------------------
+// Arrow metadata (Schema.fbs, Message.fbs, File.fbs). Field indices are the vtable slots: a union field takes two
+// slots, its type and its value.
+
+static const int16_t MetadataVersion_V5 = 4;
+static const uint8_t Type_Int = 2;
+static const uint8_t Type_Utf8 = 5;
+static const uint8_t MessageHeader_Schema = 1;
+static const uint8_t MessageHeader_DictionaryBatch = 2;
+static const uint8_t MessageHeader_RecordBatch = 3;
+
+/// <summary>
+/// Arrow FieldNode and Buffer structs, each two int64 values.
+/// </summary>
+struct arrowpair_t
+{
+    int64_t first;
+    int64_t second;
+};
+
+/// <summary>
+/// Arrow Block struct, as laid out in the footer.
+/// </summary>
+struct arrowblock_t
+{
+    int64_t offset;
+    int32_t metaDataLength;
+    int32_t padding;
+    int64_t bodyLength;
+};
+
+static fbptr_t ArrowIntType(int32_t bitWidth, bool bSigned)
+{
+    fbptr_t pInt = FbTable();
+    FbScalar(pInt, 0, bitWidth);
+    FbScalar(pInt, 1, (uint8_t)(bSigned ? 1 : 0));
+    return pInt;
+}
+
+/// <summary>
+/// Kinds of columns in the output.
+/// </summary>
+enum class columnkind_t { eDictionary, eUtf8, eUInt16, eInt64 };
+
+/// <summary>
+/// Name, kind, and nullability of each column, in order.
+/// </summary>
+static const struct
+{
+    const char* szName;
+    columnkind_t kind;
+    bool bNullable;
+} columnDefs[] =
+{
+    { "module", columnkind_t::eDictionary, false },
+    { "type", columnkind_t::eDictionary, false },
+    { "language", columnkind_t::eDictionary, false },
+    { "resource_id", columnkind_t::eUInt16, true },
+    { "resource_name", columnkind_t::eUtf8, true },
+    { "item_id", columnkind_t::eInt64, true },
+    { "text", columnkind_t::eUtf8, false },
+    { "text_no_accels", columnkind_t::eUtf8, true },
+    { "control_type", columnkind_t::eDictionary, true },
+};
+
+static fbptr_t ArrowSchema()
+{
+    std::vector<fbptr_t> vFields;
+    int64_t dictionaryId = 0;
+    for (const auto& columnDef : columnDefs)
+    {
+        fbptr_t pField = FbTable();
+        FbChild(pField, 0, FbString(columnDef.szName));
+        FbScalar(pField, 1, (uint8_t)(columnDef.bNullable ? 1 : 0));
+        switch (columnDef.kind)
+        {
+        case columnkind_t::eDictionary:
+        {
+            // The field's type is the dictionary's value type; the column holds indices into the dictionary.
+            FbScalar(pField, 2, Type_Utf8);
+            FbChild(pField, 3, FbTable());
+            fbptr_t pEncoding = FbTable();
+            FbScalar(pEncoding, 0, dictionaryId++);
+            FbChild(pEncoding, 1, ArrowIntType(32, true));
+            FbScalar(pEncoding, 2, (uint8_t)0);
+            FbChild(pField, 4, pEncoding);
+            break;
+        }
+        case columnkind_t::eUtf8:
+            FbScalar(pField, 2, Type_Utf8);
+            FbChild(pField, 3, FbTable());
+            break;
+        case columnkind_t::eUInt16:
+            FbScalar(pField, 2, Type_Int);
+            FbChild(pField, 3, ArrowIntType(16, false));
+            break;
+        case columnkind_t::eInt64:
+            FbScalar(pField, 2, Type_Int);
+            FbChild(pField, 3, ArrowIntType(64, true));
+            break;
+        }
+        FbChild(pField, 5, FbTableVector(std::vector<fbptr_t>()));
+        vFields.push_back(pField);
+    }
+
+    fbptr_t pSchema = FbTable();
+    // Little-endian
+    FbScalar(pSchema, 0, (int16_t)0);
+    FbChild(pSchema, 1, FbTableVector(vFields));
+    return pSchema;
+}
+
+static fbptr_t ArrowMessage(uint8_t headerType, const fbptr_t& pHeader, int64_t bodyLength)
+{
+    fbptr_t pMessage = FbTable();
+    FbScalar(pMessage, 0, MetadataVersion_V5);
+    FbScalar(pMessage, 1, headerType);
+    FbChild(pMessage, 2, pHeader);
+    FbScalar(pMessage, 3, bodyLength);
+    return pMessage;
+}
+
+// --------------------------------------------------------------------------------------------------------------
+// Column builders for one record batch.
+
+/// <summary>
+/// Message body under construction: the buffers of each column, each padded to 8 bytes, and the
+/// FieldNode and Buffer entries that describe them.
+/// </summary>
+struct arrowbody_t
+{
+    std::vector<uint8_t> vBytes;
+    std::vector<arrowpair_t> vNodes;
+    std::vector<arrowpair_t> vBuffers;
+
+    void AddNode(int64_t length, int64_t nullCount)
+    {
+        vNodes.push_back({ length, nullCount });
+    }
+
+    void AddBuffer(const void* pData, size_t cbData)
+    {
+        vBuffers.push_back({ (int64_t)vBytes.size(), (int64_t)cbData });
+        const uint8_t* pBytes = (const uint8_t*)pData;
+        vBytes.insert(vBytes.end(), pBytes, pBytes + cbData);
+        PadTo(vBytes, 8);
+    }
+
+    fbptr_t RecordBatch(int64_t length) const
+    {
+        fbptr_t pBatch = FbTable();
+        FbScalar(pBatch, 0, length);
+        FbChild(pBatch, 1, FbStructVector(vNodes.data(), sizeof(arrowpair_t), vNodes.size(), 8));
+        FbChild(pBatch, 2, FbStructVector(vBuffers.data(), sizeof(arrowpair_t), vBuffers.size(), 8));
+        return pBatch;
+    }
+};
+
+/// <summary>
+/// Validity bitmap of a column, one bit per row, set for non-null values.
+/// </summary>
+struct validity_t
+{
+    std::vector<uint8_t> vBits;
+    size_t nRows = 0;
+    int64_t nNulls = 0;
+
+    void Append(bool bValid)
+    {
+        if (0 == (nRows & 7))
+            vBits.push_back(0);
+        if (bValid)
+            vBits.back() |= (uint8_t)(1 << (nRows & 7));
+        else
+            ++nNulls;
+        ++nRows;
+    }
+
+    void Clear()
+    {
+        vBits.clear();
+        nRows = 0;
+        nNulls = 0;
+    }
+
+    /// <summary>
+    /// Adds the column's node and its validity buffer, which is empty if there are no nulls.
+    /// </summary>
+    void AddTo(arrowbody_t& body) const
+    {
+        body.AddNode((int64_t)nRows, nNulls);
+        body.AddBuffer(vBits.data(), (0 == nNulls) ? 0 : vBits.size());
+    }
+};
+
+template <typename T>
+struct fixedcolumn_t
+{
+    validity_t validity;
+    std::vector<T> vValues;
+
+    void Append(bool bValid, T value)
+    {
+        validity.Append(bValid);
+        vValues.push_back(bValid ? value : T());
+    }
+
+    void Clear()
+    {
+        validity.Clear();
+        vValues.clear();
+    }
+
+    void AddTo(arrowbody_t& body) const
+    {
+        validity.AddTo(body);
+        body.AddBuffer(vValues.data(), vValues.size() * sizeof(T));
+    }
+};
+
+struct utf8column_t
+{
+    validity_t validity;
+    std::vector<int32_t> vOffsets = std::vector<int32_t>(1, 0);
+    std::vector<char> vData;
+
+    /// <summary>
+    /// Appends the text as UTF-8, or a null value if pText is nullptr.
+    /// </summary>
+    void Append(const std::wstring* pText)
+    {
+        validity.Append(nullptr != pText);
+        if (nullptr != pText)
+        {
+            const size_t cbData = vData.size();
+            vData.resize(cbData + pText->length() * nMaxUtf8BytesPerWchar);
+            vData.resize(cbData + WideToUtf8(pText->c_str(), pText->length(), vData.data() + cbData));
+        }
+        vOffsets.push_back((int32_t)vData.size());
+    }
+
+    void Clear()
+    {
+        validity.Clear();
+        vOffsets.resize(1);
+        vData.clear();
+    }
+
+    void AddTo(arrowbody_t& body) const
+    {
+        validity.AddTo(body);
+        body.AddBuffer(vOffsets.data(), vOffsets.size() * sizeof(int32_t));
+        body.AddBuffer(vData.data(), vData.size());
+    }
+};
+
+/// <summary>
+/// Dictionary-encoded text column: the indices are per record batch; the dictionary accumulates over the whole file.
+/// </summary>
+struct dictionarycolumn_t
+{
+    fixedcolumn_t<int32_t> indices;
+    utf8column_t values;
+    std::unordered_map<std::wstring, int32_t> valueIndices;
+    // Consecutive rows usually have the same value (e.g., the module), which needn't be looked up again.
+    std::wstring sLastValue;
+    int32_t ixLastValue = -1;
+
+    void Append(const std::wstring* pValue)
+    {
+        if (nullptr == pValue)
+        {
+            indices.Append(false, 0);
+            return;
+        }
+        if (ixLastValue < 0 || *pValue != sLastValue)
+        {
+            auto result = valueIndices.insert(std::make_pair(*pValue, (int32_t)valueIndices.size()));
+            if (result.second)
+                values.Append(pValue);
+            sLastValue = *pValue;
+            ixLastValue = result.first->second;
+        }
+        indices.Append(true, ixLastValue);
+    }
+};
+
+/// <summary>
+/// Builders for each column of the current record batch.
+/// </summary>
+struct ArrowFileWriter::columns_t
+{
+    dictionarycolumn_t module;
+    dictionarycolumn_t type;
+    dictionarycolumn_t language;
+    fixedcolumn_t<uint16_t> resourceId;
+    utf8column_t resourceName;
+    fixedcolumn_t<int64_t> itemId;
+    utf8column_t text;
+    utf8column_t textNoAccels;
+    dictionarycolumn_t controlType;
+    size_t nRows = 0;
+    // Reused for the type and language of each row
+    std::wstring sType;
+    std::wstring sLanguage;
+    int32_t lastLangId = -1;
+    std::wstring sNoAccels;
+
+    std::vector<dictionarycolumn_t*> Dictionaries()
+    {
+        return { &module, &type, &language, &controlType };
+    }
+};
+
+/// <summary>
+/// Maximum rows in a record batch.
+/// </summary>
+static const size_t nRecordBatchRows = 65536;
+
+/// <summary>
+/// Maximum UTF-8 bytes of text in a record batch, well below the 2 GB that int32 offsets can address.
+/// </summary>
+static const size_t cbRecordBatchText = 256 * 1024 * 1024;
+
+// --------------------------------------------------------------------------------------------------------------
+
+static const char szArrowMagic[] = "ARROW1";
+
+ArrowFileWriter::ArrowFileWriter() :
+    m_cbWritten(0)
+{
+}
+
+ArrowFileWriter::~ArrowFileWriter()
+{
+    if (m_file.is_open())
+    {
+        std::wstring sErrorInfo;
+        Close(sErrorInfo);
+    }
+}
+
+bool ArrowFileWriter::Open(const std::wstring& sFilePath, std::wstring& sErrorInfo)
+{
+#ifdef _WIN32
+    m_file.open(sFilePath.c_str(), std::ios::binary | std::ios::trunc);
+#else
+    m_file.open(WStringToUtf8(sFilePath).c_str(), std::ios::binary | std::ios::trunc);
+#endif
+    if (!m_file.is_open())
+    {
+        sErrorInfo = L"Cannot create file " + sFilePath;
+        return false;
+    }
+    m_cbWritten = 0;
+    m_pColumns.reset(new columns_t());
+    m_vDictionaryBlocks.clear();
+    m_vRecordBatchBlocks.clear();
+
+    // Magic number padded to 8 bytes, then the schema message.
+    WriteBytes(szArrowMagic, 6);
+    WriteBytes("\0\0", 2);
+    WriteMessage(FbFinish(ArrowMessage(MessageHeader_Schema, ArrowSchema(), 0)), std::vector<uint8_t>(), nullptr);
+    return true;
+}
+
+void ArrowFileWriter::Add(const std::wstring& sModule, const resourcerecord_t& record)
+{
+    columns_t& columns = *m_pColumns;
+    const textrecord_t& text = record.text;
+    const bool bMessage = (rsrctype_t::eMessageTable == record.type);
+    const bool bDialog = (rsrctype_t::eDialog == record.type);
+    const wchar_t* szType = ResourceExtractor(record.type).szName;
+    if (columns.sType != szType)
+        columns.sType = szType;
+    if (record.langId != columns.lastLangId)
+    {
+        columns.sLanguage = LangIdToName(record.langId);
+        columns.lastLangId = record.langId;
+    }
+
+    columns.module.Append(&sModule);
+    columns.type.Append(&columns.sType);
+    columns.language.Append(&columns.sLanguage);
+    columns.resourceId.Append(record.sResourceName.empty(), record.resourceId);
+    columns.resourceName.Append(record.sResourceName.empty() ? nullptr : &record.sResourceName);
+    columns.itemId.Append(textrecord_t::item_t::eId == text.item, text.id);
+    columns.text.Append(&text.sText);
+    if (!bMessage)
+        columns.sNoAccels = RemoveAccelsFromText(text.sText);
+    columns.textNoAccels.Append(bMessage ? nullptr : &columns.sNoAccels);
+    columns.controlType.Append((bDialog && textrecord_t::item_t::eId == text.item) ? &text.sControlType : nullptr);
+
+    if (++columns.nRows >= nRecordBatchRows || columns.text.vData.size() + columns.textNoAccels.vData.size() >= cbRecordBatchText)
+        WriteRecordBatch();
+}
+
+bool ArrowFileWriter::Close(std::wstring& sErrorInfo)
+{
+    if (!m_file.is_open())
+    {
+        sErrorInfo = L"File not open";
+        return false;
+    }
+    if (m_pColumns->nRows > 0)
+        WriteRecordBatch();
+    WriteDictionaries();
+
+    // End-of-stream marker, then the footer: version, schema, and the locations of the dictionaries and record batches.
+    const uint32_t eos[2] = { 0xFFFFFFFF, 0 };
+    WriteBytes(eos, sizeof(eos));
+    std::vector<arrowblock_t> vDictionaries, vRecordBatches;
+    for (const block_t& block : m_vDictionaryBlocks)
+        vDictionaries.push_back({ block.offset, block.metaDataLength, 0, block.bodyLength });
+    for (const block_t& block : m_vRecordBatchBlocks)
+        vRecordBatches.push_back({ block.offset, block.metaDataLength, 0, block.bodyLength });
+    fbptr_t pFooter = FbTable();
+    FbScalar(pFooter, 0, MetadataVersion_V5);
+    FbChild(pFooter, 1, ArrowSchema());
+    FbChild(pFooter, 2, FbStructVector(vDictionaries.data(), sizeof(arrowblock_t), vDictionaries.size(), 8));
+    FbChild(pFooter, 3, FbStructVector(vRecordBatches.data(), sizeof(arrowblock_t), vRecordBatches.size(), 8));
+    const std::vector<uint8_t> vFooter = FbFinish(pFooter);
+    WriteBytes(vFooter.data(), vFooter.size());
+    const int32_t cbFooter = (int32_t)vFooter.size();
+    WriteBytes(&cbFooter, sizeof(cbFooter));
+    WriteBytes(szArrowMagic, 6);
+
+    m_file.close();
+    m_pColumns.reset();
+    if (m_file.fail())
+    {
+        sErrorInfo = L"Error writing file";
+        return false;
+    }
+    return true;
+}
+
+/// <summary>
+/// Writes the rows added since the last record batch as a record batch, and starts a new one.
+/// </summary>
+void ArrowFileWriter::WriteRecordBatch()
+{
+    columns_t& columns = *m_pColumns;
+    arrowbody_t body;
+    columns.module.indices.AddTo(body);
+    columns.type.indices.AddTo(body);
+    columns.language.indices.AddTo(body);
+    columns.resourceId.AddTo(body);
+    columns.resourceName.AddTo(body);
+    columns.itemId.AddTo(body);
+    columns.text.AddTo(body);
+    columns.textNoAccels.AddTo(body);
+    columns.controlType.indices.AddTo(body);
+    const fbptr_t pBatch = body.RecordBatch((int64_t)columns.nRows);
+    WriteMessage(FbFinish(ArrowMessage(MessageHeader_RecordBatch, pBatch, (int64_t)body.vBytes.size())), body.vBytes, &m_vRecordBatchBlocks);
+
+    for (dictionarycolumn_t* pDictionary : columns.Dictionaries())
+        pDictionary->indices.Clear();
+    columns.resourceId.Clear();
+    columns.resourceName.Clear();
+    columns.itemId.Clear();
+    columns.text.Clear();
+    columns.textNoAccels.Clear();
+    columns.nRows = 0;
+}
+
+/// <summary>
+/// Writes each dictionary as a dictionary batch: a record batch with one column, the values.
+/// </summary>
+void ArrowFileWriter::WriteDictionaries()
+{
+    int64_t dictionaryId = 0;
+    for (dictionarycolumn_t* pDictionary : m_pColumns->Dictionaries())
+    {
+        arrowbody_t body;
+        pDictionary->values.AddTo(body);
+        fbptr_t pDictionaryBatch = FbTable();
+        FbScalar(pDictionaryBatch, 0, dictionaryId++);
+        FbChild(pDictionaryBatch, 1, body.RecordBatch((int64_t)pDictionary->values.validity.nRows));
+        WriteMessage(FbFinish(ArrowMessage(MessageHeader_DictionaryBatch, pDictionaryBatch, (int64_t)body.vBytes.size())), body.vBytes, &m_vDictionaryBlocks);
+    }
+}
+
+/// <summary>
+/// Writes an encapsulated message: continuation marker, metadata length, metadata (padded to 8 bytes), and body.
+/// </summary>
+void ArrowFileWriter::WriteMessage(const std::vector<uint8_t>& vMetadata, const std::vector<uint8_t>& vBody, std::vector<block_t>* pBlocks)
+{
+    if (nullptr != pBlocks)
+        pBlocks->push_back({ m_cbWritten, (int32_t)(8 + vMetadata.size()), (int64_t)vBody.size() });
+    const uint32_t continuation = 0xFFFFFFFF;
+    const int32_t cbMetadata = (int32_t)vMetadata.size();
+    WriteBytes(&continuation, sizeof(continuation));
+    WriteBytes(&cbMetadata, sizeof(cbMetadata));
+    WriteBytes(vMetadata.data(), vMetadata.size());
+    WriteBytes(vBody.data(), vBody.size());
+}
+
+void ArrowFileWriter::WriteBytes(const void* pData, size_t cbData)
+{
+    m_file.write((const char*)pData, (std::streamsize)cbData);
+    m_cbWritten += (int64_t)cbData;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "TextRecord.h"
+
+/*
+References:
+
+Arrow Columnar Format - Serialization and Interprocess Communication (IPC)
+https://arrow.apache.org/docs/format/Columnar.html#serialization-and-interprocess-communication-ipc
+
+Arrow flatbuffers schemas (Schema.fbs, Message.fbs, File.fbs)
+https://github.com/apache/arrow/tree/main/format
+*/
+
+/// <summary>
+/// Writes extracted text to a file in the Apache Arrow IPC file format, so that it can be memory-mapped and
+/// queried (e.g., with pyarrow, Polars, or DuckDB) without parsing or unescaping. Doesn't use the Arrow library.
+///
+/// One row per item of text, with these columns:
+///   module          : file the text came from (dictionary-encoded)
+///   type            : strings, dialogs, messages, or menus (dictionary-encoded)
+///   language        : language of the resource, such as en-US (dictionary-encoded)
+///   resource_id     : uint16 resource ID; null if the resource is named
+///   resource_name   : resource name; null if the resource has an integer ID
+///   item_id         : int64 string ID, message ID, or control ID; null for a dialog caption or menu popup
+///   text            : the text as stored in the resource, not escaped
+///   text_no_accels  : the text with accelerators removed; null for messages
+///   control_type    : dialog control type, such as Button (dictionary-encoded); null for other items
+/// Text is UTF-8. Dictionary indices are int32.
+///
+/// Rows are written in record batches of up to 65536 rows as they are added, so memory use doesn't grow with
+/// the output. Each dictionary is written once, after the last record batch; readers of the file format locate
+/// the dictionaries through the footer.
+/// </summary>
+class ArrowFileWriter
+{
+public:
+    ArrowFileWriter();
+    ~ArrowFileWriter();
+
+    /// <summary>
+    /// Creates the file and writes its header and schema.
+    /// </summary>
+    /// <param name="sFilePath">Input: name of the output file</param>
+    /// <param name="sErrorInfo">Output: diagnostic information on failure</param>
+    /// <returns>true if successful, false otherwise</returns>
+    bool Open(const std::wstring& sFilePath, std::wstring& sErrorInfo);
+
+    /// <summary>
+    /// Adds one row.
+    /// </summary>
+    /// <param name="sModule">Input: the file the text came from</param>
+    /// <param name="record">Input: the text and the resource it came from</param>
+    void Add(const std::wstring& sModule, const resourcerecord_t& record);
+
+    /// <summary>
+    /// Writes the remaining rows, the dictionaries, and the footer, and closes the file.
+    /// </summary>
+    /// <param name="sErrorInfo">Output: diagnostic information on failure</param>
+    /// <returns>true if the complete file was written, false otherwise</returns>
+    bool Close(std::wstring& sErrorInfo);
+
+private:
+    /// <summary>
+    /// Location of an encapsulated message in the file, as listed in the footer.
+    /// </summary>
+    struct block_t
+    {
+        int64_t offset;
+        int32_t metaDataLength;
+        int64_t bodyLength;
+    };
+
+    struct columns_t;
+
+    void WriteRecordBatch();
+    void WriteDictionaries();
+    void WriteMessage(const std::vector<uint8_t>& vMetadata, const std::vector<uint8_t>& vBody, std::vector<block_t>* pBlocks);
+    void WriteBytes(const void* pData, size_t cbData);
+
+    std::ofstream m_file;
+    int64_t m_cbWritten;
+    std::unique_ptr<columns_t> m_pColumns;
+    std::vector<block_t> m_vDictionaryBlocks;
+    std::vector<block_t> m_vRecordBatchBlocks;
+
+private:
+    // Not implemented
+    ArrowFileWriter(const ArrowFileWriter&) = delete;
+    ArrowFileWriter& operator = (const ArrowFileWriter&) = delete;
+};
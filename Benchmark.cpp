@@ -0,0 +1,705 @@
+#include "PlatformDefs.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <regex>
+#include <thread>
+#ifndef _WIN32
+#include <time.h>
+#include <unistd.h>
+#endif
+#include "AllocationCounter.h"
+#include "Benchmark.h"
+#include "CodePages.h"
+#include "FileEnumeration.h"
+#include "FileOutput.h"
+#include "HEX.h"
+#include "ResourceExtraction.h"
+#include "StringUtils.h"
+#include "SyntheticPE.h"
+#include "UtilityFunctions.h"
+
+/// <summary>
+/// Work done by one iteration of a benchmark, for throughput: items of text and bytes of input.
+/// </summary>
+struct benchmarkcounts_t
+{
+    uint64_t nItems = 0;
+    uint64_t cbBytes = 0;
+};
+
+/// <summary>
+/// One benchmark: an optional setup before each iteration, which isn't timed, and the timed iteration.
+/// </summary>
+struct benchmark_t
+{
+    std::wstring sName;
+    std::function<void()> fnSetup;
+    std::function<void(benchmarkcounts_t&)> fnIteration;
+};
+
+/// <summary>
+/// Measurements from one repetition of a benchmark, per iteration.
+/// </summary>
+struct repetition_t
+{
+    uint64_t nIterations = 0;
+    double realNs = 0;
+    double cpuNs = 0;
+    double itemsPerSecond = 0;
+    double bytesPerSecond = 0;
+    // Heap allocations per item of text (see ThreadAllocationCount)
+    double allocsPerItem = 0;
+};
+
+/// <summary>
+/// Stream buffer that discards its output. Output goes through a small buffer first, so that it's
+/// formatted as it would be for a file.
+/// </summary>
+class DiscardingOutputBuffer : public std::wstreambuf
+{
+public:
+    DiscardingOutputBuffer() { setp(m_buffer, m_buffer + nBufferChars); }
+
+protected:
+    int_type overflow(int_type ch) override
+    {
+        setp(m_buffer, m_buffer + nBufferChars);
+        if (!traits_type::eq_int_type(ch, traits_type::eof()))
+            sputc(traits_type::to_char_type(ch));
+        return traits_type::not_eof(ch);
+    }
+
+private:
+    static const int nBufferChars = 4096;
+    wchar_t m_buffer[nBufferChars];
+};
+
+/// <summary>
+/// Output stream that discards its output.
+/// </summary>
+class DiscardingOutput : public std::wostream
+{
+public:
+    DiscardingOutput() : std::wostream(nullptr) { rdbuf(&m_buffer); }
+
+private:
+    DiscardingOutputBuffer m_buffer;
+};
+
+/// <summary>
+/// Keeps the compiler from discarding a computation whose result is otherwise unused.
+/// </summary>
+static volatile size_t s_sink = 0;
+static inline void KeepResult(size_t value)
+{
+    s_sink = s_sink + value;
+}
+
+/// <summary>
+/// CPU time used by the calling thread, in nanoseconds.
+/// </summary>
+static uint64_t ThreadCpuNs()
+{
+#ifdef _WIN32
+    FILETIME ftCreation, ftExit, ftKernel, ftUser;
+    if (!GetThreadTimes(GetCurrentThread(), &ftCreation, &ftExit, &ftKernel, &ftUser))
+        return 0;
+    const uint64_t kernel = ((uint64_t)ftKernel.dwHighDateTime << 32) | ftKernel.dwLowDateTime;
+    const uint64_t user = ((uint64_t)ftUser.dwHighDateTime << 32) | ftUser.dwLowDateTime;
+    return (kernel + user) * 100;
+#else
+    struct timespec ts;
+    if (0 != clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts))
+        return 0;
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/// <summary>
+/// Runs a benchmark's iterations until their total time reaches the minimum.
+/// </summary>
+static repetition_t RunRepetition(const benchmark_t& benchmark, double minSeconds)
+{
+    const std::chrono::nanoseconds minTime((int64_t)(minSeconds * 1e9));
+    // Enough iterations to be measured, but not unbounded for a benchmark that's mostly setup
+    const uint64_t nMaxIterations = 100000000;
+    std::chrono::nanoseconds realTime(0);
+    uint64_t cpuNs = 0;
+    uint64_t nAllocations = 0;
+    benchmarkcounts_t counts;
+    repetition_t repetition;
+    while (repetition.nIterations < nMaxIterations && (0 == repetition.nIterations || realTime < minTime))
+    {
+        if (benchmark.fnSetup)
+            benchmark.fnSetup();
+        const uint64_t cpuStart = ThreadCpuNs();
+        const uint64_t allocationsStart = ThreadAllocationCount();
+        const auto start = std::chrono::steady_clock::now();
+        benchmark.fnIteration(counts);
+        realTime += std::chrono::steady_clock::now() - start;
+        nAllocations += ThreadAllocationCount() - allocationsStart;
+        cpuNs += ThreadCpuNs() - cpuStart;
+        ++repetition.nIterations;
+    }
+    const double seconds = std::chrono::duration<double>(realTime).count();
+    repetition.realNs = seconds * 1e9 / (double)repetition.nIterations;
+    repetition.cpuNs = (double)cpuNs / (double)repetition.nIterations;
+    if (seconds > 0)
+    {
+        repetition.itemsPerSecond = (double)counts.nItems / seconds;
+        repetition.bytesPerSecond = (double)counts.cbBytes / seconds;
+    }
+    if (counts.nItems > 0)
+        repetition.allocsPerItem = (double)nAllocations / (double)counts.nItems;
+    return repetition;
+}
+
+/// <summary>
+/// Returns the text as a JSON string literal.
+/// </summary>
+static std::wstring JsonString(const std::wstring& sText)
+{
+    std::wstring sJson = L"\"";
+    for (wchar_t ch : sText)
+    {
+        switch (ch)
+        {
+        case L'"':
+            sJson += L"\\\"";
+            break;
+        case L'\\':
+            sJson += L"\\\\";
+            break;
+        default:
+            if (ch < 0x20)
+                sJson += L"\\u" + HEXW((uint16_t)ch, 4);
+            else
+                sJson += ch;
+            break;
+        }
+    }
+    return sJson + L"\"";
+}
+
+/// <summary>
+/// Current UTC time in ISO 8601 form.
+/// </summary>
+static std::wstring IsoTimestampUTC()
+{
+    const std::time_t now = std::time(nullptr);
+    struct tm tmNow;
+#ifdef _WIN32
+    gmtime_s(&tmNow, &now);
+#else
+    gmtime_r(&now, &tmNow);
+#endif
+    char szTimestamp[32];
+    strftime(szTimestamp, sizeof(szTimestamp), "%Y-%m-%dT%H:%M:%S+00:00", &tmNow);
+    return Utf8ToWString(szTimestamp);
+}
+
+/// <summary>
+/// Writes one Google Benchmark-style run (a repetition or an aggregate) as a JSON object.
+/// </summary>
+static void WriteJsonRun(
+    std::wostream& out,
+    const std::wstring& sRunName,
+    size_t ixFamily,
+    const wchar_t* szAggregate,
+    unsigned int nRepetitions,
+    unsigned int ixRepetition,
+    uint64_t nIterations,
+    double realNs,
+    double cpuNs,
+    double itemsPerSecond,
+    double bytesPerSecond,
+    double allocsPerItem,
+    bool bFirst)
+{
+    const std::wstring sName = szAggregate ? sRunName + L"_" + szAggregate : sRunName;
+    out
+        << (bFirst ? L"" : L",") << L"\n    {\n"
+        << L"      \"name\": " << JsonString(sName) << L",\n"
+        << L"      \"family_index\": " << ixFamily << L",\n"
+        << L"      \"per_family_instance_index\": 0,\n"
+        << L"      \"run_name\": " << JsonString(sRunName) << L",\n"
+        << L"      \"run_type\": \"" << (szAggregate ? L"aggregate" : L"iteration") << L"\",\n"
+        << L"      \"repetitions\": " << nRepetitions << L",\n";
+    if (szAggregate)
+    {
+        out
+            << L"      \"threads\": 1,\n"
+            << L"      \"aggregate_name\": \"" << szAggregate << L"\",\n"
+            << L"      \"aggregate_unit\": \"" << (0 == wcscmp(szAggregate, L"cv") ? L"percentage" : L"time") << L"\",\n";
+    }
+    else
+    {
+        out
+            << L"      \"repetition_index\": " << ixRepetition << L",\n"
+            << L"      \"threads\": 1,\n";
+    }
+    out
+        << L"      \"iterations\": " << nIterations << L",\n"
+        << L"      \"real_time\": " << realNs << L",\n"
+        << L"      \"cpu_time\": " << cpuNs << L",\n"
+        << L"      \"time_unit\": \"ns\"";
+    if (bytesPerSecond > 0)
+        out << L",\n      \"bytes_per_second\": " << bytesPerSecond;
+    if (itemsPerSecond > 0)
+        out << L",\n      \"items_per_second\": " << itemsPerSecond;
+    // A user counter, in Google Benchmark's terms; only in a build that counts allocations
+    if (AllocationCountingEnabled() && (nullptr == szAggregate || 0 != wcscmp(szAggregate, L"cv")))
+        out << L",\n      \"allocs_per_item\": " << allocsPerItem;
+    out << L"\n    }";
+}
+
+// --------------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Sample text for the microbenchmarks: each form of input that a utility is given.
+/// </summary>
+struct textsample_t
+{
+    std::vector<std::wstring> vLabels;
+    std::vector<std::wstring> vSentences;
+    std::vector<std::vector<uint16_t>> vUtf16;
+    std::vector<std::string> vUtf8;
+    std::vector<std::string> vAnsi;
+    std::vector<uint32_t> vIds;
+};
+
+static void MakeTextSample(textsample_t& sample)
+{
+    SyntheticText text(1);
+    for (int ixText = 0; ixText < 2048; ++ixText)
+        sample.vLabels.push_back(text.Label());
+    for (int ixText = 0; ixText < 1024; ++ixText)
+        sample.vSentences.push_back(text.Sentence());
+    for (const std::wstring& sSentence : sample.vSentences)
+    {
+        sample.vUtf16.push_back(EncodeUtf16(sSentence));
+        sample.vUtf8.push_back(WStringToUtf8(sSentence));
+        sample.vAnsi.push_back(EncodeAnsi(sSentence));
+    }
+    for (int ixId = 0; ixId < 4096; ++ixId)
+        sample.vIds.push_back(0xC0000000 | text.Next(0x10000));
+}
+
+/// <summary>
+/// The original implementation of RemoveAccelsFromText, with std::wregex and three replacement passes, kept as the
+/// reference that the single-pass version is checked against (see CheckRemoveAccelsFromText), and benchmarked
+/// for comparison.
+/// </summary>
+static std::wstring RemoveAccelsFromTextReference(const std::wstring& sInput)
+{
+    // Pattern to search for: Left parenthesis character, ampersand character, capital letter A-Z or digit 0-9, right parenthesis character.
+    std::wregex regexAsianAccelerator(L"\\(&[A-Z0-9]\\)");
+    // Remove anything that matches the Asian accelerator pattern:
+    std::wstring sEastAsianAccelsRemoved = std::regex_replace(sInput, regexAsianAccelerator, L"");
+
+    // Now, remove any remaining ampersands unless they are escaped (two consecutive ampersands).
+    // Replace escaped ampersands with an unusual string combo, then remove remaining ampersands, and
+    // finally restore the escaped ampersands.
+    const wchar_t* szEscapedAmpersand = L"&&";
+    const std::wstring sTempReplacement = L"~`~";
+    return
+        replaceStringAll(
+            replaceStringAll(
+                replaceStringAll(sEastAsianAccelsRemoved, szEscapedAmpersand, sTempReplacement),
+                L"&", L""),
+            sTempReplacement, szEscapedAmpersand);
+}
+
+/// <summary>
+/// Differential check of RemoveAccelsFromText against RemoveAccelsFromTextReference, both the std::wstring
+/// overload and the buffer overload writing in place: known cases (East Asian accelerators, escaped ampersands,
+/// a trailing ampersand), then random strings over the characters that matter to either implementation. The
+/// reference turns its "~`~" sentinel into "&&", so the random strings have a backtick but no tilde.
+/// </summary>
+/// <param name="err">The error stream to write each mismatch into</param>
+/// <returns>true if every result matched the reference</returns>
+static bool CheckRemoveAccelsFromText(std::wostream& err)
+{
+    std::vector<std::wstring> vInputs = {
+        L"", L"&", L"&&", L"&&&", L"&&&&", L"a&", L"a&&", L"&a", L"E&xit", L"Save && E&xit",
+        L"\u524a\u9664(&R)", L"(&R)", L"(&R)&", L"&(&R)", L"&(&R)&", L"(&1)(&2)", L"&(&1)(&2)&x", L"(&&)",
+        L"(&a)", L"((&Z))", L"(&A", L"(&A)&&", L"&(&A)(&B)", L"`&`", L"(&9)`&&`",
+    };
+    SyntheticText random(8);
+    const std::wstring sAlphabet = L"&()AZ09ab`";
+    for (int ixRandom = 0; ixRandom < 50000; ++ixRandom)
+    {
+        std::wstring sInput(random.Next(13), L' ');
+        for (wchar_t& ch : sInput)
+            ch = sAlphabet[random.Next((uint32_t)sAlphabet.length())];
+        vInputs.push_back(sInput);
+    }
+
+    size_t nMismatches = 0;
+    for (const std::wstring& sInput : vInputs)
+    {
+        const std::wstring sExpected = RemoveAccelsFromTextReference(sInput);
+        std::wstring sInPlace(sInput);
+        sInPlace.resize(RemoveAccelsFromText(&sInPlace[0], sInPlace.length(), &sInPlace[0]));
+        for (const std::wstring& sActual : { RemoveAccelsFromText(sInput), sInPlace })
+        {
+            if (sActual != sExpected && nMismatches++ < 10)
+                err << L"RemoveAccelsFromText mismatch: \"" << sInput << L"\" gives \"" << sActual << L"\", reference gives \"" << sExpected << L"\"" << std::endl;
+        }
+    }
+    if (0 != nMismatches)
+        err << L"RemoveAccelsFromText: " << nMismatches << L" mismatches in " << vInputs.size() * 2 << L" checks" << std::endl;
+    return 0 == nMismatches;
+}
+
+/// <summary>
+/// Adds a microbenchmark that applies a function to each string in a set.
+/// </summary>
+template <typename T, typename Fn>
+static void AddTextBenchmark(std::vector<benchmark_t>& vBenchmarks, const wchar_t* szName, const std::vector<T>& vInputs, size_t cbPerUnit, Fn fn)
+{
+    benchmark_t benchmark;
+    benchmark.sName = szName;
+    benchmark.fnIteration = [&vInputs, cbPerUnit, fn](benchmarkcounts_t& counts)
+    {
+        size_t nResult = 0;
+        for (const T& input : vInputs)
+        {
+            nResult += fn(input);
+            counts.cbBytes += input.size() * cbPerUnit;
+        }
+        counts.nItems += vInputs.size();
+        KeepResult(nResult);
+    };
+    vBenchmarks.push_back(benchmark);
+}
+
+static void AddTextBenchmarks(std::vector<benchmark_t>& vBenchmarks, const textsample_t& sample)
+{
+    AddTextBenchmark(vBenchmarks, L"text/RemoveAccelsFromText/labels", sample.vLabels, sizeof(wchar_t),
+        [](const std::wstring& s) { return RemoveAccelsFromText(s).length(); });
+    AddTextBenchmark(vBenchmarks, L"text/RemoveAccelsFromText/sentences", sample.vSentences, sizeof(wchar_t),
+        [](const std::wstring& s) { return RemoveAccelsFromText(s).length(); });
+    AddTextBenchmark(vBenchmarks, L"text/RemoveAccelsFromTextReference/labels", sample.vLabels, sizeof(wchar_t),
+        [](const std::wstring& s) { return RemoveAccelsFromTextReference(s).length(); });
+    AddTextBenchmark(vBenchmarks, L"text/escapeCrLfTabNul/labels", sample.vLabels, sizeof(wchar_t),
+        [](const std::wstring& s) { return escapeCrLfTabNul(s).length(); });
+    AddTextBenchmark(vBenchmarks, L"text/escapeCrLfTabNul/sentences", sample.vSentences, sizeof(wchar_t),
+        [](const std::wstring& s) { return escapeCrLfTabNul(s).length(); });
+    AddTextBenchmark(vBenchmarks, L"text/WStringFromUtf16/sentences", sample.vUtf16, sizeof(uint16_t),
+        [](const std::vector<uint16_t>& v) { return WStringFromUtf16(v.data(), v.size()).length(); });
+    AddTextBenchmark(vBenchmarks, L"text/WStringFromUtf8/sentences", sample.vUtf8, 1,
+        [](const std::string& s) { return WStringFromUtf8(s.data(), s.length()).length(); });
+    AddTextBenchmark(vBenchmarks, L"text/WStringToUtf8/sentences", sample.vSentences, sizeof(wchar_t),
+        [](const std::wstring& s) { return WStringToUtf8(s).length(); });
+    AddTextBenchmark(vBenchmarks, L"text/WStringFromCodePage/1252/sentences", sample.vAnsi, 1,
+        [](const std::string& s) { return WStringFromCodePage(s.data(), s.length(), 1252).length(); });
+
+    // HEX formats single values rather than strings.
+    benchmark_t hex;
+    hex.sName = L"text/HEX/uint32";
+    hex.fnIteration = [&sample](benchmarkcounts_t& counts)
+    {
+        size_t nResult = 0;
+        for (uint32_t id : sample.vIds)
+            nResult += HEX(id, 8, false, true).length();
+        counts.nItems += sample.vIds.size();
+        counts.cbBytes += sample.vIds.size() * sizeof(uint32_t);
+        KeepResult(nResult);
+    };
+    vBenchmarks.push_back(hex);
+}
+
+// --------------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// A synthetic resource file for the macrobenchmarks, and the resource type to extract from it.
+/// </summary>
+struct syntheticfile_t
+{
+    const wchar_t* szName;
+    rsrctype_t type;
+    std::function<void(syntheticcontent_t& content)> fnContent;
+};
+
+static const syntheticfile_t syntheticFiles[] =
+{
+    { L"strings/10", rsrctype_t::eString, [](syntheticcontent_t& c) { c.nStrings = 10; } },
+    { L"strings/1k", rsrctype_t::eString, [](syntheticcontent_t& c) { c.nStrings = 1000; } },
+    { L"strings/50k", rsrctype_t::eString, [](syntheticcontent_t& c) { c.nStrings = 50000; } },
+    { L"dialogs/500x12", rsrctype_t::eDialog, [](syntheticcontent_t& c) { c.nDialogs = 500; c.nControls = 12; } },
+    { L"dialogs/deep/20x1000", rsrctype_t::eDialog, [](syntheticcontent_t& c) { c.nDialogs = 20; c.nControls = 1000; c.dialogForm = templateform_t::eExtended; } },
+    { L"messages/1k", rsrctype_t::eMessageTable, [](syntheticcontent_t& c) { c.nMessages = 1000; } },
+    { L"messages/50k", rsrctype_t::eMessageTable, [](syntheticcontent_t& c) { c.nMessages = 50000; } },
+    { L"menus/500x5x10", rsrctype_t::eMenu, [](syntheticcontent_t& c) { c.nMenus = 500; c.nMenuPopups = 5; c.nMenuItems = 10; } },
+    { L"menus/deep/20x32", rsrctype_t::eMenu, [](syntheticcontent_t& c) { c.nMenus = 20; c.menuDepth = 32; c.menuForm = templateform_t::eExtended; } },
+};
+
+static const uint16_t LangId_EnglishUS = 0x0409;
+
+/// <summary>
+/// A synthetic file written for the macrobenchmarks, kept open for the warm-cache variant.
+/// </summary>
+struct benchmarkfile_t
+{
+    std::wstring sFilePath;
+    rsrctype_t type = rsrctype_t::eString;
+    ResourceFile rsrcFile;
+    // Items of text and bytes of resource data in the file
+    benchmarkcounts_t counts;
+    DiscardingOutput out;
+    DiscardingOutput decodeErr;
+    // Arguments of each extraction, made once so that the benchmark measures only the extraction's allocations
+    std::vector<rsrctype_t> vTypes;
+    std::vector<std::wostream*> vOuts;
+    TextArena arena;
+};
+
+/// <summary>
+/// Counts the items of text and bytes of resource data that an extraction from the file processes.
+/// </summary>
+static void CountFileContents(benchmarkfile_t& file)
+{
+    std::wostringstream err;
+    ExtractRecords(file.rsrcFile, { file.type }, [&file](const resourcerecord_t&) { ++file.counts.nItems; }, err);
+    std::wstring sErrorInfo;
+    file.rsrcFile.EnumResources(file.type, [&file](const ResourceEntry_t& entry) { file.counts.cbBytes += entry.cbData; return true; }, sErrorInfo);
+}
+
+static bool AddExtractionBenchmarks(
+    std::vector<benchmark_t>& vBenchmarks,
+    std::vector<std::unique_ptr<benchmarkfile_t>>& vFiles,
+    const benchmarkoptions_t& options,
+    std::wostream& err)
+{
+#ifdef _WIN32
+    const unsigned long pid = GetCurrentProcessId();
+#else
+    const unsigned long pid = (unsigned long)getpid();
+#endif
+    const std::wstring sTempDirectory = TempDirectoryPath();
+
+    for (const syntheticfile_t& synthetic : syntheticFiles)
+    {
+        const std::wstring sName = std::wstring(L"extract/") + synthetic.szName;
+        const std::wstring sWarm = sName + L"/warm", sCold = sName + L"/cold", sParallel = sName + L"/parallel/warm";
+        bool bWanted = options.vFilters.empty();
+        for (const std::wstring& sFilter : options.vFilters)
+        {
+            if (std::wstring::npos != sWarm.find(sFilter) || std::wstring::npos != sCold.find(sFilter) || std::wstring::npos != sParallel.find(sFilter))
+                bWanted = true;
+        }
+        if (!bWanted)
+            continue;
+
+        // Each file's content is the same in every run.
+        syntheticcontent_t content;
+        synthetic.fnContent(content);
+        ResourceImageBuilder builder;
+        SyntheticText text(2);
+        AddSyntheticResources(builder, content, LangId_EnglishUS, text);
+        std::wstring sFileName = synthetic.szName;
+        std::replace(sFileName.begin(), sFileName.end(), L'/', L'-');
+        vFiles.emplace_back(new benchmarkfile_t());
+        benchmarkfile_t& file = *vFiles.back();
+        file.sFilePath = sTempDirectory + L"glr-benchmark-" + std::to_wstring(pid) + L"-" + sFileName + L".dll";
+        file.type = synthetic.type;
+        file.vTypes.push_back(file.type);
+        file.vOuts.push_back(&file.out);
+        std::wstring sErrorInfo;
+        if (!WriteBinaryFile(file.sFilePath, builder.Build(), sErrorInfo) ||
+            !file.rsrcFile.Open(file.sFilePath, std::vector<std::wstring>(), sErrorInfo))
+        {
+            err << L"Error: " << sErrorInfo << std::endl;
+            return false;
+        }
+        CountFileContents(file);
+
+        benchmark_t warm;
+        warm.sName = sWarm;
+        warm.fnIteration = [&file](benchmarkcounts_t& counts)
+        {
+            ExtractResources(file.rsrcFile, file.vTypes, file.vOuts, file.decodeErr, file.arena, 1);
+            counts.nItems += file.counts.nItems;
+            counts.cbBytes += file.counts.cbBytes;
+        };
+        vBenchmarks.push_back(warm);
+
+        benchmark_t cold;
+        cold.sName = sCold;
+        cold.fnSetup = [&file]()
+        {
+            file.rsrcFile.Close();
+            MappedFile::DropFromCache(file.sFilePath);
+        };
+        cold.fnIteration = [&file](benchmarkcounts_t& counts)
+        {
+            std::wstring sErrorInfo;
+            if (file.rsrcFile.Open(file.sFilePath, std::vector<std::wstring>(), sErrorInfo))
+                ExtractResources(file.rsrcFile, file.vTypes, file.vOuts, file.decodeErr, file.arena, 1);
+            counts.nItems += file.counts.nItems;
+            counts.cbBytes += file.counts.cbBytes;
+        };
+        vBenchmarks.push_back(cold);
+
+        // Files large enough to be decoded on several threads by default
+        if (file.counts.cbBytes >= cbParallelDecodingThreshold)
+        {
+            benchmark_t parallel;
+            parallel.sName = sParallel;
+            parallel.fnIteration = [&file](benchmarkcounts_t& counts)
+            {
+                ExtractResources(file.rsrcFile, file.vTypes, file.vOuts, file.decodeErr, file.arena, 0);
+                counts.nItems += file.counts.nItems;
+                counts.cbBytes += file.counts.cbBytes;
+            };
+            vBenchmarks.push_back(parallel);
+        }
+    }
+    return true;
+}
+
+// --------------------------------------------------------------------------------------------------------------
+
+bool RunBenchmarks(const benchmarkoptions_t& options, std::wostream& out, std::wostream& err)
+{
+    textsample_t sample;
+    MakeTextSample(sample);
+    std::vector<benchmark_t> vBenchmarks;
+    AddTextBenchmarks(vBenchmarks, sample);
+    std::vector<std::unique_ptr<benchmarkfile_t>> vFiles;
+    bool ret = AddExtractionBenchmarks(vBenchmarks, vFiles, options, err);
+
+    // Text benchmarks are filtered here; extraction benchmarks were filtered before their files were written.
+    vBenchmarks.erase(
+        std::remove_if(vBenchmarks.begin(), vBenchmarks.end(),
+            [&options](const benchmark_t& benchmark)
+            {
+                if (options.vFilters.empty())
+                    return false;
+                for (const std::wstring& sFilter : options.vFilters)
+                {
+                    if (std::wstring::npos != benchmark.sName.find(sFilter))
+                        return false;
+                }
+                return true;
+            }),
+        vBenchmarks.end());
+    if (ret && vBenchmarks.empty())
+    {
+        err << L"No benchmarks match" << std::endl;
+        ret = false;
+    }
+
+    // A faster RemoveAccelsFromText is only worth measuring if it still gives the reference's results.
+    const bool bAccelBenchmarks = std::any_of(vBenchmarks.begin(), vBenchmarks.end(),
+        [](const benchmark_t& benchmark) { return std::wstring::npos != benchmark.sName.find(L"RemoveAccelsFromText"); });
+    if (ret && bAccelBenchmarks && !CheckRemoveAccelsFromText(err))
+        ret = false;
+
+    if (ret)
+    {
+        const bool bCanDropCache = vFiles.empty() || MappedFile::DropFromCache(vFiles.front()->sFilePath);
+        out
+            << L"{\n"
+            << L"  \"context\": {\n"
+            << L"    \"date\": " << JsonString(IsoTimestampUTC()) << L",\n"
+            << L"    \"num_cpus\": " << std::thread::hardware_concurrency() << L",\n"
+#ifdef NDEBUG
+            << L"    \"library_build_type\": \"release\",\n"
+#else
+            << L"    \"library_build_type\": \"debug\",\n"
+#endif
+            << L"    \"wchar_bits\": " << sizeof(wchar_t) * 8 << L",\n"
+            << L"    \"cold_cache_drops_file_cache\": " << (bCanDropCache ? L"true" : L"false") << L",\n"
+            << L"    \"counts_allocations\": " << (AllocationCountingEnabled() ? L"true" : L"false") << L",\n"
+            << L"    \"min_time_per_repetition\": " << options.minSecondsPerRepetition << L"\n"
+            << L"  },\n"
+            << L"  \"benchmarks\": [";
+        out << std::setprecision(10);
+
+        err << std::left << std::setw(48) << L"Benchmark" << std::right << std::setw(14) << L"Time (ns)" << std::setw(14) << L"CPU (ns)" << std::setw(14) << L"MB/s" << std::setw(16) << L"Items/s" << std::setw(14) << L"Allocs/item" << std::endl;
+        bool bFirst = true;
+        for (size_t ixBenchmark = 0; ixBenchmark < vBenchmarks.size(); ++ixBenchmark)
+        {
+            const benchmark_t& benchmark = vBenchmarks[ixBenchmark];
+            // One untimed run first, to touch the code and data and to allocate anything allocated once
+            benchmarkcounts_t warmupCounts;
+            if (benchmark.fnSetup)
+                benchmark.fnSetup();
+            benchmark.fnIteration(warmupCounts);
+
+            std::vector<repetition_t> vRepetitions;
+            for (unsigned int ixRepetition = 0; ixRepetition < options.nRepetitions; ++ixRepetition)
+            {
+                vRepetitions.push_back(RunRepetition(benchmark, options.minSecondsPerRepetition));
+                const repetition_t& rep = vRepetitions.back();
+                WriteJsonRun(out, benchmark.sName, ixBenchmark, nullptr, options.nRepetitions, ixRepetition, rep.nIterations,
+                    rep.realNs, rep.cpuNs, rep.itemsPerSecond, rep.bytesPerSecond, rep.allocsPerItem, bFirst);
+                bFirst = false;
+            }
+
+            // Aggregates across repetitions, as Google Benchmark computes them
+            const size_t n = vRepetitions.size();
+            auto aggregate = [&vRepetitions, n](double repetition_t::* pField, double& mean, double& median, double& stddev)
+            {
+                std::vector<double> vValues;
+                for (const repetition_t& rep : vRepetitions)
+                    vValues.push_back(rep.*pField);
+                mean = 0;
+                for (double value : vValues)
+                    mean += value;
+                mean /= (double)n;
+                std::sort(vValues.begin(), vValues.end());
+                median = (0 == n % 2) ? (vValues[n / 2 - 1] + vValues[n / 2]) / 2 : vValues[n / 2];
+                double sumSquares = 0;
+                for (double value : vValues)
+                    sumSquares += (value - mean) * (value - mean);
+                stddev = (n > 1) ? std::sqrt(sumSquares / (double)(n - 1)) : 0;
+            };
+            double realMean, realMedian, realStddev, cpuMean, cpuMedian, cpuStddev;
+            double itemsMean, itemsMedian, itemsStddev, bytesMean, bytesMedian, bytesStddev;
+            double allocsMean, allocsMedian, allocsStddev;
+            aggregate(&repetition_t::realNs, realMean, realMedian, realStddev);
+            aggregate(&repetition_t::cpuNs, cpuMean, cpuMedian, cpuStddev);
+            aggregate(&repetition_t::itemsPerSecond, itemsMean, itemsMedian, itemsStddev);
+            aggregate(&repetition_t::bytesPerSecond, bytesMean, bytesMedian, bytesStddev);
+            aggregate(&repetition_t::allocsPerItem, allocsMean, allocsMedian, allocsStddev);
+            if (n > 1)
+            {
+                const unsigned int nReps = options.nRepetitions;
+                WriteJsonRun(out, benchmark.sName, ixBenchmark, L"mean", nReps, 0, n, realMean, cpuMean, itemsMean, bytesMean, allocsMean, false);
+                WriteJsonRun(out, benchmark.sName, ixBenchmark, L"median", nReps, 0, n, realMedian, cpuMedian, itemsMedian, bytesMedian, allocsMedian, false);
+                WriteJsonRun(out, benchmark.sName, ixBenchmark, L"stddev", nReps, 0, n, realStddev, cpuStddev, itemsStddev, bytesStddev, allocsStddev, false);
+                WriteJsonRun(out, benchmark.sName, ixBenchmark, L"cv", nReps, 0, n,
+                    realMean > 0 ? realStddev / realMean : 0, cpuMean > 0 ? cpuStddev / cpuMean : 0, 0, 0, 0, false);
+            }
+
+            err
+                << std::left << std::setw(48) << benchmark.sName << std::right << std::fixed << std::setprecision(0)
+                << std::setw(14) << realMedian << std::setw(14) << cpuMedian
+                << std::setprecision(1) << std::setw(14) << bytesMedian / (1024.0 * 1024.0)
+                << std::setprecision(0) << std::setw(16) << itemsMedian
+                << std::setprecision(2) << std::setw(14);
+            if (AllocationCountingEnabled())
+                err << allocsMedian << std::endl;
+            else
+                err << L"n/a" << std::endl;
+            err << std::defaultfloat << std::setprecision(6);
+        }
+        out << L"\n  ]\n}\n";
+    }
+
+    for (std::unique_ptr<benchmarkfile_t>& pFile : vFiles)
+    {
+        pFile->rsrcFile.Close();
+        DeleteFilePath(pFile->sFilePath);
+    }
+    return ret;
+}
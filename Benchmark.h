@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Options for RunBenchmarks.
+/// </summary>
+struct benchmarkoptions_t
+{
+    // Run only the benchmarks whose names contain one of these; all of them if empty
+    std::vector<std::wstring> vFilters;
+    // Each benchmark is run this many times, each time for at least minSecondsPerRepetition
+    unsigned int nRepetitions = 5;
+    double minSecondsPerRepetition = 0.2;
+};
+
+/// <summary>
+/// Measures the text utilities and the resource extractors, so that the effect of a change on their
+/// performance can be compared between builds.
+///
+/// Microbenchmarks ("text/...") run the string utilities (accelerator removal, escaping, HEX, and the UTF-16,
+/// UTF-8, and code page conversions) over a fixed sample of synthetic user-interface text.
+/// Macrobenchmarks ("extract/...") write synthetic PE files to the temporary directory (see SyntheticPE.h) and run
+/// each extractor's tab-delimited output over them, with the output discarded: string tables of 10, 1,000, and
+/// 50,000 strings, many small dialogs and a few with 1,000 controls each, message tables of 1,000 and 50,000
+/// messages, and many small menus and a few deeply nested ones. Each has a "warm" variant, which extracts from
+/// a file that's already mapped, and a "cold" variant, which opens, maps, and extracts from the file after
+/// asking the operating system to drop it from its file cache (see MappedFile::DropFromCache). The extractions run
+/// on one thread, except that files with at least cbParallelDecodingThreshold bytes of resources also have a
+/// "parallel/warm" variant, decoded on one thread per processor (see WriteResourceText); its CPU time and
+/// allocations are those of the calling thread only.
+///
+/// Results are written as JSON in the format of Google Benchmark's --benchmark_format=json (a run per
+/// repetition, then mean, median, stddev, and cv aggregates, with times in nanoseconds per iteration), so that
+/// they can be compared with Google Benchmark's tools/compare.py. In a build with GLR_COUNT_ALLOCATIONS defined, each
+/// run also has an "allocs_per_item" counter: heap allocations per item of text (see ThreadAllocationCount); other
+/// builds don't count allocations, and report them as "n/a". A summary is written to the error stream.
+///
+/// Before the accelerator benchmarks run, RemoveAccelsFromText is checked against the original std::wregex
+/// implementation, which is kept in Benchmark.cpp as a reference and benchmarked alongside it; a mismatch fails the run.
+/// </summary>
+/// <param name="options">Input: which benchmarks to run, and for how long</param>
+/// <param name="out">The output stream to write the JSON results into</param>
+/// <param name="err">The error stream to write progress and diagnostic information into</param>
+/// <returns>true if the benchmarks ran, false if a synthetic file couldn't be written or no benchmark matched</returns>
+bool RunBenchmarks(const benchmarkoptions_t& options, std::wostream& out, std::wostream& err);
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/// <summary>
+/// Converts text in a Windows ANSI code page, such as the non-Unicode entries of a message table, to a wstring.
+///
+/// The single-byte Windows code pages (874 and 1250 through 1258) are decoded with built-in tables on every
+/// platform; bytes that a code page leaves undefined become the code point with the same value, as Windows does
+/// for 1252. The double-byte code pages (932, 936, 949, and 950) and any other code page are decoded by the
+/// system on Windows. Elsewhere, the double-byte code pages are decoded with iconv where the system has it and a
+/// converter for the code page, and other code pages are decoded as 1252. Each character that can't be decoded
+/// (every non-ASCII character in a double-byte code page, without iconv) becomes U+FFFD. ASCII is copied
+/// directly in all code pages.
+/// </summary>
+/// <param name="pText">Input: the text</param>
+/// <param name="cbText">Input: number of bytes</param>
+/// <param name="codePage">Input: code page identifier (see AnsiCodePageFromLangId)</param>
+/// <returns>The text as a wstring</returns>
+std::wstring WStringFromCodePage(const char* pText, size_t cbText, uint16_t codePage);
+
+/// <summary>
+/// Converts text in a Windows ANSI code page to a wstring, as above, and indicates whether any character couldn't
+/// be decoded.
+/// </summary>
+/// <param name="pText">Input: the text</param>
+/// <param name="cbText">Input: number of bytes</param>
+/// <param name="codePage">Input: code page identifier (see AnsiCodePageFromLangId)</param>
+/// <param name="bLossy">Output: true if any character became U+FFFD</param>
+/// <returns>The text as a wstring</returns>
+std::wstring WStringFromCodePage(const char* pText, size_t cbText, uint16_t codePage, bool& bLossy);
@@ -0,0 +1,1247 @@
+#include "PlatformDefs.h"
+#include <algorithm>
+#include <atomic>
+#include <cwchar>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include "CorpusExtraction.h"
+#include "CorpusManifest.h"
+#include "DialogTextExtraction.h"
+#include "ExtractionCache.h"
+#include "FileOutput.h"
+#include "LanguageNames.h"
+#include "ResourceExtraction.h"
+#include "ResourceValidation.h"
+#include "TextInternPool.h"
+#include "WorkStealingPool.h"
+#include "Wow64FsRedirection.h"
+
+/// <summary>
+/// One item of text from record extraction, with the resource it came from, kept until it's written: like
+/// resourcerecord_t, but with its text in the file's arena, or for normalized output, in the intern pool.
+/// </summary>
+struct arenarecord_t
+{
+    rsrctype_t type = rsrctype_t::eString;
+    uint16_t langId = 0;
+    uint16_t resourceId = 0;
+    arenatext_t resourceName;
+    textview_t::item_t item = textview_t::item_t::eId;
+    int64_t id = 0;
+    arenatext_t text;
+    const internedtext_t* pInterned = nullptr;
+    arenatext_t controlType;
+};
+
+/// <summary>
+/// Output collected from one file, waiting to be written in order.
+/// </summary>
+struct corpusresult_t
+{
+    // Output for each resource type
+    std::vector<std::wstring> vOut;
+    // Or, for record extraction, the items of text, with their text in the arena
+    std::vector<arenarecord_t> vRecords;
+    TextArena recordArena;
+    // Or, for validation, the counts
+    validationstats_t stats;
+    std::wstring sErr;
+    // Key of the result in the extraction cache, if it's to be stored there once the file is done
+    uint64_t cacheKey = 0;
+    bool bStoreInCache = false;
+    // For incremental extraction, the hash of the file's content and the satellites it was opened with, the
+    // satellites looked for and not opened, and the hash of the language subdirectories; and whether its content is
+    // as it was, so that it wasn't decoded
+    uint64_t contentHash = 0;
+    std::vector<manifestfile_t> vSatellites;
+    std::vector<std::wstring> vSatellitesNotOpened;
+    uint64_t languageDirectoriesHash = 0;
+    bool bUnchanged = false;
+    bool bDone = false;
+};
+
+/// <summary>
+/// The extraction cache, if any, with the hash of the options of this extraction (see CorpusCache).
+/// </summary>
+struct corpuscache_t
+{
+    ExtractionCache* pCache = nullptr;
+    uint64_t optionsHash = 0;
+};
+
+/// <summary>
+/// Path of the language-neutral file that a .mui satellite file belongs to, in the parent of the satellite's
+/// language subdirectory, e.g., C:\Windows\System32\wsecedit.dll for C:\Windows\System32\fr-FR\wsecedit.dll.mui;
+/// empty if the path isn't that of a .mui file in a subdirectory.
+/// </summary>
+static std::wstring NeutralFilePath(const std::wstring& sFilePath)
+{
+    const std::wstring sMuiExt = L".mui";
+    if (sFilePath.length() <= sMuiExt.length() ||
+        0 != _wcsicmp(sFilePath.c_str() + sFilePath.length() - sMuiExt.length(), sMuiExt.c_str()))
+        return std::wstring();
+    const size_t ixNameSep = sFilePath.find_last_of(L"/\\");
+    if (std::wstring::npos == ixNameSep || 0 == ixNameSep)
+        return std::wstring();
+    const size_t ixLanguageSep = sFilePath.find_last_of(L"/\\", ixNameSep - 1);
+    const size_t ixLanguage = (std::wstring::npos == ixLanguageSep) ? 0 : ixLanguageSep + 1;
+    return sFilePath.substr(0, ixLanguage) + sFilePath.substr(ixNameSep + 1, sFilePath.length() - sMuiExt.length() - ixNameSep - 1);
+}
+
+/// <summary>
+/// Whether two paths name the same file, as the paths of a satellite file are built (see ResourceFile): on
+/// Windows, without regard to case.
+/// </summary>
+static bool SameFilePath(const std::wstring& sFilePath1, const std::wstring& sFilePath2)
+{
+#ifdef _WIN32
+    return 0 == _wcsicmp(sFilePath1.c_str(), sFilePath2.c_str());
+#else
+    return sFilePath1 == sFilePath2;
+#endif
+}
+
+/// <summary>
+/// The .mui satellite files of a corpus that a language-neutral file of the corpus is opened with, and whose text is
+/// extracted as that file's: such a satellite file isn't extracted on its own as well, which would repeat its text
+/// under its own path. Which satellites a file is opened with depends on the languages and on which files exist, so
+/// it's found by opening the language-neutral file when one of its satellites' turn comes, once for all of them.
+/// Thread-safe.
+/// </summary>
+class FoldedSatellites
+{
+public:
+    FoldedSatellites(const std::vector<std::wstring>& vFiles, const languageoptions_t& languages) :
+        m_languages(languages)
+    {
+        const std::unordered_set<std::wstring> files(vFiles.begin(), vFiles.end());
+        for (const std::wstring& sFilePath : vFiles)
+        {
+            const std::wstring sNeutralPath = NeutralFilePath(sFilePath);
+            if (!sNeutralPath.empty() && files.end() != files.find(sNeutralPath))
+                m_neutralPaths[sFilePath] = sNeutralPath;
+        }
+    }
+
+    /// <summary>
+    /// Returns true if the file is a satellite file that its language-neutral file in the corpus is opened with.
+    /// </summary>
+    bool IsFolded(const std::wstring& sFilePath)
+    {
+        auto iterNeutral = m_neutralPaths.find(sFilePath);
+        if (m_neutralPaths.end() == iterNeutral)
+            return false;
+
+        std::shared_ptr<std::vector<std::wstring>> pSatellites;
+        {
+            std::lock_guard<std::mutex> lock(m_mtx);
+            pSatellites = m_satellites[iterNeutral->second];
+        }
+        if (!pSatellites)
+        {
+            // Another worker may be opening the same file; either result will do.
+            pSatellites = std::make_shared<std::vector<std::wstring>>();
+            ResourceFile rsrcFile;
+            std::wstring sErrorInfo;
+            Wow64FsRedirection fsRedir(true);
+            if (OpenResourceFile(rsrcFile, iterNeutral->second, m_languages, sErrorInfo))
+            {
+                bool bSatellite = false;
+                rsrcFile.ForEachMappedFile([&](const std::wstring& sMappedPath, const uint8_t*, size_t)
+                    {
+                        if (bSatellite)
+                            pSatellites->push_back(sMappedPath);
+                        bSatellite = true;
+                    });
+            }
+            fsRedir.Revert();
+            std::lock_guard<std::mutex> lock(m_mtx);
+            m_satellites[iterNeutral->second] = pSatellites;
+        }
+        for (const std::wstring& sSatellitePath : *pSatellites)
+        {
+            if (SameFilePath(sSatellitePath, sFilePath))
+                return true;
+        }
+        return false;
+    }
+
+private:
+    const languageoptions_t& m_languages;
+    // Path of the language-neutral file of each satellite file of the corpus whose language-neutral file is in it
+    std::unordered_map<std::wstring, std::wstring> m_neutralPaths;
+    // Satellite files that each language-neutral file was opened with, once it has been opened
+    std::mutex m_mtx;
+    std::unordered_map<std::wstring, std::shared_ptr<std::vector<std::wstring>>> m_satellites;
+
+private:
+    // Not implemented
+    FoldedSatellites(const FoldedSatellites&) = delete;
+    FoldedSatellites& operator = (const FoldedSatellites&) = delete;
+};
+
+/// <summary>
+/// Opens one file of the corpus. Errors other than the file not being a PE file are written to the error stream.
+/// A satellite file whose language-neutral file is opened with it is skipped, as if it weren't a PE file.
+/// </summary>
+static bool OpenCorpusFile(ResourceFile& rsrcFile, const std::wstring& sFilePath, const languageoptions_t& languages, FoldedSatellites& folded, std::wostream& err)
+{
+    if (folded.IsFolded(sFilePath))
+        return false;
+
+    // WOW64 file system redirection is per-thread, so each worker disables it for itself.
+    std::wstring sErrorInfo;
+    Wow64FsRedirection fsRedir(true);
+    bool bOpened = OpenResourceFile(rsrcFile, sFilePath, languages, sErrorInfo);
+    fsRedir.Revert();
+
+    // Directory trees are full of files that aren't PE files; don't report those.
+    if (!bOpened && sErrorInfo != ResourceFile::szNotPEFile)
+        err << L"Cannot load resource file: " << sErrorInfo << std::endl;
+    return bOpened;
+}
+
+/// <summary>
+/// Hash of the options that affect a file's result, for its key in the extraction cache: the decoders' output
+/// version, the form of the result ("text" or "records"), the resource types, and the languages.
+/// </summary>
+static corpuscache_t CorpusCache(ExtractionCache* pCache, const wchar_t* szForm, const std::vector<rsrctype_t>& vTypes, const languageoptions_t& languages)
+{
+    std::wostringstream options;
+    options << L"Decoder output " << decoderOutputVersion << L'\n' << szForm << L'\n';
+    for (rsrctype_t type : vTypes)
+        options << (uint16_t)type << L' ';
+    options << L'\n' << (languages.bAllLanguages ? 1 : 0) << L'\n';
+    for (uint16_t langId : languages.vFilter)
+        options << langId << L' ';
+    options << L'\n';
+    for (const std::wstring& sLanguage : languages.vPreferred)
+        options << sLanguage << L' ';
+    const std::wstring sOptions = options.str();
+
+    corpuscache_t cache;
+    cache.pCache = pCache;
+    cache.optionsHash = HashContent(sOptions.data(), sOptions.length() * sizeof(wchar_t), 0);
+    return cache;
+}
+
+/// <summary>
+/// Hash of the content of the file and of the .mui satellite files it was opened with, starting from the seed.
+/// A satellite's path relative to the file's directory (its language subdirectory and name) is hashed too; the
+/// file's own path isn't, so copies of a file have the same hash.
+/// </summary>
+static uint64_t ContentHash(uint64_t seed, const ResourceFile& rsrcFile)
+{
+    uint64_t key = seed;
+    const std::wstring& sFilePath = rsrcFile.FilePath();
+    const size_t cchDirectory = sFilePath.length() - GetFileNameFromFilePath(sFilePath).length();
+    bool bSatellite = false;
+    rsrcFile.ForEachMappedFile([&](const std::wstring& sMappedPath, const uint8_t* pData, size_t cbData)
+        {
+            if (bSatellite)
+            {
+                const std::wstring sRelativePath = sMappedPath.substr(std::min(cchDirectory, sMappedPath.length()));
+                key = HashContent(sRelativePath.data(), sRelativePath.length() * sizeof(wchar_t), key);
+            }
+            key = HashContent(pData, cbData, key);
+            bSatellite = true;
+        });
+    return key;
+}
+
+/// <summary>
+/// Key of a file's result in the extraction cache: the content hash, starting from the options hash.
+/// </summary>
+static uint64_t CacheKey(const corpuscache_t& cache, const ResourceFile& rsrcFile)
+{
+    return ContentHash(cache.optionsHash, rsrcFile);
+}
+
+/// <summary>
+/// Writes a file's result as an extraction cache entry's payload: each type's output, the records, and the error text.
+/// </summary>
+static void SerializeResult(const corpusresult_t& result, std::vector<uint8_t>& vPayload)
+{
+    CacheEntryWriter writer(vPayload);
+    writer.Number(result.vOut.size());
+    for (const std::wstring& sOut : result.vOut)
+        writer.Text(sOut);
+    writer.Number(result.vRecords.size());
+    for (const arenarecord_t& record : result.vRecords)
+    {
+        writer.Number((uint64_t)record.type);
+        writer.Number(record.langId);
+        writer.Number(record.resourceId);
+        writer.Text(record.resourceName.pChars, record.resourceName.nChars);
+        writer.Number((uint64_t)record.item);
+        writer.SignedNumber(record.id);
+        writer.Text(record.text.pChars, record.text.nChars);
+        writer.Text(record.controlType.pChars, record.controlType.nChars);
+    }
+    writer.Text(result.sErr);
+}
+
+/// <summary>
+/// Reads text from a cache entry into the arena.
+/// </summary>
+static bool ReadArenaText(CacheEntryReader& reader, std::vector<uint16_t>& vUtf16, TextArena& arena, arenatext_t& text)
+{
+    if (!reader.Text(vUtf16))
+        return false;
+    wchar_t* pChars = arena.Allocate(vUtf16.size());
+    text = arenatext_t(pChars, Utf16ToWide(vUtf16.data(), vUtf16.size(), pChars));
+    return true;
+}
+
+/// <summary>
+/// Reads a result written by SerializeResult, with the records' text in the result's arena; with an intern pool,
+/// the records' text is interned as well. The result must have nOuts outputs.
+/// </summary>
+static bool DeserializeResult(const std::vector<uint8_t>& vPayload, size_t nOuts, TextInternPool* pPool, corpusresult_t& result)
+{
+    CacheEntryReader reader(vPayload.data(), vPayload.size());
+    std::vector<uint16_t> vUtf16;
+    uint64_t nCount;
+    if (!reader.Number(nCount) || nCount != nOuts)
+        return false;
+    for (size_t ixOut = 0; ixOut < nOuts; ++ixOut)
+    {
+        if (!reader.Text(vUtf16))
+            return false;
+        result.vOut.push_back(WStringFromUtf16(vUtf16.data(), vUtf16.size()));
+    }
+
+    if (!reader.Number(nCount))
+        return false;
+    for (uint64_t ixRecord = 0; ixRecord < nCount; ++ixRecord)
+    {
+        arenarecord_t record;
+        uint64_t type, langId, resourceId, item;
+        if (!reader.Number(type) || !reader.Number(langId) || !reader.Number(resourceId) ||
+            !ReadArenaText(reader, vUtf16, result.recordArena, record.resourceName) ||
+            !reader.Number(item) || !reader.SignedNumber(record.id) ||
+            !ReadArenaText(reader, vUtf16, result.recordArena, record.text))
+            return false;
+        if (nullptr != pPool)
+        {
+            utf16view_t text;
+            text.pChars = vUtf16.data();
+            text.nChars = vUtf16.size();
+            record.pInterned = &pPool->Intern(text);
+        }
+        if (!ReadArenaText(reader, vUtf16, result.recordArena, record.controlType))
+            return false;
+        record.type = (rsrctype_t)type;
+        record.langId = (uint16_t)langId;
+        record.resourceId = (uint16_t)resourceId;
+        record.item = (textview_t::item_t)item;
+        result.vRecords.push_back(record);
+    }
+
+    if (!reader.Text(vUtf16))
+        return false;
+    result.sErr = WStringFromUtf16(vUtf16.data(), vUtf16.size());
+    return reader.AtEnd();
+}
+
+/// <summary>
+/// Gets the file's result from the extraction cache, if there is one and it has the result. Otherwise, marks the
+/// result to be stored in the cache once the file is done.
+/// </summary>
+static bool LoadCachedResult(const corpuscache_t& cache, const ResourceFile& rsrcFile, size_t nOuts, TextInternPool* pPool, corpusresult_t& result)
+{
+    if (nullptr == cache.pCache)
+        return false;
+    const uint64_t key = CacheKey(cache, rsrcFile);
+    std::vector<uint8_t> vPayload;
+    if (cache.pCache->Load(key, vPayload))
+    {
+        if (DeserializeResult(vPayload, nOuts, pPool, result))
+            return true;
+        result = corpusresult_t();
+    }
+    result.cacheKey = key;
+    result.bStoreInCache = true;
+    return false;
+}
+
+/// <summary>
+/// A part of one file's extraction that any worker can run, with that worker's arena.
+/// </summary>
+typedef std::function<void(TextArena& arena)> FilePartFn_t;
+
+/// <summary>
+/// Adds a part of the current file's extraction to the worker's tasks; the file's result is written once every
+/// part has finished.
+/// </summary>
+typedef std::function<void(FilePartFn_t part)> SplitFn_t;
+
+/// <summary>
+/// Called once a file is open, before it's decoded; returns true if it has filled in the file's result (e.g., from
+/// the extraction cache), so that the file isn't decoded.
+/// </summary>
+typedef std::function<bool(const ResourceFile& rsrcFile, corpusresult_t& result)> FileOpenedFn_t;
+
+/// <summary>
+/// A large file being decoded in parts: kept alive, with its resources and the parts' output, until the last
+/// part has finished.
+/// </summary>
+struct splitfile_t
+{
+    ResourceFile rsrcFile;
+    std::vector<ResourceEntry_t> vEntries;
+    bool bEnumerated = false;
+    std::wstring sErrorInfo;
+    std::vector<size_t> vRunEnds;
+    std::vector<decodedrun_t> vRuns;
+    std::atomic<size_t> nRunsLeft;
+};
+
+/// <summary>
+/// Writes the runs of a split file into its result, in order, as WriteResourceText writes them.
+/// </summary>
+static void WriteSplitFileResult(const splitfile_t& file, size_t nTypes, corpusresult_t& result)
+{
+    std::vector<std::wostringstream> vOutStreams(nTypes);
+    std::vector<std::wostream*> vOuts;
+    for (std::wostringstream& out : vOutStreams)
+        vOuts.push_back(&out);
+    std::wostringstream err;
+
+    std::vector<bool> vStopped(nTypes, false);
+    for (const decodedrun_t& run : file.vRuns)
+        WriteDecodedRun(run, vOuts, err, vStopped);
+    if (!file.bEnumerated)
+        err << L"Cannot enumerate resources: " << file.sErrorInfo << std::endl;
+
+    for (std::wostringstream& out : vOutStreams)
+        result.vOut.push_back(out.str());
+    result.sErr = err.str();
+}
+
+/// <summary>
+/// Runs the extraction on one file, capturing its output and error text, unless the opened function fills them
+/// in (e.g., from the extraction cache). With more than one worker, a file with at least cbParallelDecodingThreshold bytes of resource data is split into
+/// runs of resources (see DivideIntoRuns), each a part that any worker can take; the last part to finish writes the
+/// file's result.
+/// </summary>
+static void ExtractOneFile(
+    const std::wstring& sFilePath,
+    const std::vector<rsrctype_t>& vTypes,
+    const languageoptions_t& languages,
+    FoldedSatellites& folded,
+    unsigned int nWorkers,
+    const FileOpenedFn_t& opened,
+    TextArena& arena,
+    corpusresult_t& result,
+    const SplitFn_t& split)
+{
+    std::shared_ptr<splitfile_t> pFile = std::make_shared<splitfile_t>();
+    std::wostringstream err;
+    if (!OpenCorpusFile(pFile->rsrcFile, sFilePath, languages, folded, err))
+    {
+        result.vOut.resize(vTypes.size());
+        result.sErr = err.str();
+        return;
+    }
+    if (opened(pFile->rsrcFile, result))
+        return;
+
+    // Enumerate first, as ExtractResources does, to see how much there is to decode.
+    pFile->bEnumerated = pFile->rsrcFile.EnumResources(
+        vTypes, [&pFile](const ResourceEntry_t& entry) { pFile->vEntries.push_back(entry); return true; }, pFile->sErrorInfo);
+    uint64_t cbTotal = 0;
+    for (const ResourceEntry_t& entry : pFile->vEntries)
+        cbTotal += entry.cbData;
+
+    if (nWorkers > 1 && pFile->vEntries.size() > 1 && cbTotal >= cbParallelDecodingThreshold)
+    {
+        pFile->vRunEnds = DivideIntoRuns(pFile->vEntries, nWorkers);
+        pFile->vRuns.resize(pFile->vRunEnds.size());
+        pFile->nRunsLeft = pFile->vRunEnds.size();
+        const bool bLanguageColumn = pFile->rsrcFile.AllLanguages();
+        const size_t nTypes = vTypes.size();
+        // Each part goes to the front of this worker's deque, so the last is added first, and this worker takes
+        // them from the first while other workers steal from the last.
+        for (size_t ixRun = pFile->vRunEnds.size(); ixRun-- > 0;)
+        {
+            split([pFile, ixRun, &vTypes, bLanguageColumn, nTypes, &result](TextArena& partArena)
+                {
+                    splitfile_t& file = *pFile;
+                    DecodeResourceRun(
+                        file.vEntries, (0 == ixRun) ? 0 : file.vRunEnds[ixRun - 1], file.vRunEnds[ixRun], vTypes, bLanguageColumn, partArena, file.vRuns[ixRun]);
+                    if (1 == file.nRunsLeft--)
+                        WriteSplitFileResult(file, nTypes, result);
+                });
+        }
+        return;
+    }
+
+    std::vector<std::wostringstream> vOutStreams(vTypes.size());
+    std::vector<std::wostream*> vOuts;
+    for (std::wostringstream& out : vOutStreams)
+        vOuts.push_back(&out);
+    WriteResourceText(pFile->vEntries, vTypes, vOuts, pFile->rsrcFile.AllLanguages(), 1, err, arena);
+    if (!pFile->bEnumerated)
+        err << L"Cannot enumerate resources: " << pFile->sErrorInfo << std::endl;
+
+    for (std::wostringstream& out : vOutStreams)
+        result.vOut.push_back(out.str());
+    result.sErr = err.str();
+}
+
+/// <summary>
+/// Visitor for corpus record extraction: copies each item of text into the file's arena, to outlive the file's
+/// mapping until the records are written. With an intern pool, interns each item's text instead, and copies it
+/// as well only if bKeepText is true (to store the records in the extraction cache).
+/// </summary>
+class ArenaRecordVisitor : public ResourceVisitor
+{
+public:
+    ArenaRecordVisitor(corpusresult_t& result, TextInternPool* pPool, bool bKeepText) :
+        m_result(result), m_pPool(pPool), m_bKeepText(bKeepText || nullptr == pPool) {}
+
+    void BeginResource(const ResourceEntry_t& entry) override
+    {
+        m_record.type = (rsrctype_t)entry.type.m_id;
+        m_record.langId = entry.langId;
+        m_record.resourceId = entry.name.IsId() ? entry.name.m_id : 0;
+        m_record.resourceName = arenatext_t();
+        if (!entry.name.IsId())
+        {
+            utf16view_t name;
+            name.pChars = entry.name.m_pName;
+            name.nChars = entry.name.m_cchName;
+            m_record.resourceName = Copy(ArenaText(m_scratch, name));
+        }
+        m_scratch.Reset();
+    }
+
+    void Visit(const ResourceEntry_t& entry, const textview_t& text) override
+    {
+        (void)entry;
+        m_record.item = text.item;
+        m_record.id = text.id;
+        if (nullptr != m_pPool)
+            m_record.pInterned = &m_pPool->Intern(text.text);
+        if (m_bKeepText)
+            m_record.text = Copy(ArenaText(m_scratch, text.text));
+        m_record.controlType = arenatext_t();
+        if (rsrctype_t::eDialog == m_record.type && textview_t::item_t::eId == text.item)
+            m_record.controlType = Copy(DialogControlType(m_scratch, text.windowClass, text.style));
+        m_scratch.Reset();
+        m_result.vRecords.push_back(m_record);
+    }
+
+private:
+    /// <summary>
+    /// Copies text into the file's arena. The text can be in the scratch arena, in the file's mapping (where
+    /// ArenaText returns it in place), or a literal.
+    /// </summary>
+    arenatext_t Copy(const arenatext_t& text)
+    {
+        wchar_t* pChars = m_result.recordArena.Allocate(text.nChars);
+        if (text.nChars > 0)
+            memcpy(pChars, text.pChars, text.nChars * sizeof(wchar_t));
+        return arenatext_t(pChars, text.nChars);
+    }
+
+    corpusresult_t& m_result;
+    TextInternPool* m_pPool;
+    const bool m_bKeepText;
+    arenarecord_t m_record;
+    TextArena m_scratch;
+
+private:
+    // Not implemented
+    ArenaRecordVisitor(const ArenaRecordVisitor&) = delete;
+    ArenaRecordVisitor& operator = (const ArenaRecordVisitor&) = delete;
+};
+
+/// <summary>
+/// Runs the record extraction on one file, capturing its records and error text, or reads them from the
+/// extraction cache. With an intern pool, the records' text is interned rather than copied.
+/// </summary>
+static void ExtractRecordsFromOneFile(
+    const std::wstring& sFilePath,
+    const std::vector<rsrctype_t>& vTypes,
+    const languageoptions_t& languages,
+    FoldedSatellites& folded,
+    const corpuscache_t& cache,
+    TextInternPool* pPool,
+    corpusresult_t& result)
+{
+    std::wostringstream err;
+    ResourceFile rsrcFile;
+    if (OpenCorpusFile(rsrcFile, sFilePath, languages, folded, err))
+    {
+        if (LoadCachedResult(cache, rsrcFile, 0, pPool, result))
+            return;
+        ArenaRecordVisitor visitor(result, pPool, result.bStoreInCache);
+        VisitResources(rsrcFile, vTypes, visitor, err);
+    }
+    result.sErr = err.str();
+}
+
+/// <summary>
+/// Number of workers for the corpus: one per hardware thread if nWorkers is 0. Unless files can be split into
+/// parts, no more workers than there are files.
+/// </summary>
+static unsigned int CorpusWorkers(unsigned int nWorkers, size_t nFiles, bool bSplitFiles)
+{
+    if (0 == nWorkers)
+        nWorkers = std::thread::hardware_concurrency();
+    if (0 == nWorkers)
+        nWorkers = 1;
+    if (!bSplitFiles && nWorkers > nFiles)
+        nWorkers = (nFiles > 0) ? (unsigned int)nFiles : 1;
+    return nWorkers;
+}
+
+/// <summary>
+/// Runs the extraction on each file with a pool of worker threads, and passes each file's result to the writer
+/// on the calling thread, in file order, regardless of which worker finishes first.
+/// The files are dealt out to the workers' deques in turn, and a worker that runs out of files steals from the
+/// others (see WorkStealingPool); an extraction can split a file into parts for other workers to steal. When
+/// done, writes each worker's utilization to the error stream.
+/// Each worker has an arena for the extraction's temporary text, reset after each file or part.
+/// With an extraction cache, the worker that finishes a file stores its result in the cache if the extraction
+/// marked it to be stored.
+/// Results wait to be written only within a window of nReorderWindowPerWorker files per worker past the next file
+/// to be written: a worker that takes a file beyond it waits (counted as busy) until the writer catches up, so that
+/// a slow file or a slow output doesn't leave the results of the rest of the corpus held in memory. The next file to
+/// be written is never kept waiting, since a worker takes the files in its own deque in order, and steals only once
+/// its deque is empty.
+/// </summary>
+static const size_t nReorderWindowPerWorker = 8;
+
+static void ProcessFilesInOrder(
+    const std::vector<std::wstring>& vFiles,
+    unsigned int nWorkers,
+    ExtractionCache* pCache,
+    const std::function<void(const std::wstring& sFilePath, TextArena& arena, corpusresult_t& result, const SplitFn_t& split)>& extract,
+    const std::function<void(size_t ixFile, corpusresult_t& result)>& write,
+    std::wostream& err)
+{
+    // Workers run each file's extraction, and its parts, if any; this thread writes completed results in file
+    // order. A file is done when its extraction and all its parts have finished.
+    WorkStealingPool pool(nWorkers);
+    std::vector<TextArena> vArenas(nWorkers);
+    std::vector<corpusresult_t> vResults(vFiles.size());
+    std::unique_ptr<std::atomic<size_t>[]> pTasksLeft(new std::atomic<size_t>[vFiles.size()]);
+    std::mutex mtxResults;
+    std::condition_variable cvResultDone;
+    // Files before this one have been written, or are being written.
+    size_t ixNextWrite = 0;
+    const size_t nReorderWindow = nReorderWindowPerWorker * nWorkers;
+    std::condition_variable cvWindow;
+
+    const auto finishTask = [&](size_t ixFile)
+    {
+        if (1 == pTasksLeft[ixFile]--)
+        {
+            corpusresult_t& result = vResults[ixFile];
+            if (nullptr != pCache && result.bStoreInCache)
+            {
+                std::vector<uint8_t> vPayload;
+                SerializeResult(result, vPayload);
+                pCache->Store(result.cacheKey, vPayload);
+            }
+            {
+                std::lock_guard<std::mutex> lock(mtxResults);
+                result.bDone = true;
+            }
+            cvResultDone.notify_one();
+        }
+    };
+
+    for (size_t ixFile = 0; ixFile < vFiles.size(); ++ixFile)
+    {
+        pTasksLeft[ixFile] = 1;
+        pool.PushBack((unsigned int)(ixFile % nWorkers), [&, ixFile](unsigned int ixWorker)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(mtxResults);
+                    cvWindow.wait(lock, [&]() { return ixFile < ixNextWrite + nReorderWindow; });
+                }
+                const SplitFn_t split = [&, ixFile, ixWorker](FilePartFn_t part)
+                {
+                    ++pTasksLeft[ixFile];
+                    pool.Push(ixWorker, [&, ixFile, part](unsigned int ixPartWorker)
+                        {
+                            part(vArenas[ixPartWorker]);
+                            vArenas[ixPartWorker].Reset();
+                            finishTask(ixFile);
+                        });
+                };
+                extract(vFiles[ixFile], vArenas[ixWorker], vResults[ixFile], split);
+                vArenas[ixWorker].Reset();
+                finishTask(ixFile);
+            });
+    }
+    pool.Start();
+
+    for (size_t ixFile = 0; ixFile < vFiles.size(); ++ixFile)
+    {
+        corpusresult_t result;
+        {
+            std::unique_lock<std::mutex> lock(mtxResults);
+            cvResultDone.wait(lock, [&]() { return vResults[ixFile].bDone; });
+            result = std::move(vResults[ixFile]);
+            ixNextWrite = ixFile + 1;
+        }
+        cvWindow.notify_all();
+        write(ixFile, result);
+    }
+
+    pool.Join();
+    pool.WriteUtilization(err);
+}
+
+bool CorpusExtraction(
+    const std::vector<std::wstring>& vFiles,
+    const std::vector<rsrctype_t>& vTypes,
+    const languageoptions_t& languages,
+    unsigned int nWorkers,
+    ExtractionCache* pCache,
+    const std::vector<std::wostream*>& vOuts,
+    std::wostream& err)
+{
+    for (size_t ixType = 0; ixType < vTypes.size(); ++ixType)
+    {
+        *vOuts[ixType] << L"File path\t";
+        WriteResourceHeaders(vTypes[ixType], languages.bAllLanguages, *vOuts[ixType]);
+    }
+
+    // Large files are split into runs of resources, which idle workers can steal.
+    const unsigned int nCorpusWorkers = CorpusWorkers(nWorkers, vFiles.size(), true);
+    const corpuscache_t cache = CorpusCache(pCache, L"text", vTypes, languages);
+    FoldedSatellites folded(vFiles, languages);
+    ProcessFilesInOrder(
+        vFiles,
+        nCorpusWorkers,
+        pCache,
+        [&](const std::wstring& sFilePath, TextArena& arena, corpusresult_t& result, const SplitFn_t& split)
+        {
+            ExtractOneFile(
+                sFilePath, vTypes, languages, folded, nCorpusWorkers,
+                [&](const ResourceFile& rsrcFile, corpusresult_t& fileResult) { return LoadCachedResult(cache, rsrcFile, vTypes.size(), nullptr, fileResult); },
+                arena, result, split);
+        },
+        [&](size_t ixFile, corpusresult_t& result)
+        {
+            const std::wstring sPathField = escapeCrLfTabNul(vFiles[ixFile]);
+            for (size_t ixType = 0; ixType < vTypes.size(); ++ixType)
+                WriteLinesWithPrefix(*vOuts[ixType], result.vOut[ixType], sPathField + L'\t');
+            WriteLinesWithPrefix(err, result.sErr, sPathField + L": ");
+        },
+        err);
+
+    bool bWritten = true;
+    for (std::wostream* pOut : vOuts)
+    {
+        if (pOut->flush().fail())
+            bWritten = false;
+    }
+    if (!bWritten)
+        err << L"Cannot write output" << std::endl;
+    err.flush();
+    return bWritten;
+}
+
+/// <summary>
+/// Input files per output shard, and the most shards.
+/// </summary>
+static const size_t nFilesPerShard = 64;
+static const size_t nMaxShards = 4096;
+
+/// <summary>
+/// Number of output shards for an incremental extraction of a number of files. A manifest keeps its number of shards
+/// until the number of files calls for less than half or more than twice as many; then the files are resharded.
+/// </summary>
+static uint32_t ShardCount(size_t nFiles)
+{
+    return (uint32_t)std::max<size_t>(1, std::min(nMaxShards, (nFiles + nFilesPerShard - 1) / nFilesPerShard));
+}
+
+/// <summary>
+/// Hash of the names of the language-named subdirectories that a language-neutral file's satellites are looked for
+/// in when it's opened for all languages (see ResourceFile::LanguageDirectoryNames).
+/// </summary>
+static uint64_t LanguageDirectoriesHash(const std::wstring& sFilePath)
+{
+    std::wstring sNames;
+    for (const std::wstring& sName : ResourceFile::LanguageDirectoryNames(sFilePath))
+    {
+        sNames += sName;
+        sNames += L'\n';
+    }
+    return HashContent(sNames.data(), sNames.length() * sizeof(wchar_t), 0);
+}
+
+/// <summary>
+/// Path of an output shard of incremental extraction: the type's name and the shard's number, e.g.,
+/// strings-0007.txt.
+/// </summary>
+static std::wstring ShardFilePath(const std::wstring& sDirectory, rsrctype_t type, uint32_t shard)
+{
+    wchar_t szNumber[16];
+    swprintf(szNumber, 16, L"-%04u.txt", shard);
+    return sDirectory + ResourceExtractor(type).szName + szNumber;
+}
+
+/// <summary>
+/// Reads an output shard's lines, grouped by the file path that starts each line. The headers are skipped.
+/// </summary>
+static void ReadShardLines(const std::wstring& sShardPath, std::unordered_map<std::wstring, std::wstring>& fileLines)
+{
+    std::vector<std::wstring> vLines;
+    std::wstring sErrorInfo;
+    if (!ReadFileList(sShardPath, vLines, sErrorInfo))
+        return;
+    for (size_t ixLine = 1; ixLine < vLines.size(); ++ixLine)
+    {
+        const std::wstring& sLine = vLines[ixLine];
+        const size_t ixTab = sLine.find(L'\t');
+        if (std::wstring::npos == ixTab)
+            continue;
+        std::wstring& sFileLines = fileLines[sLine.substr(0, ixTab)];
+        sFileLines += sLine;
+        sFileLines += L'\n';
+    }
+}
+
+bool IncrementalCorpusExtraction(
+    const std::vector<std::wstring>& vFiles,
+    const std::vector<rsrctype_t>& vTypes,
+    const languageoptions_t& languages,
+    unsigned int nWorkers,
+    ExtractionCache* pCache,
+    const std::wstring& sOutDirectory,
+    std::wostream& err)
+{
+    std::wstring sErrorInfo;
+    if (!CreateDirectoryPath(sOutDirectory, sErrorInfo))
+    {
+        err << L"Cannot create output directory: " << sErrorInfo << std::endl;
+        return false;
+    }
+    std::wstring sDirectory = sOutDirectory;
+    if (!EndsWith(sDirectory, L'\\') && !EndsWith(sDirectory, L'/'))
+        sDirectory += L'/';
+    const std::wstring sManifestPath = sDirectory + L"manifest.txt";
+
+    // Each file once, in the order given. A path with CR, LF, TAB, or NUL can't be recorded in the manifest or the
+    // shards, which those characters delimit.
+    std::vector<std::wstring> vInputs;
+    std::unordered_map<std::wstring, size_t> inputIndexes;
+    for (const std::wstring& sFilePath : vFiles)
+    {
+        if (!IsManifestPath(sFilePath))
+            err << L"Skipping file with CR, LF, TAB, or NUL in its path: " << escapeCrLfTabNul(sFilePath) << std::endl;
+        else if (inputIndexes.emplace(sFilePath, vInputs.size()).second)
+            vInputs.push_back(sFilePath);
+    }
+
+    // The previous run's manifest, if it had the same options and a number of shards for about this many files.
+    // Otherwise every file is extracted, into a number of shards for the number of files, and the previous run's
+    // shards are removed. (The form differs from that of earlier manifests, whose shards have the text of satellite
+    // files that FoldedSatellites now skips.)
+    const uint64_t optionsHash = CorpusCache(nullptr, L"text, without folded satellites", vTypes, languages).optionsHash;
+    const uint32_t nIdealShards = ShardCount(vInputs.size());
+    CorpusManifest oldManifest;
+    bool bOldManifest = oldManifest.Read(sManifestPath, sErrorInfo);
+    if (!bOldManifest && IsFilePath(sManifestPath))
+        err << sErrorInfo << L"; extracting every file" << std::endl;
+    const bool bReshard = bOldManifest && (oldManifest.Shards() > 2 * nIdealShards || 2 * oldManifest.Shards() < nIdealShards);
+    if (bReshard && oldManifest.OptionsHash() == optionsHash)
+        err << L"Resharding from " << oldManifest.Shards() << L" to " << nIdealShards << L" shards; extracting every file" << std::endl;
+    if (bOldManifest && (oldManifest.OptionsHash() != optionsHash || bReshard))
+    {
+        bOldManifest = false;
+        for (rsrctype_t type : AllExtractableTypes())
+        {
+            for (uint32_t shard = 0; shard < oldManifest.Shards(); ++shard)
+                DeleteFilePath(ShardFilePath(sDirectory, type, shard));
+        }
+    }
+    if (!bOldManifest)
+        oldManifest.Reset(optionsHash, nIdealShards);
+    const uint32_t nShards = oldManifest.Shards();
+
+    // A file is read again if it's new, or if its size or last-write time, or a satellite's, isn't as in the
+    // manifest, or if it might have another satellite: one that wasn't there is, or (with all languages) a language
+    // subdirectory has been added or removed. Then it's decoded only if its content has changed. A shard is rewritten if one of its files has
+    // changed or is gone. A shard with a missing file has all its files decoded again.
+    struct inputstate_t
+    {
+        uint32_t shard = 0;
+        filestamp_t stamp;
+        const manifestentry_t* pOld = nullptr;
+        bool bRead = false;
+        manifestentry_t newEntry;
+    };
+    std::vector<inputstate_t> vStates(vInputs.size());
+    std::vector<std::vector<size_t>> vShardInputs(nShards);
+    std::vector<bool> vShardRewritten(nShards, !bOldManifest);
+    std::vector<bool> vShardMissing(nShards, !bOldManifest);
+    for (uint32_t shard = 0; shard < nShards && bOldManifest; ++shard)
+    {
+        for (rsrctype_t type : vTypes)
+        {
+            if (!IsFilePath(ShardFilePath(sDirectory, type, shard)))
+                vShardMissing[shard] = vShardRewritten[shard] = true;
+        }
+    }
+    uint64_t nRemoved = 0;
+    for (const manifestentry_t& entry : oldManifest.Entries())
+    {
+        if (inputIndexes.end() == inputIndexes.find(entry.file.sFilePath))
+        {
+            vShardRewritten[entry.shard] = true;
+            ++nRemoved;
+        }
+    }
+
+    // Files to read, shard by shard, so that each shard is complete as soon as its last file is written
+    std::vector<std::wstring> vReads;
+    std::vector<size_t> vReadInputs;
+    for (size_t ixInput = 0; ixInput < vInputs.size(); ++ixInput)
+    {
+        inputstate_t& input = vStates[ixInput];
+        input.shard = ShardForPath(vInputs[ixInput], nShards);
+        input.pOld = oldManifest.Find(vInputs[ixInput]);
+        GetFileStamp(vInputs[ixInput], input.stamp);
+        input.bRead = (nullptr == input.pOld || input.pOld->file.stamp != input.stamp || vShardMissing[input.shard]);
+        for (size_t ixSatellite = 0; !input.bRead && ixSatellite < input.pOld->vSatellites.size(); ++ixSatellite)
+        {
+            filestamp_t stamp;
+            input.bRead = !GetFileStamp(input.pOld->vSatellites[ixSatellite].sFilePath, stamp) || input.pOld->vSatellites[ixSatellite].stamp != stamp;
+        }
+        for (size_t ixNotOpened = 0; !input.bRead && ixNotOpened < input.pOld->vSatellitesNotOpened.size(); ++ixNotOpened)
+            input.bRead = IsFilePath(input.pOld->vSatellitesNotOpened[ixNotOpened]);
+        if (!input.bRead && 0 != input.pOld->languageDirectoriesHash)
+            input.bRead = LanguageDirectoriesHash(vInputs[ixInput]) != input.pOld->languageDirectoriesHash;
+        vShardInputs[input.shard].push_back(ixInput);
+    }
+    // Whether a satellite file is extracted on its own depends on whether its language-neutral file is opened with it
+    // (see FoldedSatellites), so it's read again along with that file, or if that file is no longer an input.
+    for (size_t ixInput = 0; ixInput < vInputs.size(); ++ixInput)
+    {
+        const std::wstring sNeutralPath = NeutralFilePath(vInputs[ixInput]);
+        if (sNeutralPath.empty())
+            continue;
+        auto iterNeutral = inputIndexes.find(sNeutralPath);
+        if ((inputIndexes.end() != iterNeutral) ? vStates[iterNeutral->second].bRead : nullptr != oldManifest.Find(sNeutralPath))
+            vStates[ixInput].bRead = true;
+    }
+    for (uint32_t shard = 0; shard < nShards; ++shard)
+    {
+        for (size_t ixInput : vShardInputs[shard])
+        {
+            if (vStates[ixInput].bRead)
+            {
+                vReads.push_back(vInputs[ixInput]);
+                vReadInputs.push_back(ixInput);
+            }
+        }
+    }
+
+    // Output of the files of the current shard that were decoded
+    std::unordered_map<size_t, std::vector<std::wstring>> decodedOutputs;
+    uint32_t nextShard = 0, nShardsWritten = 0;
+    bool bWritten = true;
+    const auto finishShard = [&](uint32_t shard)
+    {
+        if (!vShardRewritten[shard])
+            return;
+        for (size_t ixType = 0; ixType < vTypes.size(); ++ixType)
+        {
+            // Files that weren't decoded keep their lines from the shard as it was.
+            std::unordered_map<std::wstring, std::wstring> oldLines;
+            const std::wstring sShardPath = ShardFilePath(sDirectory, vTypes[ixType], shard);
+            if (!vShardMissing[shard])
+                ReadShardLines(sShardPath, oldLines);
+
+            const std::wstring sTempPath = sShardPath + L".tmp";
+            Utf8FileOutput out;
+            bool bShardWritten = CreateFileOutput(sTempPath.c_str(), out);
+            if (bShardWritten)
+            {
+                out << L"File path\t";
+                WriteResourceHeaders(vTypes[ixType], languages.bAllLanguages, out);
+                for (size_t ixInput : vShardInputs[shard])
+                {
+                    const std::wstring& sFilePath = vInputs[ixInput];
+                    auto itDecoded = decodedOutputs.find(ixInput);
+                    if (decodedOutputs.end() != itDecoded)
+                        WriteLinesWithPrefix(out, itDecoded->second[ixType], sFilePath + L'\t');
+                    else
+                        out << oldLines[sFilePath];
+                }
+                out.close();
+                bShardWritten = !out.fail() && RenameFilePath(sTempPath, sShardPath);
+            }
+            if (!bShardWritten)
+            {
+                DeleteFilePath(sTempPath);
+                err << L"Error writing file " << sShardPath << std::endl;
+                bWritten = false;
+            }
+        }
+        decodedOutputs.clear();
+        ++nShardsWritten;
+    };
+
+    uint64_t nChanged = 0;
+    const unsigned int nCorpusWorkers = CorpusWorkers(nWorkers, vReads.size(), true);
+    const corpuscache_t cache = CorpusCache(pCache, L"text", vTypes, languages);
+    FoldedSatellites folded(vInputs, languages);
+    ProcessFilesInOrder(
+        vReads,
+        nCorpusWorkers,
+        pCache,
+        [&](const std::wstring& sFilePath, TextArena& arena, corpusresult_t& result, const SplitFn_t& split)
+        {
+            const inputstate_t& input = vStates[inputIndexes.find(sFilePath)->second];
+            ExtractOneFile(
+                sFilePath, vTypes, languages, folded, nCorpusWorkers,
+                [&](const ResourceFile& rsrcFile, corpusresult_t& fileResult)
+                {
+                    bool bSatellite = false;
+                    rsrcFile.ForEachMappedFile([&](const std::wstring& sMappedPath, const uint8_t*, size_t)
+                        {
+                            manifestfile_t satellite;
+                            satellite.sFilePath = sMappedPath;
+                            if (bSatellite && GetFileStamp(sMappedPath, satellite.stamp))
+                                fileResult.vSatellites.push_back(satellite);
+                            bSatellite = true;
+                        });
+                    fileResult.vSatellitesNotOpened = rsrcFile.MuiFilesNotOpened();
+                    if (rsrcFile.ListedLanguageDirectories())
+                        fileResult.languageDirectoriesHash = LanguageDirectoriesHash(sFilePath);
+                    fileResult.contentHash = ContentHash(0, rsrcFile);
+                    if (nullptr != input.pOld && input.pOld->contentHash == fileResult.contentHash && !vShardMissing[input.shard])
+                    {
+                        fileResult.bUnchanged = true;
+                        return true;
+                    }
+                    return LoadCachedResult(cache, rsrcFile, vTypes.size(), nullptr, fileResult);
+                },
+                arena, result, split);
+        },
+        [&](size_t ixRead, corpusresult_t& result)
+        {
+            const size_t ixInput = vReadInputs[ixRead];
+            inputstate_t& input = vStates[ixInput];
+            while (nextShard < input.shard)
+                finishShard(nextShard++);
+
+            input.newEntry.file.sFilePath = vInputs[ixInput];
+            input.newEntry.file.stamp = input.stamp;
+            input.newEntry.shard = input.shard;
+            input.newEntry.contentHash = result.contentHash;
+            input.newEntry.vSatellites = std::move(result.vSatellites);
+            input.newEntry.vSatellitesNotOpened = std::move(result.vSatellitesNotOpened);
+            input.newEntry.languageDirectoriesHash = result.languageDirectoriesHash;
+            // A file that isn't a PE file, and wasn't one before (or is new), has no output either way.
+            const bool bNoOutput = 0 == result.contentHash && (nullptr == input.pOld || 0 == input.pOld->contentHash);
+            if (vShardMissing[input.shard] || !(result.bUnchanged || bNoOutput))
+            {
+                decodedOutputs[ixInput] = std::move(result.vOut);
+                vShardRewritten[input.shard] = true;
+                ++nChanged;
+            }
+            WriteLinesWithPrefix(err, result.sErr, escapeCrLfTabNul(vInputs[ixInput]) + L": ");
+        },
+        err);
+    while (nextShard < nShards)
+        finishShard(nextShard++);
+
+    // The manifest is written last, so that if the shards aren't all written, the next run reads the files again.
+    // If no file was read or removed, it's as it was.
+    CorpusManifest manifest;
+    manifest.Reset(optionsHash, nShards);
+    for (const inputstate_t& input : vStates)
+        manifest.Add(input.bRead ? input.newEntry : *input.pOld);
+    const bool bManifestChanged = !bOldManifest || !vReads.empty() || nRemoved > 0;
+    if (bWritten && bManifestChanged && !manifest.Write(sManifestPath, sErrorInfo))
+    {
+        err << sErrorInfo << std::endl;
+        bWritten = false;
+    }
+
+    err
+        << L"Manifest: " << vInputs.size() << L" files, " << vReads.size() << L" read, " << nChanged << L" changed, "
+        << nRemoved << L" removed; " << nShardsWritten << L" of " << nShards << L" shards written" << std::endl;
+    err.flush();
+    return bWritten;
+}
+
+bool CorpusRecordExtraction(
+    const std::vector<std::wstring>& vFiles,
+    const std::vector<rsrctype_t>& vTypes,
+    const languageoptions_t& languages,
+    unsigned int nWorkers,
+    ExtractionCache* pCache,
+    const CorpusRecordCallback_t& callback,
+    std::wostream& err)
+{
+    // Records are written from the file's arena into one record, whose strings are assigned in place.
+    resourcerecord_t record;
+    const corpuscache_t cache = CorpusCache(pCache, L"records", vTypes, languages);
+    FoldedSatellites folded(vFiles, languages);
+    ProcessFilesInOrder(
+        vFiles,
+        CorpusWorkers(nWorkers, vFiles.size(), false),
+        pCache,
+        [&](const std::wstring& sFilePath, TextArena&, corpusresult_t& result, const SplitFn_t&) { ExtractRecordsFromOneFile(sFilePath, vTypes, languages, folded, cache, nullptr, result); },
+        [&](size_t ixFile, corpusresult_t& result)
+        {
+            for (const arenarecord_t& item : result.vRecords)
+            {
+                record.type = item.type;
+                record.langId = item.langId;
+                record.resourceId = item.resourceId;
+                record.sResourceName.assign(item.resourceName.pChars, item.resourceName.nChars);
+                record.text.item = item.item;
+                record.text.id = item.id;
+                record.text.sText.assign(item.text.pChars, item.text.nChars);
+                record.text.sControlType.assign(item.controlType.pChars, item.controlType.nChars);
+                callback(vFiles[ixFile], record);
+            }
+            WriteLinesWithPrefix(err, result.sErr, escapeCrLfTabNul(vFiles[ixFile]) + L": ");
+        },
+        err);
+
+    err.flush();
+    return true;
+}
+
+bool CorpusNormalizedExtraction(
+    const std::vector<std::wstring>& vFiles,
+    const std::vector<rsrctype_t>& vTypes,
+    const languageoptions_t& languages,
+    unsigned int nWorkers,
+    ExtractionCache* pCache,
+    const normalizedoutputs_t& outs,
+    std::wostream& err)
+{
+    outs.references << L"Module ID\tType\tLanguage\tResource\tItem ID\tText ID\tControl type\n";
+    outs.texts << L"Text ID\tText\tText without accelerators\n";
+    outs.modules << L"Module ID\tFile path\n";
+
+    // Workers intern the text concurrently; IDs are assigned here, in file order, so that the output doesn't
+    // depend on which worker finishes first.
+    TextInternPool pool;
+    std::unordered_map<const internedtext_t*, uint32_t> textIds;
+    std::map<uint16_t, std::wstring> languageNames;
+    uint32_t nModules = 0;
+    uint64_t nItems = 0;
+    const corpuscache_t cache = CorpusCache(pCache, L"records", vTypes, languages);
+    FoldedSatellites folded(vFiles, languages);
+    ProcessFilesInOrder(
+        vFiles,
+        CorpusWorkers(nWorkers, vFiles.size(), false),
+        pCache,
+        [&](const std::wstring& sFilePath, TextArena&, corpusresult_t& result, const SplitFn_t&) { ExtractRecordsFromOneFile(sFilePath, vTypes, languages, folded, cache, &pool, result); },
+        [&](size_t ixFile, corpusresult_t& result)
+        {
+            const std::wstring sPathField = escapeCrLfTabNul(vFiles[ixFile]);
+            if (!result.vRecords.empty())
+                outs.modules << ++nModules << L"\t" << sPathField << L'\n';
+            for (const arenarecord_t& item : result.vRecords)
+            {
+                auto itText = textIds.emplace(item.pInterned, (uint32_t)textIds.size() + 1);
+                if (itText.second)
+                    outs.texts << itText.first->second << L"\t" << item.pInterned->text << L"\t" << item.pInterned->noAccels << L'\n';
+                auto itLanguage = languageNames.find(item.langId);
+                if (languageNames.end() == itLanguage)
+                    itLanguage = languageNames.emplace(item.langId, LangIdToName(item.langId)).first;
+
+                outs.references << nModules << L"\t" << ResourceExtractor(item.type).szName << L"\t" << itLanguage->second << L"\t";
+                if (item.resourceName.empty())
+                    outs.references << item.resourceId;
+                else
+                    outs.references << item.resourceName;
+                outs.references << L"\t";
+                if (textview_t::item_t::eId == item.item)
+                    outs.references << item.id;
+                outs.references << L"\t" << itText.first->second << L"\t" << item.controlType << L'\n';
+            }
+            nItems += result.vRecords.size();
+            WriteLinesWithPrefix(err, result.sErr, sPathField + L": ");
+        },
+        err);
+
+    bool bWritten = true;
+    for (std::wostream* pOut : { &outs.references, &outs.texts, &outs.modules })
+    {
+        if (pOut->flush().fail())
+            bWritten = false;
+    }
+    err
+        << L"Normalized output: " << nItems << L" items of text in " << nModules << L" files, "
+        << textIds.size() << L" distinct texts" << std::endl;
+    if (!bWritten)
+        err << L"Cannot write normalized output" << std::endl;
+    return bWritten;
+}
+
+bool CorpusValidation(
+    const std::vector<std::wstring>& vFiles,
+    const languageoptions_t& languages,
+    unsigned int nWorkers,
+    std::wostream& out,
+    std::wostream& err)
+{
+    const auto start = std::chrono::steady_clock::now();
+    out << L"File path\t";
+    WriteValidationHeaders(out);
+
+    validationstats_t stats;
+    FoldedSatellites folded(vFiles, languages);
+    ProcessFilesInOrder(
+        vFiles,
+        CorpusWorkers(nWorkers, vFiles.size(), false),
+        nullptr,
+        [&](const std::wstring& sFilePath, TextArena&, corpusresult_t& result, const SplitFn_t&)
+        {
+            std::wostringstream problems, fileErr;
+            ResourceFile rsrcFile;
+            result.stats.nFiles = 1;
+            if (OpenCorpusFile(rsrcFile, sFilePath, languages, folded, fileErr))
+            {
+                result.stats.nPEFiles = 1;
+                ValidateResources(rsrcFile, problems, result.stats);
+            }
+            result.vOut.push_back(problems.str());
+            result.sErr = fileErr.str();
+        },
+        [&](size_t ixFile, corpusresult_t& result)
+        {
+            const std::wstring sPathField = escapeCrLfTabNul(vFiles[ixFile]);
+            WriteLinesWithPrefix(out, result.vOut[0], sPathField + L'\t');
+            WriteLinesWithPrefix(err, result.sErr, sPathField + L": ");
+            stats.Add(result.stats);
+        },
+        err);
+
+    out.flush();
+    WriteValidationSummary(stats, std::chrono::steady_clock::now() - start, err);
+    err.flush();
+
+    uint64_t nProblems = stats.nDirectoryProblems;
+    for (const validationstats_t::typestats_t& typeStats : stats.vTypes)
+        nProblems += typeStats.nProblems;
+    return 0 == nProblems;
+}
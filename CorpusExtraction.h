@@ -0,0 +1,169 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "ExtractionCache.h"
+#include "ResourceExtraction.h"
+#include "TextRecord.h"
+
+/// <summary>
+/// Extracts the text of one or more resource types from many resource files using a pool of worker threads.
+/// For each resource type, writes one combined tab-delimited output: the type's headers preceded by a
+/// "File path" column, then each file's rows preceded by that file's path. Files are reported in the
+/// order given, regardless of which worker finishes first.
+///
+/// Workers that run out of files steal from the others (see WorkStealingPool), and a file with at least
+/// cbParallelDecodingThreshold bytes of resource data is split into runs of resources that idle workers can
+/// steal, so that a few large files don't keep one worker busy long after the rest are done. When done, writes
+/// each worker's utilization to the error stream; the other corpus functions do too.
+///
+/// With an extraction cache, a file whose content, .mui satellite files, and options match an entry in the cache
+/// gets its output from the entry instead of being decoded; other files' output is stored in the cache.
+/// CorpusRecordExtraction and CorpusNormalizedExtraction use the cache the same way, sharing entries.
+///
+/// Files that aren't PE files, or that don't contain the resource types, are skipped silently, as is a .mui
+/// satellite file that a language-neutral file among the files is opened with, since its text is reported with
+/// that file's path. Other errors are written to the error stream, each line prefixed with the file path.
+/// </summary>
+/// <param name="vFiles">Input: paths of the files to inspect</param>
+/// <param name="vTypes">Input: the resource types to extract</param>
+/// <param name="languages">Input: which languages to extract</param>
+/// <param name="nWorkers">Input: number of worker threads; 0 for one per hardware thread</param>
+/// <param name="pCache">Input: the extraction cache to use, or nullptr for none</param>
+/// <param name="vOuts">Input: output stream for each resource type</param>
+/// <param name="err">The error stream to write diagnostic information into</param>
+/// <returns>true if every type's output was written, false otherwise.</returns>
+bool CorpusExtraction(
+    const std::vector<std::wstring>& vFiles,
+    const std::vector<rsrctype_t>& vTypes,
+    const languageoptions_t& languages,
+    unsigned int nWorkers,
+    ExtractionCache* pCache,
+    const std::vector<std::wostream*>& vOuts,
+    std::wostream& err);
+
+/// <summary>
+/// Extracts text from many resource files as CorpusExtraction does, but into a directory that keeps the output
+/// between runs, and on later runs decodes only the files that have changed. The output for each resource type is
+/// split into shards (e.g., strings-0000.txt, strings-0001.txt), each with the type's headers and the rows of the
+/// files whose paths hash to it, in the order given. The directory's manifest.txt records each file's size,
+/// last-write time, content hash, and shard, and those of the .mui satellite files it was opened with, and the
+/// satellite files that were looked for and not found (see CorpusManifest). Files with CR, LF, TAB, or NUL in their
+/// paths are skipped, with an error.
+///
+/// A rerun gets the size and last-write time of every file, and reads only files that are new or differ from the
+/// manifest, or that might now be opened with other satellites: a satellite that wasn't found is there, or with all
+/// languages, a language subdirectory has been added or removed. Those are hashed, and decoded only if their
+/// content has changed. Only the shards with changed, new, or removed files are rewritten, with the other files'
+/// rows copied from the shard as it was. Each shard and the manifest are written to a temporary file and renamed
+/// into place; the manifest goes last, so an interrupted run leaves files to be read again rather than shards that
+/// don't match it. If the options differ from the manifest's, or the number of files calls for less than half or
+/// more than twice the manifest's number of shards (64 files per shard), every file is extracted again.
+///
+/// Writes the numbers of files read, changed, and removed, and of shards written, to the error stream.
+/// </summary>
+/// <param name="vFiles">Input: paths of the files to inspect</param>
+/// <param name="vTypes">Input: the resource types to extract</param>
+/// <param name="languages">Input: which languages to extract</param>
+/// <param name="nWorkers">Input: number of worker threads; 0 for one per hardware thread</param>
+/// <param name="pCache">Input: the extraction cache to use, or nullptr for none</param>
+/// <param name="sOutDirectory">Input: directory for the output shards and the manifest, created if need be</param>
+/// <param name="err">The error stream to write diagnostic information into</param>
+/// <returns>true if the shards and the manifest were written, false otherwise.</returns>
+bool IncrementalCorpusExtraction(
+    const std::vector<std::wstring>& vFiles,
+    const std::vector<rsrctype_t>& vTypes,
+    const languageoptions_t& languages,
+    unsigned int nWorkers,
+    ExtractionCache* pCache,
+    const std::wstring& sOutDirectory,
+    std::wostream& err);
+
+/// <summary>
+/// Callback for corpus record extraction, called with the file path and each item of text.
+/// </summary>
+typedef std::function<void(const std::wstring& sFilePath, const resourcerecord_t& record)> CorpusRecordCallback_t;
+
+/// <summary>
+/// Decodes the text of one or more resource types from many resource files using a pool of worker threads,
+/// as CorpusExtraction does, but reports each item of text to the callback instead of writing tab-delimited text.
+/// The callback is called on the calling thread, with files in the order given.
+/// </summary>
+/// <param name="vFiles">Input: paths of the files to inspect</param>
+/// <param name="vTypes">Input: the resource types to extract</param>
+/// <param name="languages">Input: which languages to extract</param>
+/// <param name="nWorkers">Input: number of worker threads; 0 for one per hardware thread</param>
+/// <param name="pCache">Input: the extraction cache to use, or nullptr for none</param>
+/// <param name="callback">Input: function to call with each item of text</param>
+/// <param name="err">The error stream to write diagnostic information into</param>
+/// <returns>true if successful, false otherwise.</returns>
+bool CorpusRecordExtraction(
+    const std::vector<std::wstring>& vFiles,
+    const std::vector<rsrctype_t>& vTypes,
+    const languageoptions_t& languages,
+    unsigned int nWorkers,
+    ExtractionCache* pCache,
+    const CorpusRecordCallback_t& callback,
+    std::wostream& err);
+
+/// <summary>
+/// Output streams of normalized corpus extraction.
+/// </summary>
+struct normalizedoutputs_t
+{
+    // A line for each item of text, referring to its module and its text by ID
+    std::wostream& references;
+    // A line for each distinct text
+    std::wostream& texts;
+    // A line for each file with text
+    std::wostream& modules;
+};
+
+/// <summary>
+/// Extracts the text of one or more resource types from many resource files using a pool of worker threads, as
+/// CorpusExtraction does, but writes each distinct text only once. The same texts ("OK", "Cancel", standard error
+/// messages) recur across the dialogs and string tables of a Windows image, so this output is much smaller.
+///
+/// Writes three tab-delimited outputs, each with headers:
+///   references: Module ID, Type, Language, Resource, Item ID (empty for dialog captions and menu popups),
+///               Text ID, and Control type (for dialog controls)
+///   texts:      Text ID, and the text with CR, LF, TAB, and NUL escaped, with and without accelerators
+///   modules:    Module ID, and the file path
+/// IDs start at 1 and are assigned in file order, so the output doesn't depend on the number of workers.
+/// Writes the numbers of items and of distinct texts to the error stream.
+/// </summary>
+/// <param name="vFiles">Input: paths of the files to inspect</param>
+/// <param name="vTypes">Input: the resource types to extract</param>
+/// <param name="languages">Input: which languages to extract</param>
+/// <param name="nWorkers">Input: number of worker threads; 0 for one per hardware thread</param>
+/// <param name="pCache">Input: the extraction cache to use, or nullptr for none</param>
+/// <param name="outs">Input: the output streams</param>
+/// <param name="err">The error stream to write diagnostic information into</param>
+/// <returns>true if all three outputs were written, false otherwise.</returns>
+bool CorpusNormalizedExtraction(
+    const std::vector<std::wstring>& vFiles,
+    const std::vector<rsrctype_t>& vTypes,
+    const languageoptions_t& languages,
+    unsigned int nWorkers,
+    ExtractionCache* pCache,
+    const normalizedoutputs_t& outs,
+    std::wostream& err);
+
+/// <summary>
+/// Validates the resources of many resource files using a pool of worker threads (see ValidateResources):
+/// decodes every string table, dialog, message table, and menu resource, and writes a tab-delimited line for
+/// each problem found, preceded by the file path, in file order. Then writes a summary with each decoder's
+/// throughput to the error stream.
+/// </summary>
+/// <param name="vFiles">Input: paths of the files to inspect</param>
+/// <param name="languages">Input: which languages to inspect</param>
+/// <param name="nWorkers">Input: number of worker threads; 0 for one per hardware thread</param>
+/// <param name="out">The output stream to write problems into</param>
+/// <param name="err">The error stream to write diagnostic information and the summary into</param>
+/// <returns>true if no problems were found, false otherwise.</returns>
+bool CorpusValidation(
+    const std::vector<std::wstring>& vFiles,
+    const languageoptions_t& languages,
+    unsigned int nWorkers,
+    std::wostream& out,
+    std::wostream& err);
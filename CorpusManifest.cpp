@@ -0,0 +1,173 @@
+#include "PlatformDefs.h"
+#include <cwchar>
+#include <iomanip>
+#include "CorpusManifest.h"
+#include "ExtractionCache.h"
+#include "FileOutput.h"
+#include "StringUtils.h"
+
+/// <summary>
+/// First field of a manifest's first line, to tell a manifest from other files.
+/// </summary>
+static const wchar_t* const szManifestSignature = L"GetLocalizedResources manifest";
+
+/// <summary>
+/// Parses a number in the given base that takes up the whole field.
+/// </summary>
+static bool ParseManifestNumber(const std::wstring& sField, int base, uint64_t& value)
+{
+    if (sField.empty())
+        return false;
+    wchar_t* szEnd = nullptr;
+    value = wcstoull(sField.c_str(), &szEnd, base);
+    return nullptr != szEnd && 0 == *szEnd;
+}
+
+CorpusManifest::CorpusManifest() :
+    m_optionsHash(0),
+    m_nShards(1)
+{
+}
+
+void CorpusManifest::Reset(uint64_t optionsHash, uint32_t nShards)
+{
+    m_optionsHash = optionsHash;
+    m_nShards = nShards;
+    m_vEntries.clear();
+    m_entryIndexes.clear();
+}
+
+bool CorpusManifest::Read(const std::wstring& sFilePath, std::wstring& sErrorInfo)
+{
+    std::vector<std::wstring> vLines;
+    if (!IsFilePath(sFilePath) || !ReadFileList(sFilePath, vLines, sErrorInfo))
+    {
+        sErrorInfo = L"Cannot read manifest " + sFilePath;
+        return false;
+    }
+
+    std::vector<std::wstring> vFields;
+    uint64_t optionsHash = 0, nShards = 0;
+    if (vLines.size() < 2)
+    {
+        sErrorInfo = L"Not a manifest: " + sFilePath;
+        return false;
+    }
+    SplitStringToVector(vLines[0], L'\t', vFields);
+    if (3 != vFields.size() || szManifestSignature != vFields[0] ||
+        !ParseManifestNumber(vFields[1], 16, optionsHash) || !ParseManifestNumber(vFields[2], 10, nShards) ||
+        0 == nShards || nShards > 0xFFFFFFFF)
+    {
+        sErrorInfo = L"Not a manifest: " + sFilePath;
+        return false;
+    }
+    Reset(optionsHash, (uint32_t)nShards);
+
+    // After the headers, a line for each input file, then a line for each of its satellites, then a line for each
+    // satellite that wasn't found. (A manifest from before the last column was added has only five.)
+    for (size_t ixLine = 2; ixLine < vLines.size(); ++ixLine)
+    {
+        SplitStringToVector(vLines[ixLine], L'\t', vFields);
+        manifestfile_t file;
+        uint64_t shard = 0, contentHash = 0, languageDirectoriesHash = 0;
+        bool bValid = 5 == vFields.size() || 6 == vFields.size();
+        const bool bNotOpened = bValid && vFields[1].empty() && vFields[2].empty() && vFields[3].empty();
+        if (bValid && !bNotOpened)
+            bValid = ParseManifestNumber(vFields[2], 10, file.stamp.size) && ParseManifestNumber(vFields[3], 10, file.stamp.modified);
+        const bool bSatellite = bValid && vFields[1].empty();
+        if (bValid && !bSatellite)
+        {
+            bValid =
+                ParseManifestNumber(vFields[1], 10, shard) && shard < nShards &&
+                (vFields[4].empty() || ParseManifestNumber(vFields[4], 16, contentHash)) &&
+                (5 == vFields.size() || vFields[5].empty() || ParseManifestNumber(vFields[5], 16, languageDirectoriesHash));
+        }
+        if (!bValid || (bSatellite && m_vEntries.empty()))
+        {
+            sErrorInfo = L"Invalid line " + std::to_wstring(ixLine + 1) + L" in manifest " + sFilePath;
+            return false;
+        }
+
+        file.sFilePath = vFields[0];
+        if (bNotOpened)
+        {
+            m_vEntries.back().vSatellitesNotOpened.push_back(file.sFilePath);
+        }
+        else if (bSatellite)
+        {
+            m_vEntries.back().vSatellites.push_back(file);
+        }
+        else
+        {
+            manifestentry_t entry;
+            entry.file = file;
+            entry.shard = (uint32_t)shard;
+            entry.contentHash = contentHash;
+            entry.languageDirectoriesHash = languageDirectoriesHash;
+            Add(entry);
+        }
+    }
+    return true;
+}
+
+bool CorpusManifest::Write(const std::wstring& sFilePath, std::wstring& sErrorInfo) const
+{
+    const std::wstring sTempPath = sFilePath + L".tmp";
+    Utf8FileOutput out;
+    if (!CreateFileOutput(sTempPath.c_str(), out))
+    {
+        sErrorInfo = L"Cannot create file " + sTempPath;
+        return false;
+    }
+
+    out << szManifestSignature << L'\t' << std::hex << std::setfill(L'0') << std::setw(16) << m_optionsHash << std::dec << L'\t' << m_nShards << L'\n';
+    out << L"File path\tShard\tSize\tModified\tContent hash\tLanguage directories\n";
+    for (const manifestentry_t& entry : m_vEntries)
+    {
+        out << entry.file.sFilePath << L'\t' << entry.shard << L'\t' << entry.file.stamp.size << L'\t' << entry.file.stamp.modified << L'\t';
+        if (0 != entry.contentHash)
+            out << std::hex << std::setw(16) << entry.contentHash << std::dec;
+        out << L'\t';
+        if (0 != entry.languageDirectoriesHash)
+            out << std::hex << std::setw(16) << entry.languageDirectoriesHash << std::dec;
+        out << L'\n';
+        for (const manifestfile_t& satellite : entry.vSatellites)
+            out << satellite.sFilePath << L"\t\t" << satellite.stamp.size << L'\t' << satellite.stamp.modified << L"\t\t\n";
+        for (const std::wstring& sNotOpened : entry.vSatellitesNotOpened)
+            out << sNotOpened << L"\t\t\t\t\t\n";
+    }
+    out.close();
+    if (out.fail() || !RenameFilePath(sTempPath, sFilePath))
+    {
+        DeleteFilePath(sTempPath);
+        sErrorInfo = L"Error writing file " + sFilePath;
+        return false;
+    }
+    return true;
+}
+
+void CorpusManifest::Add(const manifestentry_t& entry)
+{
+    auto it = m_entryIndexes.emplace(entry.file.sFilePath, m_vEntries.size());
+    if (it.second)
+        m_vEntries.push_back(entry);
+    else
+        m_vEntries[it.first->second] = entry;
+}
+
+const manifestentry_t* CorpusManifest::Find(const std::wstring& sFilePath) const
+{
+    auto it = m_entryIndexes.find(sFilePath);
+    return (m_entryIndexes.end() == it) ? nullptr : &m_vEntries[it->second];
+}
+
+uint32_t ShardForPath(const std::wstring& sFilePath, uint32_t nShards)
+{
+    return (uint32_t)(HashContent(sFilePath.data(), sFilePath.length() * sizeof(wchar_t), 0) % nShards);
+}
+
+bool IsManifestPath(const std::wstring& sFilePath)
+{
+    static const std::wstring sSeparators(L"\r\n\t\0", 4);
+    return std::wstring::npos == sFilePath.find_first_of(sSeparators);
+}
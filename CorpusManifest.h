@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "FileEnumeration.h"
+
+/// <summary>
+/// A file that a corpus input's output depends on: the input itself, or a .mui satellite file it was opened with.
+/// </summary>
+struct manifestfile_t
+{
+    std::wstring sFilePath;
+    filestamp_t stamp;
+};
+
+/// <summary>
+/// One input file of an incremental corpus extraction.
+/// </summary>
+struct manifestentry_t
+{
+    manifestfile_t file;
+    // Output shard that has the file's text
+    uint32_t shard = 0;
+    // Hash of the content of the file and its satellites, or 0 if it isn't a PE file
+    uint64_t contentHash = 0;
+    std::vector<manifestfile_t> vSatellites;
+    // Paths of .mui satellite files that were looked for and not opened (see ResourceFile::MuiFilesNotOpened):
+    // the file is read again if one of them appears
+    std::vector<std::wstring> vSatellitesNotOpened;
+    // For a language-neutral file opened for all languages, a hash of the names of the language-named
+    // subdirectories its satellites were looked for in, so that the file is read again when a language's
+    // subdirectory is added or removed; otherwise 0
+    uint64_t languageDirectoriesHash = 0;
+};
+
+/// <summary>
+/// Manifest of an incremental corpus extraction (see IncrementalCorpusExtraction): for each input file, its path,
+/// size, last-write time, content hash, and output shard, and the same for the .mui satellite files it was opened
+/// with, along with the satellite files that were looked for and not found, and for a language-neutral file opened
+/// for all languages, a hash of the language subdirectories' names. A rerun compares each file's size and
+/// last-write time with the manifest's, and reads only the files that differ or whose satellites might, to see
+/// whether their content has changed.
+///
+/// The manifest is UTF-8 tab-delimited text: a line with the hash of the options and the number of shards, then
+/// headers, then a line for each input file, each followed by a line for each of its satellites, with no shard or
+/// content hash, then a line for each satellite looked for and not found, with only its path. Paths are written as
+/// they are, so a path can't have CR, LF, TAB, or NUL in it (see IsManifestPath).
+/// </summary>
+class CorpusManifest
+{
+public:
+    CorpusManifest();
+
+    /// <summary>
+    /// Reads a manifest written by Write.
+    /// </summary>
+    /// <param name="sFilePath">Input: path of the manifest file</param>
+    /// <param name="sErrorInfo">Output: diagnostic information on failure</param>
+    /// <returns>true if successful, false if the file doesn't exist or isn't a manifest</returns>
+    bool Read(const std::wstring& sFilePath, std::wstring& sErrorInfo);
+
+    /// <summary>
+    /// Writes the manifest to a temporary file and renames it into place, so that the file is always a complete
+    /// manifest, the old one or the new one.
+    /// </summary>
+    /// <param name="sFilePath">Input: path of the manifest file</param>
+    /// <param name="sErrorInfo">Output: diagnostic information on failure</param>
+    /// <returns>true if successful, false otherwise</returns>
+    bool Write(const std::wstring& sFilePath, std::wstring& sErrorInfo) const;
+
+    /// <summary>
+    /// Adds an entry, or replaces the entry with the same path.
+    /// </summary>
+    void Add(const manifestentry_t& entry);
+
+    /// <summary>
+    /// Returns the entry for a path, or nullptr if there isn't one.
+    /// </summary>
+    const manifestentry_t* Find(const std::wstring& sFilePath) const;
+
+    const std::vector<manifestentry_t>& Entries() const { return m_vEntries; }
+
+    /// <summary>
+    /// Starts an empty manifest for an extraction with the options and number of shards.
+    /// </summary>
+    void Reset(uint64_t optionsHash, uint32_t nShards);
+
+    // Hash of the options of the extraction: an extraction with other options can't use the manifest's results
+    uint64_t OptionsHash() const { return m_optionsHash; }
+    uint32_t Shards() const { return m_nShards; }
+
+private:
+    uint64_t m_optionsHash;
+    uint32_t m_nShards;
+    std::vector<manifestentry_t> m_vEntries;
+    std::unordered_map<std::wstring, size_t> m_entryIndexes;
+};
+
+/// <summary>
+/// Indicates whether a path can be recorded in a manifest, and in the first column of an incremental extraction's
+/// shards: not if it has CR, LF, TAB, or NUL in it, which separate fields and lines.
+/// </summary>
+bool IsManifestPath(const std::wstring& sFilePath);
+
+/// <summary>
+/// Returns the shard for an input file: a hash of its path, so that a file stays in its shard as other files
+/// come and go.
+/// </summary>
+uint32_t ShardForPath(const std::wstring& sFilePath, uint32_t nShards);
@@ -1,9 +1,11 @@
-#include <Windows.h>
+#include "PlatformDefs.h"
+#include <cstddef>
 #include <iostream>
 #include <sstream>
 #include "DialogTextExtraction.h"
-#include "SysErrorMessage.h"
+#include "ResourceExtraction.h"
 #include "UtilityFunctions.h"
+#include "ResourceCursor.h"
 #include "ResourceDefs.h"
 
 /*
@@ -38,464 +40,310 @@ const wchar_t* const sz_Dialog_ = L"[Dialog]";
 const wchar_t* const sz_Caption_ = L"[Caption]";
 
 /// <summary>
-/// Returns true if the pointed-to resource has the signature of an extended dialog template.
+/// Returns true if the resource has the signature of an extended dialog template.
 /// </summary>
-static bool IsExtendedDialogTemplate(LPVOID pResource)
+static bool IsExtendedDialogTemplate(const ResourceEntry_t& entry)
 {
-    WORD* pWord = (WORD*)pResource;
-    if (*pWord++ != 1)
-        return false;
-    if (*pWord != 0xffff)
-        return false;
-    return true;
+    CheckedResourceCursor cursor(entry.pData, entry.cbData);
+    WORD dlgVer = 0, signature = 0;
+    return cursor.Read(dlgVer) && cursor.Read(signature) && 1 == dlgVer && 0xffff == signature;
 }
 
 /// <summary>
-/// Given the address of a "sz_Or_Ord," return the memory address immediately following it.
+/// Names the type of a control of a predefined window class from its style, e.g., "Checkbox".
+/// Returns nullptr for a class name, or for an ordinal that isn't a predefined class.
 /// </summary>
-static inline uint16_t* Uint16AfterSzOrOrd(uint16_t* pMem)
+static const wchar_t* PredefinedControlType(const szorord_t& windowClass, uint32_t style)
 {
-    uint16_t w0 = *pMem;
-    switch (w0)
+    if (!windowClass.bOrdinal)
+        return nullptr;
+    switch (windowClass.ordinal)
     {
-    case 0x0000:
-        return pMem + 1;
-    case 0xffff:
-        return pMem + 2;
-    default:
-        while (0 != *pMem++)
-            ;
-        return pMem;
+    case 0x0080:
+        switch (style & BS_TYPEMASK)
+        {
+        case BS_3STATE:
+        case BS_CHECKBOX:
+        case BS_AUTO3STATE:
+        case BS_AUTOCHECKBOX:
+            return L"Checkbox";
+        case BS_RADIOBUTTON:
+        case BS_AUTORADIOBUTTON:
+            return L"Radio button";
+        case BS_GROUPBOX:
+            return L"Group box";
+        default:
+            return L"Button";
+        }
+    case 0x0081: return L"Edit";
+    case 0x0082: return L"Static";
+    case 0x0083: return L"List box";
+    case 0x0084: return L"Scroll bar";
+    case 0x0085: return L"Combo box";
+    default: return nullptr;
     }
 }
 
 /// <summary>
-/// Given the address of a zero-terminated wide-character string, return the memory address immediately following it.
+/// Names the type of a dialog control from its window class and style, e.g., "Checkbox".
 /// </summary>
-static inline uint16_t* Uint16AfterSz(uint16_t* pMem)
+std::wstring DialogControlType(const szorord_t& windowClass, uint32_t style)
 {
-    while (0 != *pMem++)
-        ;
-    return pMem;
+    const wchar_t* szType = PredefinedControlType(windowClass, style);
+    if (nullptr != szType)
+        return szType;
+    if (windowClass.bOrdinal)
+        return L"Ordinal " + std::to_wstring(windowClass.ordinal);
+    return windowClass.sz.str();
 }
 
-static inline std::wstring WindowClassName(const uint16_t* pMem, DWORD dwStyle)
+arenatext_t DialogControlType(TextArena& arena, const szorord_t& windowClass, uint32_t style)
 {
-    if (0xFFFF == *pMem)
-    {
-        switch (pMem[1])
-        {
-        case 0x0080:
-            switch (dwStyle & BS_TYPEMASK)
-            {
-            case BS_3STATE:
-            case BS_CHECKBOX:
-            case BS_AUTO3STATE:
-            case BS_AUTOCHECKBOX:
-                return L"Checkbox";
-            case BS_RADIOBUTTON:
-            case BS_AUTORADIOBUTTON:
-                return L"Radio button";
-            case BS_GROUPBOX:
-                return L"Group box";
-            default:
-                return L"Button";
-            }
-        case 0x0081: return L"Edit";
-        case 0x0082: return L"Static";
-        case 0x0083: return L"List box";
-        case 0x0084: return L"Scroll bar";
-        case 0x0085: return L"Combo box";
-        default: 
-            {
-            std::wstringstream str;
-            str << L"Ordinal " << pMem[1];
-            return str.str();
-            }
-        }
-    }
-    else
+    const wchar_t* szType = PredefinedControlType(windowClass, style);
+    if (nullptr != szType)
+        return arenatext_t(szType, wcslen(szType));
+    if (windowClass.bOrdinal)
     {
-        return (const wchar_t*)pMem;
+        // "Ordinal " and up to five digits, and the terminator that swprintf writes
+        const size_t nMaxChars = 14;
+        wchar_t* pChars = arena.Allocate(nMaxChars);
+        const int nChars = swprintf(pChars, nMaxChars, L"Ordinal %u", (unsigned int)windowClass.ordinal);
+        return arenatext_t(pChars, nChars > 0 ? (size_t)nChars : 0);
     }
+    return ArenaText(arena, windowClass.sz);
 }
 
 /// <summary>
 /// Process an extended dialog template.
-/// Output a line of tab-delimited information for non-empty dialog caption and item text.
+/// Report the dialog caption and item text, if not empty.
 /// </summary>
-/// <param name="lpName"></param>
-/// <param name="pResource"></param>
-/// <param name="dwResourceSize"></param>
-/// <param name="out"></param>
-/// <param name="err"></param>
-/// <returns></returns>
-static bool ProcessExtendedDialogTemplate(LPCWSTR lpName, LPVOID pResource, DWORD dwResourceSize, std::wostream& out, std::wostream& err)
+/// <param name="cursor">Cursor at the beginning of the dialog template</param>
+/// <param name="entry">The dialog resource, for the visitor</param>
+/// <param name="visitor">Visitor to report the text to</param>
+/// <returns>false if the template extends beyond the resource</returns>
+static bool DecodeExtendedDialogTemplate(CheckedResourceCursor& cursor, const ResourceEntry_t& entry, ResourceVisitor& visitor)
 {
-    UNREFERENCED_PARAMETER(err);
-    //TODO: Need to make sure not to look beyond size of resource.
-    UNREFERENCED_PARAMETER(dwResourceSize);
-
-    // Point to the beginning of the dialog template
-    DLGTEMPLATEEX_1* pDlgTemplateEx1 = (DLGTEMPLATEEX_1*)pResource;
-    WORD nDlgItems = pDlgTemplateEx1->cDlgItems;
-    // Point to dialog's window class:
-    uint16_t* pMem = Uint16AfterSzOrOrd(pDlgTemplateEx1->menu);
-    // Point to dialog's title/caption
-    pMem = Uint16AfterSzOrOrd(pMem);
+    // The fixed part of the dialog template, before the menu
+    DLGTEMPLATEEX_1 dlgTemplateEx1;
+    if (!cursor.Struct(dlgTemplateEx1, offsetof(DLGTEMPLATEEX_1, menu)))
+        return false;
+    WORD nDlgItems = dlgTemplateEx1.cDlgItems;
+    // Skip the menu and the dialog's window class
+    szorord_t menu, windowClass, title;
+    cursor.ReadSzOrOrd(menu);
+    cursor.ReadSzOrOrd(windowClass);
+    // Dialog's title/caption
+    utf16view_t caption;
+    if (!cursor.ReadSz(caption))
+        return false;
     // Output line if the title/caption is not empty
-    if (0x0000 != *pMem)
+    if (!caption.empty())
     {
-        std::wstring sText = escapeCrLfTab((const wchar_t*)pMem);
-        out
-            << RSRCID_t(lpName) << L"\t"
-            << sz_Caption_ << L"\t"
-            << RemoveAccelsFromText(sText) << L"\t"
-            << sText << L"\t"
-            << sz_Dialog_
-            << std::endl;
+        textview_t text;
+        text.item = textview_t::item_t::eCaption;
+        text.text = caption;
+        visitor.Visit(entry, text);
     }
-    // Point to pointsize, weight, etc. after title
-    pMem = Uint16AfterSz(pMem);
     // Skip over pointsize, weight, italic, charset
-    pMem += 3;
-    if (0 != (pDlgTemplateEx1->style & (DS_SETFONT | DS_SHELLFONT)))
+    cursor.Skip(3 * sizeof(WORD));
+    if (0 != (dlgTemplateEx1.style & (DS_SETFONT | DS_SHELLFONT)))
     {
         // skip over typeface
-        pMem = Uint16AfterSz(pMem);
+        utf16view_t typeface;
+        cursor.ReadSz(typeface);
     }
 
     // Dialog items
     for (WORD ixDlgItem = 0; ixDlgItem < nDlgItems; ++ixDlgItem)
     {
         // Each DLGITEMTEMPLATEEX must be aligned on a four-byte boundary
-        while (0 != ((unsigned long long)pMem & 0x03))
-            pMem++;
-
-        // Get the beginning of the dialog item template:
-        DLGITEMTEMPLATEEX_1* pDlgItemEx1 = (DLGITEMTEMPLATEEX_1*)pMem;
-        // Point to dialog item's title/text (after its window class)
-        pMem = Uint16AfterSzOrOrd(pDlgItemEx1->windowClass);
-        // Output a line if it's a zero-terminated string
-        if (0x0000 != *pMem && 0xFFFF != *pMem)
+        cursor.AlignTo(4);
+
+        // The fixed part of the dialog item template, followed by its window class and title/text
+        DLGITEMTEMPLATEEX_1 dlgItemEx1;
+        cursor.Struct(dlgItemEx1, offsetof(DLGITEMTEMPLATEEX_1, windowClass));
+        if (!cursor.ReadSzOrOrd(windowClass) || !cursor.ReadSzOrOrd(title))
+            return false;
+        // Output a line if it's a non-empty string
+        if (!title.bOrdinal && !title.sz.empty())
         {
-            std::wstring sText = escapeCrLfTab((const wchar_t*)pMem);
-            out
-                << RSRCID_t(lpName) << L"\t"
-                << (long)pDlgItemEx1->id << L"\t"
-                << RemoveAccelsFromText(sText) << L"\t"
-                << sText << L"\t"
-                << WindowClassName(pDlgItemEx1->windowClass, pDlgItemEx1->style)
-                << std::endl;
+            textview_t text;
+            text.id = (long)dlgItemEx1.id;
+            text.text = title.sz;
+            text.windowClass = windowClass;
+            text.style = dlgItemEx1.style;
+            visitor.Visit(entry, text);
         }
         // Get to and through the extraCount
-        pMem = Uint16AfterSzOrOrd(pMem);
-        WORD cbExtra = *pMem++;
-        pMem += (cbExtra / 2);
+        WORD cbExtra = 0;
+        cursor.Read(cbExtra);
+        cursor.Skip((cbExtra / 2) * sizeof(WORD));
     }
 
-    return true;
+    return !cursor.Failed();
 }
 
 /// <summary>
 /// Process a standard/"classic" dialog template.
-/// Output a line of tab-delimited information for non-empty dialog caption and item text.
+/// Report the dialog caption and item text, if not empty.
 /// </summary>
-/// <param name="lpName"></param>
-/// <param name="pResource"></param>
-/// <param name="dwResourceSize"></param>
-/// <param name="out"></param>
-/// <param name="err"></param>
-/// <returns></returns>
-static bool ProcessStandardDialogTemplate(LPCWSTR lpName, LPVOID pResource, DWORD dwResourceSize, std::wostream& out, std::wostream& err)
+/// <param name="cursor">Cursor at the beginning of the dialog template</param>
+/// <param name="entry">The dialog resource, for the visitor</param>
+/// <param name="visitor">Visitor to report the text to</param>
+/// <returns>false if the template extends beyond the resource</returns>
+static bool DecodeStandardDialogTemplate(CheckedResourceCursor& cursor, const ResourceEntry_t& entry, ResourceVisitor& visitor)
 {
-    UNREFERENCED_PARAMETER(err);
-    //TODO: Need to make sure not to look beyond size of resource.
-    UNREFERENCED_PARAMETER(dwResourceSize);
-
-    // Point to the beginning of the dialog template
-    DLGTEMPLATE* pDlgTemplate = (DLGTEMPLATE*)pResource;
-    WORD nDlgItems = pDlgTemplate->cdit;
-    // Point to Menu designation after declared structure
-    uint16_t* pMem = (uint16_t*)(pDlgTemplate + 1);
-    // Point to dialog's window class
-    pMem = Uint16AfterSzOrOrd(pMem);
-    // Point to dialog's title/caption
-    pMem = Uint16AfterSzOrOrd(pMem);
+    // The fixed part of the dialog template, before the menu
+    DLGTEMPLATE dlgTemplate;
+    if (!cursor.Struct(dlgTemplate))
+        return false;
+    WORD nDlgItems = dlgTemplate.cdit;
+    // Skip the menu and the dialog's window class
+    szorord_t menu, windowClass, title;
+    cursor.ReadSzOrOrd(menu);
+    cursor.ReadSzOrOrd(windowClass);
+    // Dialog's title/caption
+    utf16view_t caption;
+    if (!cursor.ReadSz(caption))
+        return false;
     // Output line if the title/caption is not empty
-    if (0x0000 != *pMem)
+    if (!caption.empty())
     {
-        std::wstring sText = escapeCrLfTab((const wchar_t*)pMem);
-        out
-            << RSRCID_t(lpName) << L"\t"
-            << sz_Caption_ << L"\t"
-            << RemoveAccelsFromText(sText) << L"\t"
-            << sText << L"\t"
-            << sz_Dialog_
-            << std::endl;
+        textview_t text;
+        text.item = textview_t::item_t::eCaption;
+        text.text = caption;
+        visitor.Visit(entry, text);
     }
-    // Point to memory after title
-    pMem = Uint16AfterSz(pMem);
-    // if DS_SETFONT is set, move pointer past the font size and name.
-    if (0 != (pDlgTemplate->style & DS_SETFONT))
+    // if DS_SETFONT is set, move past the font size and name.
+    if (0 != (dlgTemplate.style & DS_SETFONT))
     {
-        pMem = Uint16AfterSz(pMem + 1);
+        utf16view_t typeface;
+        cursor.Skip(sizeof(WORD));
+        cursor.ReadSz(typeface);
     }
 
     // Dialog items
     for (WORD ixDlgItem = 0; ixDlgItem < nDlgItems; ++ixDlgItem)
     {
         // Each DLGITEMTEMPLATE must be aligned on a four-byte boundary
-        while (0 != ((unsigned long long)pMem & 0x03))
-            pMem++;
+        cursor.AlignTo(4);
 
-        // Get the beginning of the dialog item template:
-        DLGITEMTEMPLATE* pDlgItem = (DLGITEMTEMPLATE*)pMem;
-        // Point to the item's window class
-        pMem = (uint16_t*)(pDlgItem + 1);
-        std::wstring sWindowClassName = WindowClassName(pMem, pDlgItem->style);
-        // Point to dialog item's title/text (after its window class)
-        pMem = Uint16AfterSzOrOrd(pMem);
+        // The fixed part of the dialog item template, followed by its window class and title/text
+        DLGITEMTEMPLATE dlgItem;
+        cursor.Struct(dlgItem);
+        if (!cursor.ReadSzOrOrd(windowClass) || !cursor.ReadSzOrOrd(title))
+            return false;
 
-        // Output a line if it's a zero-terminated string
-        if (0x0000 != *pMem && 0xFFFF != *pMem)
+        // Output a line if it's a non-empty string
+        if (!title.bOrdinal && !title.sz.empty())
         {
-            std::wstring sText = escapeCrLfTab((const wchar_t*)pMem);
-            out
-                << RSRCID_t(lpName) << L"\t"
-                << pDlgItem->id << L"\t"
-                << RemoveAccelsFromText(sText) << L"\t"
-                << sText << L"\t"
-                << sWindowClassName
-                << std::endl;
+            textview_t text;
+            text.id = dlgItem.id;
+            text.text = title.sz;
+            text.windowClass = windowClass;
+            text.style = dlgItem.style;
+            visitor.Visit(entry, text);
         }
 
         // Get to and through the extra count / creation data
-        pMem = Uint16AfterSzOrOrd(pMem);
-        WORD cbExtra = *pMem++;
-        pMem += (cbExtra / 2);
+        WORD cbExtra = 0;
+        cursor.Read(cbExtra);
+        cursor.Skip((cbExtra / 2) * sizeof(WORD));
     }
 
+    return !cursor.Failed();
+}
+
+/// <summary>
+/// Writes the tab-delimited headers for dialog output.
+/// </summary>
+void WriteDialogTextHeaders(std::wostream& out)
+{
+    out
+        << L"Dialog ID\t"
+        << L"Ctrl ID\t"
+        << L"Localized text\t"
+        << L"Dialog text\t"
+        << L"Ctrl Type"
+        << L'\n';
+}
+
+/// <summary>
+/// Decodes the caption and control text of one dialog resource in the current file.
+/// Unlike message tables, dialogs (and menus) are decoded with the checked cursor only, not validated first and
+/// then decoded unchecked: the text of a malformed dialog up to where it fails is still reported, and since each
+/// string is walked to its terminator as it's reported, a separate validation pass would read the whole template
+/// twice to save only the cursor's bounds tests.
+/// </summary>
+bool DecodeDialogText(const ResourceEntry_t& entry, ResourceVisitor& visitor, std::wostream& err)
+{
+    CheckedResourceCursor cursor(entry.pData, entry.cbData);
+    const bool bValid = IsExtendedDialogTemplate(entry) ?
+        DecodeExtendedDialogTemplate(cursor, entry, visitor) :
+        DecodeStandardDialogTemplate(cursor, entry, visitor);
+    // Report a malformed dialog, but continue with the file's other resources.
+    if (!bValid)
+        err << L"Error: dialog " << entry.name << L" extends beyond the end of the resource" << std::endl;
     return true;
 }
 
 /// <summary>
-/// Callback function to handle each dialog resource in the current file.
+/// Writes a line of tab-delimited output for a dialog's caption or one of its controls.
 /// </summary>
-/// <param name="hModule">Handle to the resource DLL</param>
-/// <param name="lpType">Resource type</param>
-/// <param name="lpName">Resource name/identifier</param>
-/// <param name="lParam">Pointer to output stream</param>
-/// <returns>Always returns TRUE to continue enumeration</returns>
-static BOOL CALLBACK EnumDialogCallbackProc(
-    _In_opt_ HMODULE hModule,
-    _In_ LPCWSTR lpType,
-    _In_ LPWSTR lpName,
-    _In_ LONG_PTR lParam)
+void WriteDialogText(const ResourceEntry_t& entry, const textview_t& text, TextArena& arena, std::wostream& out)
 {
-    streams_t* pStreams = (streams_t*)lParam;
-    // Should enumerate only RT_DIALOGs, but check again just to be safe
-    if (RT_DIALOG == lpType)
-    {
-// Eliminate false positive about lpType possibly being 0
-#pragma warning(push)
-#pragma warning (disable: 6387)
-        HRSRC hRsrc = FindResourceW(hModule, lpName, lpType);
-#pragma warning(pop)
-        if (NULL != hRsrc)
-        {
-            DWORD dwResourceSize = SizeofResource(hModule, hRsrc);
-            HGLOBAL hGbl = LoadResource(hModule, hRsrc);
-            if (NULL != hGbl)
-            {
-                LPVOID pData = LockResource(hGbl);
-                if (IsExtendedDialogTemplate(pData))
-                    ProcessExtendedDialogTemplate(lpName, pData, dwResourceSize, pStreams->WCout, pStreams->WCerr);
-                else
-                    ProcessStandardDialogTemplate(lpName, pData, dwResourceSize, pStreams->WCout, pStreams->WCerr);
-            }
-        }
-    }
+    const bool bCaption = textview_t::item_t::eCaption == text.item;
+    const arenatext_t escaped = EscapeCrLfTab(arena, ArenaText(arena, text.text), false);
+    WriteResourceName(out, entry.name, arena);
+    out << L"\t";
+    if (bCaption)
+        out << sz_Caption_;
     else
-    {
-        // This should never happen.
-        pStreams->WCerr << L"UNEXPECTED RESOURCE TYPE: " << RSRCID_t(lpType) << L", ID " << RSRCID_t(lpName) << std::endl;
-    }
-    return TRUE;
+        out << text.id;
+    out
+        << L"\t"
+        << RemoveAccelsFromText(arena, escaped) << L"\t"
+        << escaped << L"\t"
+        << (bCaption ? arenatext_t(sz_Dialog_, wcslen(sz_Dialog_)) : DialogControlType(arena, text.windowClass, text.style))
+        << L'\n';
 }
 
+/// <summary>
+/// Handle one dialog resource in the current file.
+/// Output a line of tab-delimited information for non-empty dialog caption and item text.
+/// </summary>
+/// <param name="entry">The dialog resource</param>
+/// <param name="streams">The output and error streams to write information into</param>
+/// <returns>Always returns true to continue enumeration</returns>
+bool ProcessDialogResource(const ResourceEntry_t& entry, streams_t& streams)
+{
+    TextArena arena;
+    TextWriterVisitor writer(WriteDialogText, arena, streams.WCout);
+    return DecodeDialogText(entry, writer, streams.WCerr);
+}
 
 /// <summary>
 /// Outputs localized text in the module's dialog resources as tab-delimited fields.
 /// Output includes the dialog ID, control ID, the localized text both with accelerators
 /// and with accelerator characters removed, and the control type.
 /// </summary>
-/// <param name="hModule">Handle to the module to inspect</param>
+/// <param name="rsrcFile">The resource file to inspect</param>
 /// <param name="streams">The output and error streams to write information into</param>
+/// <param name="nThreads">Input: maximum number of threads to decode a large file on; 0 for one per hardware thread</param>
 /// <returns>true if successful, false otherwise.</returns>
-bool DialogTextExtraction(HMODULE hModule, streams_t& streams)
+bool DialogTextExtraction(const ResourceFile& rsrcFile, streams_t& streams, unsigned int nThreads)
 {
     // Tab-delimited headers
-    streams.WCout
-        << L"Dialog ID\t"
-        << L"Ctrl ID\t"
-        << L"Localized text\t"
-        << L"Dialog text\t"
-        << L"Ctrl Type"
-        << std::endl;
+    WriteDialogTextHeaders(streams.WCout);
 
     // Enumerate the dialog resources
-    if (!EnumResourceNamesW(hModule, RT_DIALOG, EnumDialogCallbackProc, (LPARAM)&streams))
+    // Large files are decoded on several threads.
+    std::wstring sErrorInfo;
+    if (!ExtractResourcesOfType(rsrcFile, rsrctype_t::eDialog, streams.WCout, streams.WCerr, nThreads, sErrorInfo))
     {
-        DWORD dwLastErr = GetLastError();
-        streams.WCerr << L"EnumResourceNamesW failed: " << SysErrorMessageWithCode(dwLastErr) << std::endl;
+        streams.WCerr << L"Cannot enumerate dialog resources: " << sErrorInfo << std::endl;
         return false;
     }
 
     return true;
 }
-
-#if 0
-// The code below was used to validate the dialog template parsing. It is not being used at this time,
-// but I'm keeping it around in case further validation tests are needed.
-// Disable warning C4505 so the build can still succeed.
-// Warning C4505: unreferenced function with internal linkage has been removed
-#pragma warning( disable: 4505 )
-
-static bool ValidateDLGTEMPLATEEX(LPVOID pResource, std::wostream& out, std::wostream& err)
-{
-    UNREFERENCED_PARAMETER(err);
-    // uint16_t -- clearer than WORD
-    //TODO: Need to make sure not to look beyond size of resource.
-    DLGTEMPLATEEX_1* pDlgTemplateEx1 = (DLGTEMPLATEEX_1*)pResource;
-    WORD nDlgItems = pDlgTemplateEx1->cDlgItems;
-    out << L"  " << L"Items: " << nDlgItems << std::endl;
-    if (pDlgTemplateEx1->style & WS_CHILD)
-        out << L"  Child dialog" << std::endl;
-    WORD* pMem = Uint16AfterSzOrOrd(pDlgTemplateEx1->menu);
-    pMem = Uint16AfterSzOrOrd(pMem);
-    out << L"  Caption: " << (const wchar_t*)pMem << std::endl;
-    pMem = Uint16AfterSz(pMem); // after title
-    pMem += 3; // pointsize, weight, italic, charset
-    if (0 != (pDlgTemplateEx1->style & (DS_SETFONT | DS_SHELLFONT)))
-    {
-        // typeface
-        pMem = Uint16AfterSz(pMem);
-    }
-
-    for (WORD ixDlgItem = 0; ixDlgItem < nDlgItems; ++ixDlgItem)
-    {
-        // DLGITEMTEMPLATEEX must be aligned on four-byte boundaries
-        while (0 != ((unsigned long long)pMem & 0x03))
-            pMem++;
-
-        DLGITEMTEMPLATEEX_1* pDlgItemEx1 = (DLGITEMTEMPLATEEX_1*)pMem;
-        out << L"  ID: " << (long)pDlgItemEx1->id << L"  ";
-        // Window class
-        pMem = pDlgItemEx1->windowClass;
-        if (0xFFFF == *pMem)
-        {
-            switch (pMem[1])
-            {
-            case 0x0080: out << L"Button"; break;
-            case 0x0081: out << L"Edit"; break;
-            case 0x0082: out << L"Static"; break;
-            case 0x0083: out << L"List box"; break;
-            case 0x0084: out << L"Scroll bar"; break;
-            case 0x0085: out << L"Combo box"; break;
-            default: out << L"Window class ordinal " << pMem[1]; break;
-            }
-        }
-        else
-        {
-            out << L"Window class " << (const wchar_t*)pDlgItemEx1->windowClass;
-        }
-        out << L"; title ";
-        pMem = Uint16AfterSzOrOrd(pDlgItemEx1->windowClass);
-        if (0xFFFF == *pMem)
-        {
-            out << L"ordinal " << pMem[1] << std::endl;
-        }
-        else
-        {
-            out << (const wchar_t*)pMem << std::endl;
-        }
-        pMem = Uint16AfterSzOrOrd(pMem);
-        WORD cbExtra = *pMem++;
-        pMem += (cbExtra / 2);
-    }
-    out << std::endl;
-
-    return true;
-}
-
-static bool ValidateDLGTEMPLATE(LPVOID pResource, std::wostream& out, std::wostream& err)
-{
-    UNREFERENCED_PARAMETER(err);
-    DLGTEMPLATE* pDlgTemplate = (DLGTEMPLATE*)pResource;
-    WORD nDlgItems = pDlgTemplate->cdit;
-    out << L"  " << L"Items: " << nDlgItems << std::endl;
-    bool bSetFont = (0 != (pDlgTemplate->style & DS_SETFONT));
-    // Menu
-    uint16_t* pMem = (uint16_t*)(pDlgTemplate + 1);
-    // Window class
-    pMem = Uint16AfterSzOrOrd(pMem);
-    // Title
-    pMem = Uint16AfterSzOrOrd(pMem);
-    out << L"  Caption: " << (const wchar_t*)pMem << std::endl;
-    pMem = Uint16AfterSz(pMem); // after title
-    if (bSetFont)
-    {
-        pMem = Uint16AfterSz(pMem + 1);
-    }
-
-    for (WORD ixDlgItem = 0; ixDlgItem < nDlgItems; ++ixDlgItem)
-    {
-        // DLGITEMTEMPLATE must be aligned on four-byte boundaries
-        while (0 != ((unsigned long long)pMem & 0x03))
-            pMem++;
-
-        DLGITEMTEMPLATE* pDlgItem = (DLGITEMTEMPLATE*)pMem;
-        out << L"  ID: " << pDlgItem->id << L"  ";
-        // window class
-        pMem = (uint16_t*)(pDlgItem + 1);
-
-        if (0xFFFF == *pMem)
-        {
-            switch (pMem[1])
-            {
-            case 0x0080: out << L"Button"; break;
-            case 0x0081: out << L"Edit"; break;
-            case 0x0082: out << L"Static"; break;
-            case 0x0083: out << L"List box"; break;
-            case 0x0084: out << L"Scroll bar"; break;
-            case 0x0085: out << L"Combo box"; break;
-            default: out << L"Window class ordinal " << pMem[1]; break;
-            }
-        }
-        else
-        {
-            out << L"Window class " << (const wchar_t*)pMem;
-        }
-        // title
-        out << L"; title ";
-        pMem = Uint16AfterSzOrOrd(pMem);
-        if (0xFFFF == *pMem)
-        {
-            out << L"ordinal " << pMem[1] << std::endl;
-        }
-        else
-        {
-            out << (const wchar_t*)pMem << std::endl;
-        }
-        // Creation data
-        pMem = Uint16AfterSzOrOrd(pMem);
-        WORD cbExtra = *pMem++;
-        pMem += (cbExtra / 2);
-    }
-    out << std::endl;
-
-    return true;
-}
-
-#endif
\ No newline at end of file
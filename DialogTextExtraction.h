@@ -1,13 +1,56 @@
 #pragma once
 
 #include "UtilityFunctions.h"
+#include "TextRecord.h"
 
 /// <summary>
 /// Outputs localized text in the module's dialog resources as tab-delimited fields.
 /// Output includes the dialog ID, control ID, the localized text both with accelerators
 /// and with accelerator characters removed, and the control type.
 /// </summary>
-/// <param name="hModule">Handle to the module to inspect</param>
+/// <param name="rsrcFile">The resource file to inspect</param>
 /// <param name="streams">The output and error streams to write information into</param>
+/// <param name="nThreads">Input: maximum number of threads to decode a large file on; 0 for one per hardware thread</param>
 /// <returns>true if successful, false otherwise.</returns>
-bool DialogTextExtraction(HMODULE hModule, streams_t& streams);
+bool DialogTextExtraction(const ResourceFile& rsrcFile, streams_t& streams, unsigned int nThreads);
+
+/// <summary>
+/// Writes the tab-delimited headers for dialog output.
+/// </summary>
+/// <param name="out">The output stream to write the headers into</param>
+void WriteDialogTextHeaders(std::wostream& out);
+
+/// <summary>
+/// Outputs the localized text in one dialog resource, without headers.
+/// </summary>
+/// <param name="entry">The resource</param>
+/// <param name="streams">The output and error streams to write information into</param>
+/// <returns>true to continue enumeration; false if the resource is malformed</returns>
+bool ProcessDialogResource(const ResourceEntry_t& entry, streams_t& streams);
+
+/// <summary>
+/// Decodes the text in one dialog resource: its caption and the text of its controls, without escaping or accelerator removal.
+/// This is the decoding behind ProcessDialogResource, for output other than tab-delimited text.
+/// </summary>
+/// <param name="entry">The resource</param>
+/// <param name="visitor">Input: visitor to report the caption and each control's text to</param>
+/// <param name="err">The error stream to write diagnostic information into</param>
+/// <returns>true to continue enumeration; false if the resource is malformed</returns>
+bool DecodeDialogText(const ResourceEntry_t& entry, ResourceVisitor& visitor, std::wostream& err);
+
+/// <summary>
+/// Writes the tab-delimited output for one item of text that DecodeDialogText reports.
+/// </summary>
+void WriteDialogText(const ResourceEntry_t& entry, const textview_t& text, TextArena& arena, std::wostream& out);
+
+/// <summary>
+/// Names the type of a dialog control from its window class and style: "Button", "Checkbox", "Radio button",
+/// "Group box", "Edit", "Static", "List box", "Scroll bar", "Combo box", "Ordinal n" for other predefined
+/// classes, or the class name.
+/// </summary>
+std::wstring DialogControlType(const szorord_t& windowClass, uint32_t style);
+
+/// <summary>
+/// Names the type of a dialog control, as the std::wstring overload does, with any text it needs from the arena.
+/// </summary>
+arenatext_t DialogControlType(TextArena& arena, const szorord_t& windowClass, uint32_t style);
@@ -0,0 +1,394 @@
+#include "PlatformDefs.h"
+#include <algorithm>
+#include <cstring>
+#include <cwctype>
+#include <iomanip>
+#include "ExtractionCache.h"
+#include "FileEnumeration.h"
+#include "FileOutput.h"
+#include "MappedFile.h"
+#include "StringUtils.h"
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+static const uint64_t xxPrime1 = 0x9E3779B185EBCA87ull;
+static const uint64_t xxPrime2 = 0xC2B2AE3D27D4EB4Full;
+static const uint64_t xxPrime3 = 0x165667B19E3779F9ull;
+static const uint64_t xxPrime4 = 0x85EBCA77C2B2AE63ull;
+static const uint64_t xxPrime5 = 0x27D4EB2F165667C5ull;
+
+static inline uint64_t RotateLeft(uint64_t value, int nBits)
+{
+    return (value << nBits) | (value >> (64 - nBits));
+}
+
+static inline uint64_t Read64(const uint8_t* p)
+{
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint32_t Read32(const uint8_t* p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint64_t XXRound(uint64_t acc, uint64_t input)
+{
+    acc += input * xxPrime2;
+    acc = RotateLeft(acc, 31);
+    return acc * xxPrime1;
+}
+
+static inline uint64_t XXMergeRound(uint64_t acc, uint64_t value)
+{
+    acc ^= XXRound(0, value);
+    return acc * xxPrime1 + xxPrime4;
+}
+
+uint64_t HashContent(const void* pData, size_t cbData, uint64_t seed)
+{
+    // Every platform this builds for is little-endian, which XXH64 reads its input as.
+    const uint8_t* p = (const uint8_t*)pData;
+    const uint8_t* const pEnd = p + cbData;
+    uint64_t hash;
+    if (cbData >= 32)
+    {
+        // Four lanes of 8 bytes each, which the processor can compute in parallel
+        uint64_t v1 = seed + xxPrime1 + xxPrime2;
+        uint64_t v2 = seed + xxPrime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - xxPrime1;
+        const uint8_t* const pLastStripe = pEnd - 32;
+        do
+        {
+            v1 = XXRound(v1, Read64(p));
+            v2 = XXRound(v2, Read64(p + 8));
+            v3 = XXRound(v3, Read64(p + 16));
+            v4 = XXRound(v4, Read64(p + 24));
+            p += 32;
+        } while (p <= pLastStripe);
+        hash = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) + RotateLeft(v4, 18);
+        hash = XXMergeRound(hash, v1);
+        hash = XXMergeRound(hash, v2);
+        hash = XXMergeRound(hash, v3);
+        hash = XXMergeRound(hash, v4);
+    }
+    else
+    {
+        hash = seed + xxPrime5;
+    }
+    hash += (uint64_t)cbData;
+
+    for (; p + 8 <= pEnd; p += 8)
+    {
+        hash ^= XXRound(0, Read64(p));
+        hash = RotateLeft(hash, 27) * xxPrime1 + xxPrime4;
+    }
+    if (p + 4 <= pEnd)
+    {
+        hash ^= (uint64_t)Read32(p) * xxPrime1;
+        hash = RotateLeft(hash, 23) * xxPrime2 + xxPrime3;
+        p += 4;
+    }
+    for (; p < pEnd; ++p)
+    {
+        hash ^= (uint64_t)*p * xxPrime5;
+        hash = RotateLeft(hash, 11) * xxPrime1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= xxPrime2;
+    hash ^= hash >> 29;
+    hash *= xxPrime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+// --------------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Header of a cache entry file, followed by the payload. Change the format version when the header or the
+/// payload's layout changes.
+/// </summary>
+struct cacheentryheader_t
+{
+    char magic[4];
+    uint32_t formatVersion;
+    uint64_t key;
+    uint64_t cbPayload;
+    uint64_t payloadHash;
+};
+
+static const char szEntryMagic[4] = { 'G', 'L', 'R', 'C' };
+static const uint32_t nEntryFormatVersion = 1;
+static const wchar_t* const szEntryExtension = L".glrc";
+
+ExtractionCache::ExtractionCache() :
+    m_cbMax(0),
+    m_nHits(0),
+    m_nMisses(0),
+    m_nStored(0),
+    m_nTempFiles(0),
+    m_nRemoved(0),
+    m_nEntries(0),
+    m_cbEntries(0)
+{
+}
+
+bool ExtractionCache::Open(const std::wstring& sDirectory, uint64_t cbMax, std::wstring& sErrorInfo)
+{
+    if (!CreateDirectoryPath(sDirectory, sErrorInfo))
+        return false;
+    m_sDirectory = sDirectory;
+    if (!EndsWith(m_sDirectory, L'\\') && !EndsWith(m_sDirectory, L'/'))
+        m_sDirectory += L'/';
+    m_cbMax = cbMax;
+    return true;
+}
+
+std::wstring ExtractionCache::EntryDirectory(uint64_t key) const
+{
+    wchar_t szShard[3];
+    swprintf(szShard, 3, L"%02x", (unsigned int)(key >> 56));
+    return m_sDirectory + szShard;
+}
+
+std::wstring ExtractionCache::EntryPath(uint64_t key) const
+{
+    wchar_t szName[17];
+    swprintf(szName, 17, L"%016llx", (unsigned long long)key);
+    return EntryDirectory(key) + L'/' + szName + szEntryExtension;
+}
+
+bool ExtractionCache::Load(uint64_t key, std::vector<uint8_t>& vPayload)
+{
+    const std::wstring sPath = EntryPath(key);
+    MappedFile file;
+    std::wstring sErrorInfo;
+    bool bFound = false;
+    if (file.Open(sPath, sErrorInfo) && file.Size() >= sizeof(cacheentryheader_t))
+    {
+        cacheentryheader_t header;
+        memcpy(&header, file.Data(), sizeof(header));
+        const uint8_t* pPayload = file.Data() + sizeof(header);
+        bFound =
+            0 == memcmp(header.magic, szEntryMagic, sizeof(szEntryMagic)) &&
+            nEntryFormatVersion == header.formatVersion &&
+            key == header.key &&
+            header.cbPayload == file.Size() - sizeof(header) &&
+            header.payloadHash == HashContent(pPayload, (size_t)header.cbPayload, 0);
+        if (bFound)
+            vPayload.assign(pPayload, pPayload + header.cbPayload);
+    }
+    file.Close();
+
+    if (bFound)
+    {
+        // Mark it as recently used.
+        TouchFilePath(sPath);
+        ++m_nHits;
+    }
+    else
+    {
+        ++m_nMisses;
+    }
+    return bFound;
+}
+
+void ExtractionCache::Store(uint64_t key, const std::vector<uint8_t>& vPayload)
+{
+    std::wstring sErrorInfo;
+    if (!CreateDirectoryPath(EntryDirectory(key), sErrorInfo))
+        return;
+
+    cacheentryheader_t header;
+    memcpy(header.magic, szEntryMagic, sizeof(szEntryMagic));
+    header.formatVersion = nEntryFormatVersion;
+    header.key = key;
+    header.cbPayload = vPayload.size();
+    header.payloadHash = HashContent(vPayload.data(), vPayload.size(), 0);
+    std::vector<uint8_t> vFile(sizeof(header) + vPayload.size());
+    memcpy(vFile.data(), &header, sizeof(header));
+    if (!vPayload.empty())
+        memcpy(vFile.data() + sizeof(header), vPayload.data(), vPayload.size());
+
+    // A name no other process or thread uses, in the entry's directory so that the rename doesn't move the file.
+#ifdef _WIN32
+    const unsigned long processId = GetCurrentProcessId();
+#else
+    const unsigned long processId = (unsigned long)getpid();
+#endif
+    const std::wstring sPath = EntryPath(key);
+    const std::wstring sTempPath = sPath + L"." + std::to_wstring(processId) + L"-" + std::to_wstring(m_nTempFiles++) + L".tmp";
+    if (WriteBinaryFile(sTempPath, vFile, sErrorInfo) && RenameFilePath(sTempPath, sPath))
+        ++m_nStored;
+    else
+        DeleteFilePath(sTempPath);
+}
+
+/// <summary>
+/// Indicates whether a file in the cache directory is one the cache made: an entry, or a temporary file that a
+/// process didn't get to rename. The directory could have been given by mistake, so nothing else is ever removed.
+/// </summary>
+static bool IsCacheFile(const std::wstring& sFilePath, bool& bEntry)
+{
+    const std::wstring sName = GetFileNameFromFilePath(sFilePath);
+    const size_t cchKey = 16, cchExtension = wcslen(szEntryExtension);
+    if (sName.length() < cchKey + cchExtension || 0 != sName.compare(cchKey, cchExtension, szEntryExtension))
+        return false;
+    for (size_t ix = 0; ix < cchKey; ++ix)
+    {
+        if (!iswxdigit(sName[ix]))
+            return false;
+    }
+    bEntry = (sName.length() == cchKey + cchExtension);
+    return bEntry || (L'.' == sName[cchKey + cchExtension] && 0 == sName.compare(sName.length() - 4, 4, L".tmp"));
+}
+
+void ExtractionCache::Trim()
+{
+    struct cachefile_t
+    {
+        std::wstring sPath;
+        filestamp_t stamp;
+        bool bEntry;
+    };
+    std::vector<std::wstring> vPaths;
+    std::wstring sErrorInfo;
+    ExpandFileSpec(m_sDirectory, vPaths, sErrorInfo);
+    std::vector<cachefile_t> vFiles;
+    uint64_t cbTotal = 0;
+    for (const std::wstring& sPath : vPaths)
+    {
+        cachefile_t file;
+        file.sPath = sPath;
+        if (!IsCacheFile(sPath, file.bEntry) || !GetFileStamp(sPath, file.stamp))
+            continue;
+        cbTotal += file.stamp.size;
+        vFiles.push_back(file);
+    }
+
+    // Least recently used first
+    std::sort(vFiles.begin(), vFiles.end(), [](const cachefile_t& a, const cachefile_t& b) { return a.stamp.modified < b.stamp.modified; });
+    const bool bTrim = cbTotal > m_cbMax;
+    const uint64_t cbTarget = m_cbMax / 10 * 9;
+    m_nEntries = 0;
+    for (const cachefile_t& file : vFiles)
+    {
+        if (bTrim && cbTotal > cbTarget && DeleteFilePath(file.sPath))
+        {
+            cbTotal -= file.stamp.size;
+            ++m_nRemoved;
+        }
+        else if (file.bEntry)
+        {
+            ++m_nEntries;
+        }
+    }
+    m_cbEntries = cbTotal;
+}
+
+void ExtractionCache::WriteSummary(std::wostream& out) const
+{
+    out
+        << L"Extraction cache: " << m_nHits << L" found, " << m_nMisses << L" missing, " << m_nStored << L" stored, "
+        << m_nRemoved << L" removed; " << m_nEntries << L" entries, "
+        << std::fixed << std::setprecision(1) << (double)m_cbEntries / (1024.0 * 1024.0) << L" MB" << std::endl;
+    out << std::defaultfloat << std::setprecision(6);
+}
+
+// --------------------------------------------------------------------------------------------------------------
+
+void CacheEntryWriter::Number(uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        m_vData.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    m_vData.push_back((uint8_t)value);
+}
+
+void CacheEntryWriter::SignedNumber(int64_t value)
+{
+    // Zigzag encoding, so that small negative numbers are short too
+    Number(((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+/// <summary>
+/// Writes a UTF-16 code unit, little-endian, and advances past it.
+/// </summary>
+static void PutUtf16Unit(uint8_t*& pOut, uint16_t unit)
+{
+    *pOut++ = (uint8_t)unit;
+    *pOut++ = (uint8_t)(unit >> 8);
+}
+
+void CacheEntryWriter::Text(const wchar_t* pChars, size_t nChars)
+{
+    // The code units are written straight from the wide characters; where wchar_t is 32 bits, a character above
+    // U+FFFF becomes a surrogate pair, as with WStringToUtf16.
+    size_t nUnits = nChars;
+#ifndef _WIN32
+    for (size_t ix = 0; ix < nChars; ++ix)
+    {
+        if ((uint32_t)pChars[ix] > 0xFFFF)
+            ++nUnits;
+    }
+#endif
+    Number(nUnits);
+    const size_t cbStart = m_vData.size();
+    m_vData.resize(cbStart + nUnits * sizeof(uint16_t));
+    uint8_t* pOut = m_vData.data() + cbStart;
+    for (size_t ix = 0; ix < nChars; ++ix)
+    {
+        const uint32_t cp = (uint32_t)pChars[ix];
+#ifndef _WIN32
+        if (cp > 0xFFFF)
+        {
+            PutUtf16Unit(pOut, (uint16_t)(0xD800 + ((cp - 0x10000) >> 10)));
+            PutUtf16Unit(pOut, (uint16_t)(0xDC00 + ((cp - 0x10000) & 0x3FF)));
+            continue;
+        }
+#endif
+        PutUtf16Unit(pOut, (uint16_t)cp);
+    }
+}
+
+bool CacheEntryReader::Number(uint64_t& value)
+{
+    value = 0;
+    for (int nShift = 0; nShift < 64 && m_pData < m_pEnd; nShift += 7)
+    {
+        const uint8_t b = *m_pData++;
+        value |= (uint64_t)(b & 0x7F) << nShift;
+        if (0 == (b & 0x80))
+            return true;
+    }
+    return false;
+}
+
+bool CacheEntryReader::SignedNumber(int64_t& value)
+{
+    uint64_t zigzag;
+    if (!Number(zigzag))
+        return false;
+    value = (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+    return true;
+}
+
+bool CacheEntryReader::Text(std::vector<uint16_t>& vUtf16)
+{
+    uint64_t nUnits;
+    if (!Number(nUnits) || nUnits > (uint64_t)(m_pEnd - m_pData) / 2)
+        return false;
+    vUtf16.resize((size_t)nUnits);
+    for (size_t ix = 0; ix < vUtf16.size(); ++ix, m_pData += 2)
+        vUtf16[ix] = (uint16_t)(m_pData[0] | (m_pData[1] << 8));
+    return true;
+}
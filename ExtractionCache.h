@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Fast 64-bit hash of bytes (the XXH64 algorithm), for telling whether a file's content has changed.
+/// Hashing a file with a seed that is the hash of something else hashes the two together.
+/// </summary>
+uint64_t HashContent(const void* pData, size_t cbData, uint64_t seed);
+
+/// <summary>
+/// On-disk cache of extraction results, keyed by a hash of the file's content and of the options that affect the
+/// result (see HashContent), so that a rerun on files that haven't changed reads each result back rather than
+/// decoding the file again.
+///
+/// Each entry is a file in a subdirectory of the cache directory named for the key's first two hex digits, with a
+/// header that repeats the key and has the length and hash of the payload, so that a damaged or foreign entry is
+/// treated as missing. Entries are written to a temporary file and renamed into place, so several processes (and
+/// several threads of one) can use the same cache: a reader gets a complete entry or none.
+/// An entry's last-write time is its last use: reading an entry touches it, and Trim removes the least recently
+/// used entries once the cache is larger than its size cap.
+/// </summary>
+class ExtractionCache
+{
+public:
+    ExtractionCache();
+
+    /// <summary>
+    /// Uses the directory for the cache, creating it if it doesn't exist.
+    /// </summary>
+    /// <param name="sDirectory">Input: path of the cache directory</param>
+    /// <param name="cbMax">Input: size above which Trim removes entries</param>
+    /// <param name="sErrorInfo">Output: diagnostic information on failure</param>
+    /// <returns>true if successful, false otherwise</returns>
+    bool Open(const std::wstring& sDirectory, uint64_t cbMax, std::wstring& sErrorInfo);
+
+    /// <summary>
+    /// Reads the payload of the entry with the key. Thread-safe.
+    /// </summary>
+    /// <returns>true if the entry was found and is intact, false otherwise</returns>
+    bool Load(uint64_t key, std::vector<uint8_t>& vPayload);
+
+    /// <summary>
+    /// Adds an entry, replacing any entry with the same key. Failure to write it isn't an error; the result is
+    /// just not cached. Thread-safe.
+    /// </summary>
+    void Store(uint64_t key, const std::vector<uint8_t>& vPayload);
+
+    /// <summary>
+    /// If the entries take more than the size cap, removes the least recently used until they take less than
+    /// 90% of it, so that the next run's new entries don't have the cache trimmed again right away. Other processes
+    /// can be using the cache; an entry that one of them has just removed, or has open, is skipped.
+    /// </summary>
+    void Trim();
+
+    /// <summary>
+    /// Writes the numbers of entries found, missing, stored, and removed, and the size of the cache after Trim.
+    /// </summary>
+    void WriteSummary(std::wostream& out) const;
+
+private:
+    std::wstring EntryDirectory(uint64_t key) const;
+    std::wstring EntryPath(uint64_t key) const;
+
+    std::wstring m_sDirectory;
+    uint64_t m_cbMax;
+    std::atomic<uint64_t> m_nHits;
+    std::atomic<uint64_t> m_nMisses;
+    std::atomic<uint64_t> m_nStored;
+    std::atomic<uint64_t> m_nTempFiles;
+    uint64_t m_nRemoved;
+    uint64_t m_nEntries;
+    uint64_t m_cbEntries;
+
+private:
+    // Not implemented
+    ExtractionCache(const ExtractionCache&) = delete;
+    ExtractionCache& operator = (const ExtractionCache&) = delete;
+};
+
+/// <summary>
+/// Writes a cache entry's payload in a compact binary form: numbers as LEB128 variable-length integers, and text as
+/// its length followed by its UTF-16LE code units.
+/// </summary>
+class CacheEntryWriter
+{
+public:
+    explicit CacheEntryWriter(std::vector<uint8_t>& vData) : m_vData(vData) {}
+
+    void Number(uint64_t value);
+    void SignedNumber(int64_t value);
+    void Text(const wchar_t* pChars, size_t nChars);
+    void Text(const std::wstring& sText) { Text(sText.data(), sText.length()); }
+
+private:
+    std::vector<uint8_t>& m_vData;
+
+private:
+    // Not implemented
+    CacheEntryWriter(const CacheEntryWriter&) = delete;
+    CacheEntryWriter& operator = (const CacheEntryWriter&) = delete;
+};
+
+/// <summary>
+/// Reads a payload written by CacheEntryWriter. Each method returns false if the payload ends too soon.
+/// </summary>
+class CacheEntryReader
+{
+public:
+    CacheEntryReader(const uint8_t* pData, size_t cbData) : m_pData(pData), m_pEnd(pData + cbData) {}
+
+    bool Number(uint64_t& value);
+    bool SignedNumber(int64_t& value);
+    // The text's UTF-16 code units, replacing the vector's contents
+    bool Text(std::vector<uint16_t>& vUtf16);
+    bool AtEnd() const { return m_pData == m_pEnd; }
+
+private:
+    const uint8_t* m_pData;
+    const uint8_t* m_pEnd;
+};
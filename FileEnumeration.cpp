@@ -0,0 +1,347 @@
+#include "PlatformDefs.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cwctype>
+#include <fstream>
+#include <iostream>
+#include "FileEnumeration.h"
+#include "StringUtils.h"
+#include "SysErrorMessage.h"
+#ifndef _WIN32
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#ifdef _WIN32
+static const wchar_t chPathSep = L'\\';
+#else
+static const wchar_t chPathSep = L'/';
+#endif
+
+/// <summary>
+/// One item in a directory listing.
+/// </summary>
+struct direntry_t
+{
+    std::wstring sName;
+    bool bIsDirectory;
+
+    bool operator < (const direntry_t& other) const { return sName < other.sName; }
+};
+
+/// <summary>
+/// Lists the files and subdirectories of a directory, excluding "." and "..", and excluding
+/// links to directories (so that a tree walk can't loop).
+/// </summary>
+static bool ListDirectory(const std::wstring& sDirectory, std::vector<direntry_t>& vEntries, std::wstring& sErrorInfo)
+{
+#ifdef _WIN32
+    WIN32_FIND_DATAW findData = { 0 };
+    std::wstring sSearch = sDirectory;
+    if (!EndsWith(sSearch, L'\\') && !EndsWith(sSearch, L'/'))
+        sSearch += L'\\';
+    sSearch += L'*';
+    HANDLE hFind = FindFirstFileExW(sSearch.c_str(), FindExInfoBasic, &findData, FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+    if (INVALID_HANDLE_VALUE == hFind)
+    {
+        DWORD dwLastErr = GetLastError();
+        if (ERROR_FILE_NOT_FOUND == dwLastErr)
+            return true;
+        sErrorInfo = SysErrorMessageWithCode(dwLastErr);
+        return false;
+    }
+    do
+    {
+        if (0 == wcscmp(findData.cFileName, L".") || 0 == wcscmp(findData.cFileName, L".."))
+            continue;
+        const bool bIsDirectory = (0 != (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY));
+        if (bIsDirectory && 0 != (findData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT))
+            continue;
+        vEntries.push_back(direntry_t{ findData.cFileName, bIsDirectory });
+    } while (FindNextFileW(hFind, &findData));
+    FindClose(hFind);
+#else
+    const std::string sDirectoryUtf8 = WStringToUtf8(sDirectory);
+    DIR* pDir = opendir(sDirectoryUtf8.c_str());
+    if (nullptr == pDir)
+    {
+        sErrorInfo = SysErrorMessageWithCode();
+        return false;
+    }
+    while (struct dirent* pEntry = readdir(pDir))
+    {
+        if (0 == strcmp(pEntry->d_name, ".") || 0 == strcmp(pEntry->d_name, ".."))
+            continue;
+        bool bIsDirectory = (DT_DIR == pEntry->d_type);
+        if (DT_DIR != pEntry->d_type && DT_REG != pEntry->d_type)
+        {
+            // Symbolic link or unknown type: include links to regular files, but not to directories.
+            struct stat st;
+            std::string sEntryPath = sDirectoryUtf8 + '/' + pEntry->d_name;
+            if (DT_LNK == pEntry->d_type)
+            {
+                if (0 != stat(sEntryPath.c_str(), &st) || !S_ISREG(st.st_mode))
+                    continue;
+            }
+            else
+            {
+                if (0 != lstat(sEntryPath.c_str(), &st) || !(S_ISREG(st.st_mode) || S_ISDIR(st.st_mode)))
+                    continue;
+                bIsDirectory = S_ISDIR(st.st_mode);
+            }
+        }
+        vEntries.push_back(direntry_t{ Utf8ToWString(pEntry->d_name), bIsDirectory });
+    }
+    closedir(pDir);
+#endif
+    std::sort(vEntries.begin(), vEntries.end());
+    return true;
+}
+
+/// <summary>
+/// Appends a file name to a directory path.
+/// </summary>
+static std::wstring CombinePath(const std::wstring& sDirectory, const std::wstring& sName)
+{
+    if (sDirectory.empty())
+        return sName;
+    if (EndsWith(sDirectory, L'\\') || EndsWith(sDirectory, L'/'))
+        return sDirectory + sName;
+    return sDirectory + chPathSep + sName;
+}
+
+/// <summary>
+/// Appends all files in the directory and its subdirectories.
+/// </summary>
+static bool WalkDirectory(const std::wstring& sDirectory, std::vector<std::wstring>& vFiles, std::wstring& sErrorInfo)
+{
+    std::vector<direntry_t> vEntries;
+    if (!ListDirectory(sDirectory, vEntries, sErrorInfo))
+    {
+        sErrorInfo = L"Cannot read directory " + sDirectory + L": " + sErrorInfo;
+        return false;
+    }
+    for (const direntry_t& entry : vEntries)
+    {
+        const std::wstring sPath = CombinePath(sDirectory, entry.sName);
+        if (!entry.bIsDirectory)
+            vFiles.push_back(sPath);
+        else if (!WalkDirectory(sPath, vFiles, sErrorInfo))
+            return false;
+    }
+    return true;
+}
+
+bool IsDirectoryPath(const std::wstring& sPath)
+{
+#ifdef _WIN32
+    DWORD dwAttributes = GetFileAttributesW(sPath.c_str());
+    return (INVALID_FILE_ATTRIBUTES != dwAttributes && 0 != (dwAttributes & FILE_ATTRIBUTE_DIRECTORY));
+#else
+    struct stat st;
+    return (0 == stat(WStringToUtf8(sPath).c_str(), &st) && S_ISDIR(st.st_mode));
+#endif
+}
+
+bool IsFilePath(const std::wstring& sPath)
+{
+#ifdef _WIN32
+    DWORD dwAttributes = GetFileAttributesW(sPath.c_str());
+    return (INVALID_FILE_ATTRIBUTES != dwAttributes && 0 == (dwAttributes & FILE_ATTRIBUTE_DIRECTORY));
+#else
+    struct stat st;
+    return (0 == stat(WStringToUtf8(sPath).c_str(), &st) && !S_ISDIR(st.st_mode));
+#endif
+}
+
+bool GetFileStamp(const std::wstring& sPath, filestamp_t& stamp)
+{
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA fileData = { 0 };
+    if (!GetFileAttributesExW(sPath.c_str(), GetFileExInfoStandard, &fileData))
+        return false;
+    stamp.modified = ((uint64_t)fileData.ftLastWriteTime.dwHighDateTime << 32) | fileData.ftLastWriteTime.dwLowDateTime;
+    stamp.size = ((uint64_t)fileData.nFileSizeHigh << 32) | fileData.nFileSizeLow;
+#else
+    struct stat st;
+    if (0 != stat(WStringToUtf8(sPath).c_str(), &st))
+        return false;
+    stamp.modified = (uint64_t)st.st_mtim.tv_sec * 1000000000 + (uint64_t)st.st_mtim.tv_nsec;
+    stamp.size = (uint64_t)st.st_size;
+#endif
+    return true;
+}
+
+bool ListSubdirectories(const std::wstring& sDirectory, std::vector<std::wstring>& vNames, std::wstring& sErrorInfo)
+{
+    std::vector<direntry_t> vEntries;
+    if (!ListDirectory(sDirectory, vEntries, sErrorInfo))
+        return false;
+    for (const direntry_t& entry : vEntries)
+    {
+        if (entry.bIsDirectory)
+            vNames.push_back(entry.sName);
+    }
+    return true;
+}
+
+std::wstring FindPathIgnoringCase(const std::wstring& sPath)
+{
+#ifdef _WIN32
+    return sPath;
+#else
+    struct stat st;
+    if (sPath.empty() || 0 == stat(WStringToUtf8(sPath).c_str(), &st))
+        return sPath;
+
+    // Match one name at a time, starting from the root or the current directory.
+    std::vector<std::wstring> vNames;
+    SplitStringToVector(sPath, L'/', vNames);
+    std::wstring sResult = (L'/' == sPath[0]) ? L"/" : L"";
+    for (const std::wstring& sName : vNames)
+    {
+        if (sName.empty())
+            continue;
+        std::wstring sCandidate = CombinePath(sResult, sName);
+        if (sName != L"." && sName != L".." && 0 != stat(WStringToUtf8(sCandidate).c_str(), &st))
+        {
+            std::vector<direntry_t> vEntries;
+            std::wstring sErrorInfo;
+            if (!ListDirectory(sResult.empty() ? L"." : sResult, vEntries, sErrorInfo))
+                return sPath;
+            auto iter = std::find_if(vEntries.begin(), vEntries.end(), [&sName](const direntry_t& entry) { return 0 == _wcsicmp(entry.sName.c_str(), sName.c_str()); });
+            if (vEntries.end() == iter)
+                return sPath;
+            sCandidate = CombinePath(sResult, iter->sName);
+        }
+        sResult = sCandidate;
+    }
+    return sResult;
+#endif
+}
+
+std::wstring TempDirectoryPath()
+{
+#ifdef _WIN32
+    wchar_t szTempPath[MAX_PATH + 1];
+    DWORD dwLen = GetTempPathW(MAX_PATH + 1, szTempPath);
+    if (dwLen > 0 && dwLen <= MAX_PATH)
+        return szTempPath;
+    return L".\\";
+#else
+    std::wstring sTempPath = L"/tmp";
+    const char* szTmpDir = getenv("TMPDIR");
+    if (nullptr != szTmpDir && 0 != *szTmpDir)
+        sTempPath = Utf8ToWString(szTmpDir);
+    if (!EndsWith(sTempPath, chPathSep))
+        sTempPath += chPathSep;
+    return sTempPath;
+#endif
+}
+
+bool HasWildcards(const std::wstring& sPath)
+{
+    return std::wstring::npos != GetFileNameFromFilePath(sPath).find_first_of(L"*?");
+}
+
+bool WildcardMatch(const wchar_t* szPattern, const wchar_t* szName)
+{
+    // Greedy match, backtracking to the most recent * on mismatch.
+    const wchar_t* szStar = nullptr;
+    const wchar_t* szStarName = nullptr;
+    while (*szName)
+    {
+#ifdef _WIN32
+        const bool bSameChar = (std::towlower(*szPattern) == std::towlower(*szName));
+#else
+        const bool bSameChar = (*szPattern == *szName);
+#endif
+        if (L'*' == *szPattern)
+        {
+            szStar = szPattern++;
+            szStarName = szName;
+        }
+        else if (L'?' == *szPattern || (0 != *szPattern && bSameChar))
+        {
+            ++szPattern;
+            ++szName;
+        }
+        else if (nullptr != szStar)
+        {
+            szPattern = szStar + 1;
+            szName = ++szStarName;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    while (L'*' == *szPattern)
+        ++szPattern;
+    return 0 == *szPattern;
+}
+
+bool ExpandFileSpec(const std::wstring& sSpec, std::vector<std::wstring>& vFiles, std::wstring& sErrorInfo)
+{
+    sErrorInfo.clear();
+    if (IsDirectoryPath(sSpec))
+        return WalkDirectory(sSpec, vFiles, sErrorInfo);
+
+    if (!HasWildcards(sSpec))
+    {
+        vFiles.push_back(sSpec);
+        return true;
+    }
+
+    // Wildcards in the file name: match the files in its directory.
+    const std::wstring sPattern = GetFileNameFromFilePath(sSpec);
+    const std::wstring sDirectory = sSpec.substr(0, sSpec.length() - sPattern.length());
+    std::vector<direntry_t> vEntries;
+    if (!ListDirectory(sDirectory.empty() ? L"." : sDirectory, vEntries, sErrorInfo))
+    {
+        sErrorInfo = L"Cannot read directory " + sDirectory + L": " + sErrorInfo;
+        return false;
+    }
+    for (const direntry_t& entry : vEntries)
+    {
+        if (!entry.bIsDirectory && WildcardMatch(sPattern.c_str(), entry.sName.c_str()))
+            vFiles.push_back(sDirectory + entry.sName);
+    }
+    return true;
+}
+
+bool ReadFileList(const std::wstring& sListFile, std::vector<std::wstring>& vSpecs, std::wstring& sErrorInfo)
+{
+    std::ifstream fList;
+    std::istream* pIn = &std::cin;
+    if (L"-" != sListFile)
+    {
+#ifdef _WIN32
+        fList.open(sListFile);
+#else
+        fList.open(WStringToUtf8(sListFile));
+#endif
+        if (fList.fail())
+        {
+            sErrorInfo = L"Cannot open file list " + sListFile;
+            return false;
+        }
+        pIn = &fList;
+    }
+
+    std::string sLine;
+    bool bFirstLine = true;
+    while (std::getline(*pIn, sLine))
+    {
+        // Ignore a UTF-8 BOM and CRLF line endings.
+        if (bFirstLine && 0 == sLine.compare(0, 3, "\xEF\xBB\xBF"))
+            sLine.erase(0, 3);
+        bFirstLine = false;
+        if (!sLine.empty() && '\r' == sLine.back())
+            sLine.pop_back();
+        if (!sLine.empty())
+            vSpecs.push_back(Utf8ToWString(sLine));
+    }
+    return true;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// A file's last-write time and size, for telling whether it has changed.
+/// </summary>
+struct filestamp_t
+{
+    // Last-write time, in platform-specific units
+    uint64_t modified = 0;
+    uint64_t size = 0;
+
+    bool operator == (const filestamp_t& other) const { return modified == other.modified && size == other.size; }
+    bool operator != (const filestamp_t& other) const { return !(*this == other); }
+};
+
+/// <summary>
+/// Indicates whether the path names an existing directory.
+/// </summary>
+bool IsDirectoryPath(const std::wstring& sPath);
+
+/// <summary>
+/// Indicates whether the path names an existing file (not a directory).
+/// </summary>
+bool IsFilePath(const std::wstring& sPath);
+
+/// <summary>
+/// Gets the last-write time and size of a file.
+/// </summary>
+/// <param name="sPath">Input: path to the file</param>
+/// <param name="stamp">Output: the file's last-write time and size</param>
+/// <returns>true if successful, false if the file doesn't exist or can't be inspected</returns>
+bool GetFileStamp(const std::wstring& sPath, filestamp_t& stamp);
+
+/// <summary>
+/// Returns the directory for temporary files (e.g., %TEMP% on Windows, $TMPDIR or /tmp elsewhere),
+/// ending with a path separator.
+/// </summary>
+std::wstring TempDirectoryPath();
+
+/// <summary>
+/// Indicates whether the file name portion of the path contains wildcard characters (* or ?).
+/// </summary>
+bool HasWildcards(const std::wstring& sPath);
+
+/// <summary>
+/// Gets the names of the subdirectories of a directory, in name order.
+/// </summary>
+/// <param name="sDirectory">Input: path to the directory</param>
+/// <param name="vNames">Output: names (not paths) of the subdirectories</param>
+/// <param name="sErrorInfo">Output: diagnostic information on failure</param>
+/// <returns>true if successful, false if the directory cannot be read</returns>
+bool ListSubdirectories(const std::wstring& sDirectory, std::vector<std::wstring>& vNames, std::wstring& sErrorInfo);
+
+/// <summary>
+/// Finds an existing file or directory whose path matches sPath except for the case of its names, e.g.,
+/// /mnt/image/Windows/System32/wsecedit.dll for /mnt/image/windows/system32/WSECEDIT.DLL.
+/// Windows file systems aren't case-sensitive, so paths from a Windows system (such as the ones in
+/// indirect strings) don't always match the case of the names in a copy of its files on another platform.
+/// On Windows, returns sPath unchanged.
+/// </summary>
+/// <param name="sPath">Input: path to look for</param>
+/// <returns>The path of the matching file if there is one; otherwise, sPath unchanged</returns>
+std::wstring FindPathIgnoringCase(const std::wstring& sPath);
+
+/// <summary>
+/// Matches a file name against a pattern with * (any sequence) and ? (any one character) wildcards.
+/// Case-insensitive on Windows; case-sensitive elsewhere.
+/// </summary>
+bool WildcardMatch(const wchar_t* szPattern, const wchar_t* szName);
+
+/// <summary>
+/// Appends to vFiles the files that a file specification refers to:
+/// * a directory: all files in it and in all its subdirectories (not following links to directories);
+/// * a path whose file name contains wildcards, such as C:\Windows\System32\*.dll: the matching files in that directory;
+/// * anything else: the specification itself, unchanged.
+/// Files within a directory are appended in name order, so results are repeatable.
+/// </summary>
+/// <param name="sSpec">Input: directory, wildcard pattern, or file path</param>
+/// <param name="vFiles">Output: file paths are appended to this collection</param>
+/// <param name="sErrorInfo">Output: diagnostic information on failure</param>
+/// <returns>true if successful, false if a directory cannot be read</returns>
+bool ExpandFileSpec(const std::wstring& sSpec, std::vector<std::wstring>& vFiles, std::wstring& sErrorInfo);
+
+/// <summary>
+/// Appends to vSpecs the lines of a UTF-8 text file (one file specification per line). Blank lines are ignored.
+/// </summary>
+/// <param name="sListFile">Input: path to the list file, or "-" to read the list from stdin</param>
+/// <param name="vSpecs">Output: lines are appended to this collection</param>
+/// <param name="sErrorInfo">Output: diagnostic information on failure</param>
+/// <returns>true if successful, false otherwise</returns>
+bool ReadFileList(const std::wstring& sListFile, std::vector<std::wstring>& vSpecs, std::wstring& sErrorInfo);
@@ -1,7 +1,16 @@
 #include "FileOutput.h"
 #include <locale>
 #include <codecvt>
-#include <Windows.h>
+#include "PlatformDefs.h"
+#include "StringUtils.h"
+#include "FileEnumeration.h"
+#ifndef _WIN32
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 /// <summary>
 /// Ensure that output stream produces UTF-8 with optional BOM
@@ -12,6 +21,7 @@ void ImbueStreamUtf8(std::wostream& stream, bool bGenerateHeader)
     // Ensure that stream output is UTF-8.
     // Note that the heap-allocated std::codecvt_utf8 will eventually be deleted by the std::locale
     // it's initializing, so we MUST NOT match that "new" with a "delete" here.
+#ifdef _WIN32
     if (bGenerateHeader)
     {
         std::locale loc(std::locale(), new std::codecvt_utf8<wchar_t, 0x10ffff, std::generate_header>);
@@ -22,8 +32,296 @@ void ImbueStreamUtf8(std::wostream& stream, bool bGenerateHeader)
         std::locale loc(std::locale(), new std::codecvt_utf8<wchar_t, 0x10ffff>);
         stream.imbue(loc);
     }
+#else
+    // libstdc++'s codecvt_utf8 writes the BOM at the start of every conversion rather than once,
+    // so write it explicitly instead.
+    std::locale loc(std::locale(), new std::codecvt_utf8<wchar_t, 0x10ffff>);
+    stream.imbue(loc);
+    if (bGenerateHeader)
+        stream << L'\xFEFF';
+#endif
+}
+
+
+/// <summary>
+/// Number of characters collected before handing them to the writer thread.
+/// </summary>
+static const size_t nOutputBufferChars = 65536;
+
+/// <summary>
+/// Number of full buffers that can wait for the writer thread before output blocks.
+/// </summary>
+static const size_t nMaxQueuedBatches = 4;
+
+Utf8OutputBuffer::Utf8OutputBuffer() :
+    m_vChars(nOutputBufferChars),
+    m_vBytes(nOutputBufferChars * nMaxUtf8BytesPerWchar),
+#ifdef _WIN32
+    m_hFile(INVALID_HANDLE_VALUE),
+#else
+    m_fd(-1),
+#endif
+    m_bOwned(false),
+    m_bWriting(false),
+    m_bStopping(false),
+    m_bFailed(false)
+{
+    setp(&m_vChars[0], &m_vChars[0] + m_vChars.size());
+}
+
+Utf8OutputBuffer::~Utf8OutputBuffer()
+{
+    Close();
 }
 
+bool Utf8OutputBuffer::Open(const wchar_t* szFilename, bool bAppend)
+{
+    Close();
+#ifdef _WIN32
+    m_hFile = CreateFileW(
+        szFilename,
+        bAppend ? FILE_APPEND_DATA : GENERIC_WRITE,
+        FILE_SHARE_READ,
+        nullptr,
+        bAppend ? OPEN_ALWAYS : CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr);
+#else
+    m_fd = open(WStringToUtf8(szFilename).c_str(), O_WRONLY | O_CREAT | (bAppend ? O_APPEND : O_TRUNC), 0666);
+#endif
+    m_bOwned = true;
+    m_bFailed = false;
+    return IsOpen();
+}
+
+void Utf8OutputBuffer::AttachStdout()
+{
+    Close();
+#ifdef _WIN32
+    m_hFile = GetStdHandle(STD_OUTPUT_HANDLE);
+#else
+    m_fd = STDOUT_FILENO;
+#endif
+    m_bOwned = false;
+    m_bFailed = false;
+}
+
+bool Utf8OutputBuffer::Close()
+{
+    if (!IsOpen())
+        return !m_bFailed;
+    // Any high surrogate left at the end has no partner coming; WideToUtf8 replaces it.
+    QueueBuffered(true);
+    if (m_writer.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_bStopping = true;
+        }
+        m_cvQueued.notify_one();
+        m_writer.join();
+        m_bStopping = false;
+    }
+    else
+    {
+        // Nothing was queued, so convert and write here.
+        const size_t cbData = WideToUtf8(pbase(), (size_t)(pptr() - pbase()), &m_vBytes[0]);
+        if (!WriteBytes(&m_vBytes[0], cbData))
+            m_bFailed = true;
+    }
+    setp(&m_vChars[0], &m_vChars[0] + m_vChars.size());
+    if (m_bOwned)
+    {
+#ifdef _WIN32
+        CloseHandle(m_hFile);
+#else
+        close(m_fd);
+#endif
+    }
+#ifdef _WIN32
+    m_hFile = INVALID_HANDLE_VALUE;
+#else
+    m_fd = -1;
+#endif
+    return !m_bFailed;
+}
+
+Utf8OutputBuffer::int_type Utf8OutputBuffer::overflow(int_type ch)
+{
+    if (!QueueBuffered(false))
+        return traits_type::eof();
+    if (!traits_type::eq_int_type(ch, traits_type::eof()))
+        return sputc(traits_type::to_char_type(ch));
+    return traits_type::not_eof(ch);
+}
+
+int Utf8OutputBuffer::sync()
+{
+    if (!IsOpen())
+        return -1;
+    if (!m_writer.joinable())
+    {
+        // No writer thread yet: write what's buffered directly rather than starting one.
+        const size_t nChars = (size_t)(pptr() - pbase());
+        size_t nHeld = 0;
+#if WCHAR_MAX == 0xFFFF
+        if (nChars > 0 && pbase()[nChars - 1] >= 0xD800 && pbase()[nChars - 1] <= 0xDBFF)
+            nHeld = 1;
+#endif
+        const size_t cbData = WideToUtf8(pbase(), nChars - nHeld, &m_vBytes[0]);
+        if (!WriteBytes(&m_vBytes[0], cbData))
+            m_bFailed = true;
+        if (nHeld > 0)
+            m_vChars[0] = pbase()[nChars - 1];
+        setp(&m_vChars[0], &m_vChars[0] + m_vChars.size());
+        pbump((int)nHeld);
+        return m_bFailed ? -1 : 0;
+    }
+    return (QueueBuffered(false) && WaitUntilWritten()) ? 0 : -1;
+}
+
+bool Utf8OutputBuffer::IsOpen() const
+{
+#ifdef _WIN32
+    return INVALID_HANDLE_VALUE != m_hFile && nullptr != m_hFile;
+#else
+    return m_fd >= 0;
+#endif
+}
+
+/// <summary>
+/// Hands the buffered characters to the writer thread, starting it if needed, and continues with an empty buffer.
+/// Unless this is the final output, a high surrogate at the end is kept for the next batch, so that it is
+/// converted together with its low surrogate. Waits while the queue is full.
+/// </summary>
+bool Utf8OutputBuffer::QueueBuffered(bool bFinal)
+{
+    if (!IsOpen())
+        return false;
+    const size_t nChars = (size_t)(pptr() - pbase());
+    size_t nHeld = 0;
+#if WCHAR_MAX == 0xFFFF
+    if (!bFinal && nChars > 0 && pbase()[nChars - 1] >= 0xD800 && pbase()[nChars - 1] <= 0xDBFF)
+        nHeld = 1;
+#endif
+    if (nChars == nHeld)
+        return true;
+    // Short output that's complete is written by Close without a writer thread.
+    if (bFinal && !m_writer.joinable())
+        return true;
+
+    outputbatch_t batch;
+    batch.nChars = nChars - nHeld;
+    bool bFailed = false;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_writer.joinable())
+            m_writer = std::thread(&Utf8OutputBuffer::WriterThread, this);
+        m_cvWritten.wait(lock, [this] { return m_qBatches.size() < nMaxQueuedBatches; });
+        std::vector<wchar_t> vNext;
+        if (m_vSpareBuffers.empty())
+        {
+            vNext.resize(nOutputBufferChars);
+        }
+        else
+        {
+            vNext.swap(m_vSpareBuffers.back());
+            m_vSpareBuffers.pop_back();
+        }
+        if (nHeld > 0)
+            vNext[0] = pbase()[nChars - 1];
+        batch.vChars.swap(m_vChars);
+        m_vChars.swap(vNext);
+        m_qBatches.push_back(std::move(batch));
+        bFailed = m_bFailed;
+    }
+    m_cvQueued.notify_one();
+    setp(&m_vChars[0], &m_vChars[0] + m_vChars.size());
+    pbump((int)nHeld);
+    return !bFailed;
+}
+
+/// <summary>
+/// Waits until the writer thread has written everything queued.
+/// </summary>
+bool Utf8OutputBuffer::WaitUntilWritten()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cvWritten.wait(lock, [this] { return m_qBatches.empty() && !m_bWriting; });
+    return !m_bFailed;
+}
+
+/// <summary>
+/// Converts and writes queued batches in order until Close stops it. After a write fails, remaining
+/// batches are discarded.
+/// </summary>
+void Utf8OutputBuffer::WriterThread()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;)
+    {
+        m_cvQueued.wait(lock, [this] { return !m_qBatches.empty() || m_bStopping; });
+        if (m_qBatches.empty())
+            break;
+        outputbatch_t batch = std::move(m_qBatches.front());
+        m_qBatches.pop_front();
+        m_bWriting = true;
+        const bool bFailed = m_bFailed;
+        lock.unlock();
+        // There's room in the queue again.
+        m_cvWritten.notify_all();
+
+        bool bWritten = true;
+        if (!bFailed)
+        {
+            const size_t cbData = WideToUtf8(&batch.vChars[0], batch.nChars, &m_vBytes[0]);
+            bWritten = WriteBytes(&m_vBytes[0], cbData);
+        }
+
+        lock.lock();
+        if (!bWritten)
+            m_bFailed = true;
+        m_bWriting = false;
+        m_vSpareBuffers.push_back(std::move(batch.vChars));
+        m_cvWritten.notify_all();
+    }
+}
+
+bool Utf8OutputBuffer::WriteBytes(const char* pData, size_t cbData)
+{
+    while (cbData > 0)
+    {
+#ifdef _WIN32
+        DWORD cbWritten = 0;
+        const DWORD cbToWrite = (cbData > 0x40000000) ? 0x40000000 : (DWORD)cbData;
+        if (!WriteFile(m_hFile, pData, cbToWrite, &cbWritten, nullptr) || 0 == cbWritten)
+            return false;
+#else
+        ssize_t cbWritten = write(m_fd, pData, cbData);
+        if (cbWritten < 0 && EINTR == errno)
+            continue;
+        if (cbWritten <= 0)
+            return false;
+#endif
+        pData += cbWritten;
+        cbData -= (size_t)cbWritten;
+    }
+    return true;
+}
+
+void Utf8FileOutput::open(const wchar_t* szFilename, bool bAppend)
+{
+    if (m_buffer.Open(szFilename, bAppend))
+        clear();
+    else
+        setstate(std::ios_base::failbit);
+}
+
+void Utf8FileOutput::close()
+{
+    if (!m_buffer.Close())
+        setstate(std::ios_base::failbit);
+}
 
 /// <summary>
 /// Creates a output file stream for UTF-8 output with BOM.
@@ -32,13 +330,14 @@ void ImbueStreamUtf8(std::wostream& stream, bool bGenerateHeader)
 /// <param name="fOutput">Output: resulting wofstream object</param>
 /// <param name="bAppend">Input: true to append to file, false to overwrite (default)</param>
 /// <returns>true on success, false otherwise</returns>
-bool CreateFileOutput(const wchar_t* szFilename, std::wofstream & fOutput, bool bAppend /*= false*/)
+bool CreateFileOutput(const wchar_t* szFilename, Utf8FileOutput& fOutput, bool bAppend /*= false*/)
 {
     // If appending and the file already exists and is more than 0 bytes in length, do not generate the BOM header.
     // If it doesn't exist or is zero-length, append doesn't matter, so use that bool to determine whether to 
     // generate the BOM.
     if (bAppend)
     {
+#ifdef _WIN32
         WIN32_FILE_ATTRIBUTE_DATA data = { 0 };
         if (GetFileAttributesExW(szFilename, GetFileExInfoStandard, &data))
         {
@@ -55,13 +354,110 @@ bool CreateFileOutput(const wchar_t* szFilename, std::wofstream & fOutput, bool
                 bAppend = false;
             }
         }
+#else
+        struct stat st;
+        if (0 == stat(WStringToUtf8(szFilename).c_str(), &st))
+        {
+            if (0 == st.st_size)
+            {
+                bAppend = false;
+            }
+        }
+        else if (ENOENT == errno)
+        {
+            bAppend = false;
+        }
+#endif
     }
-    fOutput.open(szFilename, (bAppend ? (std::ios_base::out | std::ios_base::app) : std::ios_base::out));
+    fOutput.open(szFilename, bAppend);
     if (fOutput.fail())
     {
         return false;
     }
-    // Ensure that file output is UTF-8. BOM unless appending to a non-empty existing file.
-    ImbueStreamUtf8(fOutput, !bAppend);
+    // BOM unless appending to a non-empty existing file.
+    if (!bAppend)
+        fOutput << L'\xFEFF';
     return true;
 }
+
+bool WriteBinaryFile(const std::wstring& sFilePath, const std::vector<uint8_t>& vData, std::wstring& sErrorInfo)
+{
+#ifdef _WIN32
+    std::ofstream file(sFilePath.c_str(), std::ios::binary | std::ios::trunc);
+#else
+    std::ofstream file(WStringToUtf8(sFilePath).c_str(), std::ios::binary | std::ios::trunc);
+#endif
+    if (!file.is_open())
+    {
+        sErrorInfo = L"Cannot create file " + sFilePath;
+        return false;
+    }
+    file.write((const char*)vData.data(), (std::streamsize)vData.size());
+    file.close();
+    if (file.fail())
+    {
+        sErrorInfo = L"Cannot write file " + sFilePath;
+        return false;
+    }
+    return true;
+}
+
+bool CreateDirectoryPath(const std::wstring& sDirectory, std::wstring& sErrorInfo)
+{
+    // Each parent in turn, then the directory itself; a drive or root prefix is skipped over as an existing directory.
+    size_t ixSep = sDirectory.find_first_of(L"/\\");
+    for (;;)
+    {
+        const std::wstring sPath = sDirectory.substr(0, ixSep);
+        if (!sPath.empty() && !IsDirectoryPath(sPath))
+        {
+#ifdef _WIN32
+            const bool bCreated = FALSE != CreateDirectoryW(sPath.c_str(), nullptr) || ERROR_ALREADY_EXISTS == GetLastError();
+#else
+            const bool bCreated = 0 == mkdir(WStringToUtf8(sPath).c_str(), 0777) || EEXIST == errno;
+#endif
+            if (!bCreated)
+            {
+                sErrorInfo = L"Cannot create directory " + sPath;
+                return false;
+            }
+        }
+        if (std::wstring::npos == ixSep)
+            return true;
+        ixSep = sDirectory.find_first_of(L"/\\", ixSep + 1);
+    }
+}
+
+bool DeleteFilePath(const std::wstring& sFilePath)
+{
+#ifdef _WIN32
+    return FALSE != DeleteFileW(sFilePath.c_str());
+#else
+    return 0 == unlink(WStringToUtf8(sFilePath).c_str());
+#endif
+}
+
+bool RenameFilePath(const std::wstring& sFromPath, const std::wstring& sToPath)
+{
+#ifdef _WIN32
+    return FALSE != MoveFileExW(sFromPath.c_str(), sToPath.c_str(), MOVEFILE_REPLACE_EXISTING);
+#else
+    return 0 == rename(WStringToUtf8(sFromPath).c_str(), WStringToUtf8(sToPath).c_str());
+#endif
+}
+
+bool TouchFilePath(const std::wstring& sFilePath)
+{
+#ifdef _WIN32
+    HANDLE hFile = CreateFileW(sFilePath.c_str(), FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (INVALID_HANDLE_VALUE == hFile)
+        return false;
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    const bool bSet = FALSE != SetFileTime(hFile, nullptr, nullptr, &now);
+    CloseHandle(hFile);
+    return bSet;
+#else
+    return 0 == utimensat(AT_FDCWD, WStringToUtf8(sFilePath).c_str(), nullptr, 0);
+#endif
+}
@@ -1,7 +1,14 @@
 #pragma once
 
+#include "PlatformDefs.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <fstream>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 /// <summary>
 /// Ensure that output stream produces UTF-8 with optional BOM
@@ -10,11 +17,158 @@
 /// <param name="bGenerateHeader">true to generate BOM at start of output sequence, false not to</param>
 void ImbueStreamUtf8(std::wostream& stream, bool bGenerateHeader = true);
 
+/// <summary>
+/// Stream buffer that converts wide-character output to UTF-8 and writes it to a file in large blocks.
+/// Characters are collected in a reusable buffer and converted (see WideToUtf8) only when the buffer fills,
+/// when the stream is flushed, or when it's closed; so output should end lines with L'\n' rather than
+/// std::endl, which flushes. Surrogate pairs split across buffer boundaries are kept together.
+///
+/// Full buffers are handed to a writer thread through a short queue, so the thread producing output keeps
+/// running while earlier output is converted and written; it waits only when the queue is full. The writer
+/// thread is started when the first buffer fills, so short output is written without one.
+/// Flushing waits until everything queued has been written.
+/// </summary>
+class Utf8OutputBuffer : public std::wstreambuf
+{
+public:
+    Utf8OutputBuffer();
+    ~Utf8OutputBuffer();
+
+    /// <summary>
+    /// Creates or opens the file for writing.
+    /// </summary>
+    /// <param name="szFilename">Input: name of output file</param>
+    /// <param name="bAppend">Input: true to append to the file, false to overwrite it</param>
+    /// <returns>true on success, false otherwise</returns>
+    bool Open(const wchar_t* szFilename, bool bAppend);
+
+    /// <summary>
+    /// Writes to the process's standard output, which remains open after Close.
+    /// </summary>
+    void AttachStdout();
+
+    /// <summary>
+    /// Writes any buffered output and closes the file.
+    /// </summary>
+    /// <returns>true if all output was written, false otherwise</returns>
+    bool Close();
+
+protected:
+    int_type overflow(int_type ch) override;
+    int sync() override;
+
+private:
+    /// <summary>
+    /// Characters handed to the writer thread.
+    /// </summary>
+    struct outputbatch_t
+    {
+        std::vector<wchar_t> vChars;
+        size_t nChars;
+    };
+
+    bool IsOpen() const;
+    bool QueueBuffered(bool bFinal);
+    bool WaitUntilWritten();
+    void WriterThread();
+    bool WriteBytes(const char* pData, size_t cbData);
+
+    // Buffer being filled; only the thread producing output uses it.
+    std::vector<wchar_t> m_vChars;
+    // Conversion output; only the writer thread uses it.
+    std::vector<char> m_vBytes;
+#ifdef _WIN32
+    HANDLE m_hFile;
+#else
+    int m_fd;
+#endif
+    bool m_bOwned;
+
+    // State shared with the writer thread, guarded by m_mutex.
+    std::mutex m_mutex;
+    std::condition_variable m_cvQueued;
+    std::condition_variable m_cvWritten;
+    std::deque<outputbatch_t> m_qBatches;
+    std::vector<std::vector<wchar_t>> m_vSpareBuffers;
+    std::thread m_writer;
+    bool m_bWriting;
+    bool m_bStopping;
+    bool m_bFailed;
+
+private:
+    // Not implemented
+    Utf8OutputBuffer(const Utf8OutputBuffer&) = delete;
+    Utf8OutputBuffer& operator = (const Utf8OutputBuffer&) = delete;
+};
+
+/// <summary>
+/// Output stream that writes UTF-8 through a Utf8OutputBuffer.
+/// </summary>
+class Utf8FileOutput : public std::wostream
+{
+public:
+    Utf8FileOutput() : std::wostream(nullptr) { rdbuf(&m_buffer); }
+
+    /// <summary>
+    /// Creates or opens the file for writing, setting the stream's failbit on failure.
+    /// </summary>
+    void open(const wchar_t* szFilename, bool bAppend = false);
+
+    /// <summary>
+    /// Writes to the process's standard output.
+    /// </summary>
+    void attach_stdout() { m_buffer.AttachStdout(); }
+
+    /// <summary>
+    /// Writes any buffered output and closes the file, setting the stream's failbit if any output couldn't be written.
+    /// </summary>
+    void close();
+
+private:
+    Utf8OutputBuffer m_buffer;
+};
+
 /// <summary>
 /// Creates a output file stream for UTF-8 output with BOM.
 /// </summary>
 /// <param name="szFilename">Input: name of output file</param>
-/// <param name="fOutput">Output: resulting wofstream object</param>
+/// <param name="fOutput">Output: resulting output stream object</param>
 /// <param name="bAppend">Input: true to append to file, false to overwrite (default)</param>
 /// <returns>true on success, false otherwise</returns>
-bool CreateFileOutput(const wchar_t* szFilename, std::wofstream& fOutput, bool bAppend = false);
+bool CreateFileOutput(const wchar_t* szFilename, Utf8FileOutput& fOutput, bool bAppend = false);
+
+/// <summary>
+/// Creates (or overwrites) a file with binary content.
+/// </summary>
+/// <param name="sFilePath">Input: path of the file to write</param>
+/// <param name="vData">Input: the file's content</param>
+/// <param name="sErrorInfo">Output: diagnostic information on failure</param>
+/// <returns>true if the complete file was written, false otherwise</returns>
+bool WriteBinaryFile(const std::wstring& sFilePath, const std::vector<uint8_t>& vData, std::wstring& sErrorInfo);
+
+/// <summary>
+/// Creates a directory, and any of its parent directories that don't exist.
+/// </summary>
+/// <param name="sDirectory">Input: path of the directory</param>
+/// <param name="sErrorInfo">Output: diagnostic information on failure</param>
+/// <returns>true if the directory exists or was created, false otherwise</returns>
+bool CreateDirectoryPath(const std::wstring& sDirectory, std::wstring& sErrorInfo);
+
+/// <summary>
+/// Deletes a file.
+/// </summary>
+/// <returns>true if the file was deleted, false otherwise</returns>
+bool DeleteFilePath(const std::wstring& sFilePath);
+
+/// <summary>
+/// Renames a file, replacing any file that has the new name. Where the platform allows, the replacement is atomic:
+/// a process opening the new name gets either the old file or the new one, never a partly written file.
+/// </summary>
+/// <returns>true if the file was renamed, false otherwise</returns>
+bool RenameFilePath(const std::wstring& sFromPath, const std::wstring& sToPath);
+
+/// <summary>
+/// Sets a file's last-write time to the current time.
+/// </summary>
+/// <returns>true if the time was set, false otherwise</returns>
+bool TouchFilePath(const std::wstring& sFilePath);
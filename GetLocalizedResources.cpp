@@ -1,19 +1,35 @@
 // GetLocalizedResources.cpp : This file contains the 'main' function. Program execution begins and ends there.
 //
 
-#include <Windows.h>
+#include "PlatformDefs.h"
 #include <iostream>
+#include <memory>
+#ifdef _WIN32
 #include <io.h>
 #include <fcntl.h>
+#endif
+#include "ArrowExport.h"
+#include "Benchmark.h"
 #include "FileOutput.h"
+#include "FileEnumeration.h"
+#include "CorpusExtraction.h"
+#include "ExtractionCache.h"
+#include "ResourceExtraction.h"
 #include "DialogTextExtraction.h"
 #include "StringTableExtraction.h"
 #include "MessageTableExtraction.h"
 #include "MenuTextExtraction.h"
 #include "IndirectStringExtraction.h"
+#include "MessageCatalog.h"
+#include "ResolverServer.h"
+#include "SyntheticFileGenerator.h"
 #include "SysErrorMessage.h"
 #include "UtilityFunctions.h"
+#ifdef _WIN32
 #include "LanguageChanger.h"
+#endif
+#include "LanguageNames.h"
+#include "ResourceFile.h"
 #include "Wow64FsRedirection.h"
 
 /// <summary>
@@ -34,16 +50,37 @@ static void Usage(const wchar_t* argv0, const wchar_t* szError = nullptr)
 		<< std::endl
 		<< L"Usage:" << std::endl
 		<< std::endl
-		<< L"    " << sExe << L" [-l langspec] [-o outfile] indirectString" << std::endl
+		<< L"    " << sExe << L" [-l langspec] [-r imageroot] [-o outfile] indirectString" << std::endl
+		<< L"    " << sExe << L" -i reflist [-l langspec] [-r imageroot] [-o outfile] [-j workers]" << std::endl
+		<< L"    " << sExe << L" -S socketpath [-l langspec] [-r imageroot]" << std::endl
 		<< L"    " << sExe << L" {-s|-d|-m|-n} [-l langspec] [-o outfile] resourceFile" << std::endl
+		<< L"    " << sExe << L" {-s|-d|-m|-n} [-l langspec | -L langlist] [-o outfile] [-j workers] [-c cachedir [-C megabytes]] [-f listfile] [path ...]" << std::endl
+		<< L"    " << sExe << L" -a [-l langspec | -L langlist] -o outfile [-j workers] [-c cachedir [-C megabytes]] [-f listfile] [path ...]" << std::endl
+		<< L"    " << sExe << L" {-s|-d|-m|-n|-a} -N [-l langspec | -L langlist] -o outfile [-j workers] [-c cachedir [-C megabytes]] [-f listfile] [path ...]" << std::endl
+		<< L"    " << sExe << L" {-s|-d|-m|-n|-a} -u outdir [-l langspec | -L langlist] [-j workers] [-c cachedir [-C megabytes]] [-f listfile] [path ...]" << std::endl
+		<< L"    " << sExe << L" -V [-l langspec | -L langlist] [-o outfile] [-j workers] [-f listfile] [path ...]" << std::endl
+		<< L"    " << sExe << L" -B catalogfile [-l langspec | -L langlist] [-j workers] [-c cachedir [-C megabytes]] [-f listfile] [path ...]" << std::endl
+		<< L"    " << sExe << L" -e ID [-l langspec] [-o outfile] catalogfile [module ...]" << std::endl
+		<< L"    " << sExe << L" -P [-o outfile] [benchmark ...]" << std::endl
+		<< L"    " << sExe << L" -G outdir [-o outfile] [setting=value ...]" << std::endl
 		<< std::endl
 		<< L"  -l langspec" << std::endl
 		<< L"       : use the specified language (if possible) instead of the default language." << std::endl
 		<< L"         Language specification must be in the \"name\" form, such as \"fr-FR\"." << std::endl
 		<< std::endl
+		<< L"  -L langlist" << std::endl
+		<< L"       : output every language in the resource file instead of one, with a leading \"Language\"" << std::endl
+		<< L"         column. For a language-neutral file, includes the .mui files in all its language" << std::endl
+		<< L"         subdirectories. langlist is * for all languages, or a comma-separated list of" << std::endl
+		<< L"         languages to include, such as \"fr-FR,de-DE\"." << std::endl
+		<< std::endl
 		<< L"  -o   : output to a named UTF-8 file. If -o not used, outputs to stdout." << std::endl
 		<< L"         (Recommended: much higher fidelity than Windows console redirection" << std::endl
 		<< L"         using \">\" or \"|\", especially with non-English languages.)" << std::endl
+		<< L"         If outfile has the extension .arrow, writes an Apache Arrow IPC file instead of" << std::endl
+		<< L"         tab-delimited text: one table with a row per item of text and columns module, type," << std::endl
+		<< L"         language, resource_id, resource_name, item_id, text, text_no_accels, and" << std::endl
+		<< L"         control_type. With -a, all four types go into that one file." << std::endl
 		<< std::endl
 		<< L"  indirectString" << std::endl
 		<< L"       : text beginning with the @ symbol that specifies a string resource, such as" << std::endl
@@ -53,11 +90,78 @@ static void Usage(const wchar_t* argv0, const wchar_t* szError = nullptr)
 		<< L"         Full documentation on the supported syntaxes for indirect strings here:" << std::endl
 		<< L"         https://learn.microsoft.com/en-us/windows/win32/api/shlwapi/nf-shlwapi-shloadindirectstring#remarks" << std::endl
 		<< std::endl
+		<< L"  -i reflist" << std::endl
+		<< L"       : resolve many indirect strings, one per line, from a UTF-8 text file (\"-\" for stdin)." << std::endl
+		<< L"         Each referenced file is read only once. Outputs the indirect string and its text, in" << std::endl
+		<< L"         input order. Only the @filepath,-stringID form is supported." << std::endl
+		<< L"  -r imageroot" << std::endl
+		<< L"       : resolve indirect strings against an offline Windows image (e.g., a mounted disk image)" << std::endl
+		<< L"         rather than the running system. Drive letters and variables such as %SystemRoot% refer" << std::endl
+		<< L"         to the image. On platforms other than Windows, indirect strings are always resolved by" << std::endl
+		<< L"         reading the files directly." << std::endl
+		<< std::endl
+		<< L"  -S socketpath" << std::endl
+		<< L"       : run as a lookup server on a Unix domain socket (not on Windows), keeping recently used" << std::endl
+		<< L"         files mapped. Each request is a line with tab-separated fields, answered with a line" << std::endl
+		<< L"         \"ok<TAB>text\" or \"error<TAB>info\":" << std::endl
+		<< L"           indirect<TAB>indirectString" << std::endl
+		<< L"           string<TAB>filepath<TAB>stringID" << std::endl
+		<< L"           message<TAB>filepath<TAB>messageID" << std::endl
+		<< L"           stats   (cache hit/miss counts and latency histograms)" << std::endl
+		<< std::endl
 		<< L"  If not referencing an indirect string, must pick one of -s, -d, -m, or -n:" << std::endl
 		<< L"  -s   : output contents of string table" << std::endl
 		<< L"  -d   : output text in dialog resources" << std::endl
 		<< L"  -m   : output contents of message table" << std::endl
 		<< L"  -n   : output text in menu resources" << std::endl
+		<< L"  -a   : output all four of the above, reading each file only once. Requires -o (or -u); output for" << std::endl
+		<< L"         each type goes to a separate file named after outfile, e.g., out-strings.txt, out-dialogs.txt," << std::endl
+		<< L"         out-messages.txt, and out-menus.txt for \"-o out.txt\"." << std::endl
+		<< L"  -N   : normalized output, writing each distinct text only once. Requires -o; outfile gets a line" << std::endl
+		<< L"         for each item of text with the IDs of its module and its text, and two more files named" << std::endl
+		<< L"         after outfile (e.g., out-texts.txt and out-modules.txt) list the texts and modules by ID." << std::endl
+		<< L"         Writes the number of items and of distinct texts to stderr." << std::endl
+		<< L"  -u outdir" << std::endl
+		<< L"       : incremental output: write each type's output into shards in a directory (e.g.," << std::endl
+		<< L"         strings-0000.txt, strings-0001.txt, ...), with a manifest of each file's size, time," << std::endl
+		<< L"         content hash, and shard. Rerun with the same directory to update it: only files whose" << std::endl
+		<< L"         size or time has changed, or that have a new .mui satellite file, are read, only those" << std::endl
+		<< L"         whose content has changed are decoded, and only the shards with changed, new, or removed" << std::endl
+		<< L"         files are rewritten." << std::endl
+		<< std::endl
+		<< L"  -V   : validate: decode every string table, dialog, message table, and menu resource of the files" << std::endl
+		<< L"         (in all languages unless -l or -L), and output a line for each malformed resource." << std::endl
+		<< L"         Writes the number of resources and each decoder's throughput to stderr. Exit code is 1" << std::endl
+		<< L"         if any problems were found." << std::endl
+		<< std::endl
+		<< L"  -B catalogfile" << std::endl
+		<< L"       : build a message catalog from the string tables and message tables of the files: an" << std::endl
+		<< L"         indexed file for fast lookups by ID with -e." << std::endl
+		<< L"  -e ID: look up a string ID or message ID (decimal, or hex with 0x) in a message catalog." << std::endl
+		<< L"         Outputs the text of the ID from every module in the catalog, or from the named modules" << std::endl
+		<< L"         (file names or full paths). With -l, only that language. Exit code is 1 if no text" << std::endl
+		<< L"         was found." << std::endl
+		<< std::endl
+		<< L"  -P   : run performance benchmarks of the text utilities and of each extractor over synthetic" << std::endl
+		<< L"         files (written to the temporary directory), with warm and cold file cache. Outputs" << std::endl
+		<< L"         JSON in Google Benchmark's format and writes a summary to stderr. Runs only the" << std::endl
+		<< L"         benchmarks whose names contain one of the benchmark arguments, if any (e.g., \"strings\")." << std::endl
+		<< L"         The accelerator benchmarks first check RemoveAccelsFromText against the original" << std::endl
+		<< L"         implementation over known and random strings, and fail if any result differs." << std::endl
+		<< L"         Allocations per item are counted only in a build with GLR_COUNT_ALLOCATIONS defined." << std::endl
+		<< std::endl
+		<< L"  -G outdir" << std::endl
+		<< L"       : generate synthetic PE files with string table, dialog, menu, and message table resources" << std::endl
+		<< L"         into a directory, for tests and scaling experiments. The same settings always produce" << std::endl
+		<< L"         the same files. Outputs the path of each file written. Settings (default in brackets):" << std::endl
+		<< L"           seed=N [1], files=N [1], pe=pe32|pe32+|mixed [pe32+], langs=langlist [en-US]," << std::endl
+		<< L"           mui=0|1: language-neutral files with .mui files in language subdirectories [0]," << std::endl
+		<< L"           strings=N (up to 65536) [100], dialogs=N [10], controls=N [10], menus=N [10]," << std::endl
+		<< L"           menupopups=N [4], menuitems=N [8], menudepth=N (up to 1000) [2]," << std::endl
+		<< L"           dialogform=classic|extended|mixed [mixed], menuform=classic|extended|mixed [mixed]," << std::endl
+		<< L"           messages=N [100], encoding=ansi|unicode|utf8|mixed [mixed]," << std::endl
+		<< L"           named=0|1: named rather than numbered dialogs and menus [0]," << std::endl
+		<< L"           misalign=0|1: resource data at odd offsets [0]" << std::endl
 		<< std::endl
 		<< L"  resourceFile" << std::endl
 		<< L"       : the resource PE file (e.g., EXE or DLL) from which to extract resources." << std::endl
@@ -65,28 +169,122 @@ static void Usage(const wchar_t* argv0, const wchar_t* szError = nullptr)
 		<< L"         Can be an EXE or DLL, or an associated .mui file." << std::endl
 		<< L"         If a system file, Windows will get the system's default localized resources." << std::endl
 		<< std::endl
+		<< L"  path : multiple resource files, directories (searched recursively), and/or wildcard" << std::endl
+		<< L"         patterns such as C:\\Windows\\System32\\*.dll. Extracts from all the files into one" << std::endl
+		<< L"         output, with a leading \"File path\" column. Files that aren't PE files or that don't" << std::endl
+		<< L"         contain the requested resource type are skipped, as are .mui files that a language-neutral" << std::endl
+		<< L"         file among the paths is opened with (their text is output with that file's path)." << std::endl
+		<< L"  -f listfile" << std::endl
+		<< L"       : also read paths, one per line, from a UTF-8 text file (\"-\" for stdin)." << std::endl
+		<< L"  -j workers" << std::endl
+		<< L"       : number of files to process in parallel (default: one per processor). Files are dealt out" << std::endl
+		<< L"         to the workers in turn, and a worker that runs out takes files from the others. A file with" << std::endl
+		<< L"         at least 256 KB of the requested resources is split into runs of resources that idle workers" << std::endl
+		<< L"         can take (except with -N, -V, or -B; a single file is decoded on this many threads), with the" << std::endl
+		<< L"         same output as from one thread; -j 1 decodes it on one. With paths, the time each worker was" << std::endl
+		<< L"         busy, and idle at the end, is written to stderr when done." << std::endl
+		<< L"  -c cachedir" << std::endl
+		<< L"       : keep each file's extracted text in a cache directory, keyed by a hash of the file's content" << std::endl
+		<< L"         (and its .mui files) and of the options, and reuse it for files that haven't changed since" << std::endl
+		<< L"         an earlier run, instead of decoding them again. Several runs can share a cache directory at" << std::endl
+		<< L"         once. Always extracts in corpus mode, with a \"File path\" column, even for a single file." << std::endl
+		<< L"         Writes the numbers of files found in and added to the cache to stderr." << std::endl
+		<< L"  -C megabytes" << std::endl
+		<< L"       : size cap of the cache directory (default 1024). When a run leaves the cache larger, the" << std::endl
+		<< L"         least recently used entries are removed." << std::endl
+		<< std::endl
 		<< L"Examples:" << std::endl
 		<< L"    " << sExe << L" \"@wsecedit.dll,-59167\"" << std::endl
 		<< L"    " << sExe << L" \"@wsecedit.dll,-59167\" -l fr-fr -o .\\59167-fr.txt" << std::endl
+		<< L"    " << sExe << L" -i .\\ServiceDisplayNames.txt -r D:\\ -o .\\ServiceDisplayNames-resolved.txt" << std::endl
 		<< L"    " << sExe << L" -d wsecedit.dll -o .\\wsecedit-dlg.txt" << std::endl
 		<< L"    " << sExe << L" -s -o .\\wsecedit-strings.txt C:\\Windows\\System32\\fr-FR\\wsecedit.dll.mui" << std::endl
 		<< L"    " << sExe << L" -m msprivs.dll -l fr-FR -o .\\msprivs-French.txt" << std::endl
 		<< L"    " << sExe << L" -m ntdll.dll -o .\\AllTheNtstatusErrorMessages.txt" << std::endl
 		<< L"    " << sExe << L" -m kernel32.dll -o .\\LotsOfTheWin32ErrorMessages.txt" << std::endl
+		<< L"    " << sExe << L" -s -o .\\System32-strings.txt C:\\Windows\\System32" << std::endl
+		<< L"    " << sExe << L" -a -o .\\wsecedit.txt wsecedit.dll" << std::endl
+		<< L"    " << sExe << L" -d -L * -o .\\wsecedit-dlg-all.txt wsecedit.dll" << std::endl
+		<< L"    " << sExe << L" -a -L * -o .\\System32.arrow C:\\Windows\\System32" << std::endl
+		<< L"    " << sExe << L" -a -N -L * -o .\\System32.txt C:\\Windows\\System32" << std::endl
+		<< L"    " << sExe << L" -a -o .\\System32.txt -c .\\glrcache C:\\Windows\\System32" << std::endl
+		<< L"    " << sExe << L" -a -L * -u .\\System32-text C:\\Windows\\System32" << std::endl
+		<< L"    " << sExe << L" -V -o .\\System32-problems.txt C:\\Windows\\System32" << std::endl
+		<< L"    " << sExe << L" -B .\\errors.glrcat ntdll.dll kernel32.dll" << std::endl
+		<< L"    " << sExe << L" -e 0xC0000005 .\\errors.glrcat ntdll.dll" << std::endl
+		<< L"    " << sExe << L" -P -o .\\benchmark.json" << std::endl
+		<< L"    " << sExe << L" -G .\\synthetic files=10 langs=en-US,fr-FR,ja-JP mui=1 seed=7" << std::endl
+		<< L"    " << sExe << L" -G .\\huge strings=65536 messages=1000000 menudepth=1000 misalign=1" << std::endl
 		<< std::endl;
 	exit(-1);
 }
 
+/// <summary>
+/// Returns the name of the output file for one resource type in -a mode: the type's name is
+/// appended to the output file's base name, e.g., C:\\out\\wsecedit-dialogs.txt for C:\\out\\wsecedit.txt.
+/// </summary>
+static std::wstring OutputFileForType(const std::wstring& sOutFile, const wchar_t* szTypeName)
+{
+	std::wstring sDirectory, sFilenameNoExt, sExtension;
+	SplitFilePath(sOutFile, sDirectory, sFilenameNoExt, sExtension);
+	std::wstring sResult = sOutFile.substr(0, sOutFile.length() - GetFileNameFromFilePath(sOutFile).length());
+	sResult += sFilenameNoExt + L"-" + szTypeName;
+	if (sExtension.length() > 0)
+		sResult += L"." + sExtension;
+	return sResult;
+}
+
+/// <summary>
+/// Returns the full path of a resource file specified without a path, if it can be found
+/// in the places Windows looks for DLLs (e.g., System32 and the directories in the PATH).
+/// Otherwise (and on non-Windows platforms) returns the input unchanged.
+/// </summary>
+static std::wstring ResolveResourceFilePath(const std::wstring& sResource)
+{
+#ifdef _WIN32
+	if (std::wstring::npos == sResource.find_first_of(L"/\\:") && !IsDirectoryPath(sResource))
+	{
+		wchar_t szFullPath[MAX_PATH];
+		DWORD dwLen = SearchPathW(nullptr, sResource.c_str(), nullptr, MAX_PATH, szFullPath, nullptr);
+		if (dwLen > 0 && dwLen < MAX_PATH)
+			return szFullPath;
+	}
+#endif
+	return sResource;
+}
+
+/// <summary>
+/// Number of resource files the lookup server keeps mapped.
+/// </summary>
+static const size_t nServerCacheFiles = 256;
+
 int wmain(int argc, wchar_t** argv)
 {
 	// Set output mode to UTF8.
+#ifdef _WIN32
 	if (_setmode(_fileno(stdout), _O_U8TEXT) == -1 || _setmode(_fileno(stderr), _O_U8TEXT) == -1)
 	{
 		std::wcerr << L"Unable to set stdout and/or stderr modes to UTF8." << std::endl;
 	}
+#else
+	// Wide-character streams have to be independent of C stdio for their locale to take effect.
+	std::ios_base::sync_with_stdio(false);
+	ImbueStreamUtf8(std::wcout, false);
+	ImbueStreamUtf8(std::wcerr, false);
+#endif
 
 	bool bOut_toFile = false;
-	std::wstring sOutFile, sResource, sLangSpec;
+	// Normalized output (-N): texts and modules by ID
+	bool bNormalized = false;
+	// Cache size cap given (-C)
+	bool bCacheMax = false;
+	std::wstring sOutFile, sResource, sLangSpec, sLangList, sFileList, sRefList, sImageRoot, sSocketPath, sCatalogFile, sLookupId, sGenerateDir, sCacheDir, sUpdateDir;
+	// All resource file names/directories/patterns on the command line, in order
+	std::vector<std::wstring> vResources;
+	// Number of worker threads for multiple files; 0 for the default
+	unsigned int nWorkers = 0;
+	// Size cap of the extraction cache (-C), in megabytes
+	unsigned long ulCacheMegabytes = 1024;
 	enum class option_t
 	{
 		eNotSet,
@@ -94,7 +292,15 @@ int wmain(int argc, wchar_t** argv)
 		eDialog,
 		eMessageTable,
 		eMenu,
-		eIndirectString
+		eAllTypes,
+		eIndirectString,
+		eIndirectStringBatch,
+		eResolverServer,
+		eValidate,
+		eBuildCatalog,
+		eCatalogLookup,
+		eBenchmark,
+		eGenerate
 	} option = option_t::eNotSet;
 
 	// Optional redirection for stdout and stderr.
@@ -104,10 +310,12 @@ int wmain(int argc, wchar_t** argv)
 	std::wostream* pWCout = &std::wcout;
 	std::wostream* pWCerr = &std::wcerr;
 	// Option for file output streams.
-	std::wofstream fOut, fErr;
+	Utf8FileOutput fOut, fErr;
 	bool bCloseFOut = false, bCloseFErr = false;
 
+#ifdef _WIN32
 	LanguageChanger languageChanger;
+#endif
 
 	// Process command-line arguments
 	int ixArg = 1;
@@ -122,6 +330,14 @@ int wmain(int argc, wchar_t** argv)
 			option = option_t::eMessageTable;
 		else if (0 == wcscmp(L"-n", argv[ixArg]))
 			option = option_t::eMenu;
+		else if (0 == wcscmp(L"-a", argv[ixArg]))
+			option = option_t::eAllTypes;
+		else if (0 == wcscmp(L"-N", argv[ixArg]))
+			bNormalized = true;
+		else if (0 == wcscmp(L"-V", argv[ixArg]))
+			option = option_t::eValidate;
+		else if (0 == wcscmp(L"-P", argv[ixArg]))
+			option = option_t::eBenchmark;
 		else if (0 == wcscmp(L"-o", argv[ixArg]))
 		{
 			// Check for already set output file
@@ -141,68 +357,436 @@ int wmain(int argc, wchar_t** argv)
 				Usage(argv[0], L"Missing arg for -l");
 			sLangSpec = argv[ixArg];
 		}
+		else if (0 == wcscmp(L"-L", argv[ixArg]))
+		{
+			if (sLangList.length() > 0)
+				Usage(argv[0], L"Language list specified multiple times");
+			if (++ixArg >= argc)
+				Usage(argv[0], L"Missing arg for -L");
+			sLangList = argv[ixArg];
+		}
+		else if (0 == wcscmp(L"-i", argv[ixArg]))
+		{
+			if (option_t::eIndirectStringBatch == option)
+				Usage(argv[0], L"Indirect string list specified multiple times");
+			if (++ixArg >= argc)
+				Usage(argv[0], L"Missing arg for -i");
+			option = option_t::eIndirectStringBatch;
+			sRefList = argv[ixArg];
+		}
+		else if (0 == wcscmp(L"-S", argv[ixArg]))
+		{
+			if (option_t::eResolverServer == option)
+				Usage(argv[0], L"Socket path specified multiple times");
+			if (++ixArg >= argc)
+				Usage(argv[0], L"Missing arg for -S");
+			option = option_t::eResolverServer;
+			sSocketPath = argv[ixArg];
+		}
+		else if (0 == wcscmp(L"-B", argv[ixArg]))
+		{
+			if (option_t::eBuildCatalog == option)
+				Usage(argv[0], L"Catalog file specified multiple times");
+			if (++ixArg >= argc)
+				Usage(argv[0], L"Missing arg for -B");
+			option = option_t::eBuildCatalog;
+			sCatalogFile = argv[ixArg];
+		}
+		else if (0 == wcscmp(L"-e", argv[ixArg]))
+		{
+			if (option_t::eCatalogLookup == option)
+				Usage(argv[0], L"ID specified multiple times");
+			if (++ixArg >= argc)
+				Usage(argv[0], L"Missing arg for -e");
+			option = option_t::eCatalogLookup;
+			sLookupId = argv[ixArg];
+		}
+		else if (0 == wcscmp(L"-G", argv[ixArg]))
+		{
+			if (option_t::eGenerate == option)
+				Usage(argv[0], L"Output directory specified multiple times");
+			if (++ixArg >= argc)
+				Usage(argv[0], L"Missing arg for -G");
+			option = option_t::eGenerate;
+			sGenerateDir = argv[ixArg];
+		}
+		else if (0 == wcscmp(L"-r", argv[ixArg]))
+		{
+			if (sImageRoot.length() > 0)
+				Usage(argv[0], L"Image root specified multiple times");
+			if (++ixArg >= argc)
+				Usage(argv[0], L"Missing arg for -r");
+			sImageRoot = argv[ixArg];
+		}
+		else if (0 == wcscmp(L"-f", argv[ixArg]))
+		{
+			if (sFileList.length() > 0)
+				Usage(argv[0], L"File list specified multiple times");
+			if (++ixArg >= argc)
+				Usage(argv[0], L"Missing arg for -f");
+			sFileList = argv[ixArg];
+		}
+		else if (0 == wcscmp(L"-j", argv[ixArg]))
+		{
+			if (++ixArg >= argc)
+				Usage(argv[0], L"Missing arg for -j");
+			wchar_t* szEnd = nullptr;
+			unsigned long ulWorkers = wcstoul(argv[ixArg], &szEnd, 10);
+			if (0 == ulWorkers || ulWorkers > 1024 || nullptr == szEnd || 0 != *szEnd)
+				Usage(argv[0], L"Invalid number of workers for -j");
+			nWorkers = (unsigned int)ulWorkers;
+		}
+		else if (0 == wcscmp(L"-u", argv[ixArg]))
+		{
+			if (sUpdateDir.length() > 0)
+				Usage(argv[0], L"Output directory specified multiple times");
+			if (++ixArg >= argc)
+				Usage(argv[0], L"Missing arg for -u");
+			sUpdateDir = argv[ixArg];
+		}
+		else if (0 == wcscmp(L"-c", argv[ixArg]))
+		{
+			if (sCacheDir.length() > 0)
+				Usage(argv[0], L"Cache directory specified multiple times");
+			if (++ixArg >= argc)
+				Usage(argv[0], L"Missing arg for -c");
+			sCacheDir = argv[ixArg];
+		}
+		else if (0 == wcscmp(L"-C", argv[ixArg]))
+		{
+			if (++ixArg >= argc)
+				Usage(argv[0], L"Missing arg for -C");
+			wchar_t* szEnd = nullptr;
+			bCacheMax = true;
+			ulCacheMegabytes = wcstoul(argv[ixArg], &szEnd, 10);
+			if (0 == ulCacheMegabytes || ulCacheMegabytes > 1048576 || nullptr == szEnd || 0 != *szEnd)
+				Usage(argv[0], L"Invalid cache size for -C");
+		}
 		else
 		{
-			// Already set file name
-			if (sResource.length() > 0)
+			// Only one indirect string, and nothing else with it
+			if (option_t::eIndirectString == option)
 				Usage(argv[0]);
-			sResource = argv[ixArg];
-			if (L'@' == sResource[0])
+			if (L'@' == argv[ixArg][0])
 			{
-				if (option_t::eNotSet != option)
+				if (option_t::eNotSet != option || sResource.length() > 0)
 				{
 					Usage(argv[0], L"Don't use -s -m -n or -o switches with indirect string");
 				}
 				option = option_t::eIndirectString;
 			}
+			if (0 == sResource.length())
+				sResource = argv[ixArg];
+			vResources.push_back(argv[ixArg]);
 		}
 		++ixArg;
 	}
 	// Validate command line
 	if (option_t::eNotSet == option)
 		Usage(argv[0], L"Option not specified.");
-	if (0 == sResource.length())
+	const bool bIndirect = (option_t::eIndirectString == option || option_t::eIndirectStringBatch == option || option_t::eResolverServer == option);
+	const bool bBenchmark = (option_t::eBenchmark == option);
+	const bool bGenerate = (option_t::eGenerate == option);
+	if (option_t::eIndirectStringBatch == option || option_t::eResolverServer == option)
+	{
+		if (vResources.size() > 0)
+			Usage(argv[0], L"Don't specify resource files with -i or -S");
+	}
+	else if (bBenchmark)
+	{
+		// Arguments name benchmarks rather than files.
+		if (sFileList.length() > 0 || sLangSpec.length() > 0 || sLangList.length() > 0 || sImageRoot.length() > 0)
+			Usage(argv[0], L"Don't use -f, -l, -L, or -r with -P");
+	}
+	else if (bGenerate)
+	{
+		// Arguments are generator settings rather than files.
+		if (sFileList.length() > 0 || sLangSpec.length() > 0 || sLangList.length() > 0 || sImageRoot.length() > 0)
+			Usage(argv[0], L"Don't use -f, -l, -L, or -r with -G; use the langs setting for languages");
+	}
+	else if (0 == sResource.length() && 0 == sFileList.length())
 		Usage(argv[0], L"Resource file not specified.");
+	if (bIndirect && sFileList.length() > 0)
+		Usage(argv[0], L"Don't use -f with indirect string");
+	if (!bIndirect && sImageRoot.length() > 0)
+		Usage(argv[0], L"-r can be used only with indirect strings");
+	if (sImageRoot.length() > 0 && !IsDirectoryPath(sImageRoot))
+		Usage(argv[0], L"Image root is not a directory");
+	if (option_t::eAllTypes == option && !bOut_toFile && 0 == sUpdateDir.length())
+		Usage(argv[0], L"-a requires -o or -u");
+	if (sLangList.length() > 0 && sLangSpec.length() > 0)
+		Usage(argv[0], L"Don't use -l with -L");
+	if (bIndirect && sLangList.length() > 0)
+		Usage(argv[0], L"Don't use -L with indirect string");
+
+	// Columnar output instead of tab-delimited text, chosen by the output file's extension
+	bool bArrowOut = false;
+	if (bOut_toFile)
+	{
+		std::wstring sDirectory, sFilenameNoExt, sExtension;
+		SplitFilePath(sOutFile, sDirectory, sFilenameNoExt, sExtension);
+		bArrowOut = (0 == _wcsicmp(sExtension.c_str(), L"arrow"));
+	}
+	if (bArrowOut && bIndirect)
+		Usage(argv[0], L"Arrow output (-o *.arrow) is for resource files, not indirect strings");
+	if (bArrowOut && bBenchmark)
+		Usage(argv[0], L"Benchmark results are JSON, not Arrow output (-o *.arrow)");
+	if (bArrowOut && bGenerate)
+		Usage(argv[0], L"Arrow output (-o *.arrow) is for extracted text, not generated file paths");
+	if (bArrowOut && bNormalized)
+		Usage(argv[0], L"Normalized output (-N) is tab-delimited text, not Arrow output (-o *.arrow)");
+
+	// Generator settings
+	generatoroptions_t generatorOptions;
+	if (bGenerate)
+	{
+		for (const std::wstring& sSetting : vResources)
+		{
+			std::wstring sErrorInfo;
+			if (!ParseGeneratorSetting(sSetting, generatorOptions, sErrorInfo))
+			{
+				std::wstring sErrText = L"Invalid generator setting: " + sErrorInfo;
+				Usage(argv[0], sErrText.c_str());
+			}
+		}
+	}
+
+	// Message catalog: built from resource files, or looked up in, with the catalog named by the first path
+	const bool bCatalogLookup = (option_t::eCatalogLookup == option);
+	uint32_t lookupId = 0;
+	uint16_t lookupLangId = 0;
+	if (option_t::eValidate == option && bArrowOut)
+		Usage(argv[0], L"Arrow output (-o *.arrow) is for extracted text, not validation");
+	if (option_t::eBuildCatalog == option && bOut_toFile)
+		Usage(argv[0], L"Don't use -o with -B");
+	if (bCatalogLookup)
+	{
+		if (!ParseId(sLookupId, 0xFFFFFFFF, lookupId))
+			Usage(argv[0], L"Invalid ID for -e");
+		if (sFileList.length() > 0 || sLangList.length() > 0 || bArrowOut)
+			Usage(argv[0], L"Don't use -f, -L, or Arrow output with -e");
+		if (sLangSpec.length() > 0 && !LangIdFromName(sLangSpec, lookupLangId))
+			Usage(argv[0], L"Unrecognized language name");
+	}
+
+	// Languages to extract
+	languageoptions_t languages;
+	languages.vPreferred = PreferredUILanguages(sLangSpec);
+	if (sLangList.length() > 0 || (option_t::eValidate == option && sLangSpec.empty()))
+	{
+		std::wstring sErrorInfo;
+		languages.bAllLanguages = true;
+		if (sLangList.length() > 0 && L"*" != sLangList && !LangIdsFromNameList(sLangList, languages.vFilter, sErrorInfo))
+		{
+			std::wstring sErrText = L"Language list not valid: " + sErrorInfo;
+			Usage(argv[0], sErrText.c_str());
+		}
+	}
+
+	// Resource types to extract
+	std::vector<rsrctype_t> vTypes;
+	switch (option)
+	{
+	case option_t::eStringTable:
+		vTypes.push_back(rsrctype_t::eString);
+		break;
+	case option_t::eDialog:
+		vTypes.push_back(rsrctype_t::eDialog);
+		break;
+	case option_t::eMessageTable:
+		vTypes.push_back(rsrctype_t::eMessageTable);
+		break;
+	case option_t::eMenu:
+		vTypes.push_back(rsrctype_t::eMenu);
+		break;
+	case option_t::eAllTypes:
+		vTypes = AllExtractableTypes();
+		break;
+	default:
+		break;
+	}
+	if (bNormalized && vTypes.empty())
+		Usage(argv[0], L"-N requires -s, -d, -m, -n, or -a");
+	if (bNormalized && !bOut_toFile)
+		Usage(argv[0], L"-N requires -o");
+	if (sCacheDir.length() > 0 && (bIndirect || bCatalogLookup || bBenchmark || bGenerate || option_t::eValidate == option))
+		Usage(argv[0], L"-c is for extracting text from resource files, with -s, -d, -m, -n, -a, or -B");
+	if (bCacheMax && 0 == sCacheDir.length())
+		Usage(argv[0], L"-C requires -c");
+	if (sUpdateDir.length() > 0 && (vTypes.empty() || bNormalized || bOut_toFile))
+		Usage(argv[0], L"-u requires -s, -d, -m, -n, or -a, and writes its own files: don't use -N or -o with it");
+
+	Wow64FsRedirection fsRedir;
+
+	// Multiple files, a directory, or a wildcard pattern: extract from all the files ("corpus mode").
+	// Normalized output always is, even for a single file, and so are extraction with the cache and incremental
+	// extraction.
+	bool bCorpus = (option_t::eBuildCatalog == option || option_t::eValidate == option || bNormalized || sCacheDir.length() > 0 || sUpdateDir.length() > 0);
+	if (!bIndirect && !bCatalogLookup && !bBenchmark && !bGenerate && !bCorpus)
+	{
+		fsRedir.Disable();
+		bCorpus =
+			sFileList.length() > 0 ||
+			vResources.size() > 1 ||
+			IsDirectoryPath(sResource) ||
+			HasWildcards(sResource);
+		fsRedir.Revert();
+	}
 
 	// If language specified, switch to it
 	if (sLangSpec.length() > 0)
 	{
 		std::wstring sErrorInfo;
-		if (!languageChanger.SetLanguage(sLangSpec.c_str(), sErrorInfo))
+#ifdef _WIN32
+		bool bLangSet = languageChanger.SetLanguage(sLangSpec.c_str(), sErrorInfo);
+#else
+		// No thread UI language to set; just validate the name, which is used to choose among resources.
+		uint16_t langId;
+		bool bLangSet = LangIdFromName(sLangSpec, langId);
+		if (!bLangSet)
+			sErrorInfo = L"Unrecognized language name";
+#endif
+		if (!bLangSet)
 		{
 			std::wstring sErrText = L"Language not set: " + sErrorInfo;
 			Usage(argv[0], sErrText.c_str());
 		}
 	}
 
-	Wow64FsRedirection fsRedir;
-	HMODULE hModule = NULL;
+	ResourceFile rsrcFile;
+	std::vector<std::wstring> vFiles;
+	// Extraction results from earlier runs, with -c
+	ExtractionCache extractionCache;
+	ExtractionCache* pCache = nullptr;
+	// Indirect strings to resolve with -i
+	std::vector<std::wstring> vReferences;
+
+	if (bCorpus)
+	{
+		// Gather the files to inspect.
+		std::vector<std::wstring> vSpecs = vResources;
+		std::wstring sErrorInfo;
+		if (sFileList.length() > 0 && !ReadFileList(sFileList, vSpecs, sErrorInfo))
+		{
+			std::wcerr << sErrorInfo << std::endl;
+			Usage(argv[0]);
+		}
+		fsRedir.Disable();
+		for (const std::wstring& sSpec : vSpecs)
+		{
+			if (!ExpandFileSpec(ResolveResourceFilePath(sSpec), vFiles, sErrorInfo))
+				std::wcerr << sErrorInfo << std::endl;
+		}
+		fsRedir.Revert();
 
-	if (option_t::eIndirectString != option)
+		if (sCacheDir.length() > 0)
+		{
+			if (!extractionCache.Open(sCacheDir, (uint64_t)ulCacheMegabytes << 20, sErrorInfo))
+			{
+				std::wstring sErrText = L"Cannot use cache directory: " + sErrorInfo;
+				Usage(argv[0], sErrText.c_str());
+			}
+			pCache = &extractionCache;
+		}
+	}
+	else if (option_t::eIndirectStringBatch == option)
 	{
-		// Load the resource file. 
+		std::wstring sErrorInfo;
+		if (!ReadFileList(sRefList, vReferences, sErrorInfo))
+		{
+			std::wcerr << sErrorInfo << std::endl;
+			Usage(argv[0]);
+		}
+	}
+	else if (!bIndirect && !bCatalogLookup && !bBenchmark && !bGenerate)
+	{
+		// Map the resource file (and its .mui file for the preferred language, if it has one).
 		// Temporarily disable WOW64 file system redirection so if this is a 32-bit process it can still
 		// access resources in the System32 directory on 64-bit Windows.
+		std::wstring sErrorInfo;
 		fsRedir.Disable();
-		hModule = LoadLibraryExW(sResource.c_str(), NULL, LOAD_LIBRARY_AS_DATAFILE);
-		DWORD dwLastErr = GetLastError();
+		bool bOpened = OpenResourceFile(rsrcFile, ResolveResourceFilePath(sResource), languages, sErrorInfo);
 		fsRedir.Revert();
-		if (!hModule)
+		if (!bOpened)
 		{
 			std::wcerr
 				<< L"Cannot load resource file " << sResource << std::endl
-				<< SysErrorMessageWithCode(dwLastErr) << std::endl;
+				<< sErrorInfo << std::endl;
 			Usage(argv[0]);
 		}
 	}
 
-	// Set up output file if specified.
-	if (bOut_toFile)
+	// Output stream for each resource type
+	std::vector<std::wostream*> vOuts;
+	// Files for each resource type, or for normalized output, the references, texts, and modules
+	std::vector<std::unique_ptr<Utf8FileOutput>> vTypeOuts;
+	ArrowFileWriter arrowOut;
+
+	// Set up output file(s) if specified.
+	if (bArrowOut)
+	{
+		// One file for all resource types, with a column for the type
+		std::wstring sErrorInfo;
+		fsRedir.Disable();
+		bool bFileCreated = arrowOut.Open(sOutFile, sErrorInfo);
+		fsRedir.Revert();
+		if (!bFileCreated)
+		{
+			std::wcerr << L"Error: Couldn't open output file " << sOutFile << std::endl;
+			Usage(argv[0]);
+		}
+	}
+	else if (bNormalized)
+	{
+		// References go to the named file, for all the resource types; the texts and modules to files named after it.
+		const std::wstring vNormalizedFiles[] = { sOutFile, OutputFileForType(sOutFile, L"texts"), OutputFileForType(sOutFile, L"modules") };
+		for (const std::wstring& sNormalizedFile : vNormalizedFiles)
+		{
+			vTypeOuts.emplace_back(new Utf8FileOutput());
+			fsRedir.Disable();
+			bool bFileCreated = CreateFileOutput(sNormalizedFile.c_str(), *vTypeOuts.back());
+			fsRedir.Revert();
+			if (!bFileCreated)
+			{
+				std::wcerr << L"Error: Couldn't open output file " << sNormalizedFile << std::endl;
+				Usage(argv[0]);
+			}
+		}
+	}
+	else if (option_t::eAllTypes == option)
+	{
+		// One file per resource type
+		for (size_t ixType = 0; ixType < vTypes.size(); ++ixType)
+		{
+			std::wstring sTypeOutFile = OutputFileForType(sOutFile, ResourceExtractor(vTypes[ixType]).szName);
+			vTypeOuts.emplace_back(new Utf8FileOutput());
+			fsRedir.Disable();
+			bool bFileCreated = CreateFileOutput(sTypeOutFile.c_str(), *vTypeOuts[ixType]);
+			fsRedir.Revert();
+			if (!bFileCreated)
+			{
+				std::wcerr << L"Error: Couldn't open output file " << sTypeOutFile << std::endl;
+				Usage(argv[0]);
+			}
+			vOuts.push_back(vTypeOuts[ixType].get());
+		}
+	}
+	else if (bOut_toFile)
 	{
 		// Maybe not a good idea to write the output in/under the System32 directory, but allow it
 		// rather than redirect to SysWOW64.
 		fsRedir.Disable();
-		bool bFileCreated = CreateFileOutput(sOutFile.c_str(), fOut);
+		bool bFileCreated;
+		if (bBenchmark)
+		{
+			// JSON, for other tools to read: no BOM
+			fOut.open(sOutFile.c_str());
+			bFileCreated = !fOut.fail();
+		}
+		else
+		{
+			bFileCreated = CreateFileOutput(sOutFile.c_str(), fOut);
+		}
 		fsRedir.Revert();
 		if (bFileCreated)
 		{
@@ -212,46 +796,160 @@ int wmain(int argc, wchar_t** argv)
 		else
 		{
 			std::wcerr << L"Error: Couldn't open output file " << sOutFile << std::endl;
-			if (NULL != hModule)
-				FreeLibrary(hModule);
 			Usage(argv[0]);
 		}
 	}
+#ifndef _WIN32
+	else
+	{
+		// No console to accommodate: stdout gets the same buffered UTF-8 output as a file.
+		fOut.attach_stdout();
+		pWCout = &fOut;
+		bCloseFOut = true;
+	}
+#endif
+
+	if (vOuts.empty())
+		vOuts.push_back(pWCout);
 
 	// Single object specifying output and error streams
 	streams_t streams(*pWCout, *pWCerr);
 
 	// Do the work...
-	switch (option)
+	int exitCode = 0;
+	if (bArrowOut)
+	{
+		// Records go straight from the decoders into the columns, with no tab-delimited text in between.
+		if (bCorpus)
+		{
+			CorpusRecordExtraction(
+				vFiles, vTypes, languages, nWorkers, pCache,
+				[&arrowOut](const std::wstring& sFilePath, const resourcerecord_t& record) { arrowOut.Add(sFilePath, record); },
+				*pWCerr);
+		}
+		else
+		{
+			ExtractRecords(rsrcFile, vTypes, [&](const resourcerecord_t& record) { arrowOut.Add(rsrcFile.FilePath(), record); }, *pWCerr);
+		}
+		std::wstring sErrorInfo;
+		if (!arrowOut.Close(sErrorInfo))
+		{
+			*pWCerr << L"Error: Couldn't write output file " << sOutFile << L": " << sErrorInfo << std::endl;
+			exitCode = 1;
+		}
+	}
+	else if (option_t::eValidate == option)
+	{
+		if (!CorpusValidation(vFiles, languages, nWorkers, *pWCout, *pWCerr))
+			exitCode = 1;
+	}
+	else if (option_t::eBuildCatalog == option)
+	{
+		if (!BuildMessageCatalog(vFiles, languages, nWorkers, pCache, sCatalogFile, *pWCerr))
+			exitCode = 1;
+	}
+	else if (bBenchmark)
+	{
+		benchmarkoptions_t benchmarkOptions;
+		benchmarkOptions.vFilters = vResources;
+		if (!RunBenchmarks(benchmarkOptions, *pWCout, *pWCerr))
+			exitCode = 1;
+	}
+	else if (bGenerate)
+	{
+		if (!GenerateSyntheticFiles(generatorOptions, sGenerateDir, *pWCout, *pWCerr))
+			exitCode = 1;
+	}
+	else if (bCatalogLookup)
+	{
+		const std::vector<std::wstring> vModules(vResources.begin() + 1, vResources.end());
+		if (!MessageCatalogLookup(sResource, lookupId, vModules, lookupLangId, streams))
+			exitCode = 1;
+	}
+	else if (bNormalized)
+	{
+		const normalizedoutputs_t outs = { *vTypeOuts[0], *vTypeOuts[1], *vTypeOuts[2] };
+		if (!CorpusNormalizedExtraction(vFiles, vTypes, languages, nWorkers, pCache, outs, *pWCerr))
+			exitCode = 1;
+	}
+	else if (sUpdateDir.length() > 0)
+	{
+		if (!IncrementalCorpusExtraction(vFiles, vTypes, languages, nWorkers, pCache, sUpdateDir, *pWCerr))
+			exitCode = 1;
+	}
+	else if (bCorpus)
+	{
+		if (!CorpusExtraction(vFiles, vTypes, languages, nWorkers, pCache, vOuts, *pWCerr))
+			exitCode = 1;
+	}
+	else if (option_t::eAllTypes == option || languages.bAllLanguages)
+	{
+		// All requested resource types and/or languages from a single pass over the resource directory
+		for (size_t ixType = 0; ixType < vTypes.size(); ++ixType)
+			WriteResourceHeaders(vTypes[ixType], languages.bAllLanguages, *vOuts[ixType]);
+		TextArena arena;
+		ExtractResources(rsrcFile, vTypes, vOuts, *pWCerr, arena, nWorkers);
+	}
+	else switch (option)
 	{
 	case option_t::eStringTable:
-		StringTableExtraction(hModule, streams);
+		StringTableExtraction(rsrcFile, streams, nWorkers);
 		break;
 	case option_t::eDialog:
-		DialogTextExtraction(hModule, streams);
+		DialogTextExtraction(rsrcFile, streams, nWorkers);
 		break;
 	case option_t::eMessageTable:
-		MessageTableExtraction(hModule, streams);
+		MessageTableExtraction(rsrcFile, streams, nWorkers);
 		break;
 	case option_t::eMenu:
-		MenuTextExtraction(hModule, streams);
+		MenuTextExtraction(rsrcFile, streams, nWorkers);
 		break;
 	case option_t::eIndirectString:
-		IndirectStringExtraction(sResource, streams);
+		IndirectStringExtraction(sResource, languages.vPreferred, sImageRoot, streams);
+		break;
+	case option_t::eIndirectStringBatch:
+		IndirectStringBatchExtraction(vReferences, languages.vPreferred, sImageRoot, nWorkers, streams);
+		break;
+	case option_t::eResolverServer:
+		ResolverServer(sSocketPath, languages.vPreferred, sImageRoot, nServerCacheFiles, *pWCerr);
 		break;
 	default:
 		streams.WCerr << L"This option doesn't exist - WTAF? " << (int)option << std::endl;
 		break;
 	}
 
-	if (NULL != hModule)
-		FreeLibrary(hModule);
+	if (nullptr != pCache)
+	{
+		pCache->Trim();
+		pCache->WriteSummary(*pWCerr);
+	}
+
+	rsrcFile.Close();
 
 	if (bCloseFOut)
 		fOut.close();
+	for (std::unique_ptr<Utf8FileOutput>& pTypeOut : vTypeOuts)
+		pTypeOut->close();
 	if (bCloseFErr)
 		fErr.close();
 
-	return 0;
+	return exitCode;
+}
+
+#ifndef _WIN32
+/// <summary>
+/// Entry point on platforms without wmain: convert the UTF-8 command line to wide characters.
+/// </summary>
+int main(int argc, char** argv)
+{
+	std::vector<std::wstring> vArgs;
+	std::vector<wchar_t*> vArgv;
+	for (int ixArg = 0; ixArg < argc; ++ixArg)
+		vArgs.push_back(Utf8ToWString(argv[ixArg]));
+	for (std::wstring& sArg : vArgs)
+		vArgv.push_back(&sArg[0]);
+	vArgv.push_back(nullptr);
+	return wmain(argc, &vArgv[0]);
 }
+#endif
 
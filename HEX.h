@@ -5,6 +5,7 @@
 #include <iostream>
 #include <iomanip>
 #include <sstream>
+#include <cstdint>
 
 template <typename T>
 inline uint64_t HEXHelperFn_ToU64ForHEX(T num)
@@ -43,7 +44,8 @@ std::string HEXA(T num, unsigned long fieldwidth = sizeof(T) * 2, bool bUpcase =
 	return str.str();
 }
 
-#ifdef UNICODE
+// Non-Windows builds are always wide-character
+#if defined(UNICODE) || !defined(_WIN32)
 #define HEX HEXW
 #else
 #define HEX HEXA
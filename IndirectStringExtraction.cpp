@@ -1,30 +1,416 @@
-#include <Windows.h>
+#include "PlatformDefs.h"
+#ifdef _WIN32
 #include <Shlwapi.h>
 #pragma comment(lib, "shlwapi.lib")
+#endif
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <thread>
 #include <vector>
 #include "SysErrorMessage.h"
 #include "IndirectStringExtraction.h"
+#include "StringTableExtraction.h"
+#include "FileEnumeration.h"
+#include "Wow64FsRedirection.h"
+
+#ifdef _WIN32
+static const wchar_t chPathSep = L'\\';
+#else
+static const wchar_t chPathSep = L'/';
+#endif
 
 /// <summary>
-/// Calls the Windows API that translates an indirect-string reference into human-language text
-/// and outputs it to (possibly redirected) stdout.
+/// Translates an indirect-string reference into human-language text and outputs it to (possibly redirected) stdout.
 /// </summary>
 /// <param name="sResource">The indirect string reference</param>
+/// <param name="vLanguages">Input: preferred languages by name, most preferred first (if not using the Windows API)</param>
+/// <param name="sImageRoot">Input: root directory of an offline Windows image; empty for the running system</param>
 /// <param name="streams">The output and error streams to write information into</param>
 /// <returns>true if successful, false otherwise.</returns>
-bool IndirectStringExtraction(const std::wstring& sResource, streams_t& streams)
+bool IndirectStringExtraction(const std::wstring& sResource, const std::vector<std::wstring>& vLanguages, const std::wstring& sImageRoot, streams_t& streams)
 {
-	const size_t bufSize = 16384;
-	std::vector<wchar_t> vBuffer(bufSize);
-	HRESULT hr = SHLoadIndirectString(sResource.c_str(), &vBuffer[0], bufSize, nullptr);
-	if (S_OK == hr)
+#ifdef _WIN32
+	if (sImageRoot.empty())
 	{
-		streams.WCout << (const wchar_t*)&vBuffer[0] << std::endl;
-		return true;
+		const size_t bufSize = 16384;
+		std::vector<wchar_t> vBuffer(bufSize);
+		HRESULT hr = SHLoadIndirectString(sResource.c_str(), &vBuffer[0], bufSize, nullptr);
+		if (S_OK == hr)
+		{
+			streams.WCout << (const wchar_t*)&vBuffer[0] << std::endl;
+			return true;
+		}
+		else
+		{
+			streams.WCerr << SysErrorMessageWithCode(hr) << std::endl;
+			return false;
+		}
+	}
+#endif
+	std::wstring sText, sErrorInfo;
+	if (!ResolveIndirectString(sResource, vLanguages, sImageRoot, sText, sErrorInfo))
+	{
+		streams.WCerr << sErrorInfo << std::endl;
+		return false;
+	}
+	streams.WCout << sText << std::endl;
+	return true;
+}
+
+bool ParseIndirectString(const std::wstring& sReference, std::wstring& sModule, uint16_t& stringId, std::wstring& sErrorInfo)
+{
+	if (sReference.length() < 2 || L'@' != sReference[0])
+	{
+		sErrorInfo = L"Not an indirect string reference";
+		return false;
+	}
+	if (L'{' == sReference[1])
+	{
+		sErrorInfo = L"Package resource references are not supported";
+		return false;
 	}
-	else
+
+	// The file path can contain commas; the resource ID follows the last one.
+	size_t ixComma = sReference.rfind(L',');
+	if (std::wstring::npos == ixComma)
 	{
-		streams.WCerr << SysErrorMessageWithCode(hr) << std::endl;
+		sErrorInfo = L"Missing resource ID";
 		return false;
 	}
+	sModule = sReference.substr(1, ixComma - 1);
+	// Ignore a version modifier (";v2").
+	std::wstring sId = sReference.substr(ixComma + 1);
+	size_t ixSemicolon = sId.find(L';');
+	if (std::wstring::npos != ixSemicolon)
+		sId.resize(ixSemicolon);
+	// Leading and trailing spaces are allowed around both parts.
+	while (!sModule.empty() && L' ' == sModule.back())
+		sModule.pop_back();
+	while (!sModule.empty() && L' ' == sModule.front())
+		sModule.erase(0, 1);
+	if (sModule.empty())
+	{
+		sErrorInfo = L"Missing file path";
+		return false;
+	}
+
+	wchar_t* szEnd = nullptr;
+	long lId = wcstol(sId.c_str(), &szEnd, 10);
+	while (nullptr != szEnd && L' ' == *szEnd)
+		++szEnd;
+	if (sId.c_str() == szEnd || nullptr == szEnd || 0 != *szEnd)
+	{
+		sErrorInfo = L"Not a resource ID: " + sId;
+		return false;
+	}
+	// A positive number is an index of a resource of an unspecified type, not a string.
+	if (lId > 0)
+	{
+		sErrorInfo = L"Not a string resource ID (must be negative): " + sId;
+		return false;
+	}
+	if (lId < -65535)
+	{
+		sErrorInfo = L"String resource ID out of range: " + sId;
+		return false;
+	}
+	stringId = (uint16_t)-lId;
+	return true;
+}
+
+/// <summary>
+/// Replaces each %name% in the text for which lookup returns a value. Other text is left unchanged.
+/// </summary>
+static std::wstring ExpandVariables(const std::wstring& sText, const std::function<bool(const std::wstring&, std::wstring&)>& lookup)
+{
+	std::wstring sResult;
+	size_t ixPos = 0;
+	while (ixPos < sText.length())
+	{
+		size_t ixStart = sText.find(L'%', ixPos);
+		size_t ixEnd = (std::wstring::npos == ixStart) ? std::wstring::npos : sText.find(L'%', ixStart + 1);
+		if (std::wstring::npos == ixEnd)
+			break;
+		std::wstring sValue;
+		sResult += sText.substr(ixPos, ixStart - ixPos);
+		if (lookup(sText.substr(ixStart + 1, ixEnd - ixStart - 1), sValue))
+		{
+			sResult += sValue;
+			ixPos = ixEnd + 1;
+		}
+		else
+		{
+			// Not a variable; the closing % might begin one.
+			sResult += L'%';
+			ixPos = ixStart + 1;
+		}
+	}
+	sResult += sText.substr(ixPos < sText.length() ? ixPos : sText.length());
+	return sResult;
+}
+
+/// <summary>
+/// Environment variables that commonly appear in indirect strings, and where they point within a Windows volume.
+/// </summary>
+static const struct
+{
+	const wchar_t* szName;
+	const wchar_t* szImagePath;
+} imageVariables[] =
+{
+	{ L"SystemDrive", L"" },
+	{ L"SystemRoot", L"\\Windows" },
+	{ L"windir", L"\\Windows" },
+	{ L"ProgramFiles", L"\\Program Files" },
+	{ L"ProgramW6432", L"\\Program Files" },
+	{ L"ProgramFiles(x86)", L"\\Program Files (x86)" },
+	{ L"CommonProgramFiles", L"\\Program Files\\Common Files" },
+	{ L"CommonProgramW6432", L"\\Program Files\\Common Files" },
+	{ L"CommonProgramFiles(x86)", L"\\Program Files (x86)\\Common Files" },
+	{ L"ProgramData", L"\\ProgramData" },
+	{ L"ALLUSERSPROFILE", L"\\ProgramData" },
+};
+
+/// <summary>
+/// Resolves a file path from a Windows system against the root directory of an offline copy of its system volume.
+/// </summary>
+static std::wstring LocateInImage(const std::wstring& sModule, const std::wstring& sImageRoot)
+{
+	std::wstring sPath = ExpandVariables(sModule,
+		[](const std::wstring& sName, std::wstring& sValue)
+		{
+			for (const auto& variable : imageVariables)
+			{
+				if (0 == _wcsicmp(variable.szName, sName.c_str()))
+				{
+					sValue = variable.szImagePath;
+					return true;
+				}
+			}
+			return false;
+		});
+
+	// Drive letters all refer to the image's volume.
+	if (sPath.length() >= 2 && L':' == sPath[1])
+		sPath.erase(0, 2);
+
+	std::wstring sRoot = sImageRoot;
+	while (!sRoot.empty() && (EndsWith(sRoot, L'\\') || EndsWith(sRoot, L'/')))
+		sRoot.pop_back();
+	if (std::wstring::npos == sPath.find_first_of(L"/\\"))
+	{
+		// File name only: look where the loader looks first for system DLLs.
+		const wchar_t* szSearchDirs[] = { L"\\Windows\\System32\\", L"\\Windows\\" };
+		for (const wchar_t* szSearchDir : szSearchDirs)
+		{
+			std::wstring sCandidate = FindPathIgnoringCase(replaceStringAll(sRoot + szSearchDir + sPath, L"\\", std::wstring(1, chPathSep)));
+			if (IsFilePath(sCandidate))
+				return sCandidate;
+		}
+	}
+	if (!sPath.empty() && L'\\' != sPath[0] && L'/' != sPath[0])
+		sPath = L'\\' + sPath;
+	return FindPathIgnoringCase(replaceStringAll(sRoot + sPath, L"\\", std::wstring(1, chPathSep)));
+}
+
+std::wstring LocateIndirectStringModule(const std::wstring& sModule, const std::wstring& sImageRoot)
+{
+	if (!sImageRoot.empty())
+		return LocateInImage(sModule, sImageRoot);
+
+#ifdef _WIN32
+	std::vector<wchar_t> vExpanded(32768);
+	DWORD dwLen = ExpandEnvironmentStringsW(sModule.c_str(), &vExpanded[0], (DWORD)vExpanded.size());
+	std::wstring sPath = (dwLen > 0 && dwLen <= vExpanded.size()) ? std::wstring(&vExpanded[0]) : sModule;
+	if (std::wstring::npos == sPath.find_first_of(L"/\\:"))
+	{
+		wchar_t szFullPath[MAX_PATH];
+		dwLen = SearchPathW(nullptr, sPath.c_str(), nullptr, MAX_PATH, szFullPath, nullptr);
+		if (dwLen > 0 && dwLen < MAX_PATH)
+			return szFullPath;
+	}
+	return sPath;
+#else
+	return ExpandVariables(sModule,
+		[](const std::wstring& sName, std::wstring& sValue)
+		{
+			const char* szValue = getenv(WStringToUtf8(sName).c_str());
+			if (nullptr == szValue)
+				return false;
+			sValue = Utf8ToWString(szValue);
+			return true;
+		});
+#endif
+}
+
+/// <summary>
+/// Opens the file for resolving indirect strings, with WOW64 file system redirection disabled so that
+/// a 32-bit process can still read files in the System32 directory on 64-bit Windows.
+/// </summary>
+static bool OpenModule(ResourceFile& rsrcFile, const std::wstring& sPath, const std::vector<std::wstring>& vLanguages, std::wstring& sErrorInfo)
+{
+	Wow64FsRedirection fsRedir(true);
+	if (!rsrcFile.Open(sPath, vLanguages, sErrorInfo))
+	{
+		sErrorInfo = L"Cannot load resource file " + sPath + L": " + sErrorInfo;
+		return false;
+	}
+	return true;
+}
+
+/// <summary>
+/// Gets one string from an open file.
+/// </summary>
+static bool LoadModuleString(const ResourceFile& rsrcFile, uint16_t stringId, std::wstring& sText, std::wstring& sErrorInfo)
+{
+	if (!FindStringResource(rsrcFile, stringId, sText))
+	{
+		sErrorInfo = L"String ID " + std::to_wstring(stringId) + L" not found in " + rsrcFile.FilePath();
+		return false;
+	}
+	return true;
+}
+
+bool ResolveIndirectString(const std::wstring& sReference, const std::vector<std::wstring>& vLanguages, const std::wstring& sImageRoot, std::wstring& sText, std::wstring& sErrorInfo)
+{
+	if (sReference.empty() || L'@' != sReference[0])
+	{
+		sText = sReference;
+		return true;
+	}
+
+	std::wstring sModule;
+	uint16_t stringId;
+	if (!ParseIndirectString(sReference, sModule, stringId, sErrorInfo))
+		return false;
+	ResourceFile rsrcFile;
+	return
+		OpenModule(rsrcFile, LocateIndirectStringModule(sModule, sImageRoot), vLanguages, sErrorInfo) &&
+		LoadModuleString(rsrcFile, stringId, sText, sErrorInfo);
+}
+
+/// <summary>
+/// One reference in a batch, and its result.
+/// </summary>
+struct indirectref_t
+{
+	uint16_t stringId = 0;
+	std::wstring sText;
+	std::wstring sErrorInfo;
+	bool bResolved = false;
+};
+
+/// <summary>
+/// The references in a batch that name the same file.
+/// </summary>
+struct modulegroup_t
+{
+	std::wstring sPath;
+	std::vector<size_t> vIxRefs;
+};
+
+bool IndirectStringBatchExtraction(
+	const std::vector<std::wstring>& vReferences,
+	const std::vector<std::wstring>& vLanguages,
+	const std::wstring& sImageRoot,
+	unsigned int nWorkers,
+	streams_t& streams)
+{
+	streams.WCout
+		<< L"Indirect string\t"
+		<< L"Localized text"
+		<< L'\n';
+
+	// Parse the references and group them by file. Each distinct file path in the input is located only once.
+	std::vector<indirectref_t> vRefs(vReferences.size());
+	std::vector<modulegroup_t> vGroups;
+	std::map<std::wstring, size_t> ixGroupByModule, ixGroupByPath;
+	for (size_t ixRef = 0; ixRef < vReferences.size(); ++ixRef)
+	{
+		indirectref_t& ref = vRefs[ixRef];
+		const std::wstring& sReference = vReferences[ixRef];
+		if (sReference.empty() || L'@' != sReference[0])
+		{
+			ref.sText = sReference;
+			ref.bResolved = true;
+			continue;
+		}
+		std::wstring sModule;
+		if (!ParseIndirectString(sReference, sModule, ref.stringId, ref.sErrorInfo))
+			continue;
+
+		auto iterModule = ixGroupByModule.find(sModule);
+		if (ixGroupByModule.end() == iterModule)
+		{
+			std::wstring sPath = LocateIndirectStringModule(sModule, sImageRoot);
+			// Different spellings of a path can name the same file.
+#ifdef _WIN32
+			std::wstring sPathKey = sPath;
+			WString_To_Upper(sPathKey);
+#else
+			const std::wstring& sPathKey = sPath;
+#endif
+			auto iterPath = ixGroupByPath.find(sPathKey);
+			if (ixGroupByPath.end() == iterPath)
+			{
+				iterPath = ixGroupByPath.insert(std::make_pair(sPathKey, vGroups.size())).first;
+				vGroups.push_back(modulegroup_t{ sPath, std::vector<size_t>() });
+			}
+			iterModule = ixGroupByModule.insert(std::make_pair(sModule, iterPath->second)).first;
+		}
+		vGroups[iterModule->second].vIxRefs.push_back(ixRef);
+	}
+
+	if (0 == nWorkers)
+		nWorkers = std::thread::hardware_concurrency();
+	if (0 == nWorkers)
+		nWorkers = 1;
+	if (nWorkers > vGroups.size())
+		nWorkers = (unsigned int)vGroups.size();
+
+	// Each worker takes the next file, maps it once, and resolves all of its references.
+	// Each reference belongs to exactly one group, so workers never write the same result.
+	std::atomic<size_t> ixNextGroup(0);
+	std::vector<std::thread> vWorkers;
+	for (unsigned int ixWorker = 0; ixWorker < nWorkers; ++ixWorker)
+	{
+		vWorkers.emplace_back([&]()
+			{
+				for (size_t ixGroup = ixNextGroup++; ixGroup < vGroups.size(); ixGroup = ixNextGroup++)
+				{
+					const modulegroup_t& group = vGroups[ixGroup];
+					ResourceFile rsrcFile;
+					std::wstring sErrorInfo;
+					const bool bOpened = OpenModule(rsrcFile, group.sPath, vLanguages, sErrorInfo);
+					for (size_t ixRef : group.vIxRefs)
+					{
+						indirectref_t& ref = vRefs[ixRef];
+						if (!bOpened)
+							ref.sErrorInfo = sErrorInfo;
+						else
+							ref.bResolved = LoadModuleString(rsrcFile, ref.stringId, ref.sText, ref.sErrorInfo);
+					}
+				}
+			});
+	}
+	for (std::thread& worker : vWorkers)
+		worker.join();
+
+	bool ret = true;
+	for (size_t ixRef = 0; ixRef < vReferences.size(); ++ixRef)
+	{
+		const indirectref_t& ref = vRefs[ixRef];
+		const std::wstring sReference = escapeCrLfTabNul(vReferences[ixRef]);
+		streams.WCout << sReference << L"\t" << escapeCrLfTabNul(ref.sText) << L"\n";
+		if (!ref.bResolved)
+		{
+			streams.WCerr << sReference << L": " << ref.sErrorInfo << L"\n";
+			ret = false;
+		}
+	}
+	streams.WCout.flush();
+	streams.WCerr.flush();
+	return ret;
 }
@@ -1,12 +1,75 @@
 #pragma once
 
+#include <vector>
 #include "UtilityFunctions.h"
 
 /// <summary>
-/// Calls the Windows API that translates an indirect-string reference into human-language text
-/// and outputs it to (possibly redirected) stdout.
+/// Translates an indirect-string reference into human-language text and outputs it to (possibly redirected) stdout.
+/// On Windows, calls the Windows API that does this for the running system; with an offline image root, or
+/// on other platforms, reads the referenced file's resources directly (see ResolveIndirectString).
 /// </summary>
 /// <param name="sResource">The indirect string reference</param>
+/// <param name="vLanguages">Input: preferred languages by name, most preferred first (if not using the Windows API)</param>
+/// <param name="sImageRoot">Input: root directory of an offline Windows image; empty for the running system</param>
 /// <param name="streams">The output and error streams to write information into</param>
 /// <returns>true if successful, false otherwise.</returns>
-bool IndirectStringExtraction(const std::wstring& sResource, streams_t& streams);
+bool IndirectStringExtraction(const std::wstring& sResource, const std::vector<std::wstring>& vLanguages, const std::wstring& sImageRoot, streams_t& streams);
+
+/// <summary>
+/// Parses an indirect string reference of the form @filepath,-stringID (optionally followed by a
+/// ;v version modifier, which is ignored). Other forms, such as @{PackageFullName?ms-resource://...},
+/// are not supported.
+/// </summary>
+/// <param name="sReference">Input: the indirect string reference</param>
+/// <param name="sModule">Output: the file path, as written in the reference (environment variables not expanded)</param>
+/// <param name="stringId">Output: the string resource ID</param>
+/// <param name="sErrorInfo">Output: diagnostic information on failure</param>
+/// <returns>true if successful, false otherwise</returns>
+bool ParseIndirectString(const std::wstring& sReference, std::wstring& sModule, uint16_t& stringId, std::wstring& sErrorInfo);
+
+/// <summary>
+/// Returns the path of the file named in an indirect string reference: expands %environment variables%,
+/// and searches for a file name without a directory, as SHLoadIndirectString does.
+/// 
+/// If sImageRoot is not empty, the path is instead resolved against an offline Windows image (e.g., a
+/// mounted disk image or a copy of a Windows volume): drive letters and the standard variables such as
+/// %SystemRoot% and %ProgramFiles% map into the image, file names without a directory are looked for in
+/// its Windows\System32 and Windows directories, and the case of each name doesn't need to match.
+/// </summary>
+/// <param name="sModule">Input: the file path from the reference</param>
+/// <param name="sImageRoot">Input: root directory of an offline Windows image; empty for the running system</param>
+/// <returns>The path of the file to read</returns>
+std::wstring LocateIndirectStringModule(const std::wstring& sModule, const std::wstring& sImageRoot);
+
+/// <summary>
+/// Resolves an indirect string reference by reading the file's resources directly, rather than with
+/// SHLoadIndirectString, so it works on any platform and against an offline Windows image.
+/// Text that doesn't begin with @ is returned unchanged, as SHLoadIndirectString does.
+/// </summary>
+/// <param name="sReference">Input: the indirect string reference</param>
+/// <param name="vLanguages">Input: preferred languages by name, most preferred first</param>
+/// <param name="sImageRoot">Input: root directory of an offline Windows image; empty for the running system</param>
+/// <param name="sText">Output: the localized text</param>
+/// <param name="sErrorInfo">Output: diagnostic information on failure</param>
+/// <returns>true if successful, false otherwise</returns>
+bool ResolveIndirectString(const std::wstring& sReference, const std::vector<std::wstring>& vLanguages, const std::wstring& sImageRoot, std::wstring& sText, std::wstring& sErrorInfo);
+
+/// <summary>
+/// Resolves many indirect string references, reading each referenced file only once: references are
+/// grouped by file, and all of a file's references are resolved together, using a pool of worker threads.
+/// Outputs tab-delimited headers, then one row per reference, in input order, with the reference and its
+/// localized text (empty if it can't be resolved). CR, LF, TAB, and embedded NUL characters are replaced
+/// in the output with \r, \n, \t, and \0. Errors are written to the error stream, each line prefixed with the reference.
+/// </summary>
+/// <param name="vReferences">Input: the indirect string references</param>
+/// <param name="vLanguages">Input: preferred languages by name, most preferred first</param>
+/// <param name="sImageRoot">Input: root directory of an offline Windows image; empty for the running system</param>
+/// <param name="nWorkers">Input: number of worker threads; 0 for one per hardware thread</param>
+/// <param name="streams">The output and error streams to write information into</param>
+/// <returns>true if every reference was resolved, false otherwise.</returns>
+bool IndirectStringBatchExtraction(
+	const std::vector<std::wstring>& vReferences,
+	const std::vector<std::wstring>& vLanguages,
+	const std::wstring& sImageRoot,
+	unsigned int nWorkers,
+	streams_t& streams);
@@ -0,0 +1,209 @@
+#include "PlatformDefs.h"
+#include "LanguageNames.h"
+#include "HEX.h"
+
+/// <summary>
+/// Languages for which Windows ships localized (MUI) resources, plus a few other common ones.
+/// </summary>
+static const struct
+{
+    uint16_t langId;
+    const wchar_t* szName;
+} sLanguageTable[] =
+{
+    { 0x0401, L"ar-SA" }, { 0x0402, L"bg-BG" }, { 0x0403, L"ca-ES" }, { 0x0404, L"zh-TW" },
+    { 0x0405, L"cs-CZ" }, { 0x0406, L"da-DK" }, { 0x0407, L"de-DE" }, { 0x0408, L"el-GR" },
+    { 0x0409, L"en-US" }, { 0x040B, L"fi-FI" }, { 0x040C, L"fr-FR" }, { 0x040D, L"he-IL" },
+    { 0x040E, L"hu-HU" }, { 0x040F, L"is-IS" }, { 0x0410, L"it-IT" }, { 0x0411, L"ja-JP" },
+    { 0x0412, L"ko-KR" }, { 0x0413, L"nl-NL" }, { 0x0414, L"nb-NO" }, { 0x0415, L"pl-PL" },
+    { 0x0416, L"pt-BR" }, { 0x0418, L"ro-RO" }, { 0x0419, L"ru-RU" }, { 0x041A, L"hr-HR" },
+    { 0x041B, L"sk-SK" }, { 0x041C, L"sq-AL" }, { 0x041D, L"sv-SE" }, { 0x041E, L"th-TH" },
+    { 0x041F, L"tr-TR" }, { 0x0420, L"ur-PK" }, { 0x0421, L"id-ID" }, { 0x0422, L"uk-UA" },
+    { 0x0423, L"be-BY" }, { 0x0424, L"sl-SI" }, { 0x0425, L"et-EE" }, { 0x0426, L"lv-LV" },
+    { 0x0427, L"lt-LT" }, { 0x0429, L"fa-IR" }, { 0x042A, L"vi-VN" }, { 0x042B, L"hy-AM" },
+    { 0x042C, L"az-Latn-AZ" }, { 0x042D, L"eu-ES" }, { 0x042F, L"mk-MK" }, { 0x0436, L"af-ZA" },
+    { 0x0437, L"ka-GE" }, { 0x0439, L"hi-IN" }, { 0x043A, L"mt-MT" }, { 0x043E, L"ms-MY" },
+    { 0x043F, L"kk-KZ" }, { 0x0440, L"ky-KG" }, { 0x0441, L"sw-KE" }, { 0x0443, L"uz-Latn-UZ" },
+    { 0x0444, L"tt-RU" }, { 0x0445, L"bn-IN" }, { 0x0446, L"pa-IN" }, { 0x0447, L"gu-IN" },
+    { 0x0448, L"or-IN" }, { 0x0449, L"ta-IN" }, { 0x044A, L"te-IN" }, { 0x044B, L"kn-IN" },
+    { 0x044C, L"ml-IN" }, { 0x044D, L"as-IN" }, { 0x044E, L"mr-IN" }, { 0x0450, L"mn-MN" },
+    { 0x0452, L"cy-GB" }, { 0x0453, L"km-KH" }, { 0x0454, L"lo-LA" }, { 0x0456, L"gl-ES" },
+    { 0x0457, L"kok-IN" }, { 0x045B, L"si-LK" }, { 0x045E, L"am-ET" }, { 0x0461, L"ne-NP" },
+    { 0x0463, L"ps-AF" }, { 0x0464, L"fil-PH" }, { 0x0481, L"mi-NZ" }, { 0x0491, L"gd-GB" },
+    { 0x0804, L"zh-CN" }, { 0x0809, L"en-GB" }, { 0x080A, L"es-MX" }, { 0x0816, L"pt-PT" },
+    { 0x081A, L"sr-Latn-CS" }, { 0x083C, L"ga-IE" }, { 0x0845, L"bn-BD" }, { 0x0C04, L"zh-HK" },
+    { 0x0C0A, L"es-ES" }, { 0x0C0C, L"fr-CA" }, { 0x0C1A, L"sr-Cyrl-CS" }, { 0x141A, L"bs-Latn-BA" },
+    { 0x201A, L"bs-Cyrl-BA" }, { 0x241A, L"sr-Latn-RS" }, { 0x281A, L"sr-Cyrl-RS" }, { 0x0428, L"tg-Cyrl-TJ" },
+    { 0x0442, L"tk-TM" }, { 0x0480, L"ug-CN" }, { 0x0485, L"sah-RU" }, { 0x0465, L"dv-MV" },
+};
+
+/// <summary>
+/// Gets the Windows language identifier (LANGID) for a language name such as "fr-FR".
+/// </summary>
+bool LangIdFromName(const std::wstring& sName, uint16_t& langId)
+{
+#ifdef _WIN32
+    LCID lcid = LocaleNameToLCID(sName.c_str(), 0);
+    if (0 != lcid)
+    {
+        langId = LANGIDFROMLCID(lcid);
+        return true;
+    }
+#endif
+    for (const auto& entry : sLanguageTable)
+    {
+        if (0 == _wcsicmp(sName.c_str(), entry.szName))
+        {
+            langId = entry.langId;
+            return true;
+        }
+    }
+    return false;
+}
+
+/// <summary>
+/// Gets the language name for a Windows language identifier, or the identifier in hex.
+/// </summary>
+std::wstring LangIdToName(uint16_t langId)
+{
+    // Primary language 0 is neutral, or the process/user/system default; none names a specific language.
+    if (0 != (langId & 0x3FF))
+    {
+#ifdef _WIN32
+        wchar_t szName[LOCALE_NAME_MAX_LENGTH];
+        if (LCIDToLocaleName(MAKELCID(langId, SORT_DEFAULT), szName, LOCALE_NAME_MAX_LENGTH, 0) > 0)
+            return szName;
+#endif
+        for (const auto& entry : sLanguageTable)
+        {
+            if (langId == entry.langId)
+                return entry.szName;
+        }
+    }
+    return HEX(langId, 4, true, true);
+}
+
+/// <summary>
+/// ANSI code pages of languages that don't use Windows-1252, by primary language.
+/// </summary>
+static const struct
+{
+    uint16_t primaryLangId;
+    uint16_t codePage;
+} sAnsiCodePageTable[] =
+{
+    { 0x01, 1256 }, { 0x02, 1251 }, { 0x04, 936 }, { 0x05, 1250 }, { 0x08, 1253 }, { 0x0D, 1255 },
+    { 0x0E, 1250 }, { 0x11, 932 }, { 0x12, 949 }, { 0x15, 1250 }, { 0x18, 1250 }, { 0x19, 1251 },
+    { 0x1A, 1250 }, { 0x1B, 1250 }, { 0x1C, 1250 }, { 0x1E, 874 }, { 0x1F, 1254 }, { 0x20, 1256 },
+    { 0x22, 1251 }, { 0x23, 1251 }, { 0x24, 1250 }, { 0x25, 1257 }, { 0x26, 1257 }, { 0x27, 1257 },
+    { 0x28, 1251 }, { 0x29, 1256 }, { 0x2A, 1258 }, { 0x2C, 1254 }, { 0x2F, 1251 }, { 0x3F, 1251 },
+    { 0x40, 1251 }, { 0x42, 1250 }, { 0x43, 1254 }, { 0x44, 1251 }, { 0x50, 1251 }, { 0x6D, 1251 },
+    { 0x80, 1256 }, { 0x85, 1251 }, { 0x8C, 1256 },
+};
+
+/// <summary>
+/// Gets the ANSI code page of a language: the code page of non-Unicode text in its resources.
+/// </summary>
+uint16_t AnsiCodePageFromLangId(uint16_t langId)
+{
+#ifdef _WIN32
+    DWORD dwCodePage = 0;
+    if (0 != (langId & 0x3FF) &&
+        GetLocaleInfoW(MAKELCID(langId, SORT_DEFAULT), LOCALE_IDEFAULTANSICODEPAGE | LOCALE_RETURN_NUMBER, (LPWSTR)&dwCodePage, sizeof(dwCodePage) / sizeof(wchar_t)) > 0 &&
+        0 != dwCodePage)
+    {
+        return (uint16_t)dwCodePage;
+    }
+#endif
+    // Languages whose sublanguages differ in script
+    switch (langId)
+    {
+    case 0x0404: case 0x0C04: case 0x1404: case 0x7C04:
+        // Chinese (Traditional)
+        return 950;
+    case 0x0C1A: case 0x1C1A: case 0x201A: case 0x281A: case 0x301A: case 0x6C1A: case 0x7C1A:
+        // Serbian and Bosnian (Cyrillic)
+        return 1251;
+    case 0x082C: case 0x0843:
+        // Azerbaijani and Uzbek (Cyrillic)
+        return 1251;
+    default:
+        break;
+    }
+    for (const auto& entry : sAnsiCodePageTable)
+    {
+        if ((langId & 0x3FF) == entry.primaryLangId)
+            return entry.codePage;
+    }
+    return 1252;
+}
+
+/// <summary>
+/// Parses a comma-separated list of language names.
+/// </summary>
+bool LangIdsFromNameList(const std::wstring& sList, std::vector<uint16_t>& vLangIds, std::wstring& sErrorInfo)
+{
+    vLangIds.clear();
+    size_t ixStart = 0;
+    while (ixStart <= sList.length())
+    {
+        size_t ixComma = sList.find(L',', ixStart);
+        if (std::wstring::npos == ixComma)
+            ixComma = sList.length();
+        const std::wstring sName = sList.substr(ixStart, ixComma - ixStart);
+        uint16_t langId;
+        if (!LangIdFromName(sName, langId))
+        {
+            sErrorInfo = L"Unrecognized language name \"" + sName + L"\"";
+            return false;
+        }
+        vLangIds.push_back(langId);
+        ixStart = ixComma + 1;
+    }
+    return true;
+}
+
+/// <summary>
+/// Returns the names of the preferred UI languages in priority order.
+/// </summary>
+std::vector<std::wstring> PreferredUILanguages(const std::wstring& sLangSpec)
+{
+    std::vector<std::wstring> vCandidates;
+    if (sLangSpec.length() > 0)
+        vCandidates.push_back(sLangSpec);
+
+#ifdef _WIN32
+    // The thread's preferred UI languages, merged with the user and system fallbacks.
+    // This is the list the resource loader consults.
+    const DWORD dwFlags = MUI_LANGUAGE_NAME | MUI_MERGE_USER_FALLBACK | MUI_MERGE_SYSTEM_FALLBACK;
+    ULONG ulNumLanguages = 0, cchLanguagesBuffer = 0;
+    if (GetThreadPreferredUILanguages(dwFlags, &ulNumLanguages, nullptr, &cchLanguagesBuffer) && cchLanguagesBuffer > 0)
+    {
+        std::vector<wchar_t> vBuffer(cchLanguagesBuffer);
+        if (GetThreadPreferredUILanguages(dwFlags, &ulNumLanguages, &vBuffer[0], &cchLanguagesBuffer))
+        {
+            for (const wchar_t* szLang = &vBuffer[0]; 0 != *szLang; szLang += wcslen(szLang) + 1)
+                vCandidates.push_back(szLang);
+        }
+    }
+#else
+    // No system language preferences to consult when inspecting files copied from Windows.
+    // Fall back to US English, the language of the base resources in most Windows files.
+    vCandidates.push_back(L"en-US");
+#endif
+
+    // Remove duplicates, keeping the first occurrence
+    std::vector<std::wstring> vLanguages;
+    for (const std::wstring& sCandidate : vCandidates)
+    {
+        bool bDuplicate = false;
+        for (const std::wstring& sLang : vLanguages)
+        {
+            if (0 == _wcsicmp(sLang.c_str(), sCandidate.c_str()))
+                bDuplicate = true;
+        }
+        if (!bDuplicate)
+            vLanguages.push_back(sCandidate);
+    }
+    return vLanguages;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Gets the Windows language identifier (LANGID) for a language name such as "fr-FR".
+/// Case-insensitive. Uses the Windows locale APIs where available, and otherwise
+/// a built-in table of the languages for which Windows ships localized resources.
+/// </summary>
+/// <param name="sName">Input: language name</param>
+/// <param name="langId">Output: language identifier, if found</param>
+/// <returns>true if the name was recognized, false otherwise</returns>
+bool LangIdFromName(const std::wstring& sName, uint16_t& langId);
+
+/// <summary>
+/// Gets the language name (e.g., "fr-FR") for a Windows language identifier (LANGID).
+/// Language identifiers that don't name a specific language (e.g., neutral, 0x0000) or that aren't
+/// recognized are returned in hex, e.g., "0x0000".
+/// </summary>
+/// <param name="langId">Input: language identifier</param>
+/// <returns>Language name</returns>
+std::wstring LangIdToName(uint16_t langId);
+
+/// <summary>
+/// Gets the ANSI code page associated with a language (e.g., 1251 for ru-RU), which is the code page of
+/// non-Unicode text in resources of that language. Uses the Windows locale APIs where available, and otherwise
+/// a built-in table. Neutral and unrecognized languages get Windows-1252.
+/// </summary>
+/// <param name="langId">Input: language identifier</param>
+/// <returns>Code page identifier</returns>
+uint16_t AnsiCodePageFromLangId(uint16_t langId);
+
+/// <summary>
+/// Parses a comma-separated list of language names, such as "fr-FR,de-DE".
+/// </summary>
+/// <param name="sList">Input: comma-separated language names</param>
+/// <param name="vLangIds">Output: language identifiers, in the order listed</param>
+/// <param name="sErrorInfo">Output: diagnostic information on failure</param>
+/// <returns>true if all names were recognized, false otherwise</returns>
+bool LangIdsFromNameList(const std::wstring& sList, std::vector<uint16_t>& vLangIds, std::wstring& sErrorInfo);
+
+/// <summary>
+/// Returns the names of the preferred UI languages in priority order, for choosing among
+/// localized resources the way the Windows resource loader does.
+/// </summary>
+/// <param name="sLangSpec">Input: language requested on the command line; can be empty.</param>
+/// <returns>Language names, most preferred first, without duplicates</returns>
+std::vector<std::wstring> PreferredUILanguages(const std::wstring& sLangSpec);
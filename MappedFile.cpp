@@ -0,0 +1,154 @@
+#include "PlatformDefs.h"
+#include "MappedFile.h"
+#include "SysErrorMessage.h"
+#include "StringUtils.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() :
+	m_pData(nullptr),
+	m_cbData(0)
+#ifdef _WIN32
+	, m_hMapping(NULL)
+#endif
+{
+}
+
+/// <summary>
+/// Maps the named file into memory, read-only.
+/// </summary>
+/// <param name="sFilePath">Input: path to the file to map</param>
+/// <param name="sErrorInfo">Output: diagnostic information on failure</param>
+/// <returns>true if successful, false otherwise</returns>
+bool MappedFile::Open(const std::wstring& sFilePath, std::wstring& sErrorInfo)
+{
+	Close();
+	sErrorInfo.clear();
+
+#ifdef _WIN32
+	// Share everything: the file is quite possibly loaded as an image by other processes.
+	HANDLE hFile = CreateFileW(sFilePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (INVALID_HANDLE_VALUE == hFile)
+	{
+		sErrorInfo = SysErrorMessageWithCode();
+		return false;
+	}
+	LARGE_INTEGER liSize = { 0 };
+	if (!GetFileSizeEx(hFile, &liSize))
+	{
+		sErrorInfo = SysErrorMessageWithCode();
+		CloseHandle(hFile);
+		return false;
+	}
+	if (0 == liSize.QuadPart)
+	{
+		sErrorInfo = L"File is empty";
+		CloseHandle(hFile);
+		return false;
+	}
+	// The mapping object keeps its own reference to the file, so the file handle isn't needed after this.
+	m_hMapping = CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	DWORD dwLastErr = GetLastError();
+	CloseHandle(hFile);
+	if (NULL == m_hMapping)
+	{
+		sErrorInfo = SysErrorMessageWithCode(dwLastErr);
+		return false;
+	}
+	m_pData = (const uint8_t*)MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+	if (nullptr == m_pData)
+	{
+		sErrorInfo = SysErrorMessageWithCode();
+		Close();
+		return false;
+	}
+	m_cbData = (size_t)liSize.QuadPart;
+#else
+	int fd = open(WStringToUtf8(sFilePath).c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+	{
+		sErrorInfo = SysErrorMessageWithCode();
+		return false;
+	}
+	struct stat st;
+	if (0 != fstat(fd, &st))
+	{
+		sErrorInfo = SysErrorMessageWithCode();
+		close(fd);
+		return false;
+	}
+	if (!S_ISREG(st.st_mode))
+	{
+		sErrorInfo = L"Not a regular file";
+		close(fd);
+		return false;
+	}
+	if (0 == st.st_size)
+	{
+		sErrorInfo = L"File is empty";
+		close(fd);
+		return false;
+	}
+	// The mapping keeps its own reference to the file, so the descriptor isn't needed after this.
+	void* pv = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	DWORD dwLastErr = GetLastError();
+	close(fd);
+	if (MAP_FAILED == pv)
+	{
+		sErrorInfo = SysErrorMessageWithCode(dwLastErr);
+		return false;
+	}
+	m_pData = (const uint8_t*)pv;
+	m_cbData = (size_t)st.st_size;
+#endif
+	return true;
+}
+
+/// <summary>
+/// Releases the mapping, if any.
+/// </summary>
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (nullptr != m_pData)
+		UnmapViewOfFile(m_pData);
+	if (NULL != m_hMapping)
+		CloseHandle(m_hMapping);
+	m_hMapping = NULL;
+#else
+	if (nullptr != m_pData)
+		munmap((void*)m_pData, m_cbData);
+#endif
+	m_pData = nullptr;
+	m_cbData = 0;
+}
+
+/// <summary>
+/// Asks the operating system to drop the file's pages from its file cache.
+/// </summary>
+bool MappedFile::DropFromCache(const std::wstring& sFilePath)
+{
+#ifdef _WIN32
+	HANDLE hFile = CreateFileW(sFilePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_NO_BUFFERING, NULL);
+	if (INVALID_HANDLE_VALUE == hFile)
+		return false;
+	CloseHandle(hFile);
+	return true;
+#elif defined(POSIX_FADV_DONTNEED)
+	int fd = open(WStringToUtf8(sFilePath).c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return false;
+	// Dirty pages aren't dropped; write them first (e.g., for a file that was just created).
+	fdatasync(fd);
+	const bool bDropped = (0 == posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED));
+	close(fd);
+	return bDropped;
+#else
+	UNREFERENCED_PARAMETER(sFilePath);
+	return false;
+#endif
+}
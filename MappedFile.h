@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/// <summary>
+/// Read-only memory mapping of an entire file.
+/// Uses file mapping objects on Windows and mmap elsewhere. The mapping is released
+/// when the object is closed or destroyed.
+/// </summary>
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile() { Close(); }
+
+	/// <summary>
+	/// Maps the named file into memory, read-only.
+	/// </summary>
+	/// <param name="sFilePath">Input: path to the file to map</param>
+	/// <param name="sErrorInfo">Output: diagnostic information on failure</param>
+	/// <returns>true if successful, false otherwise</returns>
+	bool Open(const std::wstring& sFilePath, std::wstring& sErrorInfo);
+
+	/// <summary>
+	/// Releases the mapping, if any.
+	/// </summary>
+	void Close();
+
+	/// <summary>
+	/// Address of the first byte of the mapped file; nullptr if not mapped.
+	/// </summary>
+	const uint8_t* Data() const { return m_pData; }
+
+	/// <summary>
+	/// Size of the mapped file in bytes.
+	/// </summary>
+	size_t Size() const { return m_cbData; }
+
+	bool IsOpen() const { return nullptr != m_pData; }
+
+	/// <summary>
+	/// Asks the operating system to drop the file's pages from its file cache, so that the next mapping
+	/// reads the file from storage (for measuring cold-cache performance). The file must not be mapped.
+	/// Uses posix_fadvise where available; on Windows, opens the file without buffering, which has the
+	/// cache manager discard the file's cached pages if nothing else has it open.
+	/// </summary>
+	/// <param name="sFilePath">Input: path to the file</param>
+	/// <returns>true if the request was made, false if the file couldn't be opened or the platform has no way to ask</returns>
+	static bool DropFromCache(const std::wstring& sFilePath);
+
+private:
+	const uint8_t* m_pData;
+	size_t m_cbData;
+#ifdef _WIN32
+	void* m_hMapping;
+#endif
+
+private:
+	// Not implemented
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator = (const MappedFile&) = delete;
+};
@@ -1,8 +1,10 @@
-#include <Windows.h>
+#include "PlatformDefs.h"
+#include <cstddef>
 #include <iostream>
 #include "MenuTextExtraction.h"
-#include "SysErrorMessage.h"
+#include "ResourceExtraction.h"
 #include "UtilityFunctions.h"
+#include "ResourceCursor.h"
 #include "ResourceDefs.h"
 #include "HEX.h"
 
@@ -28,12 +30,15 @@ https://devblogs.microsoft.com/oldnewthing/20080710-00/?p=21673
 /// Indicates whether the resource is a standard menu template, an extended menu template,
 /// or neither.
 /// </summary>
-/// <param name="pResource">Address of the resource</param>
+/// <param name="entry">The resource</param>
 /// <param name="bIsExtendedMenuTemplate">If successful, true for extended, false for standard. Undefined if not successful.</param>
 /// <returns>true if resource determined to be a standard or extended menu template; false if not.</returns>
-static bool IsExtendedMenuTemplate(LPVOID pResource, bool& bIsExtendedMenuTemplate)
+static bool IsExtendedMenuTemplate(const ResourceEntry_t& entry, bool& bIsExtendedMenuTemplate)
 {
-    WORD wVersion = *(WORD*)pResource;
+    CheckedResourceCursor cursor(entry.pData, entry.cbData);
+    WORD wVersion = 0;
+    if (!cursor.Read(wVersion))
+        return false;
     switch (wVersion)
     {
     case 0:
@@ -48,108 +53,76 @@ static bool IsExtendedMenuTemplate(LPVOID pResource, bool& bIsExtendedMenuTempla
 }
 
 /// <summary>
-/// Indicates whether the second memory address is in the range beginning with the first memory address and
-/// with the resource size specified.
+/// Returns the text up to the first tab character.
 /// </summary>
-/// <param name="pvBaseAddress">Input: base address</param>
-/// <param name="dwResourceSize">Input: number of valid bytes following the base address</param>
-/// <param name="pMem">Input: address to check</param>
-/// <returns>true if pMem is between pvBaseAddress and pvBaseAddress+dwResourceSize; false otherwise</returns>
-static inline bool InAddressRange(LPVOID pvBaseAddress, DWORD dwResourceSize, uint16_t* pMem)
+static inline utf16view_t RemoveTabAndAfter(const utf16view_t& text)
 {
-    byte* pBaseAddress = (byte*)pvBaseAddress;
-    byte* pMaxAddress = pBaseAddress + dwResourceSize;
-    return ((byte*)pMem >= pBaseAddress && (byte*)pMem < pMaxAddress);
-}
-
-/// <summary>
-/// Given the address of a zero-terminated wide-character string, return the memory address immediately following it.
-/// </summary>
-static inline uint16_t* Uint16AfterSz(uint16_t* pMem)
-{
-    while (0 != *pMem++)
-        ;
-    return pMem;
-}
-
-/// <summary>
-/// Returns the input string terminated at the first tab character.
-/// </summary>
-static inline std::wstring RemoveTabAndAfter(const std::wstring& sInput)
-{
-    size_t ix = sInput.find(L'\t', 0);
-    if (std::wstring::npos == ix)
-        return sInput;
-    else
-        return sInput.substr(0, ix);
+    utf16view_t result = text;
+    for (size_t ix = 0; ix < text.nChars; ++ix)
+    {
+        if (L'\t' == text.pChars[ix])
+        {
+            result.nChars = ix;
+            break;
+        }
+    }
+    return result;
 }
 
 /// <summary>
 /// Process an extended menu template.
-/// Output a line of tab-delimited information for each textual menu item.
+/// Report the text of each textual menu item.
 /// Helped tremendously by Raymond Chen's "The evolution of menu templates: 16/32-bit extended menus"
 /// </summary>
-/// <param name="lpName"></param>
-/// <param name="pResource"></param>
-/// <param name="dwResourceSize"></param>
-/// <param name="out"></param>
+/// <param name="cursor">Cursor at the beginning of the menu template</param>
+/// <param name="entry">The menu resource, for the visitor</param>
+/// <param name="visitor">Visitor to report the text to</param>
 /// <param name="err"></param>
-/// <returns></returns>
-static bool ProcessExtendedMenuTemplate(LPCWSTR lpName, LPVOID pResource, DWORD dwResourceSize, std::wostream& out, std::wostream& err)
+/// <returns>false if the template extends beyond the resource</returns>
+static bool DecodeExtendedMenuTemplate(CheckedResourceCursor& cursor, const ResourceEntry_t& entry, ResourceVisitor& visitor, std::wostream& err)
 {
     // Point to the beginning of the menu template
-    MENUEX_TEMPLATE_HEADER* pHeader = (MENUEX_TEMPLATE_HEADER*)pResource;
+    MENUEX_TEMPLATE_HEADER header;
+    if (!cursor.Struct(header))
+        return false;
 
     // This failure NEVER happens
-    if (4 != pHeader->wOffset)
-        err << L"EXTENDED OFFSET UNEXPECTED VALUE: " << pHeader->wOffset << std::endl;
-
-    // Point to the memory immediately following the header
-    uint16_t* pMem = (uint16_t*)(pHeader + 1);
+    if (4 != header.wOffset)
+        err << L"EXTENDED OFFSET UNEXPECTED VALUE: " << header.wOffset << std::endl;
 
-    // Add size of an extra uint16_t before comparing, to make sure the alignment won't push it over
-    while (InAddressRange(pResource, dwResourceSize, pMem + 1))
+    // Look for another item only if more than one uint16_t remains, to make sure the alignment won't push it over
+    while (cursor.Remaining() > sizeof(uint16_t))
     {
         // Each MENUEX_TEMPLATE_ITEM must be aligned on a four-byte boundary
-        while (0 != ((unsigned long long)pMem & 0x03))
-            pMem++;
+        cursor.AlignTo(4);
 
-        // Point to the extended menu template item
-        MENUEX_TEMPLATE_ITEM* pMenuItem = (MENUEX_TEMPLATE_ITEM*)pMem;
+        // The extended menu template item, up to its text
+        MENUEX_TEMPLATE_ITEM menuItem;
+        if (!cursor.Struct(menuItem, offsetof(MENUEX_TEMPLATE_ITEM, szText)))
+            return false;
         // There is no szText member if the menu item is a separator or a bitmap
-        bool bNoText = 0 != (pMenuItem->dwType & (MFT_SEPARATOR | MFT_BITMAP));
+        bool bNoText = 0 != (menuItem.dwType & (MFT_SEPARATOR | MFT_BITMAP));
         // Popup is followed by a four-byte header structure preceding the popup menu items
-        bool bPopup = 0 != (pMenuItem->wFlags & 0x01);
+        bool bPopup = 0 != (menuItem.wFlags & 0x01);
         // Look for text only if it can be there
         if (!bNoText)
         {
+            utf16view_t text;
+            if (!cursor.ReadSz(text))
+                return false;
             // If there's non-empty text, output a line of tab-delimited info
-            std::wstring sText = pMenuItem->szText;
-            if (sText.length() > 0)
+            if (!text.empty())
             {
-                // Name/ID of menu
-                // Control ID for the menu item
-                // Localized text, with ampersand accelerators removed
-                // Original text, with ampersands not removed
-                out
-                    << RSRCID_t(lpName) << L"\t"
-                    << (INT)pMenuItem->uId << L"\t"
-                    << RemoveAccelsFromText(sText) << L"\t"
-                    << sText
-                    << std::endl;
+                // Control ID for the menu item, and its text
+                textview_t item;
+                item.id = (INT)menuItem.uId;
+                item.text = text;
+                visitor.Visit(entry, item);
             }
+            // A popup's text is followed by a four-byte (two uint16_t) header
+            if (bPopup && !cursor.Skip(sizeof(DWORD)))
+                return false;
         }
-
-        // Point to the next extended menu item
-        if (bNoText)
-            // No szText member, so point to where it would have been
-            pMem = (uint16_t*)pMenuItem->szText;
-        else if (bPopup)
-            // After the text, and a four-byte (two uint16_t) header
-            pMem = Uint16AfterSz((uint16_t*)(pMenuItem->szText)) + 2;
-        else
-            // After the text
-            pMem = Uint16AfterSz((uint16_t*)(pMenuItem->szText));
     }
 
     return true;
@@ -170,143 +143,135 @@ static bool ProcessExtendedMenuTemplate(LPCWSTR lpName, LPVOID pResource, DWORD
 
 /// <summary>
 /// Process a standard/"classic" menu template.
-/// Output a line of tab-delimited information for each textual menu item.
+/// Report the text of each textual menu item.
 /// Helped tremendously by Raymond Chen's "The evolution of menu templates: 16/32-bit classic menus"
 /// </summary>
-/// <param name="lpName"></param>
-/// <param name="pResource"></param>
-/// <param name="dwResourceSize"></param>
-/// <param name="out"></param>
+/// <param name="cursor">Cursor at the beginning of the menu template</param>
+/// <param name="entry">The menu resource, for the visitor</param>
+/// <param name="visitor">Visitor to report the text to</param>
 /// <param name="err"></param>
-/// <returns></returns>
-static bool ProcessStandardMenuTemplate(LPCWSTR lpName, LPVOID pResource, DWORD dwResourceSize, std::wostream& out, std::wostream& err)
+/// <returns>false if the template extends beyond the resource</returns>
+static bool DecodeStandardMenuTemplate(CheckedResourceCursor& cursor, const ResourceEntry_t& entry, ResourceVisitor& visitor, std::wostream& err)
 {
     // Point to the beginning of the menu template
-    MENUHEADER* pHeader = (MENUHEADER*)pResource;
+    MENUHEADER header;
+    if (!cursor.Struct(header))
+        return false;
 
     // This failure NEVER happens
-    if (0 != pHeader->cbHeaderSize)
-        err << L"STANDARD CBHEADERSIZE UNEXPECTED VALUE: " << pHeader->cbHeaderSize << std::endl;
+    if (0 != header.cbHeaderSize)
+        err << L"STANDARD CBHEADERSIZE UNEXPECTED VALUE: " << header.cbHeaderSize << std::endl;
 
-    // Point to the memory immediately following the header
-    uint16_t* pMem = (uint16_t*)(pHeader + 1);
-
-    // Add size of an extra uint16_t before comparing
-    while (InAddressRange(pResource, dwResourceSize, pMem + 1))
+    // Look for another item only if more than one uint16_t remains
+    while (cursor.Remaining() > sizeof(uint16_t))
     {
         // First word is flags, which indicates whether it's a popup or an item with a control ID
-        WORD wFlags = *pMem++;
-        if (wFlags & MF_POPUP)
-        {
-            // It's a popup. No control ID. Menu text starts right after the flags.
-            std::wstring sText = (const wchar_t*)pMem;
+        WORD wFlags = 0;
+        cursor.Read(wFlags);
+        // A popup has no control ID; its menu text starts right after the flags.
+        // Otherwise the next word is the menu item's control ID, followed by the menu text.
+        const bool bPopup = 0 != (wFlags & MF_POPUP);
+        WORD wID = 0;
+        if (!bPopup)
+            cursor.Read(wID);
+        utf16view_t text;
+        if (!cursor.ReadSz(text))
+            return false;
 
-            // If non-empty, write out a line of tab-delimited information
-            if (sText.length() > 0)
-            {
-                // Tab character is used to add an accelerator key combo to the menu entry.
-                // Almost certainly don't need to worry about those in popups, but check anyway.
-                sText = RemoveTabAndAfter(sText);
-
-                // Name/ID of menu
-                // No control ID for popup, so write "n/a"
-                // Localized text, with ampersand accelerators removed
-                // Original text, with ampersands not removed
-                out
-                    << RSRCID_t(lpName) << L"\t"
-                    << L"n/a" << L"\t"
-                    << RemoveAccelsFromText(sText) << L"\t"
-                    << sText
-                    << std::endl;
-            }
-        }
-        else
+        // If non-empty, write out a line of tab-delimited information
+        if (!text.empty())
         {
-            // Not a popup; next word is the menu item's control ID, followed by the menu text.
-            WORD wID = *pMem++;
-            std::wstring sText = (const wchar_t*)pMem;
-
-            // If non-empty, write out a line of tab-delimited information
-            if (sText.length() > 0)
-            {
-                // Tab character is used to add an accelerator key combo to the menu entry.
-                sText = RemoveTabAndAfter(sText);
-
-                // Name/ID of menu
+            // Tab character is used to add an accelerator key combo to the menu entry.
+            // Almost certainly don't need to worry about those in popups, but check anyway.
+            textview_t item;
+            item.text = RemoveTabAndAfter(text);
+            if (bPopup)
+                // No control ID for popup
+                item.item = textview_t::item_t::ePopup;
+            else
                 // Control ID for the menu item
-                // Localized text, with ampersand accelerators removed
-                // Original text, with ampersands not removed
-                out
-                    << RSRCID_t(lpName) << L"\t"
-                    << wID << L"\t"
-                    << RemoveAccelsFromText(sText) << L"\t"
-                    << sText
-                    << std::endl;
-            }
+                item.id = wID;
+            visitor.Visit(entry, item);
         }
-        // Point to the next menu item, which follows the text that pMem is pointing to.
-        pMem = Uint16AfterSz(pMem);
     }
 
     return true;
 }
 
 /// <summary>
-/// Callback function to handle each menu resource in the current file.
+/// Writes the tab-delimited headers for menu output.
 /// </summary>
-/// <param name="hModule">Handle to the resource DLL</param>
-/// <param name="lpType">Resource type</param>
-/// <param name="lpName">Resource name/identifier</param>
-/// <param name="lParam">Pointer to output stream</param>
-/// <returns>Always returns TRUE to continue enumeration</returns>
-static BOOL CALLBACK EnumMenuCallbackProc(
-    _In_opt_ HMODULE hModule,
-    _In_ LPCWSTR lpType,
-    _In_ LPWSTR lpName,
-    _In_ LONG_PTR lParam)
+void WriteMenuTextHeaders(std::wostream& out)
 {
-    streams_t* pStreams = (streams_t*)lParam;
-    // Should enumerate only RT_MENUs, but check again just to be safe
-    if (RT_MENU == lpType)
+    out
+        << L"Menu ID\t"
+        << L"Ctrl ID\t"
+        << L"Localized text\t"
+        << L"Dialog text"
+        << L'\n';
+}
+
+/// <summary>
+/// Decodes the item text of one menu resource in the current file.
+/// Menus are decoded with the checked cursor only, as dialogs are (see DecodeDialogText).
+/// </summary>
+bool DecodeMenuText(const ResourceEntry_t& entry, ResourceVisitor& visitor, std::wostream& err)
+{
+    bool bValid, bIsExtendedMenuTemplate;
+    bValid = IsExtendedMenuTemplate(entry, bIsExtendedMenuTemplate);
+    if (!bValid)
     {
-        // Eliminate false positive about lpType possibly being 0
-#pragma warning(push)
-#pragma warning (disable: 6387)
-        HRSRC hRsrc = FindResourceW(hModule, lpName, lpType);
-#pragma warning(pop)
-        if (NULL != hRsrc)
-        {
-            DWORD dwResourceSize = SizeofResource(hModule, hRsrc);
-            HGLOBAL hGbl = LoadResource(hModule, hRsrc);
-            if (NULL != hGbl)
-            {
-                LPVOID pData = LockResource(hGbl);
-                bool bValid, bIsExtendedMenuTemplate;
-                bValid = IsExtendedMenuTemplate(pData, bIsExtendedMenuTemplate);
-                if (!bValid)
-                {
-                    pStreams->WCerr << L"INVALID MENU, WTAF" << std::endl;
-                }
-                else
-                {
-                    if (bIsExtendedMenuTemplate)
-                    {
-                        ProcessExtendedMenuTemplate(lpName, pData, dwResourceSize, pStreams->WCout, pStreams->WCerr);
-                    }
-                    else
-                    {
-                        ProcessStandardMenuTemplate(lpName, pData, dwResourceSize, pStreams->WCout, pStreams->WCerr);
-                    }
-                }
-            }
-        }
+        err << L"INVALID MENU, WTAF" << std::endl;
     }
     else
     {
-        // This should never happen.
-        pStreams->WCerr << L"UNEXPECTED RESOURCE TYPE: " << RSRCID_t(lpType) << L", ID " << RSRCID_t(lpName) << std::endl;
+        CheckedResourceCursor cursor(entry.pData, entry.cbData);
+        if (bIsExtendedMenuTemplate)
+            bValid = DecodeExtendedMenuTemplate(cursor, entry, visitor, err);
+        else
+            bValid = DecodeStandardMenuTemplate(cursor, entry, visitor, err);
+        // Report a malformed menu, but continue with the file's other resources.
+        if (!bValid)
+            err << L"Error: menu " << entry.name << L" extends beyond the end of the resource" << std::endl;
     }
-    return TRUE;
+    return true;
+}
+
+/// <summary>
+/// Writes a line of tab-delimited output for one menu item or popup.
+/// </summary>
+void WriteMenuText(const ResourceEntry_t& entry, const textview_t& text, TextArena& arena, std::wostream& out)
+{
+    // Name/ID of menu
+    // Control ID for the menu item; no control ID for popup, so write "n/a"
+    // Localized text, with ampersand accelerators removed
+    // Original text, with ampersands not removed
+    const arenatext_t itemText = ArenaText(arena, text.text);
+    WriteResourceName(out, entry.name, arena);
+    out << L"\t";
+    if (textview_t::item_t::ePopup == text.item)
+        out << L"n/a";
+    else
+        out << text.id;
+    out
+        << L"\t"
+        << RemoveAccelsFromText(arena, itemText) << L"\t"
+        << itemText
+        << L'\n';
+}
+
+/// <summary>
+/// Handle one menu resource in the current file.
+/// Output a line of tab-delimited information for each textual menu item.
+/// </summary>
+/// <param name="entry">The menu resource</param>
+/// <param name="streams">The output and error streams to write information into</param>
+/// <returns>Always returns true to continue enumeration</returns>
+bool ProcessMenuResource(const ResourceEntry_t& entry, streams_t& streams)
+{
+    TextArena arena;
+    TextWriterVisitor writer(WriteMenuText, arena, streams.WCout);
+    return DecodeMenuText(entry, writer, streams.WCerr);
 }
 
 /// <summary>
@@ -314,24 +279,21 @@ static BOOL CALLBACK EnumMenuCallbackProc(
 /// Output includes the menu ID, control ID, and the localized text both with accelerators
 /// and with accelerator characters removed.
 /// </summary>
-/// <param name="hModule">Handle to the module to inspect</param>
+/// <param name="rsrcFile">The resource file to inspect</param>
 /// <param name="streams">The output and error streams to write information into</param>
+/// <param name="nThreads">Input: maximum number of threads to decode a large file on; 0 for one per hardware thread</param>
 /// <returns>true if successful, false otherwise.</returns>
-bool MenuTextExtraction(HMODULE hModule, streams_t& streams)
+bool MenuTextExtraction(const ResourceFile& rsrcFile, streams_t& streams, unsigned int nThreads)
 {
     // Tab-delimited headers
-    streams.WCout
-        << L"Menu ID\t"
-        << L"Ctrl ID\t"
-        << L"Localized text\t"
-        << L"Dialog text"
-        << std::endl;
+    WriteMenuTextHeaders(streams.WCout);
 
     // Enumerate the menu resources
-    if (!EnumResourceNamesW(hModule, RT_MENU, EnumMenuCallbackProc, (LPARAM)&streams))
+    // Large files are decoded on several threads.
+    std::wstring sErrorInfo;
+    if (!ExtractResourcesOfType(rsrcFile, rsrctype_t::eMenu, streams.WCout, streams.WCerr, nThreads, sErrorInfo))
     {
-        DWORD dwLastErr = GetLastError();
-        streams.WCerr << L"EnumResourceNamesW failed: " << SysErrorMessageWithCode(dwLastErr) << std::endl;
+        streams.WCerr << L"Cannot enumerate menu resources: " << sErrorInfo << std::endl;
         return false;
     }
 
@@ -1,13 +1,44 @@
 #pragma once
 
 #include "UtilityFunctions.h"
+#include "TextRecord.h"
 
 /// <summary>
 /// Outputs localized text in the module's menu resources as tab-delimited fields.
 /// Output includes the menu ID, control ID, and the localized text both with accelerators
 /// and with accelerator characters removed.
 /// </summary>
-/// <param name="hModule">Handle to the module to inspect</param>
+/// <param name="rsrcFile">The resource file to inspect</param>
 /// <param name="streams">The output and error streams to write information into</param>
+/// <param name="nThreads">Input: maximum number of threads to decode a large file on; 0 for one per hardware thread</param>
 /// <returns>true if successful, false otherwise.</returns>
-bool MenuTextExtraction(HMODULE hModule, streams_t& streams);
+bool MenuTextExtraction(const ResourceFile& rsrcFile, streams_t& streams, unsigned int nThreads);
+
+/// <summary>
+/// Writes the tab-delimited headers for menu output.
+/// </summary>
+/// <param name="out">The output stream to write the headers into</param>
+void WriteMenuTextHeaders(std::wostream& out);
+
+/// <summary>
+/// Outputs the localized text in one menu resource, without headers.
+/// </summary>
+/// <param name="entry">The resource</param>
+/// <param name="streams">The output and error streams to write information into</param>
+/// <returns>true to continue enumeration; false if the resource is malformed</returns>
+bool ProcessMenuResource(const ResourceEntry_t& entry, streams_t& streams);
+
+/// <summary>
+/// Decodes the text in one menu resource: the text of its items and popups, without escaping or accelerator removal.
+/// This is the decoding behind ProcessMenuResource, for output other than tab-delimited text.
+/// </summary>
+/// <param name="entry">The resource</param>
+/// <param name="visitor">Input: visitor to report the text of each item and popup to</param>
+/// <param name="err">The error stream to write diagnostic information into</param>
+/// <returns>true to continue enumeration; false if the resource is malformed</returns>
+bool DecodeMenuText(const ResourceEntry_t& entry, ResourceVisitor& visitor, std::wostream& err);
+
+/// <summary>
+/// Writes the tab-delimited output for one item of text that DecodeMenuText reports.
+/// </summary>
+void WriteMenuText(const ResourceEntry_t& entry, const textview_t& text, TextArena& arena, std::wostream& out);
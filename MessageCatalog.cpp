@@ -0,0 +1,739 @@
+#include "PlatformDefs.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+#include "MessageCatalog.h"
+#include "CorpusExtraction.h"
+#include "HEX.h"
+#include "LanguageNames.h"
+#include "StringUtils.h"
+
+/*
+Catalog file layout. All values are little-endian; each section starts on an 8-byte boundary.
+
+    header_t
+    table_t[nTables]                (module, resource type, language)
+    int32_t[nBuckets]               perfect hash displacements for (table, ID) keys, one per bucket
+    entry_t[nEntries]               entries, each at the slot the perfect hash assigns its key
+    int32_t[nIdBuckets]             perfect hash displacements for IDs
+    idrange_t[nIds]                 each distinct ID, at the slot the perfect hash assigns it
+    uint32_t[nEntries]              entry slots grouped by ID, in table order within each ID
+    int32_t[nModuleBuckets]         perfect hash displacements for module names
+    modulename_t[nModuleNames]      each module name, at the slot the perfect hash assigns it
+    uint32_t[nModuleTables]         table indexes grouped by module name, in table order within each name
+    char[cbHeap]                    UTF-8 module names and text
+
+Each perfect hash is "hash and displace": a key's first hash picks a bucket, and the bucket's displacement
+picks the key's slot: either directly (a negative value -(slot + 1), used for buckets with one key) or as
+the seed of a second hash, chosen when building so that every key in the bucket lands in a free slot.
+Keys that aren't in the catalog land on some slot, so a lookup compares the slot's key.
+
+The keys are a table index and ID, an ID, and a module name: each module's file name and path, with ASCII
+letters lowercased (see ModuleNameKey), hashed to 64 bits. So every lookup, by ID alone or by module and ID,
+takes a constant number of probes, however many tables the catalog has.
+*/
+
+static const char szCatalogMagic[8] = { 'G', 'L', 'R', 'C', 'A', 'T', '2', 0 };
+
+struct MessageCatalog::header_t
+{
+    char magic[8];
+    uint32_t nTables;
+    uint32_t nBuckets;
+    uint32_t nEntries;
+    uint32_t nIdBuckets;
+    uint32_t nIds;
+    uint32_t nModuleBuckets;
+    uint32_t nModuleNames;
+    uint32_t nModuleTables;
+    uint64_t ofsTables;
+    uint64_t ofsBuckets;
+    uint64_t ofsEntries;
+    uint64_t ofsIdBuckets;
+    uint64_t ofsIds;
+    uint64_t ofsIdSlots;
+    uint64_t ofsModuleBuckets;
+    uint64_t ofsModuleNames;
+    uint64_t ofsModuleTables;
+    uint64_t ofsHeap;
+    uint64_t cbHeap;
+};
+
+struct MessageCatalog::table_t
+{
+    uint32_t ofsModule;
+    uint32_t cbModule;
+    uint16_t type;
+    uint16_t langId;
+    uint32_t reserved;
+};
+
+struct MessageCatalog::entry_t
+{
+    uint32_t ixTable;
+    uint32_t id;
+    uint32_t ofsText;
+    uint32_t cbText;
+};
+
+// The entries with one ID: ID slots ixFirst to ixFirst + nSlots - 1
+struct MessageCatalog::idrange_t
+{
+    uint32_t id;
+    uint32_t ixFirst;
+    uint32_t nSlots;
+    uint32_t reserved;
+};
+
+// The tables of the modules with one name: module tables ixFirst to ixFirst + nTables - 1
+struct MessageCatalog::modulename_t
+{
+    uint32_t ofsName;
+    uint32_t cbName;
+    uint32_t ixFirst;
+    uint32_t nTables;
+};
+
+/// <summary>
+/// Average number of keys per perfect hash bucket.
+/// </summary>
+static const uint32_t nKeysPerBucket = 4;
+
+/// <summary>
+/// Hashes a key with a seed: 0 to choose the bucket, or a bucket's displacement to choose the slot.
+/// </summary>
+static inline uint64_t CatalogHash(uint64_t key, uint32_t seed)
+{
+    // splitmix64 finalizer
+    uint64_t z = key + (seed + 1) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/// <summary>
+/// Key of an entry: its table index and ID.
+/// </summary>
+static inline uint64_t EntryKey(uint32_t ixTable, uint32_t id)
+{
+    return ((uint64_t)ixTable << 32) | id;
+}
+
+/// <summary>
+/// Returns the slot that a perfect hash assigns a key, or nSlots if the displacements are damaged.
+/// </summary>
+static inline uint32_t PerfectHashSlot(const int32_t* pBuckets, uint32_t nBuckets, uint32_t nSlots, uint64_t key)
+{
+    const int32_t displacement = pBuckets[CatalogHash(key, 0) % nBuckets];
+    const uint32_t ixSlot = (displacement < 0) ?
+        (uint32_t)(-(displacement + 1)) :
+        (uint32_t)(CatalogHash(key, (uint32_t)displacement) % nSlots);
+    return (ixSlot < nSlots) ? ixSlot : nSlots;
+}
+
+/// <summary>
+/// Builds a perfect hash over distinct keys.
+/// </summary>
+/// <param name="vKeys">Input: the keys</param>
+/// <param name="vBuckets">Output: the displacement of each bucket</param>
+/// <param name="vKeySlots">Output: the slot of each key, from 0 to the number of keys - 1</param>
+/// <returns>true if successful, false if two keys are the same</returns>
+static bool BuildPerfectHash(const std::vector<uint64_t>& vKeys, std::vector<int32_t>& vBuckets, std::vector<uint32_t>& vKeySlots)
+{
+    const uint32_t nKeys = (uint32_t)vKeys.size();
+    const uint32_t nBuckets = nKeys / nKeysPerBucket + 1;
+    vBuckets.assign(nBuckets, 0);
+    vKeySlots.assign(nKeys, 0);
+
+    // Keys in each bucket; buckets with the most keys are placed first, while there are the most free slots.
+    std::vector<std::vector<uint32_t>> vBucketKeys(nBuckets);
+    for (uint32_t ixKey = 0; ixKey < nKeys; ++ixKey)
+        vBucketKeys[CatalogHash(vKeys[ixKey], 0) % nBuckets].push_back(ixKey);
+    std::vector<uint32_t> vBucketOrder(nBuckets);
+    for (uint32_t ixBucket = 0; ixBucket < nBuckets; ++ixBucket)
+        vBucketOrder[ixBucket] = ixBucket;
+    std::stable_sort(vBucketOrder.begin(), vBucketOrder.end(), [&](uint32_t ix1, uint32_t ix2) { return vBucketKeys[ix1].size() > vBucketKeys[ix2].size(); });
+
+    std::vector<bool> vUsed(nKeys, false);
+    std::vector<uint32_t> vCandidateSlots;
+    uint32_t ixNextFree = 0;
+    for (uint32_t ixBucket : vBucketOrder)
+    {
+        const std::vector<uint32_t>& vBucket = vBucketKeys[ixBucket];
+        if (vBucket.empty())
+            break;
+        if (1 == vBucket.size())
+        {
+            // Single keys take the free slots in order, with no search.
+            while (vUsed[ixNextFree])
+                ++ixNextFree;
+            vUsed[ixNextFree] = true;
+            vKeySlots[vBucket[0]] = ixNextFree;
+            vBuckets[ixBucket] = -(int32_t)ixNextFree - 1;
+            continue;
+        }
+        // Identical keys would never land in distinct slots.
+        for (size_t ixKey = 1; ixKey < vBucket.size(); ++ixKey)
+        {
+            for (size_t ixOther = 0; ixOther < ixKey; ++ixOther)
+            {
+                if (vKeys[vBucket[ixKey]] == vKeys[vBucket[ixOther]])
+                    return false;
+            }
+        }
+        // Try seeds until every key in the bucket lands in a distinct free slot.
+        bool bPlaced = false;
+        for (uint32_t seed = 1; seed < 0x7FFFFFFF && !bPlaced; ++seed)
+        {
+            vCandidateSlots.clear();
+            bPlaced = true;
+            for (uint32_t ixKey : vBucket)
+            {
+                const uint32_t ixSlot = (uint32_t)(CatalogHash(vKeys[ixKey], seed) % nKeys);
+                if (vUsed[ixSlot] || vCandidateSlots.end() != std::find(vCandidateSlots.begin(), vCandidateSlots.end(), ixSlot))
+                {
+                    bPlaced = false;
+                    break;
+                }
+                vCandidateSlots.push_back(ixSlot);
+            }
+            if (bPlaced)
+            {
+                for (size_t ixKey = 0; ixKey < vBucket.size(); ++ixKey)
+                {
+                    vUsed[vCandidateSlots[ixKey]] = true;
+                    vKeySlots[vBucket[ixKey]] = vCandidateSlots[ixKey];
+                }
+                vBuckets[ixBucket] = (int32_t)seed;
+            }
+        }
+        if (!bPlaced)
+            return false;
+    }
+    return true;
+}
+
+/// <summary>
+/// Returns a module name as it's stored in the module name index: UTF-8, with ASCII letters lowercased, so that a
+/// lookup isn't case-sensitive and doesn't depend on the locale the catalog was built in.
+/// </summary>
+static std::string ModuleNameKey(const std::wstring& sName)
+{
+    std::string sKey = WStringToUtf8(sName);
+    for (char& ch : sKey)
+    {
+        if (ch >= 'A' && ch <= 'Z')
+            ch = (char)(ch - 'A' + 'a');
+    }
+    return sKey;
+}
+
+/// <summary>
+/// Hash of a module name key, as the perfect hash's key.
+/// </summary>
+static inline uint64_t ModuleNameHash(const std::string& sKey)
+{
+    return HashContent(sKey.data(), sKey.length(), 0);
+}
+
+// --------------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Collects the tables, entries, and text of a catalog, and writes the catalog file.
+/// </summary>
+class CatalogBuilder
+{
+public:
+    void Add(const std::wstring& sModule, const resourcerecord_t& record);
+    bool Write(const std::wstring& sFilePath, std::wstring& sErrorInfo);
+
+private:
+    uint32_t AddToHeap(const std::wstring& sText, uint32_t& cbText);
+    uint32_t AddUtf8ToHeap(const std::string& sUtf8, uint32_t& cbText);
+
+    // Access to MessageCatalog's file structures
+    typedef MessageCatalog::table_t table_t;
+    typedef MessageCatalog::entry_t entry_t;
+    typedef MessageCatalog::idrange_t idrange_t;
+    typedef MessageCatalog::modulename_t modulename_t;
+
+    std::vector<table_t> m_vTables;
+    std::map<std::tuple<std::wstring, uint16_t, uint16_t>, uint32_t> m_tableIndices;
+    std::vector<entry_t> m_vEntries;
+    // Keys already added; an ID that appears in more than one resource of a table keeps its first text.
+    std::unordered_map<uint64_t, uint32_t> m_keys;
+    std::string m_sHeap;
+    std::unordered_map<std::string, uint32_t> m_heapOffsets;
+    std::string m_sUtf8;
+};
+
+uint32_t CatalogBuilder::AddToHeap(const std::wstring& sText, uint32_t& cbText)
+{
+    m_sUtf8.resize(sText.length() * nMaxUtf8BytesPerWchar);
+    m_sUtf8.resize(WideToUtf8(sText.c_str(), sText.length(), &m_sUtf8[0]));
+    return AddUtf8ToHeap(m_sUtf8, cbText);
+}
+
+uint32_t CatalogBuilder::AddUtf8ToHeap(const std::string& sUtf8, uint32_t& cbText)
+{
+    cbText = (uint32_t)sUtf8.length();
+    auto result = m_heapOffsets.insert(std::make_pair(sUtf8, (uint32_t)m_sHeap.length()));
+    if (result.second)
+        m_sHeap += sUtf8;
+    return result.first->second;
+}
+
+void CatalogBuilder::Add(const std::wstring& sModule, const resourcerecord_t& record)
+{
+    // Only items with IDs can be looked up.
+    if (textrecord_t::item_t::eId != record.text.item)
+        return;
+
+    auto tableKey = std::make_tuple(sModule, (uint16_t)record.type, record.langId);
+    auto iterTable = m_tableIndices.find(tableKey);
+    if (m_tableIndices.end() == iterTable)
+    {
+        table_t table = table_t();
+        table.ofsModule = AddToHeap(sModule, table.cbModule);
+        table.type = (uint16_t)record.type;
+        table.langId = record.langId;
+        iterTable = m_tableIndices.insert(std::make_pair(tableKey, (uint32_t)m_vTables.size())).first;
+        m_vTables.push_back(table);
+    }
+
+    entry_t entry = entry_t();
+    entry.ixTable = iterTable->second;
+    entry.id = (uint32_t)record.text.id;
+    if (!m_keys.insert(std::make_pair(EntryKey(entry.ixTable, entry.id), (uint32_t)m_vEntries.size())).second)
+        return;
+    entry.ofsText = AddToHeap(record.text.sText, entry.cbText);
+    m_vEntries.push_back(entry);
+}
+
+template <typename T>
+static void WriteSection(std::ofstream& file, uint64_t& cbWritten, const T* pData, size_t nItems)
+{
+    static const char padding[8] = { 0 };
+    file.write((const char*)pData, (std::streamsize)(nItems * sizeof(T)));
+    cbWritten += nItems * sizeof(T);
+    const size_t cbPadding = (size_t)((8 - cbWritten % 8) % 8);
+    file.write(padding, (std::streamsize)cbPadding);
+    cbWritten += cbPadding;
+}
+
+static uint64_t SectionSize(size_t cbSection)
+{
+    return (cbSection + 7) & ~(uint64_t)7;
+}
+
+bool CatalogBuilder::Write(const std::wstring& sFilePath, std::wstring& sErrorInfo)
+{
+    // Entries, at the slots of their (table, ID) keys
+    std::vector<uint64_t> vKeys;
+    for (const entry_t& entry : m_vEntries)
+        vKeys.push_back(EntryKey(entry.ixTable, entry.id));
+    std::vector<int32_t> vBuckets;
+    std::vector<uint32_t> vKeySlots;
+    if (!BuildPerfectHash(vKeys, vBuckets, vKeySlots))
+    {
+        sErrorInfo = L"Cannot build perfect hash";
+        return false;
+    }
+    std::vector<entry_t> vSlots(m_vEntries.size());
+    for (size_t ixEntry = 0; ixEntry < m_vEntries.size(); ++ixEntry)
+        vSlots[vKeySlots[ixEntry]] = m_vEntries[ixEntry];
+
+    // Entry slots grouped by ID, and each ID's range of them, at the slot of the ID
+    std::vector<uint32_t> vIdSlots(vSlots.size());
+    for (uint32_t ixSlot = 0; ixSlot < (uint32_t)vSlots.size(); ++ixSlot)
+        vIdSlots[ixSlot] = ixSlot;
+    std::sort(vIdSlots.begin(), vIdSlots.end(),
+        [&vSlots](uint32_t ix1, uint32_t ix2) { return std::tie(vSlots[ix1].id, vSlots[ix1].ixTable) < std::tie(vSlots[ix2].id, vSlots[ix2].ixTable); });
+    std::vector<idrange_t> vIdRanges;
+    for (uint32_t ixIdSlot = 0; ixIdSlot < (uint32_t)vIdSlots.size(); ++ixIdSlot)
+    {
+        const uint32_t id = vSlots[vIdSlots[ixIdSlot]].id;
+        if (vIdRanges.empty() || vIdRanges.back().id != id)
+        {
+            idrange_t range = idrange_t();
+            range.id = id;
+            range.ixFirst = ixIdSlot;
+            vIdRanges.push_back(range);
+        }
+        ++vIdRanges.back().nSlots;
+    }
+    vKeys.clear();
+    for (const idrange_t& range : vIdRanges)
+        vKeys.push_back(range.id);
+    std::vector<int32_t> vIdBuckets;
+    if (!BuildPerfectHash(vKeys, vIdBuckets, vKeySlots))
+    {
+        sErrorInfo = L"Cannot build perfect hash";
+        return false;
+    }
+    std::vector<idrange_t> vIds(vIdRanges.size());
+    for (size_t ixRange = 0; ixRange < vIdRanges.size(); ++ixRange)
+        vIds[vKeySlots[ixRange]] = vIdRanges[ixRange];
+
+    // Tables grouped by module name (each module's file name and path), and each name's range of them, at the
+    // slot of the name
+    std::map<std::string, std::vector<uint32_t>> moduleNameTables;
+    for (const auto& tableIndex : m_tableIndices)
+    {
+        const std::wstring& sModule = std::get<0>(tableIndex.first);
+        moduleNameTables[ModuleNameKey(sModule)].push_back(tableIndex.second);
+        moduleNameTables[ModuleNameKey(GetFileNameFromFilePath(sModule))].push_back(tableIndex.second);
+    }
+    std::vector<uint32_t> vModuleTables;
+    std::vector<modulename_t> vModuleNameRanges;
+    vKeys.clear();
+    for (auto& nameTables : moduleNameTables)
+    {
+        std::vector<uint32_t>& vTables = nameTables.second;
+        std::sort(vTables.begin(), vTables.end());
+        vTables.erase(std::unique(vTables.begin(), vTables.end()), vTables.end());
+        modulename_t name = modulename_t();
+        name.ofsName = AddUtf8ToHeap(nameTables.first, name.cbName);
+        name.ixFirst = (uint32_t)vModuleTables.size();
+        name.nTables = (uint32_t)vTables.size();
+        vModuleTables.insert(vModuleTables.end(), vTables.begin(), vTables.end());
+        vModuleNameRanges.push_back(name);
+        vKeys.push_back(ModuleNameHash(nameTables.first));
+    }
+    std::vector<int32_t> vModuleBuckets;
+    if (!BuildPerfectHash(vKeys, vModuleBuckets, vKeySlots))
+    {
+        sErrorInfo = L"Cannot build perfect hash";
+        return false;
+    }
+    std::vector<modulename_t> vModuleNames(vModuleNameRanges.size());
+    for (size_t ixName = 0; ixName < vModuleNameRanges.size(); ++ixName)
+        vModuleNames[vKeySlots[ixName]] = vModuleNameRanges[ixName];
+    // Module names are added to the heap last.
+    if (m_sHeap.length() > 0xFFFFFFFF)
+    {
+        sErrorInfo = L"Too much text for one catalog";
+        return false;
+    }
+
+    MessageCatalog::header_t header = MessageCatalog::header_t();
+    memcpy(header.magic, szCatalogMagic, sizeof(header.magic));
+    header.nTables = (uint32_t)m_vTables.size();
+    header.nBuckets = (uint32_t)vBuckets.size();
+    header.nEntries = (uint32_t)vSlots.size();
+    header.nIdBuckets = (uint32_t)vIdBuckets.size();
+    header.nIds = (uint32_t)vIds.size();
+    header.nModuleBuckets = (uint32_t)vModuleBuckets.size();
+    header.nModuleNames = (uint32_t)vModuleNames.size();
+    header.nModuleTables = (uint32_t)vModuleTables.size();
+    header.ofsTables = SectionSize(sizeof(header));
+    header.ofsBuckets = header.ofsTables + SectionSize(m_vTables.size() * sizeof(table_t));
+    header.ofsEntries = header.ofsBuckets + SectionSize(vBuckets.size() * sizeof(int32_t));
+    header.ofsIdBuckets = header.ofsEntries + SectionSize(vSlots.size() * sizeof(entry_t));
+    header.ofsIds = header.ofsIdBuckets + SectionSize(vIdBuckets.size() * sizeof(int32_t));
+    header.ofsIdSlots = header.ofsIds + SectionSize(vIds.size() * sizeof(idrange_t));
+    header.ofsModuleBuckets = header.ofsIdSlots + SectionSize(vIdSlots.size() * sizeof(uint32_t));
+    header.ofsModuleNames = header.ofsModuleBuckets + SectionSize(vModuleBuckets.size() * sizeof(int32_t));
+    header.ofsModuleTables = header.ofsModuleNames + SectionSize(vModuleNames.size() * sizeof(modulename_t));
+    header.ofsHeap = header.ofsModuleTables + SectionSize(vModuleTables.size() * sizeof(uint32_t));
+    header.cbHeap = m_sHeap.length();
+
+#ifdef _WIN32
+    std::ofstream file(sFilePath.c_str(), std::ios::binary | std::ios::trunc);
+#else
+    std::ofstream file(WStringToUtf8(sFilePath).c_str(), std::ios::binary | std::ios::trunc);
+#endif
+    if (!file.is_open())
+    {
+        sErrorInfo = L"Cannot create file " + sFilePath;
+        return false;
+    }
+    uint64_t cbWritten = 0;
+    WriteSection(file, cbWritten, &header, 1);
+    WriteSection(file, cbWritten, m_vTables.data(), m_vTables.size());
+    WriteSection(file, cbWritten, vBuckets.data(), vBuckets.size());
+    WriteSection(file, cbWritten, vSlots.data(), vSlots.size());
+    WriteSection(file, cbWritten, vIdBuckets.data(), vIdBuckets.size());
+    WriteSection(file, cbWritten, vIds.data(), vIds.size());
+    WriteSection(file, cbWritten, vIdSlots.data(), vIdSlots.size());
+    WriteSection(file, cbWritten, vModuleBuckets.data(), vModuleBuckets.size());
+    WriteSection(file, cbWritten, vModuleNames.data(), vModuleNames.size());
+    WriteSection(file, cbWritten, vModuleTables.data(), vModuleTables.size());
+    WriteSection(file, cbWritten, m_sHeap.data(), m_sHeap.length());
+    file.close();
+    if (file.fail())
+    {
+        sErrorInfo = L"Error writing file " + sFilePath;
+        return false;
+    }
+    return true;
+}
+
+bool BuildMessageCatalog(
+    const std::vector<std::wstring>& vFiles,
+    const languageoptions_t& languages,
+    unsigned int nWorkers,
+    ExtractionCache* pCache,
+    const std::wstring& sCatalogFile,
+    std::wostream& err)
+{
+    CatalogBuilder builder;
+    const std::vector<rsrctype_t> vTypes = { rsrctype_t::eString, rsrctype_t::eMessageTable };
+    CorpusRecordExtraction(
+        vFiles, vTypes, languages, nWorkers, pCache,
+        [&builder](const std::wstring& sFilePath, const resourcerecord_t& record) { builder.Add(sFilePath, record); },
+        err);
+
+    std::wstring sErrorInfo;
+    if (!builder.Write(sCatalogFile, sErrorInfo))
+    {
+        err << L"Cannot build catalog: " << sErrorInfo << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// --------------------------------------------------------------------------------------------------------------
+
+MessageCatalog::MessageCatalog() :
+    m_pBuckets(nullptr),
+    m_pEntries(nullptr),
+    m_pIdBuckets(nullptr),
+    m_pIds(nullptr),
+    m_pIdSlots(nullptr),
+    m_pModuleBuckets(nullptr),
+    m_pModuleNames(nullptr),
+    m_pModuleTables(nullptr),
+    m_pHeap(nullptr)
+{
+}
+
+/// <summary>
+/// Indicates whether a section of nItems items of cbItem bytes starts on an 8-byte boundary and lies within the file.
+/// </summary>
+static bool IsValidSection(uint64_t ofsSection, uint64_t nItems, size_t cbItem, uint64_t cbFile)
+{
+    return 0 == ofsSection % 8 && ofsSection <= cbFile && nItems <= (cbFile - ofsSection) / cbItem;
+}
+
+bool MessageCatalog::Open(const std::wstring& sFilePath, std::wstring& sErrorInfo)
+{
+    if (!m_file.Open(sFilePath, sErrorInfo))
+        return false;
+
+    const uint64_t cbFile = m_file.Size();
+    const header_t& header = Header();
+    if (cbFile < sizeof(header_t) || 0 != memcmp(header.magic, szCatalogMagic, sizeof(header.magic)))
+    {
+        // A catalog in an earlier format differs only in the version character.
+        const bool bEarlierFormat = cbFile >= sizeof(header.magic) && 0 == memcmp(header.magic, szCatalogMagic, 6);
+        sErrorInfo = bEarlierFormat ? L"Catalog file is in an earlier format; build it again" : L"Not a catalog file";
+        m_file.Close();
+        return false;
+    }
+    // Every section must be aligned and lie within the file, and the ID slots are one per entry.
+    const bool bValid =
+        0 != header.nBuckets && 0 != header.nIdBuckets && 0 != header.nModuleBuckets &&
+        IsValidSection(header.ofsTables, header.nTables, sizeof(table_t), cbFile) &&
+        IsValidSection(header.ofsBuckets, header.nBuckets, sizeof(int32_t), cbFile) &&
+        IsValidSection(header.ofsEntries, header.nEntries, sizeof(entry_t), cbFile) &&
+        IsValidSection(header.ofsIdBuckets, header.nIdBuckets, sizeof(int32_t), cbFile) &&
+        IsValidSection(header.ofsIds, header.nIds, sizeof(idrange_t), cbFile) &&
+        IsValidSection(header.ofsIdSlots, header.nEntries, sizeof(uint32_t), cbFile) &&
+        IsValidSection(header.ofsModuleBuckets, header.nModuleBuckets, sizeof(int32_t), cbFile) &&
+        IsValidSection(header.ofsModuleNames, header.nModuleNames, sizeof(modulename_t), cbFile) &&
+        IsValidSection(header.ofsModuleTables, header.nModuleTables, sizeof(uint32_t), cbFile) &&
+        header.ofsHeap <= cbFile && header.cbHeap <= cbFile - header.ofsHeap;
+    if (!bValid)
+    {
+        sErrorInfo = L"Catalog file is damaged";
+        m_file.Close();
+        return false;
+    }
+    m_pBuckets = (const int32_t*)(m_file.Data() + header.ofsBuckets);
+    m_pEntries = (const entry_t*)(m_file.Data() + header.ofsEntries);
+    m_pIdBuckets = (const int32_t*)(m_file.Data() + header.ofsIdBuckets);
+    m_pIds = (const idrange_t*)(m_file.Data() + header.ofsIds);
+    m_pIdSlots = (const uint32_t*)(m_file.Data() + header.ofsIdSlots);
+    m_pModuleBuckets = (const int32_t*)(m_file.Data() + header.ofsModuleBuckets);
+    m_pModuleNames = (const modulename_t*)(m_file.Data() + header.ofsModuleNames);
+    m_pModuleTables = (const uint32_t*)(m_file.Data() + header.ofsModuleTables);
+    m_pHeap = (const char*)(m_file.Data() + header.ofsHeap);
+    return true;
+}
+
+const MessageCatalog::header_t& MessageCatalog::Header() const
+{
+    return *(const header_t*)m_file.Data();
+}
+
+const MessageCatalog::table_t& MessageCatalog::Table(size_t ixTable) const
+{
+    return ((const table_t*)(m_file.Data() + Header().ofsTables))[ixTable];
+}
+
+size_t MessageCatalog::TableCount() const
+{
+    return m_file.IsOpen() ? Header().nTables : 0;
+}
+
+std::wstring MessageCatalog::TableModule(size_t ixTable) const
+{
+    const table_t& table = Table(ixTable);
+    if ((uint64_t)table.ofsModule + table.cbModule > Header().cbHeap)
+        return std::wstring();
+    return Utf8ToWString(std::string(m_pHeap + table.ofsModule, table.cbModule));
+}
+
+rsrctype_t MessageCatalog::TableType(size_t ixTable) const
+{
+    return (rsrctype_t)Table(ixTable).type;
+}
+
+uint16_t MessageCatalog::TableLangId(size_t ixTable) const
+{
+    return Table(ixTable).langId;
+}
+
+bool MessageCatalog::Find(size_t ixTable, uint32_t id, const char*& pText, size_t& cbText) const
+{
+    const header_t& header = Header();
+    if (0 == header.nEntries)
+        return false;
+    const uint32_t ixSlot = PerfectHashSlot(m_pBuckets, header.nBuckets, header.nEntries, EntryKey((uint32_t)ixTable, id));
+    if (ixSlot >= header.nEntries || m_pEntries[ixSlot].ixTable != ixTable || m_pEntries[ixSlot].id != id)
+        return false;
+    size_t ixEntryTable = 0;
+    return Entry(ixSlot, ixEntryTable, pText, cbText);
+}
+
+size_t MessageCatalog::FindId(uint32_t id, const uint32_t*& pSlots) const
+{
+    const header_t& header = Header();
+    if (0 == header.nIds)
+        return 0;
+    const uint32_t ixId = PerfectHashSlot(m_pIdBuckets, header.nIdBuckets, header.nIds, id);
+    if (ixId >= header.nIds)
+        return 0;
+    const idrange_t& range = m_pIds[ixId];
+    if (range.id != id || range.ixFirst > header.nEntries || range.nSlots > header.nEntries - range.ixFirst)
+        return 0;
+    pSlots = m_pIdSlots + range.ixFirst;
+    return range.nSlots;
+}
+
+size_t MessageCatalog::FindModule(const std::wstring& sModule, const uint32_t*& pTables) const
+{
+    const header_t& header = Header();
+    if (0 == header.nModuleNames)
+        return 0;
+    const std::string sKey = ModuleNameKey(sModule);
+    const uint32_t ixName = PerfectHashSlot(m_pModuleBuckets, header.nModuleBuckets, header.nModuleNames, ModuleNameHash(sKey));
+    if (ixName >= header.nModuleNames)
+        return 0;
+    const modulename_t& name = m_pModuleNames[ixName];
+    if (name.cbName != sKey.length() || (uint64_t)name.ofsName + name.cbName > header.cbHeap || 0 != memcmp(m_pHeap + name.ofsName, sKey.data(), sKey.length()))
+        return 0;
+    if (name.ixFirst > header.nModuleTables || name.nTables > header.nModuleTables - name.ixFirst)
+        return 0;
+    pTables = m_pModuleTables + name.ixFirst;
+    return name.nTables;
+}
+
+bool MessageCatalog::Entry(uint32_t ixSlot, size_t& ixTable, const char*& pText, size_t& cbText) const
+{
+    const header_t& header = Header();
+    if (ixSlot >= header.nEntries)
+        return false;
+    const entry_t& entry = m_pEntries[ixSlot];
+    if (entry.ixTable >= header.nTables || (uint64_t)entry.ofsText + entry.cbText > header.cbHeap)
+        return false;
+    ixTable = entry.ixTable;
+    pText = m_pHeap + entry.ofsText;
+    cbText = entry.cbText;
+    return true;
+}
+
+// --------------------------------------------------------------------------------------------------------------
+
+bool MessageCatalogLookup(
+    const std::wstring& sCatalogFile,
+    uint32_t id,
+    const std::vector<std::wstring>& vModules,
+    uint16_t langId,
+    streams_t& streams)
+{
+    MessageCatalog catalog;
+    std::wstring sErrorInfo;
+    if (!catalog.Open(sCatalogFile, sErrorInfo))
+    {
+        streams.WCerr << L"Cannot open catalog " << sCatalogFile << L": " << sErrorInfo << std::endl;
+        return false;
+    }
+
+    streams.WCout
+        << L"Module\t"
+        << L"Type\t"
+        << L"Language\t"
+        << L"ID\t"
+        << L"ID (hex)\t"
+        << L"Localized text"
+        << L'\n';
+
+    // The text of the ID in each table that has it, in table order, from the module name index if modules are
+    // named (a module can be named by its file name alone or by its path), or else from the ID index.
+    std::vector<std::tuple<size_t, const char*, size_t>> vFound;
+    const char* pText = nullptr;
+    size_t cbText = 0;
+    if (!vModules.empty())
+    {
+        std::vector<uint32_t> vTables;
+        for (const std::wstring& sModule : vModules)
+        {
+            const uint32_t* pTables = nullptr;
+            const size_t nTables = catalog.FindModule(sModule, pTables);
+            vTables.insert(vTables.end(), pTables, pTables + nTables);
+        }
+        std::sort(vTables.begin(), vTables.end());
+        vTables.erase(std::unique(vTables.begin(), vTables.end()), vTables.end());
+        for (uint32_t ixTable : vTables)
+        {
+            if (ixTable < catalog.TableCount() && catalog.Find(ixTable, id, pText, cbText))
+                vFound.push_back(std::make_tuple((size_t)ixTable, pText, cbText));
+        }
+    }
+    else
+    {
+        const uint32_t* pSlots = nullptr;
+        const size_t nSlots = catalog.FindId(id, pSlots);
+        size_t ixTable = 0;
+        for (size_t ixSlot = 0; ixSlot < nSlots; ++ixSlot)
+        {
+            if (catalog.Entry(pSlots[ixSlot], ixTable, pText, cbText))
+                vFound.push_back(std::make_tuple(ixTable, pText, cbText));
+        }
+    }
+
+    bool bFound = false;
+    for (const auto& found : vFound)
+    {
+        const size_t ixTable = std::get<0>(found);
+        if (0 != langId && catalog.TableLangId(ixTable) != langId)
+            continue;
+        streams.WCout
+            << escapeCrLfTabNul(catalog.TableModule(ixTable)) << L"\t"
+            << ResourceExtractor(catalog.TableType(ixTable)).szName << L"\t"
+            << LangIdToName(catalog.TableLangId(ixTable)) << L"\t"
+            << id << L"\t"
+            << HEX(id, 8, true, true) << L"\t"
+            << escapeCrLfTab(Utf8ToWString(std::string(std::get<1>(found), std::get<2>(found))))
+            << L'\n';
+        bFound = true;
+    }
+    if (!bFound)
+        streams.WCerr << L"No text found for ID " << id << L" (" << HEX(id, 8, true, true) << L")" << std::endl;
+    return bFound;
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ExtractionCache.h"
+#include "MappedFile.h"
+#include "ResourceExtraction.h"
+
+/// <summary>
+/// Builds a message catalog: an immutable file holding the string table and message table text of many resource
+/// files, for lookups by ID without re-running the extraction (e.g., NTSTATUS text from ntdll.dll, or Win32 error
+/// text from kernel32.dll).
+///
+/// Each (module, resource type, language) combination is a "table"; each item of text is keyed by its table and ID.
+/// The file contains the tables, a minimal perfect hash over the keys, the entries in hash order, indexes from each
+/// ID to its entries and from each module name to its tables (also minimal perfect hashes), and a heap of UTF-8
+/// text in which identical strings are stored once. MessageCatalog reads it in place from a file mapping.
+/// </summary>
+/// <param name="vFiles">Input: paths of the resource files to include</param>
+/// <param name="languages">Input: which languages to include</param>
+/// <param name="nWorkers">Input: number of worker threads for extraction; 0 for one per hardware thread</param>
+/// <param name="pCache">Input: the extraction cache to use, or nullptr for none</param>
+/// <param name="sCatalogFile">Input: path of the catalog file to create</param>
+/// <param name="err">The error stream to write diagnostic information into</param>
+/// <returns>true if successful, false otherwise.</returns>
+bool BuildMessageCatalog(
+    const std::vector<std::wstring>& vFiles,
+    const languageoptions_t& languages,
+    unsigned int nWorkers,
+    ExtractionCache* pCache,
+    const std::wstring& sCatalogFile,
+    std::wostream& err);
+
+/// <summary>
+/// Read-only access to a catalog file created by BuildMessageCatalog. Nothing is parsed or copied when the
+/// file is opened; each lookup hashes the key and compares one entry, however many tables the catalog has.
+/// </summary>
+class MessageCatalog
+{
+public:
+    MessageCatalog();
+
+    /// <summary>
+    /// Maps the catalog file and validates its layout.
+    /// </summary>
+    /// <param name="sFilePath">Input: path to the catalog file</param>
+    /// <param name="sErrorInfo">Output: diagnostic information on failure</param>
+    /// <returns>true if successful, false otherwise</returns>
+    bool Open(const std::wstring& sFilePath, std::wstring& sErrorInfo);
+
+    /// <summary>
+    /// Number of (module, resource type, language) tables in the catalog.
+    /// </summary>
+    size_t TableCount() const;
+
+    /// <summary>
+    /// Module (the path given when the catalog was built), resource type, and language of a table.
+    /// </summary>
+    std::wstring TableModule(size_t ixTable) const;
+    rsrctype_t TableType(size_t ixTable) const;
+    uint16_t TableLangId(size_t ixTable) const;
+
+    /// <summary>
+    /// Looks up the text for an ID in one table.
+    /// </summary>
+    /// <param name="ixTable">Input: index of the table</param>
+    /// <param name="id">Input: string ID or message ID</param>
+    /// <param name="pText">Output: UTF-8 text in the mapped file (not zero-terminated)</param>
+    /// <param name="cbText">Output: length of the text in bytes</param>
+    /// <returns>true if the table has text for the ID, false otherwise</returns>
+    bool Find(size_t ixTable, uint32_t id, const char*& pText, size_t& cbText) const;
+
+    /// <summary>
+    /// Finds the entries for an ID in every table, in table order.
+    /// </summary>
+    /// <param name="id">Input: string ID or message ID</param>
+    /// <param name="pSlots">Output: the entries' slots in the mapped file (see Entry)</param>
+    /// <returns>The number of entries</returns>
+    size_t FindId(uint32_t id, const uint32_t*& pSlots) const;
+
+    /// <summary>
+    /// Finds the tables of the modules with a file name or path (compared without regard to the case of ASCII
+    /// letters), in table order.
+    /// </summary>
+    /// <param name="sModule">Input: file name or path of the module</param>
+    /// <param name="pTables">Output: the tables' indexes in the mapped file</param>
+    /// <returns>The number of tables</returns>
+    size_t FindModule(const std::wstring& sModule, const uint32_t*& pTables) const;
+
+    /// <summary>
+    /// Gets the table and text of the entry in a slot.
+    /// </summary>
+    /// <param name="ixSlot">Input: slot of the entry, from FindId</param>
+    /// <param name="ixTable">Output: index of the entry's table</param>
+    /// <param name="pText">Output: UTF-8 text in the mapped file (not zero-terminated)</param>
+    /// <param name="cbText">Output: length of the text in bytes</param>
+    /// <returns>true if successful, false if the slot isn't valid</returns>
+    bool Entry(uint32_t ixSlot, size_t& ixTable, const char*& pText, size_t& cbText) const;
+
+private:
+    friend class CatalogBuilder;
+
+    struct header_t;
+    struct table_t;
+    struct entry_t;
+    struct idrange_t;
+    struct modulename_t;
+
+    const header_t& Header() const;
+    const table_t& Table(size_t ixTable) const;
+
+    MappedFile m_file;
+    const int32_t* m_pBuckets;
+    const entry_t* m_pEntries;
+    const int32_t* m_pIdBuckets;
+    const idrange_t* m_pIds;
+    const uint32_t* m_pIdSlots;
+    const int32_t* m_pModuleBuckets;
+    const modulename_t* m_pModuleNames;
+    const uint32_t* m_pModuleTables;
+    const char* m_pHeap;
+
+private:
+    // Not implemented
+    MessageCatalog(const MessageCatalog&) = delete;
+    MessageCatalog& operator = (const MessageCatalog&) = delete;
+};
+
+/// <summary>
+/// Looks up an ID in every table of a catalog and outputs the text found, as tab-delimited fields with headers:
+/// module, resource type, language, the ID in decimal and hex, and the text (with CR, LF, and TAB escaped).
+/// </summary>
+/// <param name="sCatalogFile">Input: path to the catalog file</param>
+/// <param name="id">Input: string ID or message ID</param>
+/// <param name="vModules">Input: file names or paths of modules to search; empty to search all</param>
+/// <param name="langId">Input: language to search; 0 to search all</param>
+/// <param name="streams">The output and error streams to write information into</param>
+/// <returns>true if any text was found, false otherwise.</returns>
+bool MessageCatalogLookup(
+    const std::wstring& sCatalogFile,
+    uint32_t id,
+    const std::vector<std::wstring>& vModules,
+    uint16_t langId,
+    streams_t& streams);
@@ -1,151 +1,243 @@
-#include <Windows.h>
-#include <codecvt>
+#include "PlatformDefs.h"
 #include <iostream>
-#include "SysErrorMessage.h"
 #include "UtilityFunctions.h"
+#include "CodePages.h"
+#include "ResourceCursor.h"
+#include "LanguageNames.h"
 #include "ResourceDefs.h"
 #include "HEX.h"
 #include "MessageTableExtraction.h"
+#include "ResourceExtraction.h"
 
 /// <summary>
-/// Indicates whether the second memory address is in the range beginning with the first memory address and
-/// with the resource size specified.
+/// Writes the tab-delimited headers for message table output.
 /// </summary>
-/// <param name="pvBaseAddress">Input: base address</param>
-/// <param name="dwResourceSize">Input: number of valid bytes following the base address</param>
-/// <param name="pMem">Input: address to check</param>
-/// <returns>true if pMem is between pvBaseAddress and pvBaseAddress+dwResourceSize; false otherwise</returns>
-static inline bool InAddressRange(const void* pvBaseAddress, DWORD dwResourceSize, const void* pMem)
+void WriteMessageTableHeaders(std::wostream& out)
 {
-    return (pMem >= pvBaseAddress && pMem < (byte*)pvBaseAddress + dwResourceSize);
+    out
+        << L"Msg ID\t"
+        << L"Msg ID (hex)\t"
+        << L"Localized text"
+        << L'\n';
 }
 
-
 /// <summary>
-/// Callback function to handle each message table resource in the current file.
+/// Walks the entries of a message table resource, calling entryFn(msgId, flags, pText, cbText) for each.
+/// With a checked cursor, this validates the resource: the block array, every entry, and every entry's text
+/// must lie within the resource. Each entry occupies at least its four-byte header, so the blocks together can't
+/// claim more than a quarter as many entries as the resource has bytes. A resource whose blocks do (e.g., blocks
+/// that all point at the same entries) is rejected at the first block past that total, before its entries are
+/// read, so that the walk is linear in the size of the resource however the blocks overlap.
 /// </summary>
-/// <param name="hModule">Handle to the resource DLL</param>
-/// <param name="lpType">Resource type</param>
-/// <param name="lpName">Resource name/identifier</param>
-/// <param name="lParam">Pointer to output stream</param>
-/// <returns>Always returns TRUE to continue enumeration</returns>
-static BOOL CALLBACK EnumMessageTableCallbackProc(
-    _In_opt_ HMODULE hModule,
-    _In_ LPCWSTR lpType,
-    _In_ LPWSTR lpName,
-    _In_ LONG_PTR lParam)
+template <typename Cursor, typename EntryFn>
+static bool WalkMessageTable(const ResourceEntry_t& entry, EntryFn entryFn, std::wstring& sErrorInfo)
 {
-    streams_t* pStreams = (streams_t*)lParam;
-    // Should enumerate only RT_MESSAGETABLE, but check again just to be safe
-    if (RT_MESSAGETABLE == lpType)
+    Cursor blocks(entry.pData, entry.cbData);
+    DWORD nBlocks = 0;
+    if (!blocks.Read(nBlocks))
     {
-        // Eliminate false positive about lpType possibly being 0
-#pragma warning(push)
-#pragma warning (disable: 6387)
-        HRSRC hRsrc = FindResourceW(hModule, lpName, lpType);
-#pragma warning(pop)
-        if (NULL != hRsrc)
+        sErrorInfo = L"Error: message table is truncated";
+        return false;
+    }
+    uint64_t nEntries = 0;
+    for (DWORD ixBlock = 0; ixBlock < nBlocks; ++ixBlock)
+    {
+        MESSAGE_RESOURCE_BLOCK block;
+        if (!blocks.Struct(block))
+        {
+            sErrorInfo = L"Error: message table blocks extend beyond the end of the resource";
+            return false;
+        }
+        if (block.HighId >= block.LowId)
+            nEntries += (uint64_t)block.HighId - block.LowId + 1;
+        if (nEntries > entry.cbData / (2 * sizeof(WORD)))
+        {
+            sErrorInfo = L"Error: message table blocks claim more entries than the resource can hold";
+            return false;
+        }
+        Cursor entries(entry.pData, entry.cbData);
+        entries.Seek(block.OffsetToEntries);
+        // 64-bit, so that a block ending at ID 0xFFFFFFFF ends
+        for (uint64_t msgId = block.LowId; msgId <= block.HighId; ++msgId)
         {
-            DWORD dwResourceSize = SizeofResource(hModule, hRsrc);
-            HGLOBAL hGbl = LoadResource(hModule, hRsrc);
-            if (NULL != hGbl)
+            // pEntry->Length is length of the entire structure, including two WORD values (Length and Flags).
+            WORD wLength = 0, wFlags = 0;
+            entries.Read(wLength);
+            entries.Read(wFlags);
+            const uint8_t* pText = (wLength >= 2 * sizeof(WORD)) ? entries.Bytes(wLength - 2 * sizeof(WORD)) : nullptr;
+            if (nullptr == pText)
             {
-                LPVOID pvData = LockResource(hGbl);
-                MESSAGE_RESOURCE_DATA* pData = (MESSAGE_RESOURCE_DATA*)pvData;
-                for (DWORD ixBlock = 0; ixBlock < pData->NumberOfBlocks; ++ixBlock)
-                {
-                    MESSAGE_RESOURCE_BLOCK& block = pData->Blocks[ixBlock];
-                    MESSAGE_RESOURCE_ENTRY* pEntry = (MESSAGE_RESOURCE_ENTRY*)((byte*)pData + block.OffsetToEntries);
-                    for (DWORD ixEntry = block.LowId; ixEntry <= block.HighId; ++ixEntry)
-                    {
-                        if (!InAddressRange(pvData, dwResourceSize, pEntry))
-                        {
-                            pStreams->WCerr << L"Error: address out of range" << std::endl;
-                            return FALSE;
-                        }
-
-                        pStreams->WCout 
-                            << ixEntry << L"\t" 
-                            << HEX(ixEntry, 8, true, true) << L"\t";
-                        if (pEntry->Flags & MESSAGE_RESOURCE_UNICODE)
-                        {
-                            // Message text is not guaranteed to be zero-terminated, but it might be.
-                            // Don't include any trailing null characters in the output string.
-                            const wchar_t* szText = (const wchar_t*)pEntry->Text;
-                            // Initial string length. pEntry->Length is length of the entire structure, including two WORD values (Length and Flags).
-                            // Subtract those out.
-                            size_t nChars = (pEntry->Length - 2 * (sizeof(WORD))) / sizeof(wchar_t);
-                            // Decrement while the last character is a null char
-                            while (nChars > 0 && 0 == szText[nChars - 1])
-                                nChars--;
-                            // Create a string with the specified number of characters.
-                            std::wstring str(szText, nChars);
-                            str = escapeCrLfTab(str);
-                            pStreams->WCout << str << std::endl;
-                        }
-                        else if (pEntry->Flags & MESSAGE_RESOURCE_UTF8)
-                        {
-                            pStreams->WCout << L"[[[UTF-8 text (not supported)]]]" << std::endl;
-                        }
-                        else if (0 == pEntry->Flags)
-                        {
-                            // ANSI text.
-                            // Message text is not guaranteed to be zero-terminated, but it might be.
-                            // Don't include any trailing null characters in the output string.
-                            const char* szText = (const char*)pEntry->Text;
-                            // Initial string length. pEntry->Length is length of the entire structure, including two WORD values (Length and Flags).
-                            // Subtract those out.
-                            size_t nChars = pEntry->Length - (2 * sizeof(WORD));
-                            // Decrement while the last character is a null char
-                            while (nChars > 0 && 0 == szText[nChars - 1])
-                                nChars--;
-                            // Create a string with the specified number of characters.
-                            std::string str(szText, nChars);
-                            // Replace CR, LF, and tab with escaped representations
-                            str = escapeCrLfTab(str);
-                            // Convert to wstring and output
-                            pStreams->WCout << std::wstring_convert< std::codecvt_utf8_utf16< wchar_t > >().from_bytes(str) << std::endl;
-                        }
-                        else
-                        {
-                            pStreams->WCout << L"[[[Unexpected flags value " << HEX(pEntry->Flags, 4, false, true) << L"]]]" << std::endl;
-                        }
-
-                        pEntry = (MESSAGE_RESOURCE_ENTRY*)((byte*)pEntry + pEntry->Length);
-                    }
-                }
+                sErrorInfo = L"Error: address out of range";
+                return false;
             }
+            entryFn((uint32_t)msgId, wFlags, pText, (size_t)(wLength - 2 * sizeof(WORD)));
         }
     }
+    return true;
+}
+
+/// <summary>
+/// Returns the text of a UTF-16 message table entry in place, or copied into a buffer if it's at an odd address
+/// (an entry's offset and length come from the resource, and can be odd).
+/// Message text is not guaranteed to be zero-terminated, but it might be.
+/// Don't include any trailing null characters.
+/// </summary>
+static inline utf16view_t Utf16MessageText(const uint8_t* pText, size_t cbText, std::vector<uint16_t>& vCopy)
+{
+    utf16view_t text;
+    text.nChars = cbText / sizeof(uint16_t);
+    if (0 == (uintptr_t)pText % alignof(uint16_t))
+    {
+        text.pChars = (const uint16_t*)pText;
+    }
     else
     {
-        // This should never happen.
-        pStreams->WCerr << L"UNEXPECTED RESOURCE TYPE: " << RSRCID_t(lpType) << L", ID " << RSRCID_t(lpName) << std::endl;
+        vCopy.resize(text.nChars + 1);
+        memcpy(vCopy.data(), pText, text.nChars * sizeof(uint16_t));
+        text.pChars = vCopy.data();
+    }
+    while (text.nChars > 0 && 0 == text.pChars[text.nChars - 1])
+        text.nChars--;
+    return text;
+}
+
+/// <summary>
+/// Decodes the text of a message table entry that isn't UTF-16: UTF-8, ANSI text in the code page of the
+/// resource's language, or a bracketed placeholder for unrecognized flags. Trailing null characters are dropped.
+/// bLossy is set if any ANSI character couldn't be decoded, and is otherwise left as it was.
+/// </summary>
+static std::wstring DecodeNonUtf16MessageText(WORD wFlags, const uint8_t* pText, size_t cbText, uint16_t codePage, bool& bLossy)
+{
+    const char* szText = (const char*)pText;
+    size_t nChars = cbText;
+    while (nChars > 0 && 0 == szText[nChars - 1])
+        nChars--;
+    if (wFlags & MESSAGE_RESOURCE_UTF8)
+        return WStringFromUtf8(szText, nChars);
+    if (0 == wFlags)
+    {
+        bool bLossyText = false;
+        std::wstring sText = WStringFromCodePage(szText, nChars, codePage, bLossyText);
+        bLossy = bLossy || bLossyText;
+        return sText;
+    }
+    std::wstringstream strUnexpected;
+    strUnexpected << L"[[[Unexpected flags value " << HEX(wFlags, 4, false, true) << L"]]]";
+    return strUnexpected.str();
+}
+
+/// <summary>
+/// Decodes the messages in one message table resource.
+/// </summary>
+bool DecodeMessageTableResource(const ResourceEntry_t& entry, const MessageCallback_t& callback, std::wstring& sErrorInfo)
+{
+    // Validate the whole resource first, then decode it without checks.
+    if (!WalkMessageTable<CheckedResourceCursor>(entry, [](uint32_t, WORD, const uint8_t*, size_t) {}, sErrorInfo))
+        return false;
+
+    const uint16_t codePage = AnsiCodePageFromLangId(entry.langId);
+    std::vector<uint16_t> vCopy;
+    // Undecodable ANSI characters are left as U+FFFD in the messages, without a warning.
+    bool bLossy = false;
+    return WalkMessageTable<UncheckedResourceCursor>(
+        entry,
+        [&](uint32_t msgId, WORD wFlags, const uint8_t* pText, size_t cbText)
+        {
+            if (wFlags & MESSAGE_RESOURCE_UNICODE)
+                callback(msgId, Utf16MessageText(pText, cbText, vCopy).str());
+            else
+                callback(msgId, DecodeNonUtf16MessageText(wFlags, pText, cbText, codePage, bLossy));
+        },
+        sErrorInfo);
+}
+
+/// <summary>
+/// Decodes the messages in one message table resource in the current file.
+/// UTF-16 entries are reported in place; others, and UTF-16 entries at odd addresses, are converted or copied to
+/// UTF-16 in a buffer reused for each entry.
+/// </summary>
+bool DecodeMessageTableText(const ResourceEntry_t& entry, ResourceVisitor& visitor, std::wostream& err)
+{
+    std::wstring sErrorInfo;
+    if (!WalkMessageTable<CheckedResourceCursor>(entry, [](uint32_t, WORD, const uint8_t*, size_t) {}, sErrorInfo))
+    {
+        err << sErrorInfo << std::endl;
+        return false;
     }
-    return TRUE;
+
+    const uint16_t codePage = AnsiCodePageFromLangId(entry.langId);
+    textview_t text;
+    std::vector<uint16_t> vConverted;
+    bool bLossy = false;
+    const bool bDecoded = WalkMessageTable<UncheckedResourceCursor>(
+        entry,
+        [&](uint32_t msgId, WORD wFlags, const uint8_t* pText, size_t cbText)
+        {
+            text.id = msgId;
+            if (wFlags & MESSAGE_RESOURCE_UNICODE)
+            {
+                text.text = Utf16MessageText(pText, cbText, vConverted);
+            }
+            else
+            {
+                WStringToUtf16(DecodeNonUtf16MessageText(wFlags, pText, cbText, codePage, bLossy), vConverted);
+                text.text.pChars = vConverted.data();
+                text.text.nChars = vConverted.size();
+            }
+            visitor.Visit(entry, text);
+        },
+        sErrorInfo);
+    if (bLossy)
+        err << L"Warning: message table " << entry.name << L" has text in code page " << codePage << L" that can't be decoded here; it is output as U+FFFD" << std::endl;
+    return bDecoded;
+}
+
+/// <summary>
+/// Writes a line of tab-delimited output for one message.
+/// </summary>
+void WriteMessageTableText(const ResourceEntry_t& entry, const textview_t& text, TextArena& arena, std::wostream& out)
+{
+    (void)entry;
+    // Replace CR, LF, and tab with escaped representations
+    out
+        << text.id << L"\t"
+        << HexText(arena, (uint32_t)text.id) << L"\t"
+        << EscapeCrLfTab(arena, ArenaText(arena, text.text), false)
+        << L'\n';
+}
+
+/// <summary>
+/// Handle one message table resource in the current file.
+/// </summary>
+/// <param name="entry">The message table resource</param>
+/// <param name="streams">The output and error streams to write information into</param>
+/// <returns>true to continue enumeration; false if the resource is malformed</returns>
+bool ProcessMessageTableResource(const ResourceEntry_t& entry, streams_t& streams)
+{
+    TextArena arena;
+    TextWriterVisitor writer(WriteMessageTableText, arena, streams.WCout);
+    return DecodeMessageTableText(entry, writer, streams.WCerr);
 }
 
 /// <summary>
 /// Outputs localized text in the module's message table resource as tab-delimited fields.
 /// Output includes the message ID in decimal and hex, and the localized text.
 /// </summary>
-/// <param name="hModule">Handle to the module to inspect</param>
+/// <param name="rsrcFile">The resource file to inspect</param>
 /// <param name="streams">The output and error streams to write information into</param>
+/// <param name="nThreads">Input: maximum number of threads to decode a large file on; 0 for one per hardware thread</param>
 /// <returns>true if successful, false otherwise.</returns>
-bool MessageTableExtraction(HMODULE hModule, streams_t& streams)
+bool MessageTableExtraction(const ResourceFile& rsrcFile, streams_t& streams, unsigned int nThreads)
 {
     // Tab-delimited headers
-    streams.WCout
-        << L"Msg ID\t"
-        << L"Msg ID (hex)\t"
-        << L"Localized text"
-        << std::endl;
+    WriteMessageTableHeaders(streams.WCout);
 
     // Enumerate the messagetable resources
-    if (!EnumResourceNamesW(hModule, RT_MESSAGETABLE, EnumMessageTableCallbackProc, (LPARAM)&streams))
+    // Large files are decoded on several threads.
+    std::wstring sErrorInfo;
+    if (!ExtractResourcesOfType(rsrcFile, rsrctype_t::eMessageTable, streams.WCout, streams.WCerr, nThreads, sErrorInfo))
     {
-        DWORD dwLastErr = GetLastError();
-        streams.WCerr << L"EnumResourceNamesW failed: " << SysErrorMessageWithCode(dwLastErr) << std::endl;
+        streams.WCerr << L"Cannot enumerate message table resources: " << sErrorInfo << std::endl;
         return false;
     }
     return true;
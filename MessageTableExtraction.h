@@ -1,12 +1,60 @@
 #pragma once
 
+#include <functional>
 #include "UtilityFunctions.h"
+#include "TextRecord.h"
 
 /// <summary>
 /// Outputs localized text in the module's message table resource as tab-delimited fields.
 /// Output includes the message ID in decimal and hex, and the localized text.
 /// </summary>
-/// <param name="hModule">Handle to the module to inspect</param>
+/// <param name="rsrcFile">The resource file to inspect</param>
 /// <param name="streams">The output and error streams to write information into</param>
+/// <param name="nThreads">Input: maximum number of threads to decode a large file on; 0 for one per hardware thread</param>
 /// <returns>true if successful, false otherwise.</returns>
-bool MessageTableExtraction(HMODULE hModule, streams_t& streams);
+bool MessageTableExtraction(const ResourceFile& rsrcFile, streams_t& streams, unsigned int nThreads);
+
+/// <summary>
+/// Writes the tab-delimited headers for message table output.
+/// </summary>
+/// <param name="out">The output stream to write the headers into</param>
+void WriteMessageTableHeaders(std::wostream& out);
+
+/// <summary>
+/// Outputs the localized text in one message table resource, without headers.
+/// </summary>
+/// <param name="entry">The resource</param>
+/// <param name="streams">The output and error streams to write information into</param>
+/// <returns>true to continue enumeration; false if the resource is malformed</returns>
+bool ProcessMessageTableResource(const ResourceEntry_t& entry, streams_t& streams);
+
+/// <summary>
+/// Decodes the text in one message table resource, without escaping or accelerator removal.
+/// This is the decoding behind ProcessMessageTableResource, for output other than tab-delimited text.
+/// </summary>
+/// <param name="entry">The resource</param>
+/// <param name="visitor">Input: visitor to report each message to</param>
+/// <param name="err">The error stream to write diagnostic information into</param>
+/// <returns>true to continue enumeration; false if the resource is malformed</returns>
+bool DecodeMessageTableText(const ResourceEntry_t& entry, ResourceVisitor& visitor, std::wostream& err);
+
+/// <summary>
+/// Writes the tab-delimited output for one message that DecodeMessageTableText reports.
+/// </summary>
+void WriteMessageTableText(const ResourceEntry_t& entry, const textview_t& text, TextArena& arena, std::wostream& out);
+
+/// <summary>
+/// Callback for message table decoding: message ID and text.
+/// </summary>
+typedef std::function<void(uint32_t msgId, const std::wstring& sText)> MessageCallback_t;
+
+/// <summary>
+/// Decodes the messages in one message table resource, in ascending ID order within each block, without escaping.
+/// UTF-16 and UTF-8 text is validated; ANSI text is decoded in the code page of the resource's language
+/// (see AnsiCodePageFromLangId). An entry with unrecognized flags is reported as a bracketed placeholder.
+/// </summary>
+/// <param name="entry">The resource</param>
+/// <param name="callback">Input: function to call with each message</param>
+/// <param name="sErrorInfo">Output: diagnostic information on failure</param>
+/// <returns>true if successful; false if the resource is malformed</returns>
+bool DecodeMessageTableResource(const ResourceEntry_t& entry, const MessageCallback_t& callback, std::wstring& sErrorInfo);
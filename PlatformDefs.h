@@ -0,0 +1,47 @@
+#pragma once
+
+// Platform definitions.
+// On Windows, this is just Windows.h.
+// Elsewhere (e.g., Linux), declares the small set of Windows types, macros, and functions that the
+// portable parts of this project use, so that resource files copied from Windows systems can be
+// inspected without the Windows loader.
+
+#ifdef _WIN32
+
+#include <Windows.h>
+
+#else
+
+#include <cstdint>
+#include <cerrno>
+#include <cwchar>
+
+typedef uint8_t     BYTE;
+typedef uint8_t     byte;
+typedef uint16_t    WORD;
+typedef uint32_t    DWORD;
+typedef int32_t     LONG;
+typedef int         BOOL;
+typedef int         INT;
+typedef unsigned int UINT;
+// Resource data is always UTF-16, regardless of the size of the platform's wchar_t.
+typedef char16_t    WCHAR;
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define UNREFERENCED_PARAMETER(P) (void)(P)
+
+#define _wcsnicmp wcsncasecmp
+#define _wcsicmp wcscasecmp
+
+/// <summary>
+/// Error codes on non-Windows platforms are errno values.
+/// </summary>
+inline DWORD GetLastError() { return static_cast<DWORD>(errno); }
+
+#endif
@@ -0,0 +1,646 @@
+#include "PlatformDefs.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#ifndef _WIN32
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+#include "ResolverServer.h"
+#include "FileEnumeration.h"
+#include "IndirectStringExtraction.h"
+#include "MessageTableExtraction.h"
+#include "StringTableExtraction.h"
+#include "SysErrorMessage.h"
+#include "Wow64FsRedirection.h"
+
+/// <summary>
+/// A .mui satellite file looked for when a file was mapped: its path, and its stamp, or that it wasn't there.
+/// </summary>
+struct satellitestamp_t
+{
+    std::wstring sPath;
+    bool bExists = false;
+    filestamp_t stamp;
+
+    explicit satellitestamp_t(const std::wstring& sSatellitePath) : sPath(sSatellitePath)
+    {
+        bExists = GetFileStamp(sPath, stamp);
+    }
+
+    bool operator == (const satellitestamp_t& other) const { return bExists == other.bExists && (!bExists || stamp == other.stamp); }
+    bool operator != (const satellitestamp_t& other) const { return !(*this == other); }
+};
+
+/// <summary>
+/// A mapped resource file and the text decoded from it so far. The entry goes into the cache before the file is
+/// mapped, so that requests for other files don't wait for it; requests for this file wait for it to be mapped once.
+/// </summary>
+struct cachedfile_t
+{
+    std::wstring sPath;
+    filestamp_t stamp;
+    // Mapped by the first request for the file, with the satellite files it was mapped with, and those it looked
+    // for and didn't open (not there, or not PE files), whose text would have been preferred
+    std::once_flag opened;
+    bool bOpened = false;
+    std::wstring sOpenErrorInfo;
+    ResourceFile rsrcFile;
+    std::vector<satellitestamp_t> vSatellites;
+    // Decoded string bundles by resource ID; an empty bundle if the file doesn't have it
+    std::mutex mtxBundles;
+    std::map<uint16_t, std::vector<std::wstring>> bundles;
+    // All of the file's messages, decoded by the first message request
+    std::once_flag messagesDecoded;
+    std::map<uint32_t, std::wstring> messages;
+};
+
+/// <summary>
+/// Request latencies in power-of-two buckets: up to 1 microsecond, up to 2, up to 4, ..., and more than the last.
+/// </summary>
+struct latencyhistogram_t
+{
+    static const size_t nBuckets = 18;
+    uint64_t nRequests = 0;
+    uint64_t counts[nBuckets] = {};
+
+    void Add(uint64_t microseconds)
+    {
+        size_t ixBucket = 0;
+        while (ixBucket < nBuckets - 1 && microseconds > (1ull << ixBucket))
+            ++ixBucket;
+        ++counts[ixBucket];
+        ++nRequests;
+    }
+};
+
+/// <summary>
+/// Answers lookup requests from a least-recently-used cache of mapped resource files. Thread-safe: the service's
+/// lock is held only to find, add, or remove a cache entry (and for the counters); a file is mapped and decoded
+/// outside it, so that a cold file doesn't hold up requests for the others.
+/// </summary>
+class ResolverService
+{
+public:
+    ResolverService(const std::vector<std::wstring>& vLanguages, const std::wstring& sImageRoot, size_t nCacheFiles)
+        : m_vLanguages(vLanguages), m_sImageRoot(sImageRoot), m_nCacheFiles(nCacheFiles > 0 ? nCacheFiles : 1)
+    {}
+
+    /// <summary>
+    /// Handles one request line and returns the response line (without a line ending).
+    /// </summary>
+    std::wstring HandleRequest(const std::wstring& sRequest);
+
+private:
+    enum requestkind_t { eIndirect, eString, eMessage, eNumRequestKinds };
+
+    bool ResolveIndirect(const std::wstring& sReference, std::wstring& sText, std::wstring& sErrorInfo);
+    bool LookupString(const std::wstring& sPath, uint16_t stringId, std::wstring& sText, std::wstring& sErrorInfo);
+    bool LookupMessage(const std::wstring& sPath, uint32_t msgId, std::wstring& sText, std::wstring& sErrorInfo);
+    std::shared_ptr<cachedfile_t> Acquire(const std::wstring& sPath, std::wstring& sErrorInfo);
+    std::shared_ptr<cachedfile_t> FindOrAdd(const std::wstring& sPath, const filestamp_t& stamp, const cachedfile_t* pChanged);
+    void Open(cachedfile_t& file);
+    void Remove(const std::shared_ptr<cachedfile_t>& pFile);
+    std::wstring Stats() const;
+
+    const std::vector<std::wstring> m_vLanguages;
+    const std::wstring m_sImageRoot;
+    const size_t m_nCacheFiles;
+
+    // Guards the cache's list and index, the located file paths, and the counters
+    std::mutex m_mtx;
+    // Most recently used first, and an index into the list by path
+    std::list<std::shared_ptr<cachedfile_t>> m_lru;
+    std::unordered_map<std::wstring, std::list<std::shared_ptr<cachedfile_t>>::iterator> m_index;
+    // File paths located for file names in indirect strings
+    std::unordered_map<std::wstring, std::wstring> m_located;
+
+    uint64_t m_nFileHits = 0, m_nFileMisses = 0, m_nFileReloads = 0, m_nFileEvictions = 0;
+    uint64_t m_nBundleHits = 0, m_nBundleMisses = 0;
+    uint64_t m_nMessageTableHits = 0, m_nMessageTableMisses = 0;
+    uint64_t m_nBadRequests = 0;
+    latencyhistogram_t m_latency[eNumRequestKinds];
+};
+
+/// <summary>
+/// Under the lock: returns the cached entry for the file and marks it most recently used, or if it isn't cached or
+/// has changed since it was cached (or is pChanged, whose satellite files have changed), adds a new entry, not yet
+/// mapped. Evicts the least recently used file if the cache is full; requests still using it keep it until they're
+/// done.
+/// </summary>
+std::shared_ptr<cachedfile_t> ResolverService::FindOrAdd(const std::wstring& sPath, const filestamp_t& stamp, const cachedfile_t* pChanged)
+{
+    std::lock_guard<std::mutex> lock(m_mtx);
+    auto iterIndex = m_index.find(sPath);
+    if (m_index.end() != iterIndex)
+    {
+        if ((*iterIndex->second)->stamp == stamp && iterIndex->second->get() != pChanged)
+        {
+            ++m_nFileHits;
+            m_lru.splice(m_lru.begin(), m_lru, iterIndex->second);
+            return m_lru.front();
+        }
+        // Changed since it was cached: discard it, including everything decoded from it.
+        ++m_nFileReloads;
+        m_lru.erase(iterIndex->second);
+        m_index.erase(iterIndex);
+    }
+    else
+    {
+        ++m_nFileMisses;
+    }
+
+    std::shared_ptr<cachedfile_t> pFile = std::make_shared<cachedfile_t>();
+    pFile->sPath = sPath;
+    pFile->stamp = stamp;
+    while (m_lru.size() >= m_nCacheFiles)
+    {
+        ++m_nFileEvictions;
+        m_index.erase(m_lru.back()->sPath);
+        m_lru.pop_back();
+    }
+    m_lru.push_front(pFile);
+    m_index[sPath] = m_lru.begin();
+    return pFile;
+}
+
+/// <summary>
+/// Under the lock: removes the entry from the cache, if it's still there.
+/// </summary>
+void ResolverService::Remove(const std::shared_ptr<cachedfile_t>& pFile)
+{
+    std::lock_guard<std::mutex> lock(m_mtx);
+    auto iterIndex = m_index.find(pFile->sPath);
+    if (m_index.end() != iterIndex && *iterIndex->second == pFile)
+    {
+        m_lru.erase(iterIndex->second);
+        m_index.erase(iterIndex);
+    }
+}
+
+/// <summary>
+/// Maps a cache entry's file, and records the stamps of the satellite files it looked for.
+/// </summary>
+void ResolverService::Open(cachedfile_t& file)
+{
+    Wow64FsRedirection fsRedir(true);
+    file.bOpened = file.rsrcFile.Open(file.sPath, m_vLanguages, file.sOpenErrorInfo);
+    if (file.bOpened)
+    {
+        bool bSatellite = false;
+        file.rsrcFile.ForEachMappedFile([&](const std::wstring& sMappedPath, const uint8_t*, size_t)
+            {
+                if (bSatellite)
+                    file.vSatellites.push_back(satellitestamp_t(sMappedPath));
+                bSatellite = true;
+            });
+        for (const std::wstring& sNotOpenedPath : file.rsrcFile.MuiFilesNotOpened())
+            file.vSatellites.push_back(satellitestamp_t(sNotOpenedPath));
+    }
+    fsRedir.Revert();
+}
+
+/// <summary>
+/// Returns true if none of the satellite files that a cached file looked for when it was mapped has changed, been
+/// removed, or appeared since.
+/// </summary>
+static bool SatellitesUnchanged(const cachedfile_t& file)
+{
+    for (const satellitestamp_t& satellite : file.vSatellites)
+    {
+        if (satellitestamp_t(satellite.sPath) != satellite)
+            return false;
+    }
+    return true;
+}
+
+/// <summary>
+/// Returns the cached file, mapping it if it isn't cached or it or its satellite files have changed since it was
+/// cached (see FindOrAdd). The file is mapped outside the lock, by the first request for it; other requests for it
+/// wait for that one. A file that can't be mapped isn't kept in the cache.
+/// </summary>
+std::shared_ptr<cachedfile_t> ResolverService::Acquire(const std::wstring& sPath, std::wstring& sErrorInfo)
+{
+    filestamp_t stamp;
+    if (!GetFileStamp(sPath, stamp))
+    {
+        sErrorInfo = L"Cannot load resource file " + sPath + L": " + SysErrorMessageWithCode();
+        return nullptr;
+    }
+
+    std::shared_ptr<cachedfile_t> pFile = FindOrAdd(sPath, stamp, nullptr);
+    const auto open = [this, &pFile]()
+    {
+        Open(*pFile);
+        if (!pFile->bOpened)
+            Remove(pFile);
+    };
+    std::call_once(pFile->opened, open);
+    // The text comes from a satellite file, if there is one: if one has changed, or a preferred one has appeared,
+    // map the file again.
+    if (pFile->bOpened && !SatellitesUnchanged(*pFile))
+    {
+        pFile = FindOrAdd(sPath, stamp, pFile.get());
+        std::call_once(pFile->opened, open);
+    }
+    if (!pFile->bOpened)
+    {
+        sErrorInfo = L"Cannot load resource file " + sPath + L": " + pFile->sOpenErrorInfo;
+        return nullptr;
+    }
+    return pFile;
+}
+
+bool ResolverService::LookupString(const std::wstring& sPath, uint16_t stringId, std::wstring& sText, std::wstring& sErrorInfo)
+{
+    std::shared_ptr<cachedfile_t> pFile = Acquire(sPath, sErrorInfo);
+    if (!pFile)
+        return false;
+
+    // Bundles are decoded under the file's lock, so only requests for this file wait.
+    const uint16_t bundleId = (uint16_t)((stringId >> 4) + 1);
+    std::unique_lock<std::mutex> fileLock(pFile->mtxBundles);
+    auto iterBundle = pFile->bundles.find(bundleId);
+    const bool bHit = (pFile->bundles.end() != iterBundle);
+    if (!bHit)
+    {
+        std::vector<std::wstring> vStrings;
+        ResourceEntry_t entry;
+        if (pFile->rsrcFile.Find(rsrctype_t::eString, bundleId, entry))
+            DecodeStringBundle(entry, vStrings);
+        iterBundle = pFile->bundles.insert(std::make_pair(bundleId, std::move(vStrings))).first;
+    }
+
+    const size_t ixString = stringId & 0x0F;
+    const bool bFound = (ixString < iterBundle->second.size() && !iterBundle->second[ixString].empty());
+    if (bFound)
+        sText = iterBundle->second[ixString];
+    fileLock.unlock();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        ++(bHit ? m_nBundleHits : m_nBundleMisses);
+    }
+    if (!bFound)
+        sErrorInfo = L"String ID " + std::to_wstring(stringId) + L" not found in " + sPath;
+    return bFound;
+}
+
+bool ResolverService::LookupMessage(const std::wstring& sPath, uint32_t msgId, std::wstring& sText, std::wstring& sErrorInfo)
+{
+    std::shared_ptr<cachedfile_t> pFile = Acquire(sPath, sErrorInfo);
+    if (!pFile)
+        return false;
+
+    // The first message request for the file decodes all of its messages; others for the file wait for it, and
+    // then only read them.
+    bool bDecoded = false;
+    std::call_once(pFile->messagesDecoded, [&]()
+        {
+            bDecoded = true;
+            if (!pFile->rsrcFile.HasResourceType(rsrctype_t::eMessageTable))
+                return;
+            cachedfile_t* pDecodedFile = pFile.get();
+            std::wstring sEnumErrorInfo;
+            pFile->rsrcFile.EnumResources(
+                rsrctype_t::eMessageTable,
+                [pDecodedFile](const ResourceEntry_t& entry)
+                {
+                    std::wstring sDecodeErrorInfo;
+                    // If an ID appears more than once, the first one is the one FormatMessage finds.
+                    DecodeMessageTableResource(entry, [pDecodedFile](uint32_t id, const std::wstring& sMessage) { pDecodedFile->messages.insert(std::make_pair(id, sMessage)); }, sDecodeErrorInfo);
+                    return true;
+                },
+                sEnumErrorInfo);
+        });
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        ++(bDecoded ? m_nMessageTableMisses : m_nMessageTableHits);
+    }
+
+    auto iterMessage = pFile->messages.find(msgId);
+    if (pFile->messages.end() == iterMessage)
+    {
+        sErrorInfo = L"Message ID " + std::to_wstring(msgId) + L" not found in " + sPath;
+        return false;
+    }
+    sText = iterMessage->second;
+    return true;
+}
+
+bool ResolverService::ResolveIndirect(const std::wstring& sReference, std::wstring& sText, std::wstring& sErrorInfo)
+{
+    if (sReference.empty() || L'@' != sReference[0])
+    {
+        sText = sReference;
+        return true;
+    }
+
+    std::wstring sModule;
+    uint16_t stringId;
+    if (!ParseIndirectString(sReference, sModule, stringId, sErrorInfo))
+        return false;
+
+    // Locating a module can search the file system, so it's done outside the lock.
+    std::wstring sPath;
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        auto iterLocated = m_located.find(sModule);
+        if (m_located.end() != iterLocated)
+            sPath = iterLocated->second;
+    }
+    if (sPath.empty())
+    {
+        sPath = LocateIndirectStringModule(sModule, m_sImageRoot);
+        std::lock_guard<std::mutex> lock(m_mtx);
+        // Keep the table from growing without limit with a long-running server.
+        if (m_located.size() >= 4096)
+            m_located.clear();
+        m_located[sModule] = sPath;
+    }
+    return LookupString(sPath, stringId, sText, sErrorInfo);
+}
+
+/// <summary>
+/// Cache counters and per-request-type latency histograms as tab-separated name=value fields. Called under the lock.
+/// </summary>
+std::wstring ResolverService::Stats() const
+{
+    static const wchar_t* const szKindNames[eNumRequestKinds] = { L"indirect", L"string", L"message" };
+
+    std::wostringstream stats;
+    stats
+        << L"files_cached=" << m_lru.size()
+        << L"\tfile_hits=" << m_nFileHits
+        << L"\tfile_misses=" << m_nFileMisses
+        << L"\tfile_reloads=" << m_nFileReloads
+        << L"\tfile_evictions=" << m_nFileEvictions
+        << L"\tbundle_hits=" << m_nBundleHits
+        << L"\tbundle_misses=" << m_nBundleMisses
+        << L"\tmsgtable_hits=" << m_nMessageTableHits
+        << L"\tmsgtable_misses=" << m_nMessageTableMisses
+        << L"\tbad_requests=" << m_nBadRequests;
+    for (size_t ixKind = 0; ixKind < eNumRequestKinds; ++ixKind)
+    {
+        const latencyhistogram_t& histogram = m_latency[ixKind];
+        stats << L"\t" << szKindNames[ixKind] << L"_requests=" << histogram.nRequests;
+        // Bucket upper bounds in microseconds, and count
+        stats << L"\t" << szKindNames[ixKind] << L"_latency_us=";
+        for (size_t ixBucket = 0; ixBucket < latencyhistogram_t::nBuckets; ++ixBucket)
+        {
+            if (ixBucket > 0)
+                stats << L",";
+            if (ixBucket < latencyhistogram_t::nBuckets - 1)
+                stats << (1ull << ixBucket);
+            else
+                stats << L"inf";
+            stats << L":" << histogram.counts[ixBucket];
+        }
+    }
+    return stats.str();
+}
+
+std::wstring ResolverService::HandleRequest(const std::wstring& sRequest)
+{
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::wstring> vFields;
+    SplitStringToVector(sRequest, L'\t', vFields);
+
+    if (1 == vFields.size() && L"stats" == vFields[0])
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        return L"ok\t" + Stats();
+    }
+
+    requestkind_t kind = eNumRequestKinds;
+    std::wstring sText, sErrorInfo;
+    bool bFound = false;
+    uint32_t id = 0;
+    if (2 == vFields.size() && L"indirect" == vFields[0])
+    {
+        kind = eIndirect;
+        bFound = ResolveIndirect(vFields[1], sText, sErrorInfo);
+    }
+    else if (3 == vFields.size() && L"string" == vFields[0])
+    {
+        kind = eString;
+        if (!ParseId(vFields[2], 0xFFFF, id))
+            sErrorInfo = L"Invalid string ID: " + vFields[2];
+        else
+            bFound = LookupString(vFields[1], (uint16_t)id, sText, sErrorInfo);
+    }
+    else if (3 == vFields.size() && L"message" == vFields[0])
+    {
+        kind = eMessage;
+        if (!ParseId(vFields[2], 0xFFFFFFFF, id))
+            sErrorInfo = L"Invalid message ID: " + vFields[2];
+        else
+            bFound = LookupMessage(vFields[1], id, sText, sErrorInfo);
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        ++m_nBadRequests;
+        return L"error\tUnrecognized request";
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        m_latency[kind].Add((uint64_t)elapsed.count());
+    }
+    if (!bFound)
+        return L"error\t" + escapeCrLfTabNul(sErrorInfo);
+    return L"ok\t" + escapeCrLfTabNul(sText);
+}
+
+#ifndef _WIN32
+/// <summary>
+/// Writes all of the data to the socket.
+/// </summary>
+static bool SendAll(int fd, const std::string& sData)
+{
+    size_t ixSent = 0;
+    while (ixSent < sData.length())
+    {
+        ssize_t cbSent = send(fd, sData.data() + ixSent, sData.length() - ixSent, MSG_NOSIGNAL);
+        if (cbSent < 0 && EINTR == errno)
+            continue;
+        if (cbSent <= 0)
+            return false;
+        ixSent += (size_t)cbSent;
+    }
+    return true;
+}
+
+/// <summary>
+/// Number of connection threads running, so that the server stops accepting connections at a limit instead of
+/// starting threads until it runs out.
+/// </summary>
+struct connectionlimit_t
+{
+    static const size_t nMaxConnections = 256;
+    std::mutex mtx;
+    std::condition_variable cvReleased;
+    size_t nConnections = 0;
+
+    // Waits until there's room for another connection, and counts it
+    void Acquire()
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        cvReleased.wait(lock, [this] { return nConnections < nMaxConnections; });
+        ++nConnections;
+    }
+
+    void Release()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            --nConnections;
+        }
+        cvReleased.notify_one();
+    }
+};
+
+/// <summary>
+/// Returns true if accept failed for lack of a resource that may be freed when other connections close.
+/// </summary>
+static bool IsTransientAcceptError(int error)
+{
+    return EMFILE == error || ENFILE == error || ENOBUFS == error || ENOMEM == error;
+}
+
+/// <summary>
+/// Answers requests on one connection until the client disconnects.
+/// </summary>
+static void ServeConnection(int fd, std::shared_ptr<ResolverService> pService)
+{
+    // Longest request line accepted, to protect the server from a client that never sends a line ending
+    const size_t cbMaxRequest = 65536;
+    std::string sPending;
+    char buffer[4096];
+    for (;;)
+    {
+        ssize_t cbReceived = recv(fd, buffer, sizeof(buffer), 0);
+        if (cbReceived < 0 && EINTR == errno)
+            continue;
+        if (cbReceived <= 0)
+            break;
+        sPending.append(buffer, (size_t)cbReceived);
+
+        // Answer all the complete lines received so far with a single send.
+        std::string sResponses;
+        size_t ixLineStart = 0, ixLineEnd;
+        while (std::string::npos != (ixLineEnd = sPending.find('\n', ixLineStart)))
+        {
+            std::string sLine = sPending.substr(ixLineStart, ixLineEnd - ixLineStart);
+            if (!sLine.empty() && '\r' == sLine.back())
+                sLine.pop_back();
+            sResponses += WStringToUtf8(pService->HandleRequest(Utf8ToWString(sLine))) + '\n';
+            ixLineStart = ixLineEnd + 1;
+        }
+        sPending.erase(0, ixLineStart);
+        if (!sResponses.empty() && !SendAll(fd, sResponses))
+            break;
+        if (sPending.length() > cbMaxRequest)
+        {
+            SendAll(fd, "error\tRequest too long\n");
+            break;
+        }
+    }
+    close(fd);
+}
+#endif
+
+bool ResolverServer(
+    const std::wstring& sSocketPath,
+    const std::vector<std::wstring>& vLanguages,
+    const std::wstring& sImageRoot,
+    size_t nCacheFiles,
+    std::wostream& err)
+{
+#ifdef _WIN32
+    UNREFERENCED_PARAMETER(sSocketPath);
+    UNREFERENCED_PARAMETER(vLanguages);
+    UNREFERENCED_PARAMETER(sImageRoot);
+    UNREFERENCED_PARAMETER(nCacheFiles);
+    err << L"Server mode is not supported on Windows." << std::endl;
+    return false;
+#else
+    const std::string sSocketPathUtf8 = WStringToUtf8(sSocketPath);
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (sSocketPathUtf8.length() >= sizeof(addr.sun_path))
+    {
+        err << L"Socket path is too long: " << sSocketPath << std::endl;
+        return false;
+    }
+    strncpy(addr.sun_path, sSocketPathUtf8.c_str(), sizeof(addr.sun_path) - 1);
+
+    // Replace a socket left behind by a previous server, but nothing else.
+    struct stat st;
+    if (0 == lstat(sSocketPathUtf8.c_str(), &st) && S_ISSOCK(st.st_mode))
+        unlink(sSocketPathUtf8.c_str());
+
+    int fdListen = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fdListen < 0)
+    {
+        err << L"Cannot create socket: " << SysErrorMessageWithCode() << std::endl;
+        return false;
+    }
+    if (0 != bind(fdListen, (const struct sockaddr*)&addr, sizeof(addr)) || 0 != listen(fdListen, SOMAXCONN))
+    {
+        err << L"Cannot listen on " << sSocketPath << L": " << SysErrorMessageWithCode() << std::endl;
+        close(fdListen);
+        return false;
+    }
+    err << L"Listening on " << sSocketPath << std::endl;
+
+    // One thread per connection; the service's lock is held only around its cache, so requests run concurrently.
+    // Connection threads share ownership of the service, so it outlives any that are still running if the server stops.
+    // At most connectionlimit_t::nMaxConnections connections are served at once; further clients wait in the
+    // listen backlog until a connection closes.
+    std::shared_ptr<ResolverService> pService = std::make_shared<ResolverService>(vLanguages, sImageRoot, nCacheFiles);
+    std::shared_ptr<connectionlimit_t> pLimit = std::make_shared<connectionlimit_t>();
+    for (;;)
+    {
+        pLimit->Acquire();
+        int fd = accept(fdListen, nullptr, nullptr);
+        if (fd < 0)
+        {
+            const int error = errno;
+            pLimit->Release();
+            if (EINTR == error || ECONNABORTED == error)
+                continue;
+            if (IsTransientAcceptError(error))
+            {
+                // Out of descriptors or memory: back off and let open connections finish, rather than stopping.
+                err << L"Cannot accept connection, retrying: " << SysErrorMessageWithCode(error) << std::endl;
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                continue;
+            }
+            err << L"Cannot accept connection: " << SysErrorMessageWithCode(error) << std::endl;
+            break;
+        }
+        std::thread([fd, pService, pLimit]() {
+            ServeConnection(fd, pService);
+            pLimit->Release();
+        }).detach();
+    }
+    close(fdListen);
+    unlink(sSocketPathUtf8.c_str());
+    return false;
+#endif
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Runs a resident lookup server that listens on a Unix domain socket, so that interactive tools don't pay for
+/// process startup and file mapping on every lookup. Mapped resource files are kept in a least-recently-used cache,
+/// along with the string bundles and message tables decoded from them; a cached file is reloaded if its last-write
+/// time or size changes, or that of the .mui satellite file it was mapped with, or if a satellite file for a more
+/// preferred language that wasn't there appears.
+///
+/// Requests and responses are UTF-8 lines, with tab-separated fields:
+///   indirect  TAB indirectString         : resolves an indirect string (see ResolveIndirectString)
+///   string    TAB filepath TAB stringID   : gets a string table string
+///   message   TAB filepath TAB messageID  : gets a message table message (ID in decimal, or hex with 0x)
+///   stats                                 : gets cache hit/miss counters and latency histograms
+/// Each request gets a one-line response: "ok" TAB the text (with CR, LF, TAB, and NUL escaped as \r, \n, \t, and \0),
+/// or "error" TAB diagnostic information. A connection can send any number of requests.
+///
+/// Serves up to 256 connections at once; others wait until one closes. Retries accepting a connection when out of
+/// file descriptors or memory, and otherwise runs until the listening socket fails. Not supported on Windows.
+/// </summary>
+/// <param name="sSocketPath">Input: path of the socket to create. An existing socket at that path is replaced.</param>
+/// <param name="vLanguages">Input: preferred languages by name, most preferred first</param>
+/// <param name="sImageRoot">Input: root directory of an offline Windows image for indirect strings; empty for the running system</param>
+/// <param name="nCacheFiles">Input: maximum number of resource files to keep mapped</param>
+/// <param name="err">The error stream to write diagnostic information into</param>
+/// <returns>false if the server can't start or stops because of an error</returns>
+bool ResolverServer(
+    const std::wstring& sSocketPath,
+    const std::vector<std::wstring>& vLanguages,
+    const std::wstring& sImageRoot,
+    size_t nCacheFiles,
+    std::wostream& err);
@@ -0,0 +1,278 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "StringUtils.h"
+
+/// <summary>
+/// UTF-16 text in resource data, referred to in place: not copied and not necessarily zero-terminated.
+/// </summary>
+struct utf16view_t
+{
+    const uint16_t* pChars = nullptr;
+    size_t nChars = 0;
+
+    bool empty() const { return 0 == nChars; }
+    std::wstring str() const { return WStringFromUtf16(pChars, nChars); }
+};
+
+/// <summary>
+/// An "sz_Or_Ord" value (see ResourceDefs.h): an ordinal, or a zero-terminated string that can be empty.
+/// </summary>
+struct szorord_t
+{
+    bool bOrdinal = false;
+    uint16_t ordinal = 0;
+    utf16view_t sz;
+};
+
+/// <summary>
+/// Forward-only reader over a span of resource data (pointer and size), for the variable-length structures of
+/// dialog, menu, and message table resources. Structures are copied out; strings are returned in place, without
+/// copying, unless they're at an odd address (see ReadSz).
+///
+/// ResourceCursor&lt;true&gt; (CheckedResourceCursor) is for untrusted input, such as resources in files copied from
+/// arbitrary machines: every read is checked against the end of the span. A read that doesn't fit fails and
+/// puts the cursor in a failed state in which all further reads fail, so a parser can check Failed() once after
+/// a sequence of reads. A string must be terminated within the span.
+///
+/// ResourceCursor&lt;false&gt; (UncheckedResourceCursor) is for data already walked with a checked cursor. It makes the
+/// same reads without checks; Failed() is always false. Message tables are validated with a checked walk and then
+/// decoded with an unchecked one; dialogs and menus are decoded in a single checked pass (see DecodeDialogText).
+///
+/// Offsets and alignment are relative to the start of the span.
+/// </summary>
+template <bool bChecked>
+class ResourceCursor
+{
+public:
+    ResourceCursor(const void* pData, size_t cbData) :
+        m_pData((const uint8_t*)pData),
+        m_cbData(cbData),
+        m_ofs(0),
+        m_bFailed(false)
+    {
+    }
+
+    /// <summary>
+    /// True if a read didn't fit in the span (checked cursor only).
+    /// </summary>
+    bool Failed() const { return m_bFailed; }
+
+    /// <summary>
+    /// Offset of the next read from the start of the span, and the number of bytes after it.
+    /// </summary>
+    size_t Offset() const { return m_ofs; }
+    size_t Remaining() const { return m_cbData - m_ofs; }
+
+    /// <summary>
+    /// Moves to an offset from the start of the span.
+    /// </summary>
+    bool Seek(size_t ofs)
+    {
+        if (bChecked && (m_bFailed || ofs > m_cbData))
+            return Fail();
+        m_ofs = ofs;
+        return true;
+    }
+
+    /// <summary>
+    /// Skips a number of bytes.
+    /// </summary>
+    bool Skip(size_t cb)
+    {
+        if (!Fits(cb))
+            return Fail();
+        m_ofs += cb;
+        return true;
+    }
+
+    /// <summary>
+    /// Skips to the next multiple of the alignment (a power of 2), e.g., 4 for DWORD alignment.
+    /// </summary>
+    bool AlignTo(size_t alignment)
+    {
+        return Skip(((m_ofs + alignment - 1) & ~(alignment - 1)) - m_ofs);
+    }
+
+    /// <summary>
+    /// Copies a fixed-size structure and moves past it. The structure is all zeros if it doesn't fit.
+    /// For a structure declared with a trailing placeholder array (see ResourceDefs.h), pass the size of the part
+    /// before the placeholder, e.g., offsetof(DLGITEMTEMPLATEEX_1, windowClass); the rest of the copy is zeros.
+    /// The structure is copied rather than returned in place because resource data can be at any address, and
+    /// reading a structure at an address that isn't aligned for it is undefined behavior.
+    /// </summary>
+    template <typename T>
+    bool Struct(T& value, size_t cbStruct = sizeof(T))
+    {
+        value = T();
+        const uint8_t* pStruct = Bytes(cbStruct);
+        if (nullptr == pStruct)
+            return false;
+        memcpy(&value, pStruct, cbStruct);
+        return true;
+    }
+
+    /// <summary>
+    /// Returns a number of bytes in place and moves past them, or nullptr if they don't fit.
+    /// </summary>
+    const uint8_t* Bytes(size_t cb)
+    {
+        if (!Fits(cb))
+        {
+            Fail();
+            return nullptr;
+        }
+        const uint8_t* pBytes = m_pData + m_ofs;
+        m_ofs += cb;
+        return pBytes;
+    }
+
+    /// <summary>
+    /// Reads a value (e.g., a WORD or DWORD) and moves past it. The value is 0 if it doesn't fit.
+    /// </summary>
+    template <typename T>
+    bool Read(T& value)
+    {
+        const uint8_t* pValue = Bytes(sizeof(T));
+        if (nullptr == pValue)
+        {
+            value = T();
+            return false;
+        }
+        memcpy(&value, pValue, sizeof(T));
+        return true;
+    }
+
+    /// <summary>
+    /// Reads a zero-terminated UTF-16 string, not including the terminator, and moves past the terminator.
+    /// A string at an odd address is copied into storage owned by the cursor, valid for the cursor's lifetime,
+    /// since its code units can't be read in place as uint16_t.
+    /// </summary>
+    bool ReadSz(utf16view_t& sz)
+    {
+        sz = utf16view_t();
+        if (bChecked && m_bFailed)
+            return false;
+        const uint8_t* pChars = m_pData + m_ofs;
+        const size_t nMaxChars = bChecked ? Remaining() / sizeof(uint16_t) : SIZE_MAX;
+        size_t nChars = 0;
+        if (IsUtf16Aligned(pChars))
+        {
+            const uint16_t* pAligned = (const uint16_t*)pChars;
+            while (nChars < nMaxChars && 0 != pAligned[nChars])
+                ++nChars;
+        }
+        else
+        {
+            while (nChars < nMaxChars && (0 != pChars[2 * nChars] || 0 != pChars[2 * nChars + 1]))
+                ++nChars;
+        }
+        if (nChars >= nMaxChars)
+            return Fail();
+        sz = Utf16InPlaceOrCopy(pChars, nChars);
+        m_ofs += (nChars + 1) * sizeof(uint16_t);
+        return true;
+    }
+
+    /// <summary>
+    /// Reads a number of UTF-16 code units and moves past them: in place, or a copy if they're at an odd address
+    /// (see ReadSz).
+    /// </summary>
+    bool ReadChars(size_t nChars, utf16view_t& chars)
+    {
+        chars = utf16view_t();
+        if (bChecked && nChars > SIZE_MAX / sizeof(uint16_t))
+            return Fail();
+        const uint8_t* pChars = Bytes(nChars * sizeof(uint16_t));
+        if (nullptr == pChars)
+            return false;
+        chars = Utf16InPlaceOrCopy(pChars, nChars);
+        return true;
+    }
+
+    /// <summary>
+    /// Reads an sz_Or_Ord: 0x0000 for an empty string, 0xFFFF followed by an ordinal, or a zero-terminated string.
+    /// </summary>
+    bool ReadSzOrOrd(szorord_t& value)
+    {
+        value = szorord_t();
+        uint16_t first = 0;
+        if (!Peek(first))
+            return false;
+        switch (first)
+        {
+        case 0x0000:
+            return Skip(sizeof(uint16_t));
+        case 0xFFFF:
+            value.bOrdinal = true;
+            return Skip(sizeof(uint16_t)) && Read(value.ordinal);
+        default:
+            return ReadSz(value.sz);
+        }
+    }
+
+    /// <summary>
+    /// Reads a value without moving past it.
+    /// </summary>
+    template <typename T>
+    bool Peek(T& value)
+    {
+        const size_t ofs = m_ofs;
+        const bool ret = Read(value);
+        if (ret)
+            m_ofs = ofs;
+        return ret;
+    }
+
+private:
+    bool Fits(size_t cb) const
+    {
+        return !bChecked || (!m_bFailed && cb <= m_cbData - m_ofs);
+    }
+
+    static bool IsUtf16Aligned(const uint8_t* p)
+    {
+        return 0 == ((uintptr_t)p % alignof(uint16_t));
+    }
+
+    // A view of code units in the span, or of a copy of them if they're at an odd address
+    utf16view_t Utf16InPlaceOrCopy(const uint8_t* pChars, size_t nChars)
+    {
+        utf16view_t view;
+        view.nChars = nChars;
+        if (IsUtf16Aligned(pChars))
+        {
+            view.pChars = (const uint16_t*)pChars;
+        }
+        else
+        {
+            // Each copy has its own buffer, which stays put when m_vCopies grows.
+            m_vCopies.emplace_back(nChars + 1);
+            memcpy(m_vCopies.back().data(), pChars, nChars * sizeof(uint16_t));
+            view.pChars = m_vCopies.back().data();
+        }
+        return view;
+    }
+
+    // Only a checked cursor's reads fail.
+    bool Fail()
+    {
+        m_bFailed = true;
+        m_ofs = m_cbData;
+        return false;
+    }
+
+    const uint8_t* m_pData;
+    size_t m_cbData;
+    size_t m_ofs;
+    bool m_bFailed;
+    // Copies of strings at odd addresses
+    std::vector<std::vector<uint16_t>> m_vCopies;
+};
+
+typedef ResourceCursor<true> CheckedResourceCursor;
+typedef ResourceCursor<false> UncheckedResourceCursor;
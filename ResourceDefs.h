@@ -1,6 +1,6 @@
 #pragma once
 
-#include <Windows.h>
+#include "PlatformDefs.h"
 
 // "sz_Or_Ord" (or "szOrOrd") is a placeholder declaration for a variable-length array of 16-bit elements
 // to represent what can be an ordinal value or a zero-terminated wide-character string.
@@ -10,6 +10,8 @@
 // to give the first sz_Or_Ord an offset.
 //
 // None of these structures is defined in any standard header file.
+// The definitions at the end of this file are the subset of winuser.h and winnt.h definitions
+// that the resource parsers use, for platforms other than Windows.
 
 /// <summary>
 /// https://learn.microsoft.com/en-us/windows/win32/dlgbox/dlgtemplateex
@@ -150,4 +152,83 @@ typedef struct {
 	WORD  wFlags;
 	WCHAR szText[1];
 } MENUEX_TEMPLATE_ITEM;
-#pragma pack (pop)
\ No newline at end of file
+#pragma pack (pop)
+
+#ifndef _WIN32
+
+// ------------------------------------------------------------------------------------------
+// Definitions from winuser.h
+
+#define WS_CHILD            0x40000000L
+
+#define DS_SETFONT          0x40L
+#define DS_SHELLFONT        (DS_SETFONT | 0x0008L) // DS_FIXEDSYS
+
+#define BS_3STATE           0x00000005L
+#define BS_CHECKBOX         0x00000002L
+#define BS_AUTO3STATE       0x00000006L
+#define BS_AUTOCHECKBOX     0x00000003L
+#define BS_RADIOBUTTON      0x00000004L
+#define BS_AUTORADIOBUTTON  0x00000009L
+#define BS_GROUPBOX         0x00000007L
+#define BS_TYPEMASK         0x0000000FL
+
+#define MF_GRAYED           0x00000001L
+#define MF_DISABLED         0x00000002L
+#define MF_POPUP            0x00000010L
+#define MF_END              0x00000080L
+#define MFT_BITMAP          0x00000004L
+#define MFT_SEPARATOR       0x00000800L
+
+#pragma pack (push, 2)
+/// <summary>
+/// https://learn.microsoft.com/en-us/windows/win32/api/winuser/ns-winuser-dlgtemplate
+/// </summary>
+typedef struct {
+	DWORD style;
+	DWORD dwExtendedStyle;
+	WORD cdit;
+	short x;
+	short y;
+	short cx;
+	short cy;
+} DLGTEMPLATE;
+
+/// <summary>
+/// https://learn.microsoft.com/en-us/windows/win32/api/winuser/ns-winuser-dlgitemtemplate
+/// </summary>
+typedef struct {
+	DWORD style;
+	DWORD dwExtendedStyle;
+	short x;
+	short y;
+	short cx;
+	short cy;
+	WORD id;
+} DLGITEMTEMPLATE;
+#pragma pack (pop)
+
+// ------------------------------------------------------------------------------------------
+// Definitions from winnt.h
+
+#define MESSAGE_RESOURCE_UNICODE 0x0001
+#define MESSAGE_RESOURCE_UTF8    0x0002
+
+typedef struct {
+	WORD Length;
+	WORD Flags;
+	BYTE Text[1];
+} MESSAGE_RESOURCE_ENTRY;
+
+typedef struct {
+	DWORD LowId;
+	DWORD HighId;
+	DWORD OffsetToEntries;
+} MESSAGE_RESOURCE_BLOCK;
+
+typedef struct {
+	DWORD NumberOfBlocks;
+	MESSAGE_RESOURCE_BLOCK Blocks[1];
+} MESSAGE_RESOURCE_DATA;
+
+#endif
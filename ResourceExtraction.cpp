@@ -0,0 +1,493 @@
+#include "PlatformDefs.h"
+#include <atomic>
+#include <condition_variable>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include "ResourceExtraction.h"
+#include "StringTableExtraction.h"
+#include "DialogTextExtraction.h"
+#include "MessageTableExtraction.h"
+#include "MenuTextExtraction.h"
+#include "LanguageNames.h"
+
+static const resourceextractor_t sExtractors[] =
+{
+    { rsrctype_t::eString, L"strings", WriteStringTableHeaders, DecodeStringTableText, WriteStringTableText },
+    { rsrctype_t::eDialog, L"dialogs", WriteDialogTextHeaders, DecodeDialogText, WriteDialogText },
+    { rsrctype_t::eMessageTable, L"messages", WriteMessageTableHeaders, DecodeMessageTableText, WriteMessageTableText },
+    { rsrctype_t::eMenu, L"menus", WriteMenuTextHeaders, DecodeMenuText, WriteMenuText },
+};
+
+bool OpenResourceFile(ResourceFile& rsrcFile, const std::wstring& sFilePath, const languageoptions_t& languages, std::wstring& sErrorInfo)
+{
+    if (languages.bAllLanguages)
+        return rsrcFile.OpenAllLanguages(sFilePath, languages.vFilter, sErrorInfo);
+    return rsrcFile.Open(sFilePath, languages.vPreferred, sErrorInfo);
+}
+
+const resourceextractor_t& ResourceExtractor(rsrctype_t type)
+{
+    for (const resourceextractor_t& extractor : sExtractors)
+    {
+        if (type == extractor.type)
+            return extractor;
+    }
+    // Every rsrctype_t value has an extractor.
+    return sExtractors[0];
+}
+
+const std::vector<rsrctype_t>& AllExtractableTypes()
+{
+    static const std::vector<rsrctype_t> vTypes = { rsrctype_t::eString, rsrctype_t::eDialog, rsrctype_t::eMessageTable, rsrctype_t::eMenu };
+    return vTypes;
+}
+
+void WriteResourceHeaders(rsrctype_t type, bool bLanguageColumn, std::wostream& out)
+{
+    if (bLanguageColumn)
+        out << L"Language\t";
+    ResourceExtractor(type).pfnWriteHeaders(out);
+}
+
+void WriteLinesWithPrefix(std::wostream& os, const std::wstring& sText, const std::wstring& sPrefix)
+{
+    size_t ixLine = 0;
+    while (ixLine < sText.length())
+    {
+        size_t ixEnd = sText.find(L'\n', ixLine);
+        if (std::wstring::npos == ixEnd)
+            ixEnd = sText.length();
+        os << sPrefix;
+        os.write(sText.data() + ixLine, (std::streamsize)(ixEnd - ixLine)) << L'\n';
+        ixLine = ixEnd + 1;
+    }
+}
+
+bool VisitResources(const ResourceFile& rsrcFile, const std::vector<rsrctype_t>& vTypes, ResourceVisitor& visitor, std::wostream& err)
+{
+    // A decoder returns false to stop enumerating resources of its type; other types continue.
+    std::vector<bool> vStopped(vTypes.size(), false);
+
+    std::wstring sErrorInfo;
+    bool ret = rsrcFile.EnumResources(
+        vTypes,
+        [&](const ResourceEntry_t& entry)
+        {
+            for (size_t ixType = 0; ixType < vTypes.size(); ++ixType)
+            {
+                if ((uint16_t)vTypes[ixType] == entry.type.m_id)
+                {
+                    if (vStopped[ixType])
+                        break;
+                    visitor.BeginResource(entry);
+                    if (!ResourceExtractor(vTypes[ixType]).pfnDecodeResource(entry, visitor, err))
+                        vStopped[ixType] = true;
+                    break;
+                }
+            }
+            return true;
+        },
+        sErrorInfo);
+
+    if (!ret)
+    {
+        err << L"Cannot enumerate resources: " << sErrorInfo << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/// <summary>
+/// Stream buffer that collects output in a string whose capacity is kept when it's cleared, so that once it has
+/// held the longest line, writing a line into it doesn't allocate.
+/// </summary>
+class LineBuffer : public std::wstreambuf
+{
+public:
+    void Clear() { m_sText.clear(); }
+    const std::wstring& Text() const { return m_sText; }
+    // Moves the text out, leaving the buffer empty.
+    void MoveTextTo(std::wstring& sText) { sText.swap(m_sText); m_sText.clear(); }
+
+protected:
+    int_type overflow(int_type ch) override
+    {
+        if (!traits_type::eq_int_type(ch, traits_type::eof()))
+            m_sText += traits_type::to_char_type(ch);
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize xsputn(const wchar_t* pChars, std::streamsize nChars) override
+    {
+        m_sText.append(pChars, (size_t)nChars);
+        return nChars;
+    }
+
+private:
+    std::wstring m_sText;
+};
+
+/// <summary>
+/// Visitor for ExtractResources: writes each item's tab-delimited line to its type's stream, with temporary
+/// text from the arena, which is rewound after each item.
+/// With all languages, each line is written into a buffer first so that it (and any line in unescaped text)
+/// can be labeled with the resource's language.
+/// </summary>
+class TabDelimitedVisitor : public ResourceVisitor
+{
+public:
+    TabDelimitedVisitor(const std::vector<rsrctype_t>& vTypes, const std::vector<std::wostream*>& vOuts, bool bLanguageColumn, TextArena& arena) :
+        m_vTypes(vTypes),
+        m_vOuts(vOuts),
+        m_bLanguageColumn(bLanguageColumn),
+        m_arena(arena),
+        m_pfnWriteText(nullptr),
+        m_pOut(nullptr),
+        m_pPrefix(nullptr),
+        m_lineOut(&m_lineBuffer)
+    {}
+
+    void BeginResource(const ResourceEntry_t& entry) override
+    {
+        for (size_t ixType = 0; ixType < m_vTypes.size(); ++ixType)
+        {
+            if ((uint16_t)m_vTypes[ixType] == entry.type.m_id)
+            {
+                m_pfnWriteText = ResourceExtractor(m_vTypes[ixType]).pfnWriteText;
+                m_pOut = m_vOuts[ixType];
+                break;
+            }
+        }
+        // Resources are listed by type, then name, then language, so the languages alternate; each language's
+        // column is made once.
+        if (m_bLanguageColumn)
+        {
+            std::wstring& sPrefix = m_prefixes[entry.langId];
+            if (sPrefix.empty())
+                sPrefix = LangIdToName(entry.langId) + L'\t';
+            m_pPrefix = &sPrefix;
+        }
+    }
+
+    void Visit(const ResourceEntry_t& entry, const textview_t& text) override
+    {
+        const TextArena::mark_t mark = m_arena.Mark();
+        if (m_bLanguageColumn)
+        {
+            m_lineBuffer.Clear();
+            m_pfnWriteText(entry, text, m_arena, m_lineOut);
+            WriteLinesWithPrefix(*m_pOut, m_lineBuffer.Text(), *m_pPrefix);
+        }
+        else
+        {
+            m_pfnWriteText(entry, text, m_arena, *m_pOut);
+        }
+        m_arena.Rewind(mark);
+    }
+
+private:
+    const std::vector<rsrctype_t>& m_vTypes;
+    const std::vector<std::wostream*>& m_vOuts;
+    const bool m_bLanguageColumn;
+    TextArena& m_arena;
+    // Writer and stream of the current resource's type, and its language column
+    TextWriterVisitor::WriteTextFn_t m_pfnWriteText;
+    std::wostream* m_pOut;
+    const std::wstring* m_pPrefix;
+    std::map<uint16_t, std::wstring> m_prefixes;
+    LineBuffer m_lineBuffer;
+    std::wostream m_lineOut;
+
+private:
+    // Not implemented
+    TabDelimitedVisitor(const TabDelimitedVisitor&) = delete;
+    TabDelimitedVisitor& operator = (const TabDelimitedVisitor&) = delete;
+};
+
+/// <summary>
+/// Returns the index of the resource's type in the list.
+/// </summary>
+static size_t TypeIndex(const std::vector<rsrctype_t>& vTypes, const ResourceEntry_t& entry)
+{
+    for (size_t ixType = 0; ixType < vTypes.size(); ++ixType)
+    {
+        if ((uint16_t)vTypes[ixType] == entry.type.m_id)
+            return ixType;
+    }
+    return 0;
+}
+
+std::vector<size_t> DivideIntoRuns(const std::vector<ResourceEntry_t>& vEntries, unsigned int nThreads)
+{
+    uint64_t cbTotal = 0;
+    for (const ResourceEntry_t& entry : vEntries)
+        cbTotal += entry.cbData;
+    const uint64_t cbRun = cbTotal / ((uint64_t)nThreads * 4) + 1;
+
+    std::vector<size_t> vRunEnds;
+    uint64_t cbInRun = 0;
+    for (size_t ixEntry = 0; ixEntry < vEntries.size(); ++ixEntry)
+    {
+        cbInRun += vEntries[ixEntry].cbData;
+        if (cbInRun >= cbRun || ixEntry + 1 == vEntries.size())
+        {
+            vRunEnds.push_back(ixEntry + 1);
+            cbInRun = 0;
+        }
+    }
+    return vRunEnds;
+}
+
+void DecodeResourceRun(
+    const std::vector<ResourceEntry_t>& vEntries,
+    size_t ixBegin,
+    size_t ixEnd,
+    const std::vector<rsrctype_t>& vTypes,
+    bool bLanguageColumn,
+    TextArena& arena,
+    decodedrun_t& run)
+{
+    // Every type's output goes into one buffer, and the run records where each resource's ends.
+    LineBuffer outBuffer, errBuffer;
+    std::wostream out(&outBuffer), err(&errBuffer);
+    const std::vector<std::wostream*> vRunOuts(vTypes.size(), &out);
+    TabDelimitedVisitor visitor(vTypes, vRunOuts, bLanguageColumn, arena);
+    // A type whose decoder finds a malformed resource is skipped from then on, here as when writing.
+    std::vector<bool> vStopped(vTypes.size(), false);
+    for (size_t ixEntry = ixBegin; ixEntry < ixEnd; ++ixEntry)
+    {
+        const ResourceEntry_t& entry = vEntries[ixEntry];
+        decodedrun_t::resource_t resource;
+        resource.ixType = TypeIndex(vTypes, entry);
+        resource.bDecoded = true;
+        if (!vStopped[resource.ixType])
+        {
+            visitor.BeginResource(entry);
+            resource.bDecoded = ResourceExtractor(vTypes[resource.ixType]).pfnDecodeResource(entry, visitor, err);
+            vStopped[resource.ixType] = !resource.bDecoded;
+        }
+        resource.ichOutEnd = outBuffer.Text().length();
+        resource.ichErrEnd = errBuffer.Text().length();
+        run.vResources.push_back(resource);
+    }
+    outBuffer.MoveTextTo(run.sOut);
+    errBuffer.MoveTextTo(run.sErr);
+}
+
+bool WriteDecodedRun(const decodedrun_t& run, const std::vector<std::wostream*>& vOuts, std::wostream& err, std::vector<bool>& vStopped)
+{
+    bool bAllDecoded = true;
+    size_t ichOut = 0, ichErr = 0;
+    for (const decodedrun_t::resource_t& resource : run.vResources)
+    {
+        if (!vStopped[resource.ixType])
+        {
+            vOuts[resource.ixType]->write(run.sOut.data() + ichOut, (std::streamsize)(resource.ichOutEnd - ichOut));
+            err.write(run.sErr.data() + ichErr, (std::streamsize)(resource.ichErrEnd - ichErr));
+            if (!resource.bDecoded)
+            {
+                vStopped[resource.ixType] = true;
+                bAllDecoded = false;
+            }
+        }
+        ichOut = resource.ichOutEnd;
+        ichErr = resource.ichErrEnd;
+    }
+    return bAllDecoded;
+}
+
+/// <summary>
+/// Decodes the resources on several threads (see WriteResourceText). The resources are divided into runs (see
+/// DivideIntoRuns), which the threads take in turn; this thread writes each run's output as soon as it and the runs
+/// before it are done.
+/// </summary>
+static bool WriteResourceTextInParallel(
+    const std::vector<ResourceEntry_t>& vEntries,
+    const std::vector<rsrctype_t>& vTypes,
+    const std::vector<std::wostream*>& vOuts,
+    bool bLanguageColumn,
+    unsigned int nThreads,
+    std::wostream& err)
+{
+    const std::vector<size_t> vRunEnds = DivideIntoRuns(vEntries, nThreads);
+    if (nThreads > vRunEnds.size())
+        nThreads = (unsigned int)vRunEnds.size();
+
+    std::vector<decodedrun_t> vRuns(vRunEnds.size());
+    std::atomic<size_t> ixNextRun(0);
+    std::mutex mtxRuns;
+    std::condition_variable cvRunDone;
+
+    std::vector<std::thread> vThreads;
+    for (unsigned int ixThread = 0; ixThread < nThreads; ++ixThread)
+    {
+        vThreads.emplace_back([&]()
+            {
+                TextArena arena;
+                for (size_t ixRun = ixNextRun++; ixRun < vRunEnds.size(); ixRun = ixNextRun++)
+                {
+                    decodedrun_t run;
+                    DecodeResourceRun(vEntries, (0 == ixRun) ? 0 : vRunEnds[ixRun - 1], vRunEnds[ixRun], vTypes, bLanguageColumn, arena, run);
+                    {
+                        std::lock_guard<std::mutex> lock(mtxRuns);
+                        vRuns[ixRun] = std::move(run);
+                        vRuns[ixRun].bDone = true;
+                    }
+                    cvRunDone.notify_one();
+                }
+            });
+    }
+
+    bool bAllDecoded = true;
+    std::vector<bool> vStopped(vTypes.size(), false);
+    for (size_t ixRun = 0; ixRun < vRuns.size(); ++ixRun)
+    {
+        decodedrun_t run;
+        {
+            std::unique_lock<std::mutex> lock(mtxRuns);
+            cvRunDone.wait(lock, [&]() { return vRuns[ixRun].bDone; });
+            run = std::move(vRuns[ixRun]);
+        }
+        if (!WriteDecodedRun(run, vOuts, err, vStopped))
+            bAllDecoded = false;
+    }
+
+    for (std::thread& thread : vThreads)
+        thread.join();
+    return bAllDecoded;
+}
+
+bool WriteResourceText(
+    const std::vector<ResourceEntry_t>& vEntries,
+    const std::vector<rsrctype_t>& vTypes,
+    const std::vector<std::wostream*>& vOuts,
+    bool bLanguageColumn,
+    unsigned int nThreads,
+    std::wostream& err,
+    TextArena& arena)
+{
+    uint64_t cbTotal = 0;
+    for (const ResourceEntry_t& entry : vEntries)
+        cbTotal += entry.cbData;
+    if (0 == nThreads)
+        nThreads = std::thread::hardware_concurrency();
+    if (nThreads > 1 && vEntries.size() > 1 && cbTotal >= cbParallelDecodingThreshold)
+        return WriteResourceTextInParallel(vEntries, vTypes, vOuts, bLanguageColumn, nThreads, err);
+
+    // A decoder returns false to skip the rest of its type's resources.
+    bool bAllDecoded = true;
+    std::vector<bool> vStopped(vTypes.size(), false);
+    TabDelimitedVisitor visitor(vTypes, vOuts, bLanguageColumn, arena);
+    for (const ResourceEntry_t& entry : vEntries)
+    {
+        const size_t ixType = TypeIndex(vTypes, entry);
+        if (vStopped[ixType])
+            continue;
+        visitor.BeginResource(entry);
+        if (!ResourceExtractor(vTypes[ixType]).pfnDecodeResource(entry, visitor, err))
+        {
+            vStopped[ixType] = true;
+            bAllDecoded = false;
+        }
+    }
+    return bAllDecoded;
+}
+
+bool ExtractResources(
+    const ResourceFile& rsrcFile,
+    const std::vector<rsrctype_t>& vTypes,
+    const std::vector<std::wostream*>& vOuts,
+    std::wostream& err,
+    TextArena& arena,
+    unsigned int nThreads)
+{
+    // Enumerate first, so that the resources can be divided among threads; an enumeration that fails partway is
+    // reported after the resources enumerated before the failure, as it is when decoding during the enumeration.
+    std::vector<ResourceEntry_t> vEntries;
+    std::wstring sErrorInfo;
+    const bool bEnumerated = rsrcFile.EnumResources(vTypes, [&vEntries](const ResourceEntry_t& entry) { vEntries.push_back(entry); return true; }, sErrorInfo);
+    WriteResourceText(vEntries, vTypes, vOuts, rsrcFile.AllLanguages(), nThreads, err, arena);
+    if (!bEnumerated)
+    {
+        err << L"Cannot enumerate resources: " << sErrorInfo << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool ExtractResourcesOfType(const ResourceFile& rsrcFile, rsrctype_t type, std::wostream& out, std::wostream& err, unsigned int nThreads, std::wstring& sErrorInfo)
+{
+    std::vector<ResourceEntry_t> vEntries;
+    const bool bEnumerated = rsrcFile.EnumResources(type, [&vEntries](const ResourceEntry_t& entry) { vEntries.push_back(entry); return true; }, sErrorInfo);
+    TextArena arena;
+    // A malformed resource ends the extraction, so an enumeration failure after it wouldn't have been reached.
+    const bool bAllDecoded = WriteResourceText(vEntries, { type }, { &out }, false, nThreads, err, arena);
+    return bEnumerated || !bAllDecoded;
+}
+
+/// <summary>
+/// Visitor for ExtractRecords: copies each item of text into a record, with the resource it came from.
+/// The record is reused, and its strings are assigned in place, so that once their capacity is large enough,
+/// making a record doesn't allocate.
+/// </summary>
+class RecordVisitor : public ResourceVisitor
+{
+public:
+    explicit RecordVisitor(const ResourceRecordCallback_t& callback) : m_callback(callback) {}
+
+    void BeginResource(const ResourceEntry_t& entry) override
+    {
+        // The resource fields are set once per resource; the text fields are replaced for each item.
+        m_record.type = (rsrctype_t)entry.type.m_id;
+        m_record.langId = entry.langId;
+        m_record.resourceId = entry.name.IsId() ? entry.name.m_id : 0;
+        m_record.sResourceName.clear();
+        if (!entry.name.IsId())
+        {
+            utf16view_t name;
+            name.pChars = entry.name.m_pName;
+            name.nChars = entry.name.m_cchName;
+            Assign(m_record.sResourceName, ArenaText(m_arena, name));
+        }
+        m_arena.Reset();
+    }
+
+    void Visit(const ResourceEntry_t& entry, const textview_t& text) override
+    {
+        (void)entry;
+        textrecord_t& record = m_record.text;
+        record.item = text.item;
+        record.id = text.id;
+        Assign(record.sText, ArenaText(m_arena, text.text));
+        if (rsrctype_t::eDialog == m_record.type && textview_t::item_t::eId == text.item)
+            Assign(record.sControlType, DialogControlType(m_arena, text.windowClass, text.style));
+        else
+            record.sControlType.clear();
+        m_arena.Reset();
+        m_callback(m_record);
+    }
+
+private:
+    static void Assign(std::wstring& str, const arenatext_t& text)
+    {
+        str.assign(text.pChars, text.nChars);
+    }
+
+    const ResourceRecordCallback_t& m_callback;
+    resourcerecord_t m_record;
+    TextArena m_arena;
+
+private:
+    // Not implemented
+    RecordVisitor(const RecordVisitor&) = delete;
+    RecordVisitor& operator = (const RecordVisitor&) = delete;
+};
+
+bool ExtractRecords(const ResourceFile& rsrcFile, const std::vector<rsrctype_t>& vTypes, const ResourceRecordCallback_t& callback, std::wostream& err)
+{
+    RecordVisitor visitor(callback);
+    return VisitResources(rsrcFile, vTypes, visitor, err);
+}
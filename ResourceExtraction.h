@@ -0,0 +1,213 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "UtilityFunctions.h"
+#include "TextRecord.h"
+
+/// <summary>
+/// Describes the extraction of one resource type: its headers, its per-resource decoder, the writer of
+/// each item's tab-delimited line, and a short name for the output (e.g., as an output file name suffix).
+/// </summary>
+struct resourceextractor_t
+{
+    rsrctype_t type;
+    const wchar_t* szName;
+    void (*pfnWriteHeaders)(std::wostream& out);
+    bool (*pfnDecodeResource)(const ResourceEntry_t& entry, ResourceVisitor& visitor, std::wostream& err);
+    TextWriterVisitor::WriteTextFn_t pfnWriteText;
+};
+
+/// <summary>
+/// Version of the text that the decoders and writers output, part of each extraction cache key and of the options
+/// hash of an incremental extraction's manifest, so that results from decoders that produced other text are never
+/// reused. Increment it with any change to what a decoder or writer outputs for some resource (its text, escaping,
+/// columns, records, or error text); not for changes that only make them faster.
+/// </summary>
+const uint32_t decoderOutputVersion = 1;
+
+/// <summary>
+/// Which languages to extract from each resource file.
+/// </summary>
+struct languageoptions_t
+{
+    // Preferred languages by name, most preferred first. Each resource is reported in the best available one,
+    // as the Windows resource loader would choose.
+    std::vector<std::wstring> vPreferred;
+    // If true, each resource is instead reported in every language in the file and its .mui satellite files,
+    // with a leading "Language" column.
+    bool bAllLanguages = false;
+    // With bAllLanguages, the languages to report; empty to report all.
+    std::vector<uint16_t> vFilter;
+};
+
+/// <summary>
+/// Opens a resource file for extraction in the specified language(s).
+/// </summary>
+/// <param name="rsrcFile">Output: the resource file to open</param>
+/// <param name="sFilePath">Input: path to the PE file</param>
+/// <param name="languages">Input: which languages to extract</param>
+/// <param name="sErrorInfo">Output: diagnostic information on failure</param>
+/// <returns>true if successful, false otherwise</returns>
+bool OpenResourceFile(ResourceFile& rsrcFile, const std::wstring& sFilePath, const languageoptions_t& languages, std::wstring& sErrorInfo);
+
+/// <summary>
+/// Returns the extractor for the resource type.
+/// </summary>
+const resourceextractor_t& ResourceExtractor(rsrctype_t type);
+
+/// <summary>
+/// The resource types that have extractors: string table, dialog, message table, and menu.
+/// </summary>
+const std::vector<rsrctype_t>& AllExtractableTypes();
+
+/// <summary>
+/// Writes the tab-delimited headers for a resource type's output, optionally with a leading "Language" column.
+/// </summary>
+void WriteResourceHeaders(rsrctype_t type, bool bLanguageColumn, std::wostream& out);
+
+/// <summary>
+/// Writes each line of the text to the stream, preceded by the prefix.
+/// </summary>
+void WriteLinesWithPrefix(std::wostream& os, const std::wstring& sText, const std::wstring& sPrefix);
+
+/// <summary>
+/// Decodes the text of several resource types with a single pass over the file's resource directory,
+/// dispatching each resource to its type's decoder, which reports each item of text to the visitor.
+/// Types that the file doesn't contain are skipped; a type whose decoder finds a malformed resource is
+/// skipped from then on.
+/// </summary>
+/// <param name="rsrcFile">The resource file to inspect</param>
+/// <param name="vTypes">Input: resource types to decode</param>
+/// <param name="visitor">Input: visitor to report each resource and item of text to</param>
+/// <param name="err">The error stream to write diagnostic information into</param>
+/// <returns>true if successful, false otherwise.</returns>
+bool VisitResources(const ResourceFile& rsrcFile, const std::vector<rsrctype_t>& vTypes, ResourceVisitor& visitor, std::wostream& err);
+
+/// <summary>
+/// Amount of resource data in one extraction above which WriteResourceText decodes the resources on several
+/// threads, if allowed to. Below it, starting the threads takes longer than decoding.
+/// </summary>
+const uint64_t cbParallelDecodingThreshold = 256 * 1024;
+
+/// <summary>
+/// Decodes resources that a file enumerated, dispatching each resource to its type's decoder, and writes each item's
+/// tab-delimited line to its type's stream: output for vTypes[ix] is written to *vOuts[ix], without headers.
+/// A type whose decoder finds a malformed resource is skipped from then on.
+///
+/// With more than one thread and at least cbParallelDecodingThreshold bytes of resource data, the resources are
+/// divided into runs of consecutive resources, each decoded on one of the threads into buffers of its own. The
+/// runs' output and error text is written in the order of the resources, so it's the same as from one thread.
+/// </summary>
+/// <param name="vEntries">Input: the resources, in the order to write their text</param>
+/// <param name="vTypes">Input: resource types of the resources</param>
+/// <param name="vOuts">Input: output stream for each resource type</param>
+/// <param name="bLanguageColumn">Input: true to precede each row with the resource's language</param>
+/// <param name="nThreads">Input: maximum number of threads to decode on; 0 for one per hardware thread</param>
+/// <param name="err">The error stream to write diagnostic information into</param>
+/// <param name="arena">Input: arena for the temporary text of each item when decoding on this thread</param>
+/// <returns>true if every decoder succeeded; false if any found a malformed resource</returns>
+bool WriteResourceText(
+    const std::vector<ResourceEntry_t>& vEntries,
+    const std::vector<rsrctype_t>& vTypes,
+    const std::vector<std::wostream*>& vOuts,
+    bool bLanguageColumn,
+    unsigned int nThreads,
+    std::wostream& err,
+    TextArena& arena);
+
+/// <summary>
+/// Output of a run of consecutive resources decoded on one thread (see DecodeResourceRun), waiting to be written in
+/// order: the output and error text of all the resources, one after the other, and where each resource's ends.
+/// </summary>
+struct decodedrun_t
+{
+    struct resource_t
+    {
+        size_t ixType;
+        size_t ichOutEnd;
+        size_t ichErrEnd;
+        // The decoder returned true
+        bool bDecoded;
+    };
+    std::vector<resource_t> vResources;
+    std::wstring sOut;
+    std::wstring sErr;
+    // Set by the thread that decoded the run, for the thread that writes it
+    bool bDone = false;
+};
+
+/// <summary>
+/// Divides resources into runs of consecutive resources with about the same amount of data, to be decoded on up to
+/// nThreads threads: several runs per thread, so that a thread that gets small resources takes more runs.
+/// Returns the index after each run's last resource.
+/// </summary>
+std::vector<size_t> DivideIntoRuns(const std::vector<ResourceEntry_t>& vEntries, unsigned int nThreads);
+
+/// <summary>
+/// Decodes the resources vEntries[ixBegin] up to vEntries[ixEnd] as WriteResourceText does, into the run's
+/// buffers. Any thread can decode a run, with an arena of its own.
+/// </summary>
+void DecodeResourceRun(
+    const std::vector<ResourceEntry_t>& vEntries,
+    size_t ixBegin,
+    size_t ixEnd,
+    const std::vector<rsrctype_t>& vTypes,
+    bool bLanguageColumn,
+    TextArena& arena,
+    decodedrun_t& run);
+
+/// <summary>
+/// Writes a decoded run's text to its types' streams and its error text to the error stream. Runs are written in
+/// order, with the same vStopped for all of them: a type whose decoder found a malformed resource is skipped from
+/// then on, as if the resources had been decoded on one thread.
+/// </summary>
+/// <returns>true if every decoder succeeded; false if any found a malformed resource</returns>
+bool WriteDecodedRun(const decodedrun_t& run, const std::vector<std::wostream*>& vOuts, std::wostream& err, std::vector<bool>& vStopped);
+
+/// <summary>
+/// Extracts the text of several resource types with a single pass over the file's resource directory
+/// (see WriteResourceText), writing each item's tab-delimited line. Output for vTypes[ix] is written to *vOuts[ix], without headers.
+/// Types that the file doesn't contain are skipped.
+/// If the file was opened for all languages, each row is preceded by the resource's language.
+/// </summary>
+/// <param name="rsrcFile">The resource file to inspect</param>
+/// <param name="vTypes">Input: resource types to extract</param>
+/// <param name="vOuts">Input: output stream for each resource type</param>
+/// <param name="err">The error stream to write diagnostic information into</param>
+/// <param name="arena">Input: arena for the temporary text of each item, rewound after each; a caller extracting from
+/// many files can keep one arena for all of them, so that the extraction doesn't allocate once it's large enough</param>
+/// <param name="nThreads">Input: maximum number of threads to decode a large file on; 0 for one per hardware
+/// thread, 1 for a caller that is already extracting from several files in parallel</param>
+/// <returns>true if successful, false otherwise.</returns>
+bool ExtractResources(
+    const ResourceFile& rsrcFile,
+    const std::vector<rsrctype_t>& vTypes,
+    const std::vector<std::wostream*>& vOuts,
+    std::wostream& err,
+    TextArena& arena,
+    unsigned int nThreads);
+
+/// <summary>
+/// Extracts the text of one resource type (see WriteResourceText), writing each item's tab-delimited line without
+/// headers. Stops at the first malformed resource.
+/// </summary>
+/// <param name="rsrcFile">The resource file to inspect</param>
+/// <param name="type">Input: resource type to extract</param>
+/// <param name="out">The output stream to write the text into</param>
+/// <param name="err">The error stream to write diagnostic information into</param>
+/// <param name="nThreads">Input: maximum number of threads to decode a large file on; 0 for one per hardware thread</param>
+/// <param name="sErrorInfo">Output: diagnostic information if the resources can't be enumerated</param>
+/// <returns>false if the resources can't be enumerated (e.g., the type isn't present), true otherwise</returns>
+bool ExtractResourcesOfType(const ResourceFile& rsrcFile, rsrctype_t type, std::wostream& out, std::wostream& err, unsigned int nThreads, std::wstring& sErrorInfo);
+
+/// <summary>
+/// Decodes the text of several resource types with a single pass over the file's resource directory (see
+/// VisitResources), copying each item of text into a record for the callback.
+/// </summary>
+/// <param name="rsrcFile">The resource file to inspect</param>
+/// <param name="vTypes">Input: resource types to extract</param>
+/// <param name="callback">Input: function to call with each item of text</param>
+/// <param name="err">The error stream to write diagnostic information into</param>
+/// <returns>true if successful, false otherwise.</returns>
+bool ExtractRecords(const ResourceFile& rsrcFile, const std::vector<rsrctype_t>& vTypes, const ResourceRecordCallback_t& callback, std::wostream& err);
@@ -0,0 +1,802 @@
+#include "PlatformDefs.h"
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include "ResourceFile.h"
+#include "FileEnumeration.h"
+#include "LanguageNames.h"
+#include "StringUtils.h"
+
+// Sizes and offsets of the PE structures used here. (Declared in winnt.h, which isn't available on all platforms.)
+// IMAGE_DOS_HEADER: e_magic at 0, e_lfanew at 0x3C
+// IMAGE_NT_HEADERS: Signature (4 bytes), IMAGE_FILE_HEADER (20 bytes), then the optional header
+// IMAGE_SECTION_HEADER: 40 bytes
+// IMAGE_RESOURCE_DIRECTORY: 16 bytes, followed by 8-byte IMAGE_RESOURCE_DIRECTORY_ENTRY structures
+// IMAGE_RESOURCE_DATA_ENTRY: 16 bytes
+static const uint32_t cbDosHeader = 0x40;
+static const uint32_t cbFileHeader = 20;
+static const uint32_t cbSectionHeader = 40;
+static const uint32_t cbResourceDirectory = 16;
+static const uint32_t cbResourceDirectoryEntry = 8;
+static const uint32_t cbResourceDataEntry = 16;
+static const uint16_t OptionalHeaderMagic_PE32 = 0x10B;
+static const uint16_t OptionalHeaderMagic_PE32Plus = 0x20B;
+static const uint32_t ImageDirectoryEntry_Resource = 2;
+// High bit of IMAGE_RESOURCE_DIRECTORY_ENTRY fields: name is a string; data is a subdirectory
+static const uint32_t ResourceFlag_High = 0x80000000;
+
+// Language-selection fallbacks, after the preferred languages
+static const uint16_t LangId_Neutral = 0x0000;
+static const uint16_t LangId_UserDefault = 0x0400;
+static const uint16_t LangId_SystemDefault = 0x0800;
+static const uint16_t LangId_EnglishUS = 0x0409;
+
+/// <summary>
+/// Reads little-endian values from possibly-unaligned memory.
+/// </summary>
+static inline uint16_t ReadU16(const uint8_t* p)
+{
+    uint16_t val;
+    memcpy(&val, p, sizeof(val));
+    return val;
+}
+
+static inline uint32_t ReadU32(const uint8_t* p)
+{
+    uint32_t val;
+    memcpy(&val, p, sizeof(val));
+    return val;
+}
+
+ResourceFile::ResourceFile() :
+    m_pRsrcDir(nullptr),
+    m_cbRsrcDir(0),
+    m_bAllLanguages(false),
+    m_bListedLanguageDirectories(false)
+{
+}
+
+ResourceFile::~ResourceFile()
+{
+    Close();
+}
+
+const wchar_t* const ResourceFile::szNotPEFile = L"Not a valid Portable Executable (PE) file";
+
+/// <summary>
+/// Maps the named file and locates its resource directory, and looks for a .mui satellite file.
+/// </summary>
+bool ResourceFile::Open(const std::wstring& sFilePath, const std::vector<std::wstring>& vLanguages, std::wstring& sErrorInfo)
+{
+    Close();
+    if (!OpenPE(sFilePath, sErrorInfo))
+        return false;
+
+    for (const std::wstring& sLang : vLanguages)
+    {
+        uint16_t langId;
+        if (LangIdFromName(sLang, langId))
+            m_vLangIds.push_back(langId);
+    }
+
+    OpenMuiSatellite(vLanguages);
+    return true;
+}
+
+/// <summary>
+/// Maps the named file and locates its resource directory, and looks for .mui satellite files for all languages.
+/// </summary>
+bool ResourceFile::OpenAllLanguages(const std::wstring& sFilePath, const std::vector<uint16_t>& vLangFilter, std::wstring& sErrorInfo)
+{
+    Close();
+    if (!OpenPE(sFilePath, sErrorInfo))
+        return false;
+
+    m_bAllLanguages = true;
+    m_vLangFilter = vLangFilter;
+    OpenAllMuiSatellites();
+    return true;
+}
+
+/// <summary>
+/// Releases the file mapping(s).
+/// </summary>
+void ResourceFile::Close()
+{
+    m_pMuiFile.reset();
+    m_vAllMuiFiles.clear();
+    m_vMuiFilesNotOpened.clear();
+    m_bListedLanguageDirectories = false;
+    m_bAllLanguages = false;
+    m_vLangFilter.clear();
+    m_file.Close();
+    m_vSections.clear();
+    m_vLangIds.clear();
+    m_pRsrcDir = nullptr;
+    m_cbRsrcDir = 0;
+    m_sFilePath.clear();
+}
+
+/// <summary>
+/// Path of the .mui satellite file, if one was found; otherwise empty.
+/// </summary>
+const std::wstring& ResourceFile::MuiFilePath() const
+{
+    static const std::wstring sNone;
+    return m_pMuiFile ? m_pMuiFile->FilePath() : sNone;
+}
+
+void ResourceFile::ForEachMappedFile(const MappedFileCallback_t& callback) const
+{
+    callback(m_sFilePath, m_file.Data(), m_file.Size());
+    if (m_pMuiFile)
+        m_pMuiFile->ForEachMappedFile(callback);
+    for (const std::unique_ptr<ResourceFile>& pMuiFile : m_vAllMuiFiles)
+        pMuiFile->ForEachMappedFile(callback);
+}
+
+/// <summary>
+/// Maps the file and validates the PE headers, section table, and resource data directory.
+/// </summary>
+bool ResourceFile::OpenPE(const std::wstring& sFilePath, std::wstring& sErrorInfo)
+{
+    m_sFilePath = sFilePath;
+    if (!m_file.Open(sFilePath, sErrorInfo))
+        return false;
+
+    const uint8_t* pFile = m_file.Data();
+    const size_t cbFile = m_file.Size();
+
+    // DOS header
+    if (cbFile < cbDosHeader || 'M' != pFile[0] || 'Z' != pFile[1])
+    {
+        sErrorInfo = szNotPEFile;
+        return false;
+    }
+    const uint64_t ntHeaders = ReadU32(pFile + 0x3C);
+    // NT headers: signature, file header, and at least the optional header's magic number
+    if (ntHeaders + 4 + cbFileHeader + 2 > cbFile || 0 != memcmp(pFile + ntHeaders, "PE\0\0", 4))
+    {
+        sErrorInfo = szNotPEFile;
+        return false;
+    }
+    const uint8_t* pFileHeader = pFile + ntHeaders + 4;
+    const uint16_t nSections = ReadU16(pFileHeader + 2);
+    const uint16_t cbOptionalHeader = ReadU16(pFileHeader + 16);
+    const uint64_t optionalHeader = ntHeaders + 4 + cbFileHeader;
+    const uint8_t* pOptionalHeader = pFile + optionalHeader;
+
+    // Location of the data directory array depends on PE32 vs. PE32+
+    uint32_t offsetNumberOfRvaAndSizes, offsetDataDirectory;
+    switch (ReadU16(pOptionalHeader))
+    {
+    case OptionalHeaderMagic_PE32:
+        offsetNumberOfRvaAndSizes = 92;
+        offsetDataDirectory = 96;
+        break;
+    case OptionalHeaderMagic_PE32Plus:
+        offsetNumberOfRvaAndSizes = 108;
+        offsetDataDirectory = 112;
+        break;
+    default:
+        sErrorInfo = L"Unrecognized PE optional header format";
+        return false;
+    }
+    if (offsetDataDirectory > cbOptionalHeader || optionalHeader + cbOptionalHeader > cbFile)
+    {
+        sErrorInfo = szNotPEFile;
+        return false;
+    }
+
+    // Section table, for translating RVAs to file offsets
+    const uint64_t sectionTable = optionalHeader + cbOptionalHeader;
+    if (sectionTable + (uint64_t)nSections * cbSectionHeader > cbFile)
+    {
+        sErrorInfo = L"Section table extends beyond end of file";
+        return false;
+    }
+    for (uint16_t ixSection = 0; ixSection < nSections; ++ixSection)
+    {
+        const uint8_t* pSection = pFile + sectionTable + (uint64_t)ixSection * cbSectionHeader;
+        Section_t section;
+        section.virtualSize = ReadU32(pSection + 8);
+        section.virtualAddress = ReadU32(pSection + 12);
+        section.sizeOfRawData = ReadU32(pSection + 16);
+        section.pointerToRawData = ReadU32(pSection + 20);
+        m_vSections.push_back(section);
+    }
+
+    // Resource data directory. A file without one simply has no resources.
+    const uint32_t nRvaAndSizes = ReadU32(pOptionalHeader + offsetNumberOfRvaAndSizes);
+    const uint32_t offsetResourceDirectory = offsetDataDirectory + ImageDirectoryEntry_Resource * 8;
+    if (nRvaAndSizes <= ImageDirectoryEntry_Resource || offsetResourceDirectory + 8 > cbOptionalHeader)
+        return true;
+    const uint32_t rsrcRva = ReadU32(pOptionalHeader + offsetResourceDirectory);
+    const uint32_t rsrcSize = ReadU32(pOptionalHeader + offsetResourceDirectory + 4);
+    if (0 == rsrcRva || 0 == rsrcSize)
+        return true;
+
+    // Entries in the resource directory are at offsets relative to its beginning, and can be anywhere
+    // in the rest of its section. Use all of that as the bounds for directory reads.
+    for (const Section_t& section : m_vSections)
+    {
+        if (rsrcRva >= section.virtualAddress && rsrcRva - section.virtualAddress < section.sizeOfRawData)
+        {
+            const uint64_t delta = rsrcRva - section.virtualAddress;
+            const uint64_t fileOffset = section.pointerToRawData + delta;
+            uint64_t cbAvailable = section.sizeOfRawData - delta;
+            if (fileOffset >= cbFile)
+                break;
+            if (fileOffset + cbAvailable > cbFile)
+                cbAvailable = cbFile - fileOffset;
+            m_pRsrcDir = pFile + fileOffset;
+            m_cbRsrcDir = (uint32_t)cbAvailable;
+            break;
+        }
+    }
+    if (nullptr == m_pRsrcDir)
+    {
+        sErrorInfo = L"Resource directory is not within any section";
+        return false;
+    }
+    return true;
+}
+
+/// <summary>
+/// If this is a language-neutral file (one with a "MUI" resource that isn't itself a .mui file), looks for
+/// a satellite file in a language-named subdirectory, e.g., C:\Windows\System32\fr-FR\wsecedit.dll.mui,
+/// for each preferred language in turn.
+/// </summary>
+void ResourceFile::OpenMuiSatellite(const std::vector<std::wstring>& vLanguages)
+{
+    if (!IsLanguageNeutral())
+        return;
+
+#ifdef _WIN32
+    const wchar_t chPathSep = L'\\';
+#else
+    const wchar_t chPathSep = L'/';
+#endif
+    std::wstring sDirectory;
+    size_t ixLastPathSep = m_sFilePath.find_last_of(L"/\\");
+    if (std::wstring::npos != ixLastPathSep)
+        sDirectory = m_sFilePath.substr(0, ixLastPathSep + 1);
+    const std::wstring sFileName = GetFileNameFromFilePath(m_sFilePath);
+
+    for (const std::wstring& sLang : vLanguages)
+    {
+        std::wstring sMuiPath = sDirectory + sLang + chPathSep + sFileName + L".mui";
+        std::unique_ptr<ResourceFile> pMuiFile(new ResourceFile());
+        std::wstring sErrorInfo;
+        if (pMuiFile->OpenPE(sMuiPath, sErrorInfo))
+        {
+            pMuiFile->m_vLangIds = m_vLangIds;
+            m_pMuiFile = std::move(pMuiFile);
+            return;
+        }
+        m_vMuiFilesNotOpened.push_back(sMuiPath);
+    }
+}
+
+/// <summary>
+/// A language-neutral file is one with a "MUI" resource that isn't itself a .mui file.
+/// </summary>
+bool ResourceFile::IsLanguageNeutral() const
+{
+    const std::wstring sMuiExt = L".mui";
+    if (m_sFilePath.length() >= sMuiExt.length() &&
+        0 == _wcsicmp(m_sFilePath.c_str() + m_sFilePath.length() - sMuiExt.length(), sMuiExt.c_str()))
+        return false;
+    return HasNamedType("MUI");
+}
+
+/// <summary>
+/// Returns the subdirectories of a directory that are named for a language, with their language IDs.
+/// A directory such as System32 holds thousands of language-neutral files, so the results are cached
+/// rather than listing the directory again for each of them. Thread-safe.
+/// </summary>
+static std::vector<std::pair<std::wstring, uint16_t>> LanguageSubdirectories(const std::wstring& sDirectory)
+{
+    static std::mutex mtxCache;
+    static std::map<std::wstring, std::vector<std::pair<std::wstring, uint16_t>>> cache;
+
+    std::lock_guard<std::mutex> lock(mtxCache);
+    auto iter = cache.find(sDirectory);
+    if (cache.end() != iter)
+        return iter->second;
+
+    std::vector<std::pair<std::wstring, uint16_t>> vLangDirs;
+    std::vector<std::wstring> vNames;
+    std::wstring sErrorInfo;
+    ListSubdirectories(sDirectory.empty() ? L"." : sDirectory, vNames, sErrorInfo);
+    for (const std::wstring& sName : vNames)
+    {
+        uint16_t langId;
+        if (LangIdFromName(sName, langId))
+            vLangDirs.push_back(std::make_pair(sName, langId));
+    }
+    cache[sDirectory] = vLangDirs;
+    return vLangDirs;
+}
+
+std::vector<std::wstring> ResourceFile::LanguageDirectoryNames(const std::wstring& sFilePath)
+{
+    std::wstring sDirectory;
+    size_t ixLastPathSep = sFilePath.find_last_of(L"/\\");
+    if (std::wstring::npos != ixLastPathSep)
+        sDirectory = sFilePath.substr(0, ixLastPathSep + 1);
+    std::vector<std::wstring> vNames;
+    for (const auto& langDir : LanguageSubdirectories(sDirectory))
+        vNames.push_back(langDir.first);
+    return vNames;
+}
+
+/// <summary>
+/// If this is a language-neutral file, opens the satellite files in all of the language-named
+/// subdirectories of its directory (restricted to the language filter, if there is one).
+/// </summary>
+void ResourceFile::OpenAllMuiSatellites()
+{
+    if (!IsLanguageNeutral())
+        return;
+
+#ifdef _WIN32
+    const wchar_t chPathSep = L'\\';
+#else
+    const wchar_t chPathSep = L'/';
+#endif
+    std::wstring sDirectory;
+    size_t ixLastPathSep = m_sFilePath.find_last_of(L"/\\");
+    if (std::wstring::npos != ixLastPathSep)
+        sDirectory = m_sFilePath.substr(0, ixLastPathSep + 1);
+    const std::wstring sFileName = GetFileNameFromFilePath(m_sFilePath);
+
+    m_bListedLanguageDirectories = true;
+    for (const auto& langDir : LanguageSubdirectories(sDirectory))
+    {
+        if (!m_vLangFilter.empty() && m_vLangFilter.end() == std::find(m_vLangFilter.begin(), m_vLangFilter.end(), langDir.second))
+            continue;
+        std::wstring sMuiPath = sDirectory + langDir.first + chPathSep + sFileName + L".mui";
+        std::unique_ptr<ResourceFile> pMuiFile(new ResourceFile());
+        std::wstring sErrorInfo;
+        if (pMuiFile->OpenPE(sMuiPath, sErrorInfo))
+        {
+            pMuiFile->m_bAllLanguages = true;
+            pMuiFile->m_vLangFilter = m_vLangFilter;
+            m_vAllMuiFiles.push_back(std::move(pMuiFile));
+        }
+        else
+        {
+            m_vMuiFilesNotOpened.push_back(sMuiPath);
+        }
+    }
+}
+
+/// <summary>
+/// Returns the satellite file if it contains resources of the type, otherwise this file.
+/// </summary>
+const ResourceFile& ResourceFile::SourceFor(rsrctype_t type) const
+{
+    if (m_pMuiFile && m_pMuiFile->HasType(type))
+        return *m_pMuiFile;
+    return *this;
+}
+
+/// <summary>
+/// Returns a pointer into the mapped file for the cb bytes starting at the RVA,
+/// or nullptr if they aren't all within a section's raw data.
+/// </summary>
+const uint8_t* ResourceFile::RvaToPointer(uint32_t rva, uint32_t cb) const
+{
+    for (const Section_t& section : m_vSections)
+    {
+        const uint64_t cbSection = (section.virtualSize > section.sizeOfRawData ? section.virtualSize : section.sizeOfRawData);
+        if (rva >= section.virtualAddress && rva - section.virtualAddress < cbSection)
+        {
+            const uint64_t delta = rva - section.virtualAddress;
+            const uint64_t fileOffset = section.pointerToRawData + delta;
+            if (delta + cb > section.sizeOfRawData || fileOffset + cb > m_file.Size())
+                return nullptr;
+            return m_file.Data() + fileOffset;
+        }
+    }
+    return nullptr;
+}
+
+/// <summary>
+/// Validates that the directory at the offset and all its entries are within bounds,
+/// and returns the number of named entries and ID entries.
+/// </summary>
+bool ResourceFile::ReadDirectory(uint32_t offset, uint32_t& nNamed, uint32_t& nIds) const
+{
+    if (nullptr == m_pRsrcDir || (uint64_t)offset + cbResourceDirectory > m_cbRsrcDir)
+        return false;
+    nNamed = ReadU16(m_pRsrcDir + offset + 12);
+    nIds = ReadU16(m_pRsrcDir + offset + 14);
+    return ((uint64_t)offset + cbResourceDirectory + (uint64_t)(nNamed + nIds) * cbResourceDirectoryEntry <= m_cbRsrcDir);
+}
+
+/// <summary>
+/// Returns the address of a directory entry. Caller must have validated the directory with ReadDirectory.
+/// </summary>
+const uint8_t* ResourceFile::DirectoryEntry(uint32_t dirOffset, uint32_t ixEntry) const
+{
+    return m_pRsrcDir + dirOffset + cbResourceDirectory + ixEntry * cbResourceDirectoryEntry;
+}
+
+/// <summary>
+/// Gets the type/name/language identifier of a directory entry.
+/// </summary>
+bool ResourceFile::EntryId(const uint8_t* pEntry, RSRCID_t& id) const
+{
+    const uint32_t nameField = ReadU32(pEntry);
+    if (0 == (nameField & ResourceFlag_High))
+    {
+        id = RSRCID_t((uint16_t)nameField);
+        return true;
+    }
+    // IMAGE_RESOURCE_DIR_STRING_U: WORD length, followed by that many UTF-16 code units
+    const uint32_t strOffset = nameField & ~ResourceFlag_High;
+    if ((uint64_t)strOffset + sizeof(uint16_t) > m_cbRsrcDir)
+        return false;
+    const uint16_t cchName = ReadU16(m_pRsrcDir + strOffset);
+    // The name is used in place, so it must be two-byte aligned, as the PE format requires.
+    const uint8_t* pName = m_pRsrcDir + strOffset + sizeof(uint16_t);
+    if ((uint64_t)strOffset + sizeof(uint16_t) * (1 + (uint64_t)cchName) > m_cbRsrcDir || 0 != (uintptr_t)pName % alignof(uint16_t))
+        return false;
+    id = RSRCID_t((const uint16_t*)pName, cchName);
+    return true;
+}
+
+/// <summary>
+/// Finds the name-level directory for an integer resource type.
+/// </summary>
+bool ResourceFile::FindTypeDirectory(rsrctype_t type, uint32_t& offset) const
+{
+    uint32_t nNamed, nIds;
+    if (!ReadDirectory(0, nNamed, nIds))
+        return false;
+    for (uint32_t ixEntry = nNamed; ixEntry < nNamed + nIds; ++ixEntry)
+    {
+        const uint8_t* pEntry = DirectoryEntry(0, ixEntry);
+        const uint32_t dataField = ReadU32(pEntry + 4);
+        if ((uint32_t)type == ReadU32(pEntry) && 0 != (dataField & ResourceFlag_High))
+        {
+            offset = dataField & ~ResourceFlag_High;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ResourceFile::HasType(rsrctype_t type) const
+{
+    uint32_t offset;
+    return FindTypeDirectory(type, offset);
+}
+
+/// <summary>
+/// Indicates whether the file has a resource type with the specified (ASCII) name.
+/// </summary>
+bool ResourceFile::HasNamedType(const char* szType) const
+{
+    uint32_t nNamed, nIds;
+    if (!ReadDirectory(0, nNamed, nIds))
+        return false;
+    const size_t cchType = strlen(szType);
+    for (uint32_t ixEntry = 0; ixEntry < nNamed; ++ixEntry)
+    {
+        RSRCID_t id;
+        if (EntryId(DirectoryEntry(0, ixEntry), id) && !id.IsId() && cchType == id.m_cchName)
+        {
+            bool bMatch = true;
+            for (size_t ix = 0; bMatch && ix < cchType; ++ix)
+                bMatch = (id.m_pName[ix] == (uint16_t)szType[ix]);
+            if (bMatch)
+                return true;
+        }
+    }
+    return false;
+}
+
+/// <summary>
+/// Gets the data pointer and size from an IMAGE_RESOURCE_DATA_ENTRY.
+/// </summary>
+bool ResourceFile::ReadDataEntry(uint32_t offset, ResourceEntry_t& entry) const
+{
+    if ((uint64_t)offset + cbResourceDataEntry > m_cbRsrcDir)
+        return false;
+    const uint32_t rva = ReadU32(m_pRsrcDir + offset);
+    const uint32_t cb = ReadU32(m_pRsrcDir + offset + 4);
+    const uint8_t* pData = RvaToPointer(rva, cb);
+    if (nullptr == pData)
+        return false;
+    entry.pData = pData;
+    entry.cbData = cb;
+    return true;
+}
+
+/// <summary>
+/// From the language-level directory of a resource, picks the language the Windows resource loader would:
+/// an exact match for a preferred language; then a preferred language's primary language; then neutral,
+/// user default, system default, or US English; and finally whatever comes first.
+/// </summary>
+bool ResourceFile::SelectLanguage(uint32_t nameEntryData, ResourceEntry_t& entry) const
+{
+    if (0 == (nameEntryData & ResourceFlag_High))
+        return false;
+    const uint32_t langDir = nameEntryData & ~ResourceFlag_High;
+    uint32_t nNamed, nIds;
+    if (!ReadDirectory(langDir, nNamed, nIds) || 0 == nIds)
+        return false;
+
+    const uint16_t fallbacks[] = { LangId_Neutral, LangId_UserDefault, LangId_SystemDefault, LangId_EnglishUS };
+    const size_t nPreferred = m_vLangIds.size();
+    const size_t rankNone = 2 * nPreferred + sizeof(fallbacks) / sizeof(fallbacks[0]);
+    size_t bestRank = rankNone + 1;
+    const uint8_t* pBest = nullptr;
+    for (uint32_t ixEntry = nNamed; ixEntry < nNamed + nIds && bestRank > 0; ++ixEntry)
+    {
+        const uint8_t* pEntry = DirectoryEntry(langDir, ixEntry);
+        const uint16_t langId = (uint16_t)ReadU32(pEntry);
+        size_t rank = rankNone;
+        for (size_t ix = 0; ix < nPreferred && rank == rankNone; ++ix)
+        {
+            if (langId == m_vLangIds[ix])
+                rank = ix;
+        }
+        for (size_t ix = 0; ix < nPreferred && rank == rankNone; ++ix)
+        {
+            // Primary language is the low 10 bits of the LANGID
+            if ((langId & 0x3FF) == (m_vLangIds[ix] & 0x3FF))
+                rank = nPreferred + ix;
+        }
+        for (size_t ix = 0; ix < sizeof(fallbacks) / sizeof(fallbacks[0]) && rank == rankNone; ++ix)
+        {
+            if (langId == fallbacks[ix])
+                rank = 2 * nPreferred + ix;
+        }
+        if (rank < bestRank)
+        {
+            bestRank = rank;
+            pBest = pEntry;
+        }
+    }
+
+    const uint32_t dataField = ReadU32(pBest + 4);
+    if (0 != (dataField & ResourceFlag_High))
+        return false;
+    entry.langId = (uint16_t)ReadU32(pBest);
+    return ReadDataEntry(dataField, entry);
+}
+
+/// <summary>
+/// Reports every language in the language-level directory of a resource (that is in the language filter, if any).
+/// </summary>
+bool ResourceFile::EnumLanguages(uint32_t nameEntryData, ResourceEntry_t& entry, const Callback_t& callback, bool& bContinue) const
+{
+    if (0 == (nameEntryData & ResourceFlag_High))
+        return true;
+    const uint32_t langDir = nameEntryData & ~ResourceFlag_High;
+    uint32_t nNamed, nIds;
+    if (!ReadDirectory(langDir, nNamed, nIds))
+        return true;
+
+    for (uint32_t ixEntry = nNamed; ixEntry < nNamed + nIds; ++ixEntry)
+    {
+        const uint8_t* pEntry = DirectoryEntry(langDir, ixEntry);
+        const uint16_t langId = (uint16_t)ReadU32(pEntry);
+        if (!m_vLangFilter.empty() && m_vLangFilter.end() == std::find(m_vLangFilter.begin(), m_vLangFilter.end(), langId))
+            continue;
+        const uint32_t dataField = ReadU32(pEntry + 4);
+        if (0 != (dataField & ResourceFlag_High))
+            continue;
+        entry.langId = langId;
+        // Resources whose data can't be located are skipped, as they would be by LoadResource.
+        if (ReadDataEntry(dataField, entry) && !callback(entry))
+        {
+            bContinue = false;
+            break;
+        }
+    }
+    return true;
+}
+
+/// <summary>
+/// Enumerates the resources of one type, in resource directory order, one language per name.
+/// </summary>
+bool ResourceFile::EnumResources(rsrctype_t type, const Callback_t& callback, std::wstring& sErrorInfo) const
+{
+    sErrorInfo.clear();
+    if (m_bAllLanguages)
+    {
+        // This file, then each satellite file
+        bool bFound = false, bContinue = true;
+        uint32_t typeDir;
+        if (FindTypeDirectory(type, typeDir))
+        {
+            bFound = true;
+            if (!EnumTypeDirectory(type, typeDir, callback, bContinue, sErrorInfo))
+                return false;
+        }
+        for (size_t ixMui = 0; bContinue && ixMui < m_vAllMuiFiles.size(); ++ixMui)
+        {
+            const ResourceFile& muiFile = *m_vAllMuiFiles[ixMui];
+            if (muiFile.FindTypeDirectory(type, typeDir))
+            {
+                bFound = true;
+                if (!muiFile.EnumTypeDirectory(type, typeDir, callback, bContinue, sErrorInfo))
+                    return false;
+            }
+        }
+        if (!bFound)
+        {
+            if (nullptr == m_pRsrcDir && m_vAllMuiFiles.empty())
+                sErrorInfo = L"The specified image file did not contain a resource section.";
+            else
+                sErrorInfo = L"The specified resource type cannot be found in the image file.";
+            return false;
+        }
+        return true;
+    }
+
+    const ResourceFile& source = SourceFor(type);
+    if (nullptr == source.m_pRsrcDir)
+    {
+        sErrorInfo = L"The specified image file did not contain a resource section.";
+        return false;
+    }
+    uint32_t typeDir;
+    if (!source.FindTypeDirectory(type, typeDir))
+    {
+        sErrorInfo = L"The specified resource type cannot be found in the image file.";
+        return false;
+    }
+    bool bContinue = true;
+    return source.EnumTypeDirectory(type, typeDir, callback, bContinue, sErrorInfo);
+}
+
+/// <summary>
+/// Enumerates the resources of several types with a single pass over the resource directory
+/// of the file (and of its satellite file, for the types that it provides).
+/// </summary>
+bool ResourceFile::EnumResources(const std::vector<rsrctype_t>& vTypes, const Callback_t& callback, std::wstring& sErrorInfo) const
+{
+    sErrorInfo.clear();
+    bool bContinue = true;
+    if (m_bAllLanguages)
+    {
+        // This file, then each satellite file
+        if (!EnumTypesFrom(*this, vTypes, callback, bContinue, sErrorInfo))
+            return false;
+        for (size_t ixMui = 0; bContinue && ixMui < m_vAllMuiFiles.size(); ++ixMui)
+        {
+            if (!m_vAllMuiFiles[ixMui]->EnumTypesFrom(*this, vTypes, callback, bContinue, sErrorInfo))
+                return false;
+        }
+        return true;
+    }
+    if (m_pMuiFile && !m_pMuiFile->EnumTypesFrom(*this, vTypes, callback, bContinue, sErrorInfo))
+        return false;
+    return !bContinue || EnumTypesFrom(*this, vTypes, callback, bContinue, sErrorInfo);
+}
+
+/// <summary>
+/// Walks this file's root resource directory once, enumerating the resources of each of the listed
+/// types for which this file is the source (see SourceFor) on behalf of the file that was opened.
+/// </summary>
+bool ResourceFile::EnumTypesFrom(const ResourceFile& opened, const std::vector<rsrctype_t>& vTypes, const Callback_t& callback, bool& bContinue, std::wstring& sErrorInfo) const
+{
+    if (nullptr == m_pRsrcDir)
+        return true;
+    uint32_t nNamed, nIds;
+    if (!ReadDirectory(0, nNamed, nIds))
+    {
+        sErrorInfo = L"The resource directory is malformed.";
+        return false;
+    }
+    for (uint32_t ixEntry = nNamed; bContinue && ixEntry < nNamed + nIds; ++ixEntry)
+    {
+        const uint8_t* pEntry = DirectoryEntry(0, ixEntry);
+        const uint32_t typeId = ReadU32(pEntry);
+        const uint32_t dataField = ReadU32(pEntry + 4);
+        if (0 == (dataField & ResourceFlag_High))
+            continue;
+        for (rsrctype_t type : vTypes)
+        {
+            if ((uint32_t)type == typeId && (opened.m_bAllLanguages || this == &opened.SourceFor(type)))
+            {
+                if (!EnumTypeDirectory(type, dataField & ~ResourceFlag_High, callback, bContinue, sErrorInfo))
+                    return false;
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+/// <summary>
+/// Enumerates the resources in the name-level directory of one type.
+/// </summary>
+bool ResourceFile::EnumTypeDirectory(rsrctype_t type, uint32_t typeDir, const Callback_t& callback, bool& bContinue, std::wstring& sErrorInfo) const
+{
+    uint32_t nNamed, nIds;
+    if (!ReadDirectory(typeDir, nNamed, nIds))
+    {
+        sErrorInfo = L"The resource directory is malformed.";
+        return false;
+    }
+
+    for (uint32_t ixEntry = 0; ixEntry < nNamed + nIds; ++ixEntry)
+    {
+        const uint8_t* pEntry = DirectoryEntry(typeDir, ixEntry);
+        ResourceEntry_t entry;
+        entry.type = RSRCID_t((uint16_t)type);
+        if (!EntryId(pEntry, entry.name))
+        {
+            sErrorInfo = L"The resource directory is malformed.";
+            return false;
+        }
+        if (m_bAllLanguages)
+        {
+            EnumLanguages(ReadU32(pEntry + 4), entry, callback, bContinue);
+            if (!bContinue)
+                break;
+        }
+        // Resources whose data can't be located are skipped, as they would be by LoadResource.
+        else if (SelectLanguage(ReadU32(pEntry + 4), entry))
+        {
+            if (!callback(entry))
+            {
+                bContinue = false;
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+/// <summary>
+/// Indicates whether the file (or its satellite) has any resources of the specified type.
+/// </summary>
+bool ResourceFile::HasResourceType(rsrctype_t type) const
+{
+    for (const std::unique_ptr<ResourceFile>& pMuiFile : m_vAllMuiFiles)
+    {
+        if (pMuiFile->HasType(type))
+            return true;
+    }
+    return SourceFor(type).HasType(type);
+}
+
+/// <summary>
+/// Finds a resource by integer type and integer name, choosing the language the way the Windows resource loader does.
+/// </summary>
+bool ResourceFile::Find(rsrctype_t type, uint16_t id, ResourceEntry_t& entry) const
+{
+    const ResourceFile& source = SourceFor(type);
+    uint32_t typeDir, nNamed, nIds;
+    if (!source.FindTypeDirectory(type, typeDir) || !source.ReadDirectory(typeDir, nNamed, nIds))
+        return false;
+
+    // Integer IDs follow the named entries, in ascending order. Binary search, as the Windows loader does.
+    uint32_t ixLow = nNamed, ixHigh = nNamed + nIds;
+    while (ixLow < ixHigh)
+    {
+        const uint32_t ixMid = ixLow + (ixHigh - ixLow) / 2;
+        const uint8_t* pEntry = source.DirectoryEntry(typeDir, ixMid);
+        const uint32_t entryId = ReadU32(pEntry);
+        if (entryId == id)
+        {
+            entry.type = RSRCID_t((uint16_t)type);
+            entry.name = RSRCID_t(id);
+            return source.SelectLanguage(ReadU32(pEntry + 4), entry);
+        }
+        else if (entryId < id)
+            ixLow = ixMid + 1;
+        else
+            ixHigh = ixMid;
+    }
+    return false;
+}
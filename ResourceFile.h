@@ -0,0 +1,248 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+/*
+References:
+
+PE Format - Win32 apps | Microsoft Learn
+https://learn.microsoft.com/en-us/windows/win32/debug/pe-format#the-rsrc-section
+
+Peering Inside the PE: A Tour of the Win32 Portable Executable File Format | Microsoft Learn
+https://learn.microsoft.com/en-us/previous-versions/ms809762(v=msdn.10)
+*/
+
+/// <summary>
+/// Integer identifiers of the predefined resource types this program extracts text from.
+/// (The values behind RT_MENU, RT_DIALOG, RT_STRING, and RT_MESSAGETABLE.)
+/// </summary>
+enum class rsrctype_t : uint16_t
+{
+    eMenu = 4,
+    eDialog = 5,
+    eString = 6,
+    eMessageTable = 11
+};
+
+/// <summary>
+/// Resource types and names can be a name or an integer ID.
+/// A name is a view of the length-prefixed UTF-16 string in the resource directory; it is not zero-terminated.
+/// </summary>
+struct RSRCID_t
+{
+    RSRCID_t() : m_id(0), m_pName(nullptr), m_cchName(0) {}
+    explicit RSRCID_t(uint16_t id) : m_id(id), m_pName(nullptr), m_cchName(0) {}
+    RSRCID_t(const uint16_t* pName, uint16_t cchName) : m_id(0), m_pName(pName), m_cchName(cchName) {}
+
+    bool IsId() const { return nullptr == m_pName; }
+
+    uint16_t m_id;
+    const uint16_t* m_pName;
+    uint16_t m_cchName;
+};
+
+/// <summary>
+/// One resource: its type, name, and language, and a zero-copy view of its data in the mapped file.
+/// </summary>
+struct ResourceEntry_t
+{
+    RSRCID_t type;
+    RSRCID_t name;
+    uint16_t langId = 0;
+    const uint8_t* pData = nullptr;
+    uint32_t cbData = 0;
+};
+
+/// <summary>
+/// Memory-mapped Portable Executable (PE32 or PE32+) file, including resource-only .mui files,
+/// with in-place access to its resource directory (type, then name, then language).
+/// Does not use the Windows loader, so it works on any platform and with files for any architecture.
+///
+/// If the file is a language-neutral file with an associated .mui satellite file for one of the
+/// preferred languages, resources are retrieved from the satellite file when it contains them,
+/// as the Windows resource loader does.
+/// </summary>
+class ResourceFile
+{
+public:
+    ResourceFile();
+    ~ResourceFile();
+
+    /// <summary>
+    /// Maps the named file and locates its resource directory.
+    /// A file with no resources is not an error.
+    /// </summary>
+    /// <param name="sFilePath">Input: path to the PE file</param>
+    /// <param name="vLanguages">Input: preferred languages by name (e.g., "fr-FR"), most preferred first. Can be empty.</param>
+    /// <param name="sErrorInfo">Output: diagnostic information on failure</param>
+    /// <returns>true if successful, false otherwise</returns>
+    bool Open(const std::wstring& sFilePath, const std::vector<std::wstring>& vLanguages, std::wstring& sErrorInfo);
+
+    /// <summary>
+    /// Maps the named file for extraction of every language it contains, rather than one language per resource.
+    /// If the file is a language-neutral file, its .mui satellite files in all language-named subdirectories
+    /// are also used, so that one traversal gets the text of every installed language.
+    /// </summary>
+    /// <param name="sFilePath">Input: path to the PE file</param>
+    /// <param name="vLangFilter">Input: the languages to include; empty to include all languages</param>
+    /// <param name="sErrorInfo">Output: diagnostic information on failure</param>
+    /// <returns>true if successful, false otherwise</returns>
+    bool OpenAllLanguages(const std::wstring& sFilePath, const std::vector<uint16_t>& vLangFilter, std::wstring& sErrorInfo);
+
+    /// <summary>
+    /// Indicates whether the file was opened with OpenAllLanguages.
+    /// </summary>
+    bool AllLanguages() const { return m_bAllLanguages; }
+
+    /// <summary>
+    /// Error text from Open when the file isn't a Portable Executable file at all, as opposed to a damaged one.
+    /// </summary>
+    static const wchar_t* const szNotPEFile;
+
+    /// <summary>
+    /// Releases the file mapping(s).
+    /// </summary>
+    void Close();
+
+    /// <summary>
+    /// Path of the file, as passed to Open.
+    /// </summary>
+    const std::wstring& FilePath() const { return m_sFilePath; }
+
+    /// <summary>
+    /// Path of the .mui satellite file, if one was found; otherwise empty.
+    /// </summary>
+    const std::wstring& MuiFilePath() const;
+
+    /// <summary>
+    /// Paths of the .mui satellite files that Open or OpenAllLanguages looked for, for a language-neutral file, and
+    /// couldn't open (usually because they don't exist). If one of them appears, opening the file again would
+    /// find other resources.
+    /// </summary>
+    const std::vector<std::wstring>& MuiFilesNotOpened() const { return m_vMuiFilesNotOpened; }
+
+    /// <summary>
+    /// Indicates whether OpenAllLanguages listed the language-named subdirectories of the file's directory to look
+    /// for satellite files in (see LanguageDirectoryNames); that is, whether the file is language-neutral.
+    /// </summary>
+    bool ListedLanguageDirectories() const { return m_bListedLanguageDirectories; }
+
+    /// <summary>
+    /// Names of the language-named subdirectories of a file's directory, in name order, which OpenAllLanguages
+    /// looks for a language-neutral file's satellite files in. The listing of each directory is cached for the
+    /// life of the process.
+    /// </summary>
+    /// <param name="sFilePath">Input: path of a file in the directory</param>
+    static std::vector<std::wstring> LanguageDirectoryNames(const std::wstring& sFilePath);
+
+    /// <summary>
+    /// Callback for ForEachMappedFile, with a file's path and content.
+    /// </summary>
+    typedef std::function<void(const std::wstring& sFilePath, const uint8_t* pData, size_t cbData)> MappedFileCallback_t;
+
+    /// <summary>
+    /// Calls the callback for each file that resources are read from: this file, then the .mui satellite files
+    /// it was opened with, if any.
+    /// </summary>
+    void ForEachMappedFile(const MappedFileCallback_t& callback) const;
+
+    /// <summary>
+    /// Callback for resource enumeration. Return true to continue, false to stop enumerating.
+    /// </summary>
+    typedef std::function<bool(const ResourceEntry_t&)> Callback_t;
+
+    /// <summary>
+    /// Enumerates the resources of one type, in resource directory order (named resources first, then ascending IDs).
+    /// For each name, reports only the language that the Windows resource loader would choose; or, if the file was
+    /// opened with OpenAllLanguages, every included language, from this file and then from each satellite file.
+    /// </summary>
+    /// <param name="type">Input: integer resource type</param>
+    /// <param name="callback">Input: function to call for each resource</param>
+    /// <param name="sErrorInfo">Output: diagnostic information on failure</param>
+    /// <returns>true if successful; false if the type isn't present or the resource directory is malformed</returns>
+    bool EnumResources(rsrctype_t type, const Callback_t& callback, std::wstring& sErrorInfo) const;
+
+    /// <summary>
+    /// Enumerates the resources of several types in a single pass over the resource directory, rather than
+    /// one pass per type. Types that aren't present are skipped. Types are enumerated in resource directory
+    /// order (ascending type IDs), except that types provided by a .mui satellite file come first.
+    /// (If the file was opened with OpenAllLanguages, this file comes first, then each satellite file.)
+    /// </summary>
+    /// <param name="vTypes">Input: integer resource types</param>
+    /// <param name="callback">Input: function to call for each resource</param>
+    /// <param name="sErrorInfo">Output: diagnostic information on failure</param>
+    /// <returns>true if successful; false if the resource directory is malformed</returns>
+    bool EnumResources(const std::vector<rsrctype_t>& vTypes, const Callback_t& callback, std::wstring& sErrorInfo) const;
+
+    /// <summary>
+    /// Indicates whether the file (or its satellite) has any resources of the specified type.
+    /// </summary>
+    bool HasResourceType(rsrctype_t type) const;
+
+    /// <summary>
+    /// Finds a resource by integer type and integer name, choosing the language the way the Windows resource loader does.
+    /// </summary>
+    /// <param name="type">Input: integer resource type</param>
+    /// <param name="id">Input: integer resource name</param>
+    /// <param name="entry">Output: the resource, if found</param>
+    /// <returns>true if found, false otherwise</returns>
+    bool Find(rsrctype_t type, uint16_t id, ResourceEntry_t& entry) const;
+
+private:
+    bool OpenPE(const std::wstring& sFilePath, std::wstring& sErrorInfo);
+    void OpenMuiSatellite(const std::vector<std::wstring>& vLanguages);
+    void OpenAllMuiSatellites();
+    bool IsLanguageNeutral() const;
+    const ResourceFile& SourceFor(rsrctype_t type) const;
+    bool HasType(rsrctype_t type) const;
+    bool HasNamedType(const char* szType) const;
+
+    const uint8_t* RvaToPointer(uint32_t rva, uint32_t cb) const;
+    bool ReadDirectory(uint32_t offset, uint32_t& nNamed, uint32_t& nIds) const;
+    const uint8_t* DirectoryEntry(uint32_t dirOffset, uint32_t ixEntry) const;
+    bool EntryId(const uint8_t* pEntry, RSRCID_t& id) const;
+    bool FindTypeDirectory(rsrctype_t type, uint32_t& offset) const;
+    bool EnumTypesFrom(const ResourceFile& opened, const std::vector<rsrctype_t>& vTypes, const Callback_t& callback, bool& bContinue, std::wstring& sErrorInfo) const;
+    bool EnumTypeDirectory(rsrctype_t type, uint32_t typeDir, const Callback_t& callback, bool& bContinue, std::wstring& sErrorInfo) const;
+    bool SelectLanguage(uint32_t nameEntryData, ResourceEntry_t& entry) const;
+    bool EnumLanguages(uint32_t nameEntryData, ResourceEntry_t& entry, const Callback_t& callback, bool& bContinue) const;
+    bool ReadDataEntry(uint32_t offset, ResourceEntry_t& entry) const;
+
+    struct Section_t
+    {
+        uint32_t virtualAddress;
+        uint32_t virtualSize;
+        uint32_t pointerToRawData;
+        uint32_t sizeOfRawData;
+    };
+
+    std::wstring m_sFilePath;
+    MappedFile m_file;
+    std::vector<Section_t> m_vSections;
+    // Resource directory and the number of bytes available from there to the end of its section
+    const uint8_t* m_pRsrcDir;
+    uint32_t m_cbRsrcDir;
+    // Preferred languages, most preferred first
+    std::vector<uint16_t> m_vLangIds;
+    // Satellite .mui file associated with this language-neutral file, if any
+    std::unique_ptr<ResourceFile> m_pMuiFile;
+    // Opened with OpenAllLanguages: report every language (in m_vLangFilter, if not empty) from this file
+    // and all its satellite files
+    bool m_bAllLanguages;
+    std::vector<uint16_t> m_vLangFilter;
+    std::vector<std::unique_ptr<ResourceFile>> m_vAllMuiFiles;
+    // Satellite files that were looked for and not opened, and whether the language-named subdirectories were listed
+    // to look for them
+    std::vector<std::wstring> m_vMuiFilesNotOpened;
+    bool m_bListedLanguageDirectories;
+
+private:
+    // Not implemented
+    ResourceFile(const ResourceFile&) = delete;
+    ResourceFile& operator = (const ResourceFile&) = delete;
+};
@@ -0,0 +1,130 @@
+#include "PlatformDefs.h"
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include "ResourceValidation.h"
+#include "LanguageNames.h"
+
+validationstats_t::validationstats_t(const std::vector<rsrctype_t>& vTypesToValidate)
+{
+    for (rsrctype_t type : vTypesToValidate)
+    {
+        typestats_t typeStats;
+        typeStats.type = type;
+        vTypes.push_back(typeStats);
+    }
+}
+
+void validationstats_t::Add(const validationstats_t& other)
+{
+    nFiles += other.nFiles;
+    nPEFiles += other.nPEFiles;
+    nDirectoryProblems += other.nDirectoryProblems;
+    for (size_t ixType = 0; ixType < vTypes.size() && ixType < other.vTypes.size(); ++ixType)
+    {
+        vTypes[ixType].nResources += other.vTypes[ixType].nResources;
+        vTypes[ixType].cbData += other.vTypes[ixType].cbData;
+        vTypes[ixType].nProblems += other.vTypes[ixType].nProblems;
+        vTypes[ixType].decodeTime += other.vTypes[ixType].decodeTime;
+    }
+}
+
+void WriteValidationHeaders(std::wostream& out)
+{
+    out
+        << L"Type\t"
+        << L"Resource\t"
+        << L"Language\t"
+        << L"Problem"
+        << L'\n';
+}
+
+/// <summary>
+/// Visitor that ignores the text: validation only needs the decoders' diagnostics.
+/// </summary>
+class DiscardingVisitor : public ResourceVisitor
+{
+public:
+    void Visit(const ResourceEntry_t&, const textview_t&) override {}
+};
+
+bool ValidateResources(const ResourceFile& rsrcFile, std::wostream& out, validationstats_t& stats)
+{
+    std::vector<rsrctype_t> vTypes;
+    for (const validationstats_t::typestats_t& typeStats : stats.vTypes)
+        vTypes.push_back(typeStats.type);
+    // Decoders report problems on their error stream; the text they decode isn't needed.
+    std::wostringstream decodeErr;
+    DiscardingVisitor discard;
+    bool bValid = true;
+
+    std::wstring sErrorInfo;
+    bool ret = rsrcFile.EnumResources(
+        vTypes,
+        [&](const ResourceEntry_t& entry)
+        {
+            for (size_t ixType = 0; ixType < vTypes.size(); ++ixType)
+            {
+                if ((uint16_t)vTypes[ixType] == entry.type.m_id)
+                {
+                    const resourceextractor_t& extractor = ResourceExtractor(vTypes[ixType]);
+                    validationstats_t::typestats_t& typeStats = stats.vTypes[ixType];
+                    decodeErr.str(std::wstring());
+                    // A decoder's return value only says whether to continue with its type; keep going to
+                    // find every problem.
+                    const auto start = std::chrono::steady_clock::now();
+                    extractor.pfnDecodeResource(entry, discard, decodeErr);
+                    typeStats.decodeTime += std::chrono::steady_clock::now() - start;
+                    ++typeStats.nResources;
+                    typeStats.cbData += entry.cbData;
+                    if (!decodeErr.str().empty())
+                    {
+                        ++typeStats.nProblems;
+                        bValid = false;
+                        std::wostringstream prefix;
+                        prefix << extractor.szName << L'\t' << entry.name << L'\t' << LangIdToName(entry.langId) << L'\t';
+                        WriteLinesWithPrefix(out, escapeCrLfTabNul(decodeErr.str().substr(0, decodeErr.str().length() - 1)), prefix.str());
+                    }
+                    break;
+                }
+            }
+            return true;
+        },
+        sErrorInfo);
+
+    if (!ret)
+    {
+        ++stats.nDirectoryProblems;
+        out << L"resource directory\t\t\t" << escapeCrLfTabNul(sErrorInfo) << L'\n';
+        return false;
+    }
+    return bValid;
+}
+
+void WriteValidationSummary(const validationstats_t& stats, std::chrono::nanoseconds elapsed, std::wostream& out)
+{
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    out
+        << L"Validated " << stats.nFiles << L" files (" << stats.nPEFiles << L" PE files) in "
+        << std::fixed << std::setprecision(3) << seconds << L" s" << std::endl;
+    if (stats.nDirectoryProblems > 0)
+        out << L"  resource directories that couldn't be enumerated: " << stats.nDirectoryProblems << std::endl;
+    for (const validationstats_t::typestats_t& typeStats : stats.vTypes)
+    {
+        const double decodeSeconds = std::chrono::duration<double>(typeStats.decodeTime).count();
+        const double megabytes = (double)typeStats.cbData / (1024.0 * 1024.0);
+        out
+            << L"  " << ResourceExtractor(typeStats.type).szName << L": "
+            << typeStats.nResources << L" resources, "
+            << std::setprecision(2) << megabytes << L" MB, "
+            << typeStats.nProblems << L" problems";
+        if (decodeSeconds > 0)
+        {
+            out
+                << L", " << std::setprecision(0) << (double)typeStats.nResources / decodeSeconds << L" resources/s, "
+                << std::setprecision(1) << megabytes / decodeSeconds << L" MB/s";
+        }
+        out << std::endl;
+    }
+    out << std::defaultfloat << std::setprecision(6);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ResourceExtraction.h"
+
+/// <summary>
+/// Counts from validating resources: for each resource type, how many resources were decoded, how much resource
+/// data, how many were malformed, and the time spent in the type's decoder.
+/// </summary>
+struct validationstats_t
+{
+    struct typestats_t
+    {
+        rsrctype_t type = rsrctype_t::eString;
+        uint64_t nResources = 0;
+        uint64_t cbData = 0;
+        uint64_t nProblems = 0;
+        std::chrono::nanoseconds decodeTime = std::chrono::nanoseconds(0);
+    };
+
+    // Files inspected, and those that were PE files
+    uint64_t nFiles = 0;
+    uint64_t nPEFiles = 0;
+    // Resource directories that couldn't be enumerated
+    uint64_t nDirectoryProblems = 0;
+    std::vector<typestats_t> vTypes;
+
+    explicit validationstats_t(const std::vector<rsrctype_t>& vTypesToValidate = AllExtractableTypes());
+    void Add(const validationstats_t& other);
+};
+
+/// <summary>
+/// Writes the tab-delimited headers for validation output.
+/// </summary>
+void WriteValidationHeaders(std::wostream& out);
+
+/// <summary>
+/// Decodes every resource of the specified types in a file with its type's decoder, discarding the text, and
+/// writes a tab-delimited line for each problem found: resource type, resource name/ID, language, and the
+/// decoder's diagnostic text. A resource directory that can't be enumerated is reported as a problem too.
+/// The decoders check every read against the size of the resource, so that arbitrary bytes can be inspected
+/// safely; this exercises them over a corpus of real or damaged files and measures their throughput.
+/// </summary>
+/// <param name="rsrcFile">The resource file to inspect</param>
+/// <param name="out">The output stream to write problems into, without headers</param>
+/// <param name="stats">Input/output: counts to add this file's counts to</param>
+/// <returns>true if no problems were found, false otherwise.</returns>
+bool ValidateResources(const ResourceFile& rsrcFile, std::wostream& out, validationstats_t& stats);
+
+/// <summary>
+/// Writes a summary of validation counts, with each decoder's throughput in resources and megabytes per second
+/// of decoding time (summed across worker threads, so that it's comparable between runs with different
+/// numbers of workers).
+/// </summary>
+/// <param name="stats">Input: validation counts</param>
+/// <param name="elapsed">Input: elapsed (wall clock) time of the whole validation</param>
+/// <param name="out">The output stream to write the summary into</param>
+void WriteValidationSummary(const validationstats_t& stats, std::chrono::nanoseconds elapsed, std::wostream& out);
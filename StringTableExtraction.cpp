@@ -1,8 +1,124 @@
-#include <Windows.h>
+#include "PlatformDefs.h"
 #include <iostream>
 #include "StringTableExtraction.h"
+#include "ResourceCursor.h"
+#include "ResourceExtraction.h"
 #include "UtilityFunctions.h"
 
+/// <summary>
+/// Writes the tab-delimited headers for string table output.
+/// </summary>
+void WriteStringTableHeaders(std::wostream& out)
+{
+    out
+        << L"String ID\t"
+        << L"Localized text\t"
+        << L"Orig localized text"
+        << L'\n';
+}
+
+/// <summary>
+/// Decodes one string table resource (a bundle of 16 strings).
+/// String resources are stored in blocks ("bundles") of 16 length-prefixed UTF-16 strings that are not
+/// zero-terminated. String ID n is at index (n % 16) in the bundle with resource ID (n / 16) + 1.
+/// </summary>
+bool DecodeStringBundle(const ResourceEntry_t& entry, std::vector<std::wstring>& vStrings)
+{
+    vStrings.clear();
+    CheckedResourceCursor cursor(entry.pData, entry.cbData);
+    while (vStrings.size() < 16 && cursor.Remaining() >= sizeof(uint16_t))
+    {
+        // Length prefix, followed by that many code units. Stop at a bundle that is truncated.
+        uint16_t cchString = 0;
+        utf16view_t chars;
+        if (!cursor.Read(cchString) || !cursor.ReadChars(cchString, chars))
+            return false;
+        vStrings.push_back(chars.str());
+    }
+    return true;
+}
+
+/// <summary>
+/// Decodes the strings in one string table resource (a bundle of 16 strings) in the current file.
+/// Each string is reported in place, from the length-prefixed code units in the bundle (or from a copy, if the
+/// bundle is at an odd address; see ResourceCursor::ReadChars).
+/// </summary>
+bool DecodeStringTableText(const ResourceEntry_t& entry, ResourceVisitor& visitor, std::wostream& err)
+{
+    // LoadString can't retrieve strings from named bundles, or from bundle 0 or above 4096.
+    if (!entry.name.IsId() || 0 == entry.name.m_id || entry.name.m_id > 4096)
+        return true;
+
+    const UINT uFirstID = (UINT)(entry.name.m_id - 1) << 4;
+    CheckedResourceCursor cursor(entry.pData, entry.cbData);
+    textview_t text;
+    UINT ixString = 0;
+    for (; ixString < 16 && cursor.Remaining() >= sizeof(uint16_t); ++ixString)
+    {
+        // Length prefix, followed by that many code units. Stop at a bundle that is truncated.
+        uint16_t cchString = 0;
+        cursor.Read(cchString);
+        if (!cursor.ReadChars(cchString, text.text))
+        {
+            err << L"String table resource " << entry.name << L" is truncated at string ID " << (uFirstID + ixString) << std::endl;
+            break;
+        }
+        // It is not possible to distinguish between a zero-length string and a non-existent resource;
+        // Empty strings aren't interesting and this won't report them.
+        if (cchString > 0)
+        {
+            text.id = uFirstID + ixString;
+            visitor.Visit(entry, text);
+        }
+    }
+    return true;
+}
+
+/// <summary>
+/// Writes a line of tab-delimited output for one string: its ID, and its text with CR, LF, TAB, and NUL
+/// escaped, with and without accelerators.
+/// </summary>
+void WriteStringTableText(const ResourceEntry_t& entry, const textview_t& text, TextArena& arena, std::wostream& out)
+{
+    (void)entry;
+    const arenatext_t escaped = EscapeCrLfTab(arena, ArenaText(arena, text.text), true);
+    out
+        << text.id << L"\t"
+        << RemoveAccelsFromText(arena, escaped) << L"\t"
+        << escaped
+        << L'\n';
+}
+
+/// <summary>
+/// Handle one string table resource (a bundle of 16 strings) in the current file.
+/// </summary>
+/// <param name="entry">The string table resource</param>
+/// <param name="streams">The output and error streams to write information into</param>
+/// <returns>Always returns true to continue enumeration</returns>
+bool ProcessStringTableResource(const ResourceEntry_t& entry, streams_t& streams)
+{
+    TextArena arena;
+    TextWriterVisitor writer(WriteStringTableText, arena, streams.WCout);
+    return DecodeStringTableText(entry, writer, streams.WCerr);
+}
+
+/// <summary>
+/// Gets the text of one string resource, as LoadString would. Only the one bundle that contains the string is read.
+/// </summary>
+bool FindStringResource(const ResourceFile& rsrcFile, uint16_t stringId, std::wstring& sText)
+{
+    ResourceEntry_t entry;
+    if (!rsrcFile.Find(rsrctype_t::eString, (uint16_t)((stringId >> 4) + 1), entry))
+        return false;
+
+    std::vector<std::wstring> vStrings;
+    DecodeStringBundle(entry, vStrings);
+    const size_t ixString = stringId & 0x0F;
+    if (ixString >= vStrings.size() || vStrings[ixString].empty())
+        return false;
+    sText = vStrings[ixString];
+    return true;
+}
 
 /// <summary>
 /// Outputs localized text in the module's string table as tab-delimited fields.
@@ -10,45 +126,27 @@
 /// and with accelerator characters removed. CR, LF, TAB, and embedded NUL characters
 /// are replaced in the output with \r, \n, \t, and \0.
 /// </summary>
-/// <param name="hModule">Handle to the module to inspect</param>
+/// <param name="rsrcFile">The resource file to inspect</param>
 /// <param name="streams">The output and error streams to write information into</param>
+/// <param name="nThreads">Input: maximum number of threads to decode a large file on; 0 for one per hardware thread</param>
 /// <returns>true if successful, false otherwise.</returns>
-bool StringTableExtraction(HMODULE hModule, streams_t& streams)
+bool StringTableExtraction(const ResourceFile& rsrcFile, streams_t& streams, unsigned int nThreads)
 {
     // Tab-delimited headers
-    streams.WCout
-        << L"String ID\t"
-        << L"Localized text\t"
-        << L"Orig localized text"
-        << std::endl;
+    WriteStringTableHeaders(streams.WCout);
+
+    // A file with no string table has nothing to report.
+    if (!rsrcFile.HasResourceType(rsrctype_t::eString))
+        return true;
 
-    // String table IDs must be between 0 and 65535.
-    // Because of the way string resources are stored and enumerated (blocks of 16 length-prefixed strings, not
-    // zero-terminated, it's far easier just to query for every possible ID and report the ones that we find, 
-    // and not terribly time-consuming.
-    for (UINT uID = 0; uID < 65536; uID++)
+    // Decode the bundles that are actually present rather than probing for all 65536 possible IDs.
+    // Bundles are enumerated in ascending resource ID order, so string IDs are reported in ascending order.
+    // Large files are decoded on several threads.
+    std::wstring sErrorInfo;
+    if (!ExtractResourcesOfType(rsrcFile, rsrctype_t::eString, streams.WCout, streams.WCerr, nThreads, sErrorInfo))
     {
-        // Optional use of LoadStringW where the caller doesn't need to preallocate a buffer to fill,
-        // passing 0 for the cchBufferMax parameter.
-        // The lpBuffer parameter is treated as the address of a wchar_t pointer, and receives a pointer
-        // to a read-only buffer containing the string data. That data is not guaranteed to be zero-terminated;
-        // the return value indicates how many characters the requested string contains.
-        // Note that it is not possible to distinguish between a zero-length string and a non-existent resource;
-        // Empty strings aren't interesting and this won't report them.
-        wchar_t* pszBuffer = nullptr;
-        int ret = LoadStringW(hModule, uID, (LPWSTR) &pszBuffer, 0);
-        if (0 != ret && nullptr != pszBuffer)
-        {
-            // wstring constructor that takes a pointer and the number of characters.
-            std::wstring sString(pszBuffer, ret);
-            // Replace CR, LF, and TAB with \r, \n, and \t
-            sString = escapeCrLfTabNul(sString);
-            streams.WCout
-                << uID << L"\t"
-                << RemoveAccelsFromText(sString) << L"\t"
-                << sString
-                << std::endl;
-        }
+        streams.WCerr << L"Cannot enumerate string table resources: " << sErrorInfo << std::endl;
+        return false;
     }
 
     return true;
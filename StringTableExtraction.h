@@ -1,6 +1,7 @@
 #pragma once
 
 #include "UtilityFunctions.h"
+#include "TextRecord.h"
 
 /// <summary>
 /// Outputs localized text in the module's string table as tab-delimited fields.
@@ -8,7 +9,56 @@
 /// and with accelerator characters removed. CR, LF, TAB, and embedded NUL characters
 /// are replaced in the output with \r, \n, \t, and \0.
 /// </summary>
-/// <param name="hModule">Handle to the module to inspect</param>
+/// <param name="rsrcFile">The resource file to inspect</param>
 /// <param name="streams">The output and error streams to write information into</param>
+/// <param name="nThreads">Input: maximum number of threads to decode a large file on; 0 for one per hardware thread</param>
 /// <returns>true if successful, false otherwise.</returns>
-bool StringTableExtraction(HMODULE hModule, streams_t& streams);
+bool StringTableExtraction(const ResourceFile& rsrcFile, streams_t& streams, unsigned int nThreads);
+
+/// <summary>
+/// Writes the tab-delimited headers for string table output.
+/// </summary>
+/// <param name="out">The output stream to write the headers into</param>
+void WriteStringTableHeaders(std::wostream& out);
+
+/// <summary>
+/// Outputs the localized text in one string table resource (a bundle of 16 strings), without headers.
+/// </summary>
+/// <param name="entry">The resource</param>
+/// <param name="streams">The output and error streams to write information into</param>
+/// <returns>true to continue enumeration; false if the resource is malformed</returns>
+bool ProcessStringTableResource(const ResourceEntry_t& entry, streams_t& streams);
+
+/// <summary>
+/// Decodes the text in one string table resource (a bundle of 16 strings), without escaping or accelerator removal.
+/// This is the decoding behind ProcessStringTableResource, for output other than tab-delimited text.
+/// </summary>
+/// <param name="entry">The resource</param>
+/// <param name="visitor">Input: visitor to report each non-empty string to</param>
+/// <param name="err">The error stream to write diagnostic information into</param>
+/// <returns>true to continue enumeration; false if the resource is malformed</returns>
+bool DecodeStringTableText(const ResourceEntry_t& entry, ResourceVisitor& visitor, std::wostream& err);
+
+/// <summary>
+/// Writes the tab-delimited output for one string that DecodeStringTableText reports.
+/// </summary>
+void WriteStringTableText(const ResourceEntry_t& entry, const textview_t& text, TextArena& arena, std::wostream& out);
+
+/// <summary>
+/// Decodes one string table resource (a bundle of 16 strings) without escaping or accelerator removal.
+/// String ID n is at index (n % 16) in the bundle with resource ID (n / 16) + 1.
+/// </summary>
+/// <param name="entry">The resource</param>
+/// <param name="vStrings">Output: the strings in the bundle, in order; strings that aren't present are empty.
+/// A bundle can have fewer than 16 strings.</param>
+/// <returns>true if successful; false if the bundle is truncated (vStrings has the strings before that point)</returns>
+bool DecodeStringBundle(const ResourceEntry_t& entry, std::vector<std::wstring>& vStrings);
+
+/// <summary>
+/// Gets the text of one string resource, as LoadString would, choosing the language the way the Windows resource loader does.
+/// </summary>
+/// <param name="rsrcFile">The resource file to inspect</param>
+/// <param name="stringId">Input: string resource ID</param>
+/// <param name="sText">Output: the string's text, without escaping or accelerator removal</param>
+/// <returns>true if found; false if the string doesn't exist, is empty, or its bundle is malformed</returns>
+bool FindStringResource(const ResourceFile& rsrcFile, uint16_t stringId, std::wstring& sText);
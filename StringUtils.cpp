@@ -1,8 +1,14 @@
 // String utilities
 
-#include <Windows.h>
+#include "PlatformDefs.h"
 #include <sstream>
 #include <locale>
+#include <cstring>
+#include <cwchar>
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#include <emmintrin.h>
+#define STRINGUTILS_SSE2
+#endif
 
 #include "StringUtils.h"
 
@@ -30,6 +36,22 @@ void SplitStringToVector(const std::wstring& strInput, wchar_t delim, std::vecto
 	} while (!ss.eof());
 }
 
+// ------------------------------------------------------------------------------------------
+/// <summary>
+/// Parses an unsigned decimal number, or hex with 0x (e.g., a string ID or message ID).
+/// </summary>
+bool ParseId(const std::wstring& sId, uint32_t maxValue, uint32_t& id)
+{
+	const bool bHex = StartsWith(sId, L"0x");
+	const wchar_t* szDigits = sId.c_str() + (bHex ? 2 : 0);
+	wchar_t* szEnd = nullptr;
+	unsigned long long ullId = wcstoull(szDigits, &szEnd, bHex ? 16 : 10);
+	if (0 == *szDigits || L'-' == *szDigits || nullptr == szEnd || 0 != *szEnd || ullId > maxValue)
+		return false;
+	id = (uint32_t)ullId;
+	return true;
+}
+
 // ------------------------------------------------------------------------------------------
 /// <summary>
 /// Convert a wstring in place to locale-sensitive upper-case
@@ -53,6 +75,391 @@ std::wstring& WString_To_Upper(std::wstring& str)
 	return str;
 }
 
+// ------------------------------------------------------------------------------------------
+// Escape CR, LF, TAB, and NUL characters
+
+/// <summary>
+/// Returns the index of the first character at or after ix that might need escaping (any code below 14,
+/// which includes NUL, TAB, LF, and CR), or nChars if there is none.
+/// </summary>
+static inline size_t FindEscapeCandidate(const wchar_t* pText, size_t ix, size_t nChars)
+{
+#ifdef STRINGUTILS_SSE2
+	// Test 16 bytes of text at a time.
+	const size_t nPerVector = sizeof(__m128i) / sizeof(wchar_t);
+	for (; ix + nPerVector <= nChars; ix += nPerVector)
+	{
+		const __m128i chars = _mm_loadu_si128((const __m128i*)(pText + ix));
+#if WCHAR_MAX == 0xFFFF
+		// Unsigned 16-bit code units: saturating subtraction leaves zero only for codes up to 13.
+		const __m128i candidates = _mm_cmpeq_epi16(_mm_subs_epu16(chars, _mm_set1_epi16(13)), _mm_setzero_si128());
+#else
+		// 32-bit code points are never negative, so a signed comparison works.
+		const __m128i candidates = _mm_cmplt_epi32(chars, _mm_set1_epi32(14));
+#endif
+		const unsigned int mask = (unsigned int)_mm_movemask_epi8(candidates);
+		if (0 != mask)
+		{
+			// Byte index of the lowest set bit, converted to a character index
+			unsigned int ixByte = 0;
+			while (0 == (mask & (1u << ixByte)))
+				++ixByte;
+			return ix + ixByte / sizeof(wchar_t);
+		}
+	}
+#endif
+	for (; ix < nChars; ++ix)
+	{
+		if ((uint32_t)pText[ix] < 14)
+			return ix;
+	}
+	return nChars;
+}
+
+/// <summary>
+/// Writes the text with all CR, LF, and TAB characters converted to \r, \n, \t in a single pass, and optionally
+/// embedded NUL characters converted to \0 (dropping a NUL at the end of the text).
+/// </summary>
+size_t EscapeCrLfTab(const wchar_t* pText, size_t nChars, bool bEscapeNul, wchar_t* pOut)
+{
+	wchar_t* pNext = pOut;
+	size_t ixRun = 0;
+	for (;;)
+	{
+		const size_t ix = FindEscapeCandidate(pText, ixRun, nChars);
+		memcpy(pNext, pText + ixRun, (ix - ixRun) * sizeof(wchar_t));
+		pNext += ix - ixRun;
+		if (ix == nChars)
+			break;
+		switch (pText[ix])
+		{
+		case L'\r':
+			*pNext++ = L'\\';
+			*pNext++ = L'r';
+			break;
+		case L'\n':
+			*pNext++ = L'\\';
+			*pNext++ = L'n';
+			break;
+		case L'\t':
+			*pNext++ = L'\\';
+			*pNext++ = L't';
+			break;
+		case L'\0':
+			if (!bEscapeNul)
+			{
+				*pNext++ = L'\0';
+			}
+			else if (ix != nChars - 1)
+			{
+				*pNext++ = L'\\';
+				*pNext++ = L'0';
+			}
+			break;
+		default:
+			*pNext++ = pText[ix];
+			break;
+		}
+		ixRun = ix + 1;
+	}
+	return (size_t)(pNext - pOut);
+}
+
+/// <summary>
+/// Indicates whether EscapeCrLfTab might change the text.
+/// </summary>
+bool MightNeedEscapeCrLfTab(const wchar_t* pText, size_t nChars)
+{
+	return FindEscapeCandidate(pText, 0, nChars) < nChars;
+}
+
+/// <summary>
+/// Appends text to the output, with all CR, LF, and TAB characters converted to \r, \n, \t in a single pass,
+/// and optionally embedded NUL characters converted to \0 (dropping a NUL at the end of the text).
+/// </summary>
+void AppendEscapedCrLfTab(std::wstring& sOut, const wchar_t* pText, size_t nChars, bool bEscapeNul)
+{
+	const size_t ixStart = sOut.length();
+	if (!MightNeedEscapeCrLfTab(pText, nChars))
+	{
+		sOut.append(pText, nChars);
+		return;
+	}
+	// Each character becomes at most two.
+	sOut.resize(ixStart + 2 * nChars);
+	sOut.resize(ixStart + EscapeCrLfTab(pText, nChars, bEscapeNul, &sOut[ixStart]));
+}
+
+// ------------------------------------------------------------------------------------------
+// UTF-16 and UTF-8 conversions
+
+/// <summary>
+/// Creates a wstring from UTF-16 code units, such as text in resource data.
+/// Where wchar_t is 16 bits (Windows), this is a direct copy. Where wchar_t is 32 bits,
+/// surrogate pairs are combined, and unpaired surrogates are replaced with U+FFFD.
+/// </summary>
+std::wstring WStringFromUtf16(const uint16_t* pText, size_t nChars)
+{
+#ifdef _WIN32
+	return std::wstring((const wchar_t*)pText, nChars);
+#else
+	std::wstring sResult(nChars, L'\0');
+	if (nChars > 0)
+		sResult.resize(Utf16ToWide(pText, nChars, &sResult[0]));
+	return sResult;
+#endif
+}
+
+/// <summary>
+/// Converts UTF-16 code units to wide characters in a buffer.
+/// </summary>
+size_t Utf16ToWide(const uint16_t* pText, size_t nChars, wchar_t* pOut)
+{
+#ifdef _WIN32
+	if (nChars > 0)
+		memcpy(pOut, pText, nChars * sizeof(wchar_t));
+	return nChars;
+#else
+	wchar_t* pNext = pOut;
+	for (size_t ix = 0; ix < nChars; ++ix)
+	{
+		uint32_t ch = pText[ix];
+		if (ch >= 0xD800 && ch <= 0xDBFF && ix + 1 < nChars && pText[ix + 1] >= 0xDC00 && pText[ix + 1] <= 0xDFFF)
+		{
+			ch = 0x10000 + ((ch - 0xD800) << 10) + (pText[++ix] - 0xDC00);
+		}
+		else if (ch >= 0xD800 && ch <= 0xDFFF)
+		{
+			ch = 0xFFFD;
+		}
+		*pNext++ = (wchar_t)ch;
+	}
+	return (size_t)(pNext - pOut);
+#endif
+}
+
+/// <summary>
+/// Creates a wstring from a zero-terminated sequence of UTF-16 code units.
+/// </summary>
+std::wstring WStringFromUtf16Sz(const uint16_t* szText)
+{
+	size_t nChars = 0;
+	while (0 != szText[nChars])
+		++nChars;
+	return WStringFromUtf16(szText, nChars);
+}
+
+/// <summary>
+/// Converts a wstring to UTF-16 code units.
+/// </summary>
+void WStringToUtf16(const std::wstring& str, std::vector<uint16_t>& vUtf16)
+{
+	vUtf16.clear();
+	vUtf16.reserve(str.length());
+	for (wchar_t ch : str)
+	{
+		const uint32_t cp = (uint32_t)ch;
+		if (cp > 0xFFFF)
+		{
+			vUtf16.push_back((uint16_t)(0xD800 + ((cp - 0x10000) >> 10)));
+			vUtf16.push_back((uint16_t)(0xDC00 + ((cp - 0x10000) & 0x3FF)));
+		}
+		else
+		{
+			vUtf16.push_back((uint16_t)cp);
+		}
+	}
+}
+
+/// <summary>
+/// Converts wide characters to UTF-8, combining surrogate pairs where wchar_t is 16 bits.
+/// </summary>
+size_t WideToUtf8(const wchar_t* pText, size_t nChars, char* pOut)
+{
+	char* pNext = pOut;
+	size_t ix = 0;
+	while (ix < nChars)
+	{
+#ifdef STRINGUTILS_SSE2
+		// Copy ASCII 8 characters at a time, narrowing each to a byte.
+		while (ix + 8 <= nChars)
+		{
+#if WCHAR_MAX == 0xFFFF
+			const __m128i chars = _mm_loadu_si128((const __m128i*)(pText + ix));
+			if (0xFFFF != _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(chars, _mm_set1_epi16((short)0xFF80)), _mm_setzero_si128())))
+				break;
+			_mm_storel_epi64((__m128i*)pNext, _mm_packus_epi16(chars, chars));
+#else
+			const __m128i chars0 = _mm_loadu_si128((const __m128i*)(pText + ix));
+			const __m128i chars1 = _mm_loadu_si128((const __m128i*)(pText + ix + 4));
+			const __m128i nonAscii = _mm_and_si128(_mm_or_si128(chars0, chars1), _mm_set1_epi32((int)0xFFFFFF80));
+			if (0xFFFF != _mm_movemask_epi8(_mm_cmpeq_epi32(nonAscii, _mm_setzero_si128())))
+				break;
+			const __m128i units = _mm_packs_epi32(chars0, chars1);
+			_mm_storel_epi64((__m128i*)pNext, _mm_packus_epi16(units, units));
+#endif
+			ix += 8;
+			pNext += 8;
+		}
+		if (ix >= nChars)
+			break;
+#endif
+		uint32_t ch = (uint32_t)pText[ix++];
+		// Combine surrogate pairs where wchar_t is 16 bits
+		if (ch >= 0xD800 && ch <= 0xDBFF && ix < nChars && (uint32_t)pText[ix] >= 0xDC00 && (uint32_t)pText[ix] <= 0xDFFF)
+			ch = 0x10000 + ((ch - 0xD800) << 10) + ((uint32_t)pText[ix++] - 0xDC00);
+		else if ((ch >= 0xD800 && ch <= 0xDFFF) || ch > 0x10FFFF)
+			ch = 0xFFFD;
+
+		if (ch < 0x80)
+		{
+			*pNext++ = (char)ch;
+		}
+		else if (ch < 0x800)
+		{
+			*pNext++ = (char)(0xC0 | (ch >> 6));
+			*pNext++ = (char)(0x80 | (ch & 0x3F));
+		}
+		else if (ch < 0x10000)
+		{
+			*pNext++ = (char)(0xE0 | (ch >> 12));
+			*pNext++ = (char)(0x80 | ((ch >> 6) & 0x3F));
+			*pNext++ = (char)(0x80 | (ch & 0x3F));
+		}
+		else
+		{
+			*pNext++ = (char)(0xF0 | (ch >> 18));
+			*pNext++ = (char)(0x80 | ((ch >> 12) & 0x3F));
+			*pNext++ = (char)(0x80 | ((ch >> 6) & 0x3F));
+			*pNext++ = (char)(0x80 | (ch & 0x3F));
+		}
+	}
+	return (size_t)(pNext - pOut);
+}
+
+/// <summary>
+/// Converts a wstring to UTF-8 (e.g., for file paths on non-Windows platforms).
+/// </summary>
+std::string WStringToUtf8(const std::wstring& str)
+{
+	std::string sResult(str.length() * nMaxUtf8BytesPerWchar, '\0');
+	if (!str.empty())
+		sResult.resize(WideToUtf8(str.data(), str.length(), &sResult[0]));
+	return sResult;
+}
+
+/// <summary>
+/// Converts UTF-8 text to wide characters, validating it. Runs of ASCII are copied 16 bytes at a time with SSE2.
+/// </summary>
+std::wstring WStringFromUtf8(const char* pText, size_t cbText)
+{
+	std::wstring sResult;
+	sResult.resize(cbText);
+	wchar_t* pOut = &sResult[0];
+	size_t nOut = 0;
+	const unsigned char* p = (const unsigned char*)pText;
+	size_t ix = 0;
+	while (ix < cbText)
+	{
+#ifdef STRINGUTILS_SSE2
+		// Widen ASCII 16 bytes at a time.
+		while (ix + 16 <= cbText)
+		{
+			const __m128i bytes = _mm_loadu_si128((const __m128i*)(p + ix));
+			if (0 != _mm_movemask_epi8(bytes))
+				break;
+			const __m128i lo = _mm_unpacklo_epi8(bytes, _mm_setzero_si128());
+			const __m128i hi = _mm_unpackhi_epi8(bytes, _mm_setzero_si128());
+#if WCHAR_MAX == 0xFFFF
+			_mm_storeu_si128((__m128i*)(pOut + nOut), lo);
+			_mm_storeu_si128((__m128i*)(pOut + nOut + 8), hi);
+#else
+			_mm_storeu_si128((__m128i*)(pOut + nOut), _mm_unpacklo_epi16(lo, _mm_setzero_si128()));
+			_mm_storeu_si128((__m128i*)(pOut + nOut + 4), _mm_unpackhi_epi16(lo, _mm_setzero_si128()));
+			_mm_storeu_si128((__m128i*)(pOut + nOut + 8), _mm_unpacklo_epi16(hi, _mm_setzero_si128()));
+			_mm_storeu_si128((__m128i*)(pOut + nOut + 12), _mm_unpackhi_epi16(hi, _mm_setzero_si128()));
+#endif
+			ix += 16;
+			nOut += 16;
+		}
+		if (ix >= cbText)
+			break;
+#endif
+		uint32_t ch = p[ix];
+		if (ch < 0x80)
+		{
+			pOut[nOut++] = (wchar_t)ch;
+			++ix;
+			continue;
+		}
+		// Number of continuation bytes, and the smallest code point that may use that many (to reject overlong forms)
+		size_t nTrail = 0;
+		uint32_t chMin = 0;
+		bool bValid = true;
+		if ((ch & 0xE0) == 0xC0)
+		{
+			nTrail = 1;
+			ch &= 0x1F;
+			chMin = 0x80;
+		}
+		else if ((ch & 0xF0) == 0xE0)
+		{
+			nTrail = 2;
+			ch &= 0x0F;
+			chMin = 0x800;
+		}
+		else if ((ch & 0xF8) == 0xF0)
+		{
+			nTrail = 3;
+			ch &= 0x07;
+			chMin = 0x10000;
+		}
+		else
+		{
+			bValid = false;
+		}
+
+		if (ix + nTrail >= cbText)
+			bValid = false;
+		for (size_t ixTrail = 1; bValid && ixTrail <= nTrail; ++ixTrail)
+		{
+			if ((p[ix + ixTrail] & 0xC0) != 0x80)
+				bValid = false;
+			else
+				ch = (ch << 6) | (p[ix + ixTrail] & 0x3F);
+		}
+		if (!bValid || ch < chMin || ch > 0x10FFFF || (ch >= 0xD800 && ch <= 0xDFFF))
+		{
+			pOut[nOut++] = (wchar_t)0xFFFD;
+			++ix;
+			continue;
+		}
+		ix += nTrail + 1;
+#ifdef _WIN32
+		// A 4-byte sequence becomes a surrogate pair, so the output never outgrows the input.
+		if (ch >= 0x10000)
+		{
+			pOut[nOut++] = (wchar_t)(0xD800 + ((ch - 0x10000) >> 10));
+			pOut[nOut++] = (wchar_t)(0xDC00 + ((ch - 0x10000) & 0x3FF));
+			continue;
+		}
+#endif
+		pOut[nOut++] = (wchar_t)ch;
+	}
+	sResult.resize(nOut);
+	return sResult;
+}
+
+/// <summary>
+/// Converts UTF-8 text to a wstring (e.g., for command-line arguments on non-Windows platforms).
+/// Invalid sequences are replaced with U+FFFD.
+/// </summary>
+std::wstring Utf8ToWString(const std::string& str)
+{
+	return WStringFromUtf8(str.data(), str.length());
+}
+
+#ifdef _WIN32
 // ----------------------------------------------------------------------------------------------------
 // Date/time-related string manipulation
 
@@ -145,6 +552,8 @@ std::wstring TimestampUTCforFilepath(bool bIncludeMilliseconds /*= false*/)
 	return SystemTimeToWString(st, bIncludeMilliseconds, true);
 }
 
+#endif
+
 // ------------------------------------------------------------------------------------------
 // File system path string manipulation
 
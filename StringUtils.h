@@ -3,6 +3,8 @@
 #include <string>
 #include <sstream>
 #include <vector>
+#include <cstdint>
+#include "PlatformDefs.h"
 
 // ------------------------------------------------------------------------------------------
 // StartsWith, EndsWith, SplitStringToVector
@@ -45,6 +47,16 @@ inline bool EndsWith(const std::wstring& str, wchar_t chr)
 /// <param name="elems">Output: vector of substrings</param>
 void SplitStringToVector(const std::wstring& strInput, wchar_t delim, std::vector<std::wstring>& elems);
 
+// ------------------------------------------------------------------------------------------
+/// <summary>
+/// Parses an unsigned decimal number, or hex with 0x (e.g., a string ID or message ID).
+/// </summary>
+/// <param name="sId">Input: the number as text</param>
+/// <param name="maxValue">Input: the largest value allowed</param>
+/// <param name="id">Output: the number</param>
+/// <returns>true if sId is a number no greater than maxValue, false otherwise</returns>
+bool ParseId(const std::wstring& sId, uint32_t maxValue, uint32_t& id);
+
 // ------------------------------------------------------------------------------------------
 /// <summary>
 /// Convert a wstring in place to locale-sensitive upper-case
@@ -144,6 +156,35 @@ inline std::string replaceEmbeddedNuls(const std::string& str)
     return sResult.str();
 }
 
+/// <summary>
+/// Writes text to a buffer, with all CR, LF, and TAB characters converted to \r, \n, \t in a single pass, and
+/// embedded NUL characters converted to \0 if bEscapeNul is true (see AppendEscapedCrLfTab).
+/// </summary>
+/// <param name="pText">Input: text to escape</param>
+/// <param name="nChars">Input: number of characters in the text</param>
+/// <param name="bEscapeNul">Input: true to escape embedded NUL characters as well</param>
+/// <param name="pOut">Output: buffer with room for 2 * nChars characters, which the text can't overlap</param>
+/// <returns>The number of characters written</returns>
+size_t EscapeCrLfTab(const wchar_t* pText, size_t nChars, bool bEscapeNul, wchar_t* pOut);
+
+/// <summary>
+/// Indicates whether the text has a character that EscapeCrLfTab might change (any code below 14). If not, the
+/// escaped text is the text itself.
+/// </summary>
+bool MightNeedEscapeCrLfTab(const wchar_t* pText, size_t nChars);
+
+/// <summary>
+/// Appends text to the output, with all CR, LF, and TAB characters converted to \r, \n, \t in a single pass.
+/// If bEscapeNul is true, embedded NUL characters are also converted to \0, and a NUL at the end of the text is dropped
+/// (as escapeCrLfTabNul does). Runs of text without those characters are copied in bulk; on x86/x64 they are found
+/// with SSE2.
+/// </summary>
+/// <param name="sOut">Output: buffer to append the escaped text to</param>
+/// <param name="pText">Input: text to escape</param>
+/// <param name="nChars">Input: number of characters in the text</param>
+/// <param name="bEscapeNul">Input: true to escape embedded NUL characters as well</param>
+void AppendEscapedCrLfTab(std::wstring& sOut, const wchar_t* pText, size_t nChars, bool bEscapeNul);
+
 /// <summary>
 /// Convert all CR, LF, and TAB characters in input string to \r, \n, \t
 /// </summary>
@@ -151,7 +192,9 @@ inline std::string replaceEmbeddedNuls(const std::string& str)
 /// <returns>String with replacements made</returns>
 inline std::wstring escapeCrLfTab(const std::wstring& str)
 {
-    return replaceStringAll(replaceStringAll(replaceStringAll(str, L"\r", L"\\r"), L"\n", L"\\n"), L"\t", L"\\t");
+    std::wstring sResult;
+    AppendEscapedCrLfTab(sResult, str.data(), str.length(), false);
+    return sResult;
 }
 
 inline std::string escapeCrLfTab(const std::string& str)
@@ -166,7 +209,9 @@ inline std::string escapeCrLfTab(const std::string& str)
 /// <returns>String with replacements made</returns>
 inline std::wstring escapeCrLfTabNul(const std::wstring& str)
 {
-    return replaceEmbeddedNuls(escapeCrLfTab(str));
+    std::wstring sResult;
+    AppendEscapedCrLfTab(sResult, str.data(), str.length(), true);
+    return sResult;
 }
 
 inline std::string escapeCrLfTabNul(const std::string& str)
@@ -174,6 +219,80 @@ inline std::string escapeCrLfTabNul(const std::string& str)
     return replaceEmbeddedNuls(escapeCrLfTab(str));
 }
 
+// ------------------------------------------------------------------------------------------
+// UTF-16 and UTF-8 conversions
+
+/// <summary>
+/// Creates a wstring from UTF-16 code units, such as text in resource data.
+/// Where wchar_t is 16 bits (Windows), this is a direct copy. Where wchar_t is 32 bits,
+/// surrogate pairs are combined, and unpaired surrogates are replaced with U+FFFD.
+/// </summary>
+/// <param name="pText">Input: pointer to UTF-16 code units</param>
+/// <param name="nChars">Input: number of UTF-16 code units</param>
+/// <returns>The text as a wstring</returns>
+std::wstring WStringFromUtf16(const uint16_t* pText, size_t nChars);
+
+/// <summary>
+/// Converts UTF-16 code units to wide characters, as WStringFromUtf16 does, into a buffer.
+/// </summary>
+/// <param name="pText">Input: pointer to UTF-16 code units</param>
+/// <param name="nChars">Input: number of UTF-16 code units</param>
+/// <param name="pOut">Output: buffer of at least nChars wide characters</param>
+/// <returns>Number of wide characters written to pOut</returns>
+size_t Utf16ToWide(const uint16_t* pText, size_t nChars, wchar_t* pOut);
+
+/// <summary>
+/// Creates a wstring from a zero-terminated sequence of UTF-16 code units.
+/// </summary>
+std::wstring WStringFromUtf16Sz(const uint16_t* szText);
+
+/// <summary>
+/// Converts a wstring to UTF-16 code units, the reverse of WStringFromUtf16. Where wchar_t is 32 bits,
+/// characters above U+FFFF become surrogate pairs.
+/// </summary>
+/// <param name="str">Input: the text</param>
+/// <param name="vUtf16">Output: the code units, replacing the vector's contents</param>
+void WStringToUtf16(const std::wstring& str, std::vector<uint16_t>& vUtf16);
+
+/// <summary>
+/// Maximum number of UTF-8 bytes that one wchar_t can produce: 3 for a UTF-16 code unit (a surrogate pair
+/// produces 4 bytes from two code units), 4 for a 32-bit code point.
+/// </summary>
+const size_t nMaxUtf8BytesPerWchar = (sizeof(wchar_t) == 2) ? 3 : 4;
+
+/// <summary>
+/// Converts wide characters to UTF-8. Where wchar_t is 16 bits, surrogate pairs are combined.
+/// Unpaired surrogates and values that aren't Unicode code points are replaced with U+FFFD.
+/// Runs of ASCII text are converted several characters at a time (with SSE2 on x86/x64).
+/// </summary>
+/// <param name="pText">Input: wide characters to convert</param>
+/// <param name="nChars">Input: number of wide characters</param>
+/// <param name="pOut">Output: buffer of at least nChars * nMaxUtf8BytesPerWchar bytes</param>
+/// <returns>Number of bytes written to pOut</returns>
+size_t WideToUtf8(const wchar_t* pText, size_t nChars, char* pOut);
+
+/// <summary>
+/// Converts a wstring to UTF-8 (e.g., for file paths on non-Windows platforms).
+/// </summary>
+std::string WStringToUtf8(const std::wstring& str);
+
+/// <summary>
+/// Converts UTF-8 text, such as UTF-8 message table entries, to a wstring. Invalid sequences (including
+/// overlong forms and encoded surrogates) are replaced with U+FFFD, one per invalid byte.
+/// Runs of ASCII text are converted several bytes at a time (with SSE2 on x86/x64).
+/// </summary>
+/// <param name="pText">Input: UTF-8 bytes</param>
+/// <param name="cbText">Input: number of bytes</param>
+/// <returns>The text as a wstring</returns>
+std::wstring WStringFromUtf8(const char* pText, size_t cbText);
+
+/// <summary>
+/// Converts UTF-8 text to a wstring (e.g., for command-line arguments on non-Windows platforms).
+/// Invalid sequences are replaced with U+FFFD.
+/// </summary>
+std::wstring Utf8ToWString(const std::string& str);
+
+#ifdef _WIN32
 // ------------------------------------------------------------------------------------------
 // Date/time-related string manipulation
 
@@ -222,6 +341,7 @@ std::wstring TimestampUTC(bool bIncludeMilliseconds = false);
 /// <param name="bIncludeMilliseconds">Input: whether to incorporate milliseconds in the output</param>
 /// <returns>Alpha-sortable timestamp string</returns>
 std::wstring TimestampUTCforFilepath(bool bIncludeMilliseconds = false);
+#endif
 
 // ------------------------------------------------------------------------------------------
 // File system path string manipulation
@@ -0,0 +1,349 @@
+#include "PlatformDefs.h"
+#include <iomanip>
+#include <sstream>
+#include "SyntheticFileGenerator.h"
+#include "FileOutput.h"
+#include "LanguageNames.h"
+#include "StringUtils.h"
+
+#ifdef _WIN32
+static const wchar_t chPathSep = L'\\';
+#else
+static const wchar_t chPathSep = L'/';
+#endif
+
+// MUI configuration resource (type "MUI", ID 1): signature and version, and the file types of a
+// language-neutral file and of its satellite files
+static const uint32_t MuiSignature = 0xFECDFECD;
+static const uint32_t MuiVersion = 0x00010000;
+static const uint32_t MuiFileType_LanguageNeutralMain = 0x11;
+static const uint32_t MuiFileType_LanguageNeutralMui = 0x12;
+// Size of the fixed part, before the type lists and language names
+static const uint32_t cbMuiHeader = 0x84;
+
+generatoroptions_t::generatoroptions_t()
+{
+    content.nStrings = 100;
+    content.nDialogs = 10;
+    content.nControls = 10;
+    content.dialogForm = templateform_t::eMixed;
+    content.nMenus = 10;
+    content.nMenuPopups = 4;
+    content.nMenuItems = 8;
+    content.menuDepth = 2;
+    content.menuForm = templateform_t::eMixed;
+    content.nMessages = 100;
+    content.vMessageEncodings = { messageencoding_t::eAnsi, messageencoding_t::eUnicode, messageencoding_t::eUtf8 };
+}
+
+/// <summary>
+/// Parses a number for a setting, within limits.
+/// </summary>
+static bool ParseCount(const std::wstring& sName, const std::wstring& sValue, uint32_t minValue, uint32_t maxValue, uint32_t& value, std::wstring& sErrorInfo)
+{
+    if (!ParseId(sValue, maxValue, value) || value < minValue)
+    {
+        sErrorInfo = sName + L" must be a number from " + std::to_wstring(minValue) + L" to " + std::to_wstring(maxValue);
+        return false;
+    }
+    return true;
+}
+
+static bool ParseFlag(const std::wstring& sName, const std::wstring& sValue, bool& bValue, std::wstring& sErrorInfo)
+{
+    if (L"0" != sValue && L"1" != sValue)
+    {
+        sErrorInfo = sName + L" must be 0 or 1";
+        return false;
+    }
+    bValue = (L"1" == sValue);
+    return true;
+}
+
+static bool ParseTemplateForm(const std::wstring& sName, const std::wstring& sValue, templateform_t& form, std::wstring& sErrorInfo)
+{
+    if (L"classic" == sValue)
+        form = templateform_t::eClassic;
+    else if (L"extended" == sValue)
+        form = templateform_t::eExtended;
+    else if (L"mixed" == sValue)
+        form = templateform_t::eMixed;
+    else
+    {
+        sErrorInfo = sName + L" must be classic, extended, or mixed";
+        return false;
+    }
+    return true;
+}
+
+bool ParseGeneratorSetting(const std::wstring& sSetting, generatoroptions_t& options, std::wstring& sErrorInfo)
+{
+    const size_t ixEquals = sSetting.find(L'=');
+    if (std::wstring::npos == ixEquals)
+    {
+        sErrorInfo = L"Setting is not name=value: " + sSetting;
+        return false;
+    }
+    const std::wstring sName = sSetting.substr(0, ixEquals);
+    const std::wstring sValue = sSetting.substr(ixEquals + 1);
+    syntheticcontent_t& content = options.content;
+
+    if (L"seed" == sName)
+        return ParseCount(sName, sValue, 0, 0xFFFFFFFF, options.seed, sErrorInfo);
+    if (L"files" == sName)
+        return ParseCount(sName, sValue, 1, 100000, options.nFiles, sErrorInfo);
+    if (L"strings" == sName)
+        return ParseCount(sName, sValue, 0, 65536, content.nStrings, sErrorInfo);
+    // Dialog and menu IDs start at 100 and 200 and must fit in a WORD.
+    if (L"dialogs" == sName)
+        return ParseCount(sName, sValue, 0, 65000, content.nDialogs, sErrorInfo);
+    if (L"controls" == sName)
+        return ParseCount(sName, sValue, 0, 65535, content.nControls, sErrorInfo);
+    if (L"menus" == sName)
+        return ParseCount(sName, sValue, 0, 65000, content.nMenus, sErrorInfo);
+    if (L"menupopups" == sName)
+        return ParseCount(sName, sValue, 0, 1000, content.nMenuPopups, sErrorInfo);
+    if (L"menuitems" == sName)
+        return ParseCount(sName, sValue, 1, 1000, content.nMenuItems, sErrorInfo);
+    // Menus are built and encoded recursively, a level at a time.
+    if (L"menudepth" == sName)
+        return ParseCount(sName, sValue, 1, 1000, content.menuDepth, sErrorInfo);
+    if (L"messages" == sName)
+        return ParseCount(sName, sValue, 0, 1000000, content.nMessages, sErrorInfo);
+    if (L"dialogform" == sName)
+        return ParseTemplateForm(sName, sValue, content.dialogForm, sErrorInfo);
+    if (L"menuform" == sName)
+        return ParseTemplateForm(sName, sValue, content.menuForm, sErrorInfo);
+    if (L"mui" == sName)
+        return ParseFlag(sName, sValue, options.bMui, sErrorInfo);
+    if (L"named" == sName)
+        return ParseFlag(sName, sValue, content.bNamed, sErrorInfo);
+    if (L"misalign" == sName)
+        return ParseFlag(sName, sValue, options.bMisalign, sErrorInfo);
+    if (L"langs" == sName)
+    {
+        std::vector<uint16_t> vLangIds;
+        if (!LangIdsFromNameList(sValue, vLangIds, sErrorInfo))
+            return false;
+        if (vLangIds.empty())
+        {
+            sErrorInfo = L"langs must name at least one language";
+            return false;
+        }
+        options.vLangIds = vLangIds;
+        return true;
+    }
+    if (L"pe" == sName)
+    {
+        if (L"pe32" == sValue)
+            options.peFormat = peformat_t::ePE32;
+        else if (L"pe32+" == sValue)
+            options.peFormat = peformat_t::ePE32Plus;
+        else if (L"mixed" == sValue)
+            options.peFormat = peformat_t::eMixed;
+        else
+        {
+            sErrorInfo = L"pe must be pe32, pe32+, or mixed";
+            return false;
+        }
+        return true;
+    }
+    if (L"encoding" == sName)
+    {
+        if (L"ansi" == sValue)
+            content.vMessageEncodings = { messageencoding_t::eAnsi };
+        else if (L"unicode" == sValue)
+            content.vMessageEncodings = { messageencoding_t::eUnicode };
+        else if (L"utf8" == sValue)
+            content.vMessageEncodings = { messageencoding_t::eUtf8 };
+        else if (L"mixed" == sValue)
+            content.vMessageEncodings = { messageencoding_t::eAnsi, messageencoding_t::eUnicode, messageencoding_t::eUtf8 };
+        else
+        {
+            sErrorInfo = L"encoding must be ansi, unicode, utf8, or mixed";
+            return false;
+        }
+        return true;
+    }
+    sErrorInfo = L"Unrecognized setting: " + sName;
+    return false;
+}
+
+// --------------------------------------------------------------------------------------------------------------
+
+static void AppendU32(std::vector<uint8_t>& vData, uint32_t value)
+{
+    for (int ixByte = 0; ixByte < 4; ++ixByte)
+        vData.push_back((uint8_t)(value >> (8 * ixByte)));
+}
+
+/// <summary>
+/// Encodes a MUI configuration resource: the fixed part (signature, size, version, file type, checksums, and
+/// the offset and size of each variable part), then the list of resource type IDs in the satellite files, and
+/// a language list of one name, double-zero-terminated: the satellite's own language, or the language-neutral
+/// file's fallback language.
+/// </summary>
+static std::vector<uint8_t> EncodeMuiResource(bool bSatellite, const std::vector<uint32_t>& vMuiTypes, const std::wstring& sLanguage)
+{
+    std::vector<uint8_t> vTypes;
+    for (uint32_t type : vMuiTypes)
+        AppendU32(vTypes, type);
+    std::vector<uint8_t> vLanguage;
+    for (uint16_t unit : EncodeUtf16(sLanguage))
+    {
+        vLanguage.push_back((uint8_t)unit);
+        vLanguage.push_back((uint8_t)(unit >> 8));
+    }
+    vLanguage.resize(vLanguage.size() + 2 * sizeof(uint16_t), 0);
+
+    const uint32_t ofsTypes = cbMuiHeader;
+    const uint32_t ofsLanguage = ofsTypes + (uint32_t)vTypes.size();
+    const uint32_t cbResource = ofsLanguage + (uint32_t)vLanguage.size();
+    std::vector<uint8_t> vData;
+    AppendU32(vData, MuiSignature);
+    AppendU32(vData, cbResource);
+    AppendU32(vData, MuiVersion);
+    // Path type
+    AppendU32(vData, 0);
+    AppendU32(vData, bSatellite ? MuiFileType_LanguageNeutralMui : MuiFileType_LanguageNeutralMain);
+    // System attributes and ultimate fallback location: none
+    AppendU32(vData, 0);
+    AppendU32(vData, 0);
+    // Service checksum and checksum (16 bytes each), reserved (24 bytes)
+    vData.resize(vData.size() + 16 + 16 + 24, 0);
+    // Main name types and main ID types: none
+    for (int ixField = 0; ixField < 4; ++ixField)
+        AppendU32(vData, 0);
+    // MUI name types: none; MUI ID types
+    AppendU32(vData, 0);
+    AppendU32(vData, 0);
+    AppendU32(vData, vTypes.empty() ? 0 : ofsTypes);
+    AppendU32(vData, (uint32_t)vTypes.size());
+    // Language (satellite), or fallback language (language-neutral file)
+    AppendU32(vData, bSatellite ? ofsLanguage : 0);
+    AppendU32(vData, bSatellite ? (uint32_t)vLanguage.size() : 0);
+    AppendU32(vData, bSatellite ? 0 : ofsLanguage);
+    AppendU32(vData, bSatellite ? 0 : (uint32_t)vLanguage.size());
+    vData.insert(vData.end(), vTypes.begin(), vTypes.end());
+    vData.insert(vData.end(), vLanguage.begin(), vLanguage.end());
+    return vData;
+}
+
+/// <summary>
+/// The resource types that the content has.
+/// </summary>
+static std::vector<uint32_t> ContentTypes(const syntheticcontent_t& content)
+{
+    std::vector<uint32_t> vTypes;
+    if (content.nMenus > 0)
+        vTypes.push_back((uint32_t)rsrctype_t::eMenu);
+    if (content.nDialogs > 0)
+        vTypes.push_back((uint32_t)rsrctype_t::eDialog);
+    if (content.nStrings > 0)
+        vTypes.push_back((uint32_t)rsrctype_t::eString);
+    if (content.nMessages > 0)
+        vTypes.push_back((uint32_t)rsrctype_t::eMessageTable);
+    return vTypes;
+}
+
+/// <summary>
+/// Seed of the text for one language of one file: different for every file and language, the same in every run.
+/// </summary>
+static uint32_t TextSeed(uint32_t seed, uint32_t ixFile, uint32_t ixLang)
+{
+    uint64_t value = ((uint64_t)seed << 32) ^ ((uint64_t)ixFile << 12) ^ ixLang;
+    // Finalizer of the SplitMix64 generator, so that nearby inputs give unrelated seeds
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return (uint32_t)(value ^ (value >> 31));
+}
+
+static std::wstring JoinPath(const std::wstring& sDirectory, const std::wstring& sName)
+{
+    if (sDirectory.empty() || L'/' == sDirectory.back() || L'\\' == sDirectory.back())
+        return sDirectory + sName;
+    return sDirectory + chPathSep + sName;
+}
+
+bool GenerateSyntheticFiles(const generatoroptions_t& options, const std::wstring& sDirectory, std::wostream& out, std::wostream& err)
+{
+    std::wstring sErrorInfo;
+    if (!CreateDirectoryPath(sDirectory, sErrorInfo))
+    {
+        err << L"Error: " << sErrorInfo << std::endl;
+        return false;
+    }
+    if (options.bMui)
+    {
+        for (uint16_t langId : options.vLangIds)
+        {
+            if (!CreateDirectoryPath(JoinPath(sDirectory, LangIdToName(langId)), sErrorInfo))
+            {
+                err << L"Error: " << sErrorInfo << std::endl;
+                return false;
+            }
+        }
+    }
+
+    const std::vector<uint32_t> vMuiTypes = ContentTypes(options.content);
+    size_t nFilesWritten = 0, nResources = 0;
+    uint64_t cbWritten = 0;
+    auto writeFile = [&](const std::wstring& sFilePath, const ResourceImageBuilder& builder, bool bPE32Plus)
+    {
+        const std::vector<uint8_t> vFile = builder.Build(bPE32Plus, options.bMisalign);
+        if (!WriteBinaryFile(sFilePath, vFile, sErrorInfo))
+        {
+            err << L"Error: " << sErrorInfo << std::endl;
+            return false;
+        }
+        out << sFilePath << L'\n';
+        ++nFilesWritten;
+        nResources += builder.ResourceCount();
+        cbWritten += vFile.size();
+        return true;
+    };
+
+    for (uint32_t ixFile = 0; ixFile < options.nFiles; ++ixFile)
+    {
+        const bool bPE32Plus =
+            peformat_t::ePE32Plus == options.peFormat ||
+            (peformat_t::eMixed == options.peFormat && 0 == ixFile % 2);
+        std::wstringstream strFileName;
+        strFileName << L"synthetic" << std::setw(4) << std::setfill(L'0') << (ixFile + 1) << L".dll";
+        const std::wstring sFileName = strFileName.str();
+
+        if (options.bMui)
+        {
+            // Language-neutral file with only the MUI resource, and a satellite file for each language
+            ResourceImageBuilder neutral;
+            neutral.Add(L"MUI", (uint16_t)1, 0, EncodeMuiResource(false, vMuiTypes, LangIdToName(options.vLangIds[0])));
+            if (!writeFile(JoinPath(sDirectory, sFileName), neutral, bPE32Plus))
+                return false;
+            for (uint32_t ixLang = 0; ixLang < (uint32_t)options.vLangIds.size(); ++ixLang)
+            {
+                const uint16_t langId = options.vLangIds[ixLang];
+                const std::wstring sLanguage = LangIdToName(langId);
+                ResourceImageBuilder satellite;
+                SyntheticText text(TextSeed(options.seed, ixFile, ixLang));
+                AddSyntheticResources(satellite, options.content, langId, text);
+                satellite.Add(L"MUI", (uint16_t)1, langId, EncodeMuiResource(true, vMuiTypes, sLanguage));
+                if (!writeFile(JoinPath(JoinPath(sDirectory, sLanguage), sFileName + L".mui"), satellite, bPE32Plus))
+                    return false;
+            }
+        }
+        else
+        {
+            ResourceImageBuilder builder;
+            for (uint32_t ixLang = 0; ixLang < (uint32_t)options.vLangIds.size(); ++ixLang)
+            {
+                SyntheticText text(TextSeed(options.seed, ixFile, ixLang));
+                AddSyntheticResources(builder, options.content, options.vLangIds[ixLang], text);
+            }
+            if (!writeFile(JoinPath(sDirectory, sFileName), builder, bPE32Plus))
+                return false;
+        }
+    }
+
+    err << L"Wrote " << nFilesWritten << L" files with " << nResources << L" resources, " << cbWritten << L" bytes" << std::endl;
+    return true;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "SyntheticPE.h"
+
+/// <summary>
+/// Which PE format the generated files have.
+/// </summary>
+enum class peformat_t
+{
+    ePE32,
+    ePE32Plus,
+    // Alternating, starting with PE32+
+    eMixed
+};
+
+/// <summary>
+/// Options for GenerateSyntheticFiles, set from "name=value" settings with ParseGeneratorSetting.
+/// </summary>
+struct generatoroptions_t
+{
+    generatoroptions_t();
+
+    // Seed of the text and of the random choices; the same options produce the same files.
+    uint32_t seed = 1;
+    uint32_t nFiles = 1;
+    peformat_t peFormat = peformat_t::ePE32Plus;
+    // Languages of the resources
+    std::vector<uint16_t> vLangIds = { 0x0409 };
+    // If true, each file is language-neutral, with a .mui satellite file for each language in a subdirectory
+    // named for the language; otherwise each file has the resources in all the languages.
+    bool bMui = false;
+    // Each resource's data starts at an odd offset (see ResourceImageBuilder::Build).
+    bool bMisalign = false;
+    syntheticcontent_t content;
+};
+
+/// <summary>
+/// Applies one generator setting, "name=value", to the options. The settings are:
+///   seed=N          seed (default 1)
+///   files=N         number of files (default 1)
+///   pe=F            pe32, pe32+, or mixed (default pe32+)
+///   langs=L         comma-separated language names (default en-US)
+///   mui=0|1         language-neutral files with .mui satellite files (default 0)
+///   strings=N       string table strings, up to 65536 (default 100)
+///   dialogs=N       dialogs (default 10)
+///   controls=N      controls in each dialog (default 10)
+///   dialogform=F    classic, extended, or mixed (default mixed)
+///   menus=N         menus (default 10)
+///   menupopups=N    popups on each menu bar (default 4)
+///   menuitems=N     items at each level of a popup (default 8)
+///   menudepth=N     levels of nested popups, up to 1000 (default 2)
+///   menuform=F      classic, extended, or mixed (default mixed)
+///   messages=N      message table entries (default 100)
+///   encoding=E      message table entries' encoding: ansi, unicode, utf8, or mixed (default mixed)
+///   named=0|1       dialogs and menus named rather than numbered (default 0)
+///   misalign=0|1    resource data at odd offsets (default 0)
+/// </summary>
+/// <param name="sSetting">Input: the setting</param>
+/// <param name="options">Input/output: the options to change</param>
+/// <param name="sErrorInfo">Output: diagnostic information on failure</param>
+/// <returns>true if the setting was recognized and its value is valid, false otherwise</returns>
+bool ParseGeneratorSetting(const std::wstring& sSetting, generatoroptions_t& options, std::wstring& sErrorInfo);
+
+/// <summary>
+/// Writes synthetic resource files (see SyntheticPE.h) into a directory, e.g., for tests of the extractors on
+/// platforms without Windows binaries, and for scaling experiments with huge tables, deep nesting, and
+/// misaligned data. Files are named synthetic0001.dll, synthetic0002.dll, and so on; with options.bMui, the
+/// satellite files are named, e.g., fr-FR\synthetic0001.dll.mui.
+/// </summary>
+/// <param name="options">Input: what to generate</param>
+/// <param name="sDirectory">Input: the directory to write the files into, created if it doesn't exist</param>
+/// <param name="out">The output stream to write the path of each file into</param>
+/// <param name="err">The error stream to write a summary and diagnostic information into</param>
+/// <returns>true if all the files were written, false otherwise</returns>
+bool GenerateSyntheticFiles(const generatoroptions_t& options, const std::wstring& sDirectory, std::wostream& out, std::wostream& err);
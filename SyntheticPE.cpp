@@ -0,0 +1,873 @@
+#include "PlatformDefs.h"
+#include <cstring>
+#include "SyntheticPE.h"
+#include "CodePages.h"
+#include "LanguageNames.h"
+#include "StringUtils.h"
+
+// Layout of the synthetic PE file: headers in the first 0x400 bytes of the file, then the .rsrc section
+// at RVA 0x1000.
+static const uint32_t cbHeaders = 0x400;
+static const uint32_t rvaResources = 0x1000;
+static const uint32_t SectionAlignment = 0x1000;
+static const uint32_t FileAlignment = 0x200;
+static const uint32_t cbDosHeader = 0x40;
+static const uint32_t cbFileHeader = 20;
+static const uint32_t cbSectionHeader = 40;
+static const uint32_t cbResourceDirectory = 16;
+static const uint32_t cbResourceDirectoryEntry = 8;
+static const uint32_t cbResourceDataEntry = 16;
+static const uint32_t ResourceFlag_High = 0x80000000;
+
+// Dialog and menu template flags (see ResourceDefs.h)
+static const uint32_t Style_Popup = 0x80000000;
+static const uint32_t Style_ShellFont = 0x48;
+static const uint16_t MenuFlag_Popup = 0x0010;
+static const uint16_t MenuFlag_End = 0x0080;
+static const uint32_t MenuType_Separator = 0x0800;
+static const uint16_t MenuExFlag_Popup = 0x0001;
+static const uint16_t MenuExFlag_End = 0x0080;
+
+/// <summary>
+/// Little-endian writer that appends to a byte vector.
+/// </summary>
+class ByteWriter
+{
+public:
+    explicit ByteWriter(std::vector<uint8_t>& vBytes) : m_vBytes(vBytes) {}
+
+    size_t Size() const { return m_vBytes.size(); }
+
+    void U8(uint8_t value) { m_vBytes.push_back(value); }
+    void U16(uint16_t value) { Append(&value, sizeof(value)); }
+    void U32(uint32_t value) { Append(&value, sizeof(value)); }
+    void U64(uint64_t value) { Append(&value, sizeof(value)); }
+    void Append(const void* pData, size_t cb)
+    {
+        const uint8_t* pBytes = (const uint8_t*)pData;
+        m_vBytes.insert(m_vBytes.end(), pBytes, pBytes + cb);
+    }
+
+    /// <summary>
+    /// Pads with zeros to a multiple of the alignment, measured from the start of the vector.
+    /// </summary>
+    void AlignTo(size_t alignment)
+    {
+        while (0 != m_vBytes.size() % alignment)
+            m_vBytes.push_back(0);
+    }
+
+    /// <summary>
+    /// Writes UTF-16 code units for the text.
+    /// </summary>
+    void Utf16(const std::wstring& sText)
+    {
+        const std::vector<uint16_t> vUnits = EncodeUtf16(sText);
+        Append(vUnits.data(), vUnits.size() * sizeof(uint16_t));
+    }
+
+    /// <summary>
+    /// Writes zero-terminated UTF-16 text.
+    /// </summary>
+    void Utf16Sz(const std::wstring& sText)
+    {
+        Utf16(sText);
+        U16(0);
+    }
+
+    /// <summary>
+    /// Overwrites a value written earlier.
+    /// </summary>
+    template <typename T>
+    void Patch(size_t offset, T value)
+    {
+        memcpy(&m_vBytes[offset], &value, sizeof(value));
+    }
+
+private:
+    std::vector<uint8_t>& m_vBytes;
+};
+
+/// <summary>
+/// Number of UTF-16 code units in the text.
+/// </summary>
+static size_t Utf16Length(const std::wstring& sText)
+{
+    size_t nUnits = 0;
+    for (wchar_t ch : sText)
+        nUnits += ((uint32_t)ch > 0xFFFF) ? 2 : 1;
+    return nUnits;
+}
+
+std::vector<uint16_t> EncodeUtf16(const std::wstring& sText)
+{
+    std::vector<uint16_t> vUnits;
+    WStringToUtf16(sText, vUnits);
+    return vUnits;
+}
+
+/// <summary>
+/// Encodes text in a Windows ANSI code page, with the reverse of the decoder's table for a single-byte code page.
+/// </summary>
+class AnsiEncoder
+{
+public:
+    explicit AnsiEncoder(uint16_t codePage)
+    {
+        if (874 == codePage || (codePage >= 1250 && codePage <= 1258))
+        {
+            for (unsigned int byte = 0x80; byte <= 0xFF; ++byte)
+            {
+                const char ch = (char)byte;
+                const std::wstring sDecoded = WStringFromCodePage(&ch, 1, codePage);
+                if (1 == sDecoded.length())
+                    m_upperHalf.emplace(sDecoded[0], ch);
+            }
+        }
+    }
+
+    std::string Encode(const std::wstring& sText) const
+    {
+        std::string sAnsi;
+        sAnsi.reserve(sText.length());
+        for (wchar_t ch : sText)
+        {
+            if (ch < 0x80)
+            {
+                sAnsi += (char)ch;
+            }
+            else
+            {
+                const auto iter = m_upperHalf.find(ch);
+                sAnsi += (m_upperHalf.end() != iter) ? iter->second : '?';
+            }
+        }
+        return sAnsi;
+    }
+
+private:
+    std::map<wchar_t, char> m_upperHalf;
+};
+
+std::string EncodeAnsi(const std::wstring& sText, uint16_t codePage)
+{
+    return AnsiEncoder(codePage).Encode(sText);
+}
+
+// --------------------------------------------------------------------------------------------------------------
+
+bool synthid_t::operator < (const synthid_t& other) const
+{
+    if (IsId() != other.IsId())
+        return !IsId();
+    if (IsId())
+        return id < other.id;
+    return sName < other.sName;
+}
+
+void ResourceImageBuilder::Add(const synthid_t& type, const synthid_t& name, uint16_t langId, const std::vector<uint8_t>& vData)
+{
+    m_types[type][name][langId] = vData;
+}
+
+size_t ResourceImageBuilder::ResourceCount() const
+{
+    size_t nResources = 0;
+    for (const auto& type : m_types)
+        for (const auto& name : type.second)
+            nResources += name.second.size();
+    return nResources;
+}
+
+/// <summary>
+/// Lays out the resource section, then writes the headers in front of it.
+/// </summary>
+std::vector<uint8_t> ResourceImageBuilder::Build(bool bPE32Plus, bool bMisalignData) const
+{
+    const uint32_t dataMisalignment = bMisalignData ? 1 : 0;
+    // Sizes of each part of the resource section, to compute offsets before writing anything
+    uint32_t cbDirectories = cbResourceDirectory + (uint32_t)m_types.size() * cbResourceDirectoryEntry;
+    uint32_t nDataEntries = 0;
+    std::map<std::wstring, uint32_t> stringOffsets;
+    for (const auto& type : m_types)
+    {
+        if (!type.first.IsId())
+            stringOffsets[type.first.sName] = 0;
+        cbDirectories += cbResourceDirectory + (uint32_t)type.second.size() * cbResourceDirectoryEntry;
+        for (const auto& name : type.second)
+        {
+            if (!name.first.IsId())
+                stringOffsets[name.first.sName] = 0;
+            cbDirectories += cbResourceDirectory + (uint32_t)name.second.size() * cbResourceDirectoryEntry;
+            nDataEntries += (uint32_t)name.second.size();
+        }
+    }
+    uint32_t ofsStrings = cbDirectories + nDataEntries * cbResourceDataEntry;
+    uint32_t cbStrings = 0;
+    for (auto& str : stringOffsets)
+    {
+        str.second = ofsStrings + cbStrings;
+        cbStrings += (uint32_t)(sizeof(uint16_t) * (1 + Utf16Length(str.first)));
+    }
+
+    std::vector<uint8_t> vRsrc;
+    ByteWriter rsrc(vRsrc);
+    auto idField = [&stringOffsets](const synthid_t& id) -> uint32_t
+    {
+        return id.IsId() ? id.id : (ResourceFlag_High | stringOffsets[id.sName]);
+    };
+    auto writeDirectory = [&rsrc](size_t nNamed, size_t nIds)
+    {
+        rsrc.U32(0);
+        rsrc.U32(0);
+        rsrc.U16(4);
+        rsrc.U16(0);
+        rsrc.U16((uint16_t)nNamed);
+        rsrc.U16((uint16_t)nIds);
+    };
+    auto countNamed = [](const auto& entries)
+    {
+        size_t nNamed = 0;
+        for (const auto& entry : entries)
+            if (!entry.first.IsId())
+                ++nNamed;
+        return nNamed;
+    };
+
+    // Root directory, then the type directories, then all the name directories, breadth first
+    uint32_t ofsNext = cbResourceDirectory + (uint32_t)m_types.size() * cbResourceDirectoryEntry;
+    writeDirectory(countNamed(m_types), m_types.size() - countNamed(m_types));
+    for (const auto& type : m_types)
+    {
+        rsrc.U32(idField(type.first));
+        rsrc.U32(ResourceFlag_High | ofsNext);
+        ofsNext += cbResourceDirectory + (uint32_t)type.second.size() * cbResourceDirectoryEntry;
+    }
+    for (const auto& type : m_types)
+    {
+        writeDirectory(countNamed(type.second), type.second.size() - countNamed(type.second));
+        for (const auto& name : type.second)
+        {
+            rsrc.U32(idField(name.first));
+            rsrc.U32(ResourceFlag_High | ofsNext);
+            ofsNext += cbResourceDirectory + (uint32_t)name.second.size() * cbResourceDirectoryEntry;
+        }
+    }
+    uint32_t ofsDataEntry = cbDirectories;
+    for (const auto& type : m_types)
+    {
+        for (const auto& name : type.second)
+        {
+            writeDirectory(0, name.second.size());
+            for (const auto& lang : name.second)
+            {
+                rsrc.U32(lang.first);
+                rsrc.U32(ofsDataEntry);
+                ofsDataEntry += cbResourceDataEntry;
+            }
+        }
+    }
+
+    // Data entries, pointing at the data after the strings
+    uint32_t ofsData = ((ofsStrings + cbStrings + 7) & ~7u) + dataMisalignment;
+    for (const auto& type : m_types)
+    {
+        for (const auto& name : type.second)
+        {
+            for (const auto& lang : name.second)
+            {
+                rsrc.U32(rvaResources + ofsData);
+                rsrc.U32((uint32_t)lang.second.size());
+                rsrc.U32(0);
+                rsrc.U32(0);
+                ofsData = ((ofsData + (uint32_t)lang.second.size() + 7) & ~7u) + dataMisalignment;
+            }
+        }
+    }
+    for (const auto& str : stringOffsets)
+    {
+        rsrc.U16((uint16_t)Utf16Length(str.first));
+        rsrc.Utf16(str.first);
+    }
+    for (const auto& type : m_types)
+    {
+        for (const auto& name : type.second)
+        {
+            for (const auto& lang : name.second)
+            {
+                rsrc.AlignTo(8);
+                if (bMisalignData)
+                    rsrc.U8(0);
+                rsrc.Append(lang.second.data(), lang.second.size());
+            }
+        }
+    }
+
+    // Headers: DOS header pointing at the NT headers, file header, optional header, one section header
+    const uint32_t cbRsrc = (uint32_t)vRsrc.size();
+    const uint32_t cbRsrcRaw = (cbRsrc + FileAlignment - 1) & ~(FileAlignment - 1);
+    const uint32_t cbImage = rvaResources + ((cbRsrc + SectionAlignment - 1) & ~(SectionAlignment - 1));
+    const uint16_t cbOptionalHeader = bPE32Plus ? 240 : 224;
+    std::vector<uint8_t> vFile;
+    ByteWriter file(vFile);
+    file.U16(0x5A4D);
+    while (file.Size() < 0x3C)
+        file.U8(0);
+    file.U32(cbDosHeader);
+
+    file.Append("PE\0\0", 4);
+    file.U16(bPE32Plus ? 0x8664 : 0x014C);
+    file.U16(1);
+    file.U32(0);
+    file.U32(0);
+    file.U32(0);
+    file.U16(cbOptionalHeader);
+    // IMAGE_FILE_EXECUTABLE_IMAGE | IMAGE_FILE_DLL, and 32BIT_MACHINE or LARGE_ADDRESS_AWARE
+    file.U16(bPE32Plus ? 0x2022 : 0x2102);
+
+    file.U16(bPE32Plus ? 0x20B : 0x10B);
+    file.U16(0);
+    file.U32(0);
+    file.U32(cbRsrcRaw);
+    file.U32(0);
+    file.U32(0);
+    file.U32(0);
+    if (bPE32Plus)
+    {
+        file.U64(0x180000000);
+    }
+    else
+    {
+        file.U32(0);
+        file.U32(0x10000000);
+    }
+    file.U32(SectionAlignment);
+    file.U32(FileAlignment);
+    file.U16(6);
+    file.U16(0);
+    file.U16(10);
+    file.U16(0);
+    file.U16(6);
+    file.U16(0);
+    file.U32(0);
+    file.U32(cbImage);
+    file.U32(cbHeaders);
+    file.U32(0);
+    // IMAGE_SUBSYSTEM_WINDOWS_GUI; IMAGE_DLLCHARACTERISTICS_DYNAMIC_BASE | NX_COMPAT
+    file.U16(2);
+    file.U16(0x0140);
+    for (int ixSize = 0; ixSize < 4; ++ixSize)
+    {
+        if (bPE32Plus)
+            file.U64(0);
+        else
+            file.U32(0);
+    }
+    file.U32(0);
+    // 16 data directories; only the resource directory (index 2) is used.
+    file.U32(16);
+    for (uint32_t ixDirectory = 0; ixDirectory < 16; ++ixDirectory)
+    {
+        file.U32(2 == ixDirectory ? rvaResources : 0);
+        file.U32(2 == ixDirectory ? cbRsrc : 0);
+    }
+
+    file.Append(".rsrc\0\0\0", 8);
+    file.U32(cbRsrc);
+    file.U32(rvaResources);
+    file.U32(cbRsrcRaw);
+    file.U32(cbHeaders);
+    file.U32(0);
+    file.U32(0);
+    file.U16(0);
+    file.U16(0);
+    // IMAGE_SCN_CNT_INITIALIZED_DATA | IMAGE_SCN_MEM_READ
+    file.U32(0x40000040);
+
+    vFile.resize(cbHeaders, 0);
+    vFile.insert(vFile.end(), vRsrc.begin(), vRsrc.end());
+    vFile.resize(cbHeaders + cbRsrcRaw, 0);
+    return vFile;
+}
+
+// --------------------------------------------------------------------------------------------------------------
+
+std::vector<uint8_t> EncodeStringBundle(const std::vector<std::wstring>& vStrings)
+{
+    std::vector<uint8_t> vData;
+    ByteWriter out(vData);
+    for (size_t ixString = 0; ixString < 16; ++ixString)
+    {
+        if (ixString < vStrings.size())
+        {
+            out.U16((uint16_t)Utf16Length(vStrings[ixString]));
+            out.Utf16(vStrings[ixString]);
+        }
+        else
+        {
+            out.U16(0);
+        }
+    }
+    return vData;
+}
+
+/// <summary>
+/// Writes a control's window class: 0xFFFF and a predefined class atom, or a class name.
+/// </summary>
+static void WriteControlClass(ByteWriter& out, const syntheticcontrol_t& control)
+{
+    if (0 != control.classAtom)
+    {
+        out.U16(0xFFFF);
+        out.U16(control.classAtom);
+    }
+    else
+    {
+        out.Utf16Sz(control.sClass);
+    }
+}
+
+std::vector<uint8_t> EncodeDialog(const syntheticdialog_t& dialog)
+{
+    std::vector<uint8_t> vData;
+    ByteWriter out(vData);
+    const uint32_t style = Style_Popup | Style_ShellFont;
+    if (dialog.bExtended)
+    {
+        out.U16(1);
+        out.U16(0xFFFF);
+        out.U32(0);
+        out.U32(0);
+        out.U32(style);
+    }
+    else
+    {
+        out.U32(style);
+        out.U32(0);
+    }
+    out.U16((uint16_t)dialog.vControls.size());
+    out.U16(0);
+    out.U16(0);
+    out.U16(200);
+    out.U16(100);
+    // No menu, the default window class, the caption, and the font
+    out.U16(0);
+    out.U16(0);
+    out.Utf16Sz(dialog.sCaption);
+    out.U16(8);
+    if (dialog.bExtended)
+    {
+        out.U16(400);
+        out.U8(0);
+        out.U8(1);
+    }
+    out.Utf16Sz(L"MS Shell Dlg");
+
+    uint16_t y = 0;
+    for (const syntheticcontrol_t& control : dialog.vControls)
+    {
+        out.AlignTo(4);
+        if (dialog.bExtended)
+        {
+            out.U32(0);
+            out.U32(0);
+            out.U32(control.style);
+        }
+        else
+        {
+            out.U32(control.style);
+            out.U32(0);
+        }
+        out.U16(7);
+        out.U16(y);
+        out.U16(50);
+        out.U16(14);
+        y = (uint16_t)(y + 16);
+        if (dialog.bExtended)
+        {
+            out.U32(control.id);
+            WriteControlClass(out, control);
+        }
+        else
+        {
+            out.U16((uint16_t)control.id);
+            WriteControlClass(out, control);
+        }
+        out.Utf16Sz(control.sText);
+        // No creation data
+        out.U16(0);
+    }
+    return vData;
+}
+
+/// <summary>
+/// Writes the items of one level of a classic menu, each popup followed by its own items.
+/// </summary>
+static void WriteStandardMenuItems(ByteWriter& out, const std::vector<syntheticmenuitem_t>& vItems)
+{
+    for (size_t ixItem = 0; ixItem < vItems.size(); ++ixItem)
+    {
+        const syntheticmenuitem_t& item = vItems[ixItem];
+        const bool bPopup = !item.vItems.empty();
+        uint16_t flags = (ixItem + 1 == vItems.size()) ? MenuFlag_End : 0;
+        if (bPopup)
+        {
+            out.U16((uint16_t)(flags | MenuFlag_Popup));
+        }
+        else
+        {
+            // The classic form of a separator is an item with no flags, no ID, and no text.
+            out.U16(flags);
+            out.U16(item.bSeparator ? 0 : item.id);
+        }
+        out.Utf16Sz(item.bSeparator ? std::wstring() : item.sText);
+        if (bPopup)
+            WriteStandardMenuItems(out, item.vItems);
+    }
+}
+
+/// <summary>
+/// Writes the items of one level of an extended menu, each popup followed by its help ID and its own items.
+/// </summary>
+static void WriteExtendedMenuItems(ByteWriter& out, const std::vector<syntheticmenuitem_t>& vItems)
+{
+    for (size_t ixItem = 0; ixItem < vItems.size(); ++ixItem)
+    {
+        const syntheticmenuitem_t& item = vItems[ixItem];
+        const bool bPopup = !item.vItems.empty();
+        out.AlignTo(4);
+        out.U32(item.bSeparator ? MenuType_Separator : 0);
+        out.U32(0);
+        out.U32(item.id);
+        out.U16((uint16_t)(((ixItem + 1 == vItems.size()) ? MenuExFlag_End : 0) | (bPopup ? MenuExFlag_Popup : 0)));
+        out.Utf16Sz(item.bSeparator ? std::wstring() : item.sText);
+        if (bPopup)
+        {
+            out.AlignTo(4);
+            out.U32(0);
+            WriteExtendedMenuItems(out, item.vItems);
+        }
+    }
+}
+
+std::vector<uint8_t> EncodeMenu(const std::vector<syntheticmenuitem_t>& vItems, bool bExtended)
+{
+    std::vector<uint8_t> vData;
+    ByteWriter out(vData);
+    if (bExtended)
+    {
+        out.U16(1);
+        out.U16(4);
+        out.U32(0);
+        WriteExtendedMenuItems(out, vItems);
+    }
+    else
+    {
+        out.U16(0);
+        out.U16(0);
+        WriteStandardMenuItems(out, vItems);
+    }
+    return vData;
+}
+
+/// <summary>
+/// Writes one MESSAGE_RESOURCE_ENTRY: length, flags, and zero-terminated text padded to a multiple of 4 bytes.
+/// </summary>
+static void WriteMessageEntry(ByteWriter& out, const syntheticmessage_t& message, const AnsiEncoder& ansi)
+{
+    std::vector<uint8_t> vText;
+    ByteWriter text(vText);
+    uint16_t flags = 0;
+    switch (message.encoding)
+    {
+    case messageencoding_t::eUnicode:
+        flags = 0x0001;
+        text.Utf16Sz(message.sText);
+        break;
+    case messageencoding_t::eUtf8:
+    {
+        flags = 0x0002;
+        const std::string sUtf8 = WStringToUtf8(message.sText);
+        text.Append(sUtf8.data(), sUtf8.length());
+        text.U8(0);
+        break;
+    }
+    default:
+    {
+        const std::string sAnsi = ansi.Encode(message.sText);
+        text.Append(sAnsi.data(), sAnsi.length());
+        text.U8(0);
+        break;
+    }
+    }
+    text.AlignTo(4);
+    out.U16((uint16_t)(4 + vText.size()));
+    out.U16(flags);
+    out.Append(vText.data(), vText.size());
+}
+
+std::vector<uint8_t> EncodeMessageTable(const std::map<uint32_t, syntheticmessage_t>& messages, uint16_t codePage)
+{
+    // Blocks of consecutive IDs
+    std::vector<std::pair<uint32_t, uint32_t>> vBlocks;
+    for (const auto& message : messages)
+    {
+        if (vBlocks.empty() || message.first != vBlocks.back().second + 1)
+            vBlocks.push_back(std::make_pair(message.first, message.first));
+        else
+            vBlocks.back().second = message.first;
+    }
+
+    const AnsiEncoder ansi(codePage);
+    std::vector<uint8_t> vData;
+    ByteWriter out(vData);
+    out.U32((uint32_t)vBlocks.size());
+    const size_t ofsBlocks = out.Size();
+    for (const auto& block : vBlocks)
+    {
+        out.U32(block.first);
+        out.U32(block.second);
+        out.U32(0);
+    }
+    size_t ixBlock = 0;
+    for (const auto& message : messages)
+    {
+        if (message.first == vBlocks[ixBlock].first)
+            out.Patch<uint32_t>(ofsBlocks + ixBlock * 12 + 8, (uint32_t)out.Size());
+        WriteMessageEntry(out, message.second, ansi);
+        if (message.first == vBlocks[ixBlock].second)
+            ++ixBlock;
+    }
+    return vData;
+}
+
+// --------------------------------------------------------------------------------------------------------------
+
+// Words for synthetic text, mostly English with some non-ASCII and East Asian text
+static const wchar_t* const szWords[] =
+{
+    L"open", L"file", L"save", L"settings", L"options", L"the", L"network", L"connection", L"could", L"not",
+    L"be", L"found", L"select", L"a", L"device", L"to", L"continue", L"account", L"password", L"user",
+    L"display", L"language", L"print", L"document", L"folder", L"new", L"delete", L"copy", L"paste", L"help",
+    L"about", L"system", L"service", L"is", L"running", L"stopped", L"access", L"denied", L"for", L"this",
+    L"operation", L"properties", L"advanced", L"security", L"name", L"value", L"error", L"warning", L"ready", L"and",
+    L"Größe", L"Éditer", L"paramètres", L"Файл", L"Сохранить", L"設定", L"削除", L"ファイル", L"网络", L"보기",
+};
+static const uint32_t nWords = (uint32_t)(sizeof(szWords) / sizeof(szWords[0]));
+// Words up to this index are ASCII
+static const uint32_t nAsciiWords = 50;
+
+uint32_t SyntheticText::Next(uint32_t n)
+{
+    // Modulo rather than a std distribution, whose results differ between standard libraries
+    return (uint32_t)(m_rng() % n);
+}
+
+std::wstring SyntheticText::Words(uint32_t nWordsInText)
+{
+    // One text in eight includes non-ASCII words.
+    const bool bNonAscii = (0 == Next(8));
+    std::wstring sText;
+    for (uint32_t ixWord = 0; ixWord < nWordsInText; ++ixWord)
+    {
+        if (ixWord > 0)
+            sText += L' ';
+        sText += szWords[Next(bNonAscii ? nWords : nAsciiWords)];
+    }
+    if (!sText.empty() && sText[0] >= L'a' && sText[0] <= L'z')
+        sText[0] = (wchar_t)(sText[0] - L'a' + L'A');
+    return sText;
+}
+
+std::wstring SyntheticText::Label()
+{
+    std::wstring sText = Words(1 + Next(3));
+    switch (Next(20))
+    {
+    case 0:
+        // East Asian accelerator pattern
+        sText += L"(&";
+        sText += (wchar_t)(L'A' + Next(26));
+        sText += L')';
+        break;
+    case 1:
+        sText += L" && more";
+        break;
+    case 2:
+        sText += L"...";
+        break;
+    case 3:
+    case 4:
+    case 5:
+    case 6:
+    case 7:
+    case 8:
+    case 9:
+        sText.insert(Next((uint32_t)sText.length()), 1, L'&');
+        break;
+    default:
+        break;
+    }
+    return sText;
+}
+
+std::wstring SyntheticText::Sentence()
+{
+    std::wstring sText = Words(5 + Next(20));
+    switch (Next(16))
+    {
+    case 0:
+        sText += L": %1";
+        break;
+    case 1:
+        sText += L"\tNote";
+        break;
+    case 2:
+        sText += L".\r\n\r\n" + Words(3 + Next(8));
+        break;
+    default:
+        break;
+    }
+    sText += L".";
+    if (0 == Next(2))
+        sText += L"\r\n";
+    return sText;
+}
+
+// --------------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// ID or name of a dialog or menu.
+/// </summary>
+static synthid_t ResourceName(const wchar_t* szPrefix, uint16_t id, bool bNamed)
+{
+    if (!bNamed)
+        return synthid_t(id);
+    return synthid_t((std::wstring(szPrefix) + std::to_wstring(id)).c_str());
+}
+
+static bool ChooseExtended(templateform_t form, SyntheticText& text)
+{
+    switch (form)
+    {
+    case templateform_t::eExtended:
+        return true;
+    case templateform_t::eMixed:
+        return 0 == text.Next(2);
+    default:
+        return false;
+    }
+}
+
+static void AddStrings(ResourceImageBuilder& builder, const syntheticcontent_t& content, uint16_t langId, SyntheticText& text)
+{
+    for (uint32_t ixBundle = 0; ixBundle * 16 < content.nStrings; ++ixBundle)
+    {
+        std::vector<std::wstring> vStrings;
+        for (uint32_t ixString = ixBundle * 16; ixString < content.nStrings && vStrings.size() < 16; ++ixString)
+            vStrings.push_back(0 == text.Next(4) ? text.Sentence() : text.Label());
+        builder.Add(rsrctype_t::eString, (uint16_t)(ixBundle + 1), langId, EncodeStringBundle(vStrings));
+    }
+}
+
+static void AddDialogs(ResourceImageBuilder& builder, const syntheticcontent_t& content, uint16_t langId, SyntheticText& text)
+{
+    // Buttons, edit controls, static text, list boxes, and combo boxes, with some custom classes
+    static const uint16_t classAtoms[] = { 0x0080, 0x0080, 0x0081, 0x0082, 0x0082, 0x0082, 0x0083, 0x0085, 0 };
+    for (uint32_t ixDialog = 0; ixDialog < content.nDialogs; ++ixDialog)
+    {
+        syntheticdialog_t dialog;
+        dialog.bExtended = ChooseExtended(content.dialogForm, text);
+        dialog.sCaption = text.Label();
+        for (uint32_t ixControl = 0; ixControl < content.nControls; ++ixControl)
+        {
+            syntheticcontrol_t control;
+            control.id = 1000 + ixControl;
+            control.classAtom = classAtoms[text.Next((uint32_t)(sizeof(classAtoms) / sizeof(classAtoms[0])))];
+            if (0 == control.classAtom)
+                control.sClass = L"SysListView32";
+            // Checkboxes and radio buttons among the buttons
+            if (0x0080 == control.classAtom)
+                control.style = text.Next(4);
+            if (0x0081 != control.classAtom)
+                control.sText = text.Label();
+            dialog.vControls.push_back(control);
+        }
+        builder.Add(rsrctype_t::eDialog, ResourceName(L"DIALOG_", (uint16_t)(100 + ixDialog), content.bNamed), langId, EncodeDialog(dialog));
+    }
+}
+
+static void AddMessages(ResourceImageBuilder& builder, const syntheticcontent_t& content, uint16_t langId, SyntheticText& text)
+{
+    // Runs of 50 consecutive IDs with gaps between them, as in files with several facilities
+    std::map<uint32_t, syntheticmessage_t> messages;
+    uint32_t id = 0;
+    for (uint32_t ixMessage = 0; ixMessage < content.nMessages; ++ixMessage)
+    {
+        id += (ixMessage > 0 && 0 == ixMessage % 50) ? 100 : 1;
+        syntheticmessage_t& message = messages[id];
+        message.sText = text.Sentence();
+        if (!content.vMessageEncodings.empty())
+            message.encoding = content.vMessageEncodings[text.Next((uint32_t)content.vMessageEncodings.size())];
+    }
+    if (!messages.empty())
+        builder.Add(rsrctype_t::eMessageTable, (uint16_t)1, langId, EncodeMessageTable(messages, AnsiCodePageFromLangId(langId)));
+}
+
+/// <summary>
+/// Makes menu items: nItems at each level, and a popup among them with the next level, to the depth.
+/// </summary>
+static std::vector<syntheticmenuitem_t> MenuItems(SyntheticText& text, uint32_t nItems, uint32_t depth, uint16_t& id)
+{
+    std::vector<syntheticmenuitem_t> vItems;
+    for (uint32_t ixItem = 0; ixItem < nItems; ++ixItem)
+    {
+        syntheticmenuitem_t item;
+        if (ixItem > 0 && 0 == text.Next(6))
+        {
+            item.bSeparator = true;
+        }
+        else
+        {
+            item.sText = text.Label();
+            if (0 == text.Next(4))
+                item.sText += L"\tCtrl+" + std::wstring(1, (wchar_t)(L'A' + text.Next(26)));
+            item.id = id++;
+        }
+        vItems.push_back(item);
+    }
+    if (depth > 1)
+    {
+        syntheticmenuitem_t popup;
+        popup.sText = text.Label();
+        popup.vItems = MenuItems(text, nItems, depth - 1, id);
+        vItems.insert(vItems.begin() + text.Next(nItems), popup);
+    }
+    return vItems;
+}
+
+static void AddMenus(ResourceImageBuilder& builder, const syntheticcontent_t& content, uint16_t langId, SyntheticText& text)
+{
+    for (uint32_t ixMenu = 0; ixMenu < content.nMenus; ++ixMenu)
+    {
+        uint16_t id = 100;
+        std::vector<syntheticmenuitem_t> vBar;
+        for (uint32_t ixPopup = 0; ixPopup < content.nMenuPopups; ++ixPopup)
+        {
+            syntheticmenuitem_t popup;
+            popup.sText = text.Label();
+            popup.vItems = MenuItems(text, content.nMenuItems, content.menuDepth, id);
+            vBar.push_back(popup);
+        }
+        const bool bExtended = ChooseExtended(content.menuForm, text);
+        builder.Add(rsrctype_t::eMenu, ResourceName(L"MENU_", (uint16_t)(200 + ixMenu), content.bNamed), langId, EncodeMenu(vBar, bExtended));
+    }
+}
+
+void AddSyntheticResources(ResourceImageBuilder& builder, const syntheticcontent_t& content, uint16_t langId, SyntheticText& text)
+{
+    AddStrings(builder, content, langId, text);
+    AddDialogs(builder, content, langId, text);
+    AddMenus(builder, content, langId, text);
+    AddMessages(builder, content, langId, text);
+}
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "ResourceFile.h"
+
+/*
+Builds Portable Executable files containing resources, for measuring the extractors without real Windows
+binaries. The resource formats are the ones the decoders read; see ResourceDefs.h and the references in
+ResourceFile.h, DialogTextExtraction.cpp, MenuTextExtraction.cpp, and MessageTableExtraction.cpp.
+*/
+
+/// <summary>
+/// Resource type or name in a synthetic file: an integer ID, or a name if sName isn't empty.
+/// Ordered the way a resource directory lists its entries: names first (in ascending order), then IDs.
+/// </summary>
+struct synthid_t
+{
+    synthid_t() : id(0) {}
+    synthid_t(uint16_t id_) : id(id_) {}
+    synthid_t(rsrctype_t type) : id((uint16_t)type) {}
+    synthid_t(const wchar_t* szName) : id(0), sName(szName) {}
+
+    bool IsId() const { return sName.empty(); }
+    bool operator < (const synthid_t& other) const;
+
+    uint16_t id;
+    std::wstring sName;
+};
+
+/// <summary>
+/// Collects resources and lays them out as a PE file with a single .rsrc section: resource directory
+/// (type, then name, then language), directory strings, data entries, then the resource data, 8-byte aligned.
+/// </summary>
+class ResourceImageBuilder
+{
+public:
+    ResourceImageBuilder() {}
+
+    /// <summary>
+    /// Adds a resource, replacing any with the same type, name, and language.
+    /// </summary>
+    void Add(const synthid_t& type, const synthid_t& name, uint16_t langId, const std::vector<uint8_t>& vData);
+
+    /// <summary>
+    /// Number of resources added.
+    /// </summary>
+    size_t ResourceCount() const;
+
+    /// <summary>
+    /// Returns the contents of a PE file with the resources.
+    /// </summary>
+    /// <param name="bPE32Plus">Input: true for a PE32+ (64-bit) file, false for PE32</param>
+    /// <param name="bMisalignData">Input: true to start each resource's data one byte past an 8-byte boundary,
+    /// so that none of the WORDs and DWORDs in it are aligned</param>
+    std::vector<uint8_t> Build(bool bPE32Plus = true, bool bMisalignData = false) const;
+
+private:
+    typedef std::map<uint16_t, std::vector<uint8_t>> languages_t;
+    typedef std::map<synthid_t, languages_t> names_t;
+    std::map<synthid_t, names_t> m_types;
+
+private:
+    // Not implemented
+    ResourceImageBuilder(const ResourceImageBuilder&) = delete;
+    ResourceImageBuilder& operator = (const ResourceImageBuilder&) = delete;
+};
+
+/// <summary>
+/// Encodes text as UTF-16 code units (with surrogate pairs where wchar_t is 32 bits), without a terminator.
+/// </summary>
+std::vector<uint16_t> EncodeUtf16(const std::wstring& sText);
+
+/// <summary>
+/// Encodes text in a Windows ANSI code page. Characters the code page doesn't have become '?', as do all
+/// non-ASCII characters in code pages other than the single-byte ones (874 and 1250 through 1258).
+/// </summary>
+std::string EncodeAnsi(const std::wstring& sText, uint16_t codePage = 1252);
+
+/// <summary>
+/// Encodes a string table resource (bundle) from up to 16 strings; string n of bundle b has ID (b - 1) * 16 + n.
+/// Empty strings are absent strings.
+/// </summary>
+std::vector<uint8_t> EncodeStringBundle(const std::vector<std::wstring>& vStrings);
+
+/// <summary>
+/// One control of a synthetic dialog.
+/// </summary>
+struct syntheticcontrol_t
+{
+    uint32_t id = 0;
+    // Predefined class atom (0x0080 Button, 0x0081 Edit, 0x0082 Static, 0x0083 List box, 0x0084 Scroll bar,
+    // 0x0085 Combo box); 0 to use sClass
+    uint16_t classAtom = 0x0080;
+    std::wstring sClass;
+    std::wstring sText;
+    uint32_t style = 0;
+};
+
+/// <summary>
+/// A synthetic dialog: a DLGTEMPLATE, or a DLGTEMPLATEEX if bExtended, with a font and its controls.
+/// </summary>
+struct syntheticdialog_t
+{
+    bool bExtended = false;
+    std::wstring sCaption;
+    std::vector<syntheticcontrol_t> vControls;
+};
+
+/// <summary>
+/// Encodes a dialog resource.
+/// </summary>
+std::vector<uint8_t> EncodeDialog(const syntheticdialog_t& dialog);
+
+/// <summary>
+/// One item of a synthetic menu: a popup if it has items of its own, otherwise a command or a separator.
+/// </summary>
+struct syntheticmenuitem_t
+{
+    std::wstring sText;
+    uint16_t id = 0;
+    bool bSeparator = false;
+    std::vector<syntheticmenuitem_t> vItems;
+};
+
+/// <summary>
+/// Encodes a menu resource: a classic menu template, or an extended one if bExtended.
+/// </summary>
+std::vector<uint8_t> EncodeMenu(const std::vector<syntheticmenuitem_t>& vItems, bool bExtended);
+
+/// <summary>
+/// How message table entries are encoded.
+/// </summary>
+enum class messageencoding_t
+{
+    // Single-byte code page text (see EncodeAnsi)
+    eAnsi,
+    eUnicode,
+    eUtf8
+};
+
+/// <summary>
+/// One entry of a synthetic message table.
+/// </summary>
+struct syntheticmessage_t
+{
+    std::wstring sText;
+    messageencoding_t encoding = messageencoding_t::eUnicode;
+};
+
+/// <summary>
+/// Encodes a message table resource, with a block for each run of consecutive message IDs.
+/// </summary>
+/// <param name="messages">Input: entries by message ID</param>
+/// <param name="codePage">Input: code page of the ANSI entries (see AnsiCodePageFromLangId)</param>
+std::vector<uint8_t> EncodeMessageTable(const std::map<uint32_t, syntheticmessage_t>& messages, uint16_t codePage);
+
+/// <summary>
+/// Deterministic source of user-interface-like text: labels with and without accelerators (including the
+/// East Asian "(&X)" form), longer sentences with the occasional CR, LF, or TAB, and a share of non-ASCII
+/// text. The same seed produces the same text on every platform.
+/// </summary>
+class SyntheticText
+{
+public:
+    explicit SyntheticText(uint32_t seed) : m_rng(seed) {}
+
+    /// <summary>
+    /// A uniformly distributed value in [0, n).
+    /// </summary>
+    uint32_t Next(uint32_t n);
+
+    /// <summary>
+    /// Text like a button, menu item, or short string table entry.
+    /// </summary>
+    std::wstring Label();
+
+    /// <summary>
+    /// Text like a message table entry or a long string table entry.
+    /// </summary>
+    std::wstring Sentence();
+
+private:
+    std::wstring Words(uint32_t nWords);
+
+    std::mt19937 m_rng;
+};
+
+/// <summary>
+/// Which dialog or menu templates to make: classic, extended, or a random mix of both.
+/// </summary>
+enum class templateform_t
+{
+    eClassic,
+    eExtended,
+    eMixed
+};
+
+/// <summary>
+/// What AddSyntheticResources adds to a file for one language.
+/// </summary>
+struct syntheticcontent_t
+{
+    // String table: strings 0 through nStrings - 1 (at most 65536), in bundles of 16
+    uint32_t nStrings = 0;
+    // Dialogs 100 and up, each with nControls controls
+    uint32_t nDialogs = 0;
+    uint32_t nControls = 10;
+    templateform_t dialogForm = templateform_t::eClassic;
+    // Menus 200 and up: a menu bar of nMenuPopups popups, each with nMenuItems items, one of which is a popup
+    // with the next level of items, to menuDepth levels
+    uint32_t nMenus = 0;
+    uint32_t nMenuPopups = 4;
+    uint32_t nMenuItems = 8;
+    uint32_t menuDepth = 1;
+    templateform_t menuForm = templateform_t::eClassic;
+    // Message table 1: runs of consecutive message IDs, each entry in one of the encodings, chosen at random
+    uint32_t nMessages = 0;
+    std::vector<messageencoding_t> vMessageEncodings = { messageencoding_t::eUnicode };
+    // Dialogs and menus are named (e.g., "DIALOG_100") rather than numbered
+    bool bNamed = false;
+};
+
+/// <summary>
+/// Adds string table, dialog, menu, and message table resources in a language, with text from the source.
+/// Resource IDs depend only on the content, so a file with several languages has the same resources in each.
+/// </summary>
+void AddSyntheticResources(ResourceImageBuilder& builder, const syntheticcontent_t& content, uint16_t langId, SyntheticText& text);
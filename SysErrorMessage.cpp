@@ -1,5 +1,6 @@
-#include <Windows.h>
+#include "PlatformDefs.h"
 #include <sstream>
+#include <cstring>
 #include "SysErrorMessage.h"
 #include "HEX.h"
 
@@ -24,6 +25,7 @@ wchar_t* RemoveTrailingCRLF(wchar_t* psz)
 	return psz;
 }
 
+#ifdef _WIN32
 static std::wstring SysErrorMessage_Impl(DWORD dwErrCode, bool bWithErrorCode, bool bNtStatus)
 {
 	LPWSTR pszErrMsg = NULL;
@@ -64,6 +66,22 @@ static std::wstring SysErrorMessage_Impl(DWORD dwErrCode, bool bWithErrorCode, b
 
 	return sRetval.str();
 }
+#else
+static std::wstring SysErrorMessage_Impl(DWORD dwErrCode, bool bWithErrorCode, bool bNtStatus)
+{
+	UNREFERENCED_PARAMETER(bNtStatus);
+	std::wstringstream sRetval;
+	// strerror text is ASCII in the C locale and in the English locales that matter here.
+	const char* szErrMsg = strerror((int)dwErrCode);
+	for (const char* pch = szErrMsg; nullptr != pch && 0 != *pch; ++pch)
+		sRetval << (wchar_t)(unsigned char)*pch;
+	if (bWithErrorCode)
+	{
+		sRetval << L" Error # " << dwErrCode;
+	}
+	return sRetval.str();
+}
+#endif
 
 /// <summary>
 /// Returns human-language error text from a Windows error code
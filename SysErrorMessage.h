@@ -1,12 +1,13 @@
 #pragma once
 
-#include <Windows.h>
+#include "PlatformDefs.h"
 #include <string>
 
 // ----------------------------------------------------------------------------------------------------
 
 /// <summary>
 /// Returns human-language error text from a Windows or NTSTATUS error code
+/// (On non-Windows platforms, from an errno value.)
 /// </summary>
 /// <param name="dwErrCode">Win32 or NTSTATUS error code</param>
 /// <param name="bNtStatus">true for NTSTATUS code, false for Win32 code</param>
@@ -0,0 +1,141 @@
+#include "PlatformDefs.h"
+#include <cwchar>
+#include "TextArena.h"
+#include "UtilityFunctions.h"
+
+TextArena::TextArena(size_t nBlockChars) :
+    m_ixBlock(0),
+    m_ixChar(0),
+    m_nBlockChars(nBlockChars),
+    m_nReservedChars(0),
+    m_nAllocations(0)
+{
+}
+
+TextArena::TextArena(TextArena&& other) :
+    m_vBlocks(std::move(other.m_vBlocks)),
+    m_ixBlock(other.m_ixBlock),
+    m_ixChar(other.m_ixChar),
+    m_nBlockChars(other.m_nBlockChars),
+    m_nReservedChars(other.m_nReservedChars),
+    m_nAllocations(other.m_nAllocations)
+{
+    other.m_vBlocks.clear();
+    other.m_ixBlock = other.m_ixChar = other.m_nReservedChars = 0;
+    other.m_nAllocations = 0;
+}
+
+TextArena& TextArena::operator = (TextArena&& other)
+{
+    if (this != &other)
+    {
+        m_vBlocks = std::move(other.m_vBlocks);
+        m_ixBlock = other.m_ixBlock;
+        m_ixChar = other.m_ixChar;
+        m_nBlockChars = other.m_nBlockChars;
+        m_nReservedChars = other.m_nReservedChars;
+        m_nAllocations = other.m_nAllocations;
+        other.m_vBlocks.clear();
+        other.m_ixBlock = other.m_ixChar = other.m_nReservedChars = 0;
+        other.m_nAllocations = 0;
+    }
+    return *this;
+}
+
+wchar_t* TextArena::Allocate(size_t nChars)
+{
+    ++m_nAllocations;
+    // Move on to the next block that has room, adding one after the current block if none does. Blocks skipped
+    // because they're too small are used again after the next rewind.
+    while (m_ixBlock < m_vBlocks.size() && nChars > m_vBlocks[m_ixBlock].nChars - m_ixChar)
+    {
+        ++m_ixBlock;
+        m_ixChar = 0;
+    }
+    if (m_ixBlock == m_vBlocks.size())
+    {
+        block_t block;
+        block.nChars = (nChars > m_nBlockChars) ? nChars : m_nBlockChars;
+        block.pChars.reset(new wchar_t[block.nChars]);
+        m_nReservedChars += block.nChars;
+        m_vBlocks.push_back(std::move(block));
+        m_ixChar = 0;
+    }
+    wchar_t* pChars = m_vBlocks[m_ixBlock].pChars.get() + m_ixChar;
+    m_ixChar += nChars;
+    return pChars;
+}
+
+TextArena::mark_t TextArena::Mark() const
+{
+    mark_t mark;
+    mark.ixBlock = m_ixBlock;
+    mark.ixChar = m_ixChar;
+    return mark;
+}
+
+void TextArena::Rewind(const mark_t& mark)
+{
+    m_ixBlock = mark.ixBlock;
+    m_ixChar = mark.ixChar;
+}
+
+void TextArena::Reset()
+{
+    m_ixBlock = 0;
+    m_ixChar = 0;
+}
+
+arenatext_t ArenaText(TextArena& arena, const utf16view_t& text)
+{
+#ifdef _WIN32
+    (void)arena;
+    return arenatext_t((const wchar_t*)text.pChars, text.nChars);
+#else
+    // A surrogate pair becomes one character, so the text needs at most as many characters as code units.
+    wchar_t* pChars = arena.Allocate(text.nChars);
+    return arenatext_t(pChars, Utf16ToWide(text.pChars, text.nChars, pChars));
+#endif
+}
+
+arenatext_t EscapeCrLfTab(TextArena& arena, const arenatext_t& text, bool bEscapeNul)
+{
+    if (!MightNeedEscapeCrLfTab(text.pChars, text.nChars))
+        return text;
+    wchar_t* pChars = arena.Allocate(2 * text.nChars);
+    return arenatext_t(pChars, EscapeCrLfTab(text.pChars, text.nChars, bEscapeNul, pChars));
+}
+
+arenatext_t RemoveAccelsFromText(TextArena& arena, const arenatext_t& text)
+{
+    if (0 == text.nChars || nullptr == wmemchr(text.pChars, L'&', text.nChars))
+        return text;
+    wchar_t* pChars = arena.Allocate(text.nChars);
+    return arenatext_t(pChars, RemoveAccelsFromText(text.pChars, text.nChars, pChars));
+}
+
+arenatext_t HexText(TextArena& arena, uint32_t value)
+{
+    static const wchar_t szDigits[] = L"0123456789ABCDEF";
+    wchar_t* pChars = arena.Allocate(10);
+    pChars[0] = L'0';
+    pChars[1] = L'x';
+    for (int ixDigit = 0; ixDigit < 8; ++ixDigit)
+        pChars[2 + ixDigit] = szDigits[(value >> (28 - 4 * ixDigit)) & 0xF];
+    return arenatext_t(pChars, 10);
+}
+
+void WriteResourceName(std::wostream& os, const RSRCID_t& name, TextArena& arena)
+{
+    if (name.IsId())
+    {
+        os << name.m_id;
+    }
+    else
+    {
+        utf16view_t text;
+        text.pChars = name.m_pName;
+        text.nChars = name.m_cchName;
+        os << ArenaText(arena, text);
+    }
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "ResourceCursor.h"
+#include "ResourceFile.h"
+
+/// <summary>
+/// Text as a pointer and a length, not zero-terminated: in a TextArena, in resource data, or a string literal.
+/// </summary>
+struct arenatext_t
+{
+    arenatext_t() {}
+    arenatext_t(const wchar_t* pChars_, size_t nChars_) : pChars(pChars_), nChars(nChars_) {}
+
+    bool empty() const { return 0 == nChars; }
+
+    const wchar_t* pChars = nullptr;
+    size_t nChars = 0;
+};
+
+/// <summary>
+/// Writes the text, without formatting.
+/// </summary>
+inline std::wostream& operator << (std::wostream& os, const arenatext_t& text)
+{
+    return os.write(text.pChars, (std::streamsize)text.nChars);
+}
+
+/// <summary>
+/// Monotonic arena for the temporary text of an extraction: decoded text, escaped text, text with accelerators
+/// removed, and the like, so that writing an item of text doesn't allocate from the heap.
+/// Allocation takes the next characters of the current block; memory is never freed individually. Rewinding to a
+/// mark (e.g., after each item) or resetting (e.g., after each file) takes constant time and keeps the blocks for
+/// reuse, so once the blocks are large enough for the largest item, the arena doesn't allocate at all.
+/// Not thread-safe: each thread uses its own arena.
+/// </summary>
+class TextArena
+{
+public:
+    /// <summary>
+    /// A position in the arena to rewind to.
+    /// </summary>
+    struct mark_t
+    {
+        size_t ixBlock = 0;
+        size_t ixChar = 0;
+    };
+
+    /// <summary>
+    /// The arena allocates blocks of nBlockChars characters, or larger for a larger allocation; the first when first needed.
+    /// </summary>
+    explicit TextArena(size_t nBlockChars = 16384);
+    /// <summary>
+    /// Moves the blocks, and the text in them, to another arena; this arena is left empty.
+    /// </summary>
+    TextArena(TextArena&& other);
+    TextArena& operator = (TextArena&& other);
+
+    /// <summary>
+    /// Returns space for nChars characters, valid until the arena is reset or rewound to a mark before it.
+    /// </summary>
+    wchar_t* Allocate(size_t nChars);
+
+    /// <summary>
+    /// Returns the current position, to rewind to.
+    /// </summary>
+    mark_t Mark() const;
+
+    /// <summary>
+    /// Frees everything allocated since the mark.
+    /// </summary>
+    void Rewind(const mark_t& mark);
+
+    /// <summary>
+    /// Frees everything allocated, keeping the blocks.
+    /// </summary>
+    void Reset();
+
+    /// <summary>
+    /// Number of calls to Allocate since the arena was created.
+    /// </summary>
+    uint64_t Allocations() const { return m_nAllocations; }
+
+    /// <summary>
+    /// Number of blocks the arena has allocated from the heap, and their total size in characters.
+    /// </summary>
+    size_t BlockCount() const { return m_vBlocks.size(); }
+    size_t ReservedChars() const { return m_nReservedChars; }
+
+private:
+    struct block_t
+    {
+        std::unique_ptr<wchar_t[]> pChars;
+        size_t nChars;
+    };
+    std::vector<block_t> m_vBlocks;
+    // The current block, and the next free character in it
+    size_t m_ixBlock;
+    size_t m_ixChar;
+    size_t m_nBlockChars;
+    size_t m_nReservedChars;
+    uint64_t m_nAllocations;
+
+private:
+    // Not implemented
+    TextArena(const TextArena&) = delete;
+    TextArena& operator = (const TextArena&) = delete;
+};
+
+/// <summary>
+/// Returns UTF-16 text from resource data as wide characters: the text itself where wchar_t is 16 bits (Windows);
+/// otherwise the text converted into the arena, as WStringFromUtf16 converts it.
+/// </summary>
+arenatext_t ArenaText(TextArena& arena, const utf16view_t& text);
+
+/// <summary>
+/// Returns the text with CR, LF, and TAB characters converted to \r, \n, \t, and NUL characters converted to \0 if
+/// bEscapeNul is true (as escapeCrLfTab and escapeCrLfTabNul do). Text without those characters is returned as is.
+/// </summary>
+arenatext_t EscapeCrLfTab(TextArena& arena, const arenatext_t& text, bool bEscapeNul);
+
+/// <summary>
+/// Returns the text with accelerators removed (as RemoveAccelsFromText does). Text without ampersands is returned as is.
+/// </summary>
+arenatext_t RemoveAccelsFromText(TextArena& arena, const arenatext_t& text);
+
+/// <summary>
+/// Returns a 32-bit value as "0x" followed by eight uppercase hex digits, as HEX(value, 8, true, true) does.
+/// </summary>
+arenatext_t HexText(TextArena& arena, uint32_t value);
+
+/// <summary>
+/// Writes a resource's integer ID or name, as the RSRCID_t output operator does, with a name converted in the arena.
+/// </summary>
+void WriteResourceName(std::wostream& os, const RSRCID_t& name, TextArena& arena);
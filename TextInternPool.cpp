@@ -0,0 +1,84 @@
+#include "PlatformDefs.h"
+#include <cstring>
+#include "TextInternPool.h"
+
+/// <summary>
+/// FNV-1a hash of UTF-16 code units.
+/// </summary>
+static inline uint64_t HashUtf16(const uint16_t* pChars, size_t nChars)
+{
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (size_t ix = 0; ix < nChars; ++ix)
+    {
+        hash ^= pChars[ix];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+/// <summary>
+/// Copies text into the arena. The text can be in the scratch arena, in a mapped file, or a literal.
+/// </summary>
+static arenatext_t CopyText(TextArena& arena, const arenatext_t& text)
+{
+    wchar_t* pChars = arena.Allocate(text.nChars);
+    if (text.nChars > 0)
+        memcpy(pChars, text.pChars, text.nChars * sizeof(wchar_t));
+    return arenatext_t(pChars, text.nChars);
+}
+
+bool TextInternPool::keyequal_t::operator () (const poolkey_t& a, const poolkey_t& b) const
+{
+    return a.nChars == b.nChars && (0 == a.nChars || 0 == memcmp(a.pChars, b.pChars, a.nChars * sizeof(uint16_t)));
+}
+
+TextInternPool::TextInternPool(size_t nShards) :
+    m_nLookups(0)
+{
+    if (0 == nShards)
+        nShards = 1;
+    for (size_t ixShard = 0; ixShard < nShards; ++ixShard)
+        m_vShards.emplace_back(new shard_t());
+}
+
+const internedtext_t& TextInternPool::Intern(const utf16view_t& text)
+{
+    ++m_nLookups;
+    poolkey_t key;
+    key.pChars = text.pChars;
+    key.nChars = text.nChars;
+    key.hash = HashUtf16(text.pChars, text.nChars);
+
+    // The map picks buckets by the low bits of the hash, so shards are picked by the high bits.
+    shard_t& shard = *m_vShards[(size_t)(key.hash >> 32) % m_vShards.size()];
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    auto it = shard.texts.find(key);
+    if (shard.texts.end() != it)
+        return it->second;
+
+    // New text: keep a copy of the code units as the key (the arena's wchar_t blocks are suitably aligned for
+    // them), and compute its forms.
+    uint16_t* pKeyChars = (uint16_t*)shard.arena.Allocate((text.nChars * sizeof(uint16_t) + sizeof(wchar_t) - 1) / sizeof(wchar_t));
+    if (text.nChars > 0)
+        memcpy(pKeyChars, text.pChars, text.nChars * sizeof(uint16_t));
+    key.pChars = pKeyChars;
+
+    const arenatext_t escaped = EscapeCrLfTab(shard.scratch, ArenaText(shard.scratch, text), true);
+    const arenatext_t noAccels = RemoveAccelsFromText(shard.scratch, escaped);
+    internedtext_t interned;
+    interned.text = CopyText(shard.arena, escaped);
+    interned.noAccels = (noAccels.pChars == escaped.pChars) ? interned.text : CopyText(shard.arena, noAccels);
+    shard.scratch.Reset();
+    return shard.texts.emplace(key, interned).first->second;
+}
+
+size_t TextInternPool::Size() const
+{
+    size_t nTexts = 0;
+    for (const std::unique_ptr<shard_t>& pShard : m_vShards)
+    {
+        std::lock_guard<std::mutex> lock(pShard->mtx);
+        nTexts += pShard->texts.size();
+    }
+    return nTexts;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "ResourceCursor.h"
+#include "TextArena.h"
+
+/// <summary>
+/// The forms of one distinct text in a TextInternPool, valid for the life of the pool.
+/// </summary>
+struct internedtext_t
+{
+    // The text with CR, LF, TAB, and NUL escaped (as escapeCrLfTabNul escapes them)
+    arenatext_t text;
+    // The escaped text with accelerators removed (as RemoveAccelsFromText removes them); the same characters as
+    // text if it has no ampersands
+    arenatext_t noAccels;
+};
+
+/// <summary>
+/// Pool of the distinct texts found across many files, such as "OK", "Cancel", and "&amp;Help", which appear in
+/// thousands of dialogs and string tables. Each text is escaped and has its accelerators removed once, when first
+/// interned; every later occurrence gets the same forms back, identified by the address of its internedtext_t.
+///
+/// Thread-safe: the texts are divided among shards by hash, each with its own lock and its own arena for the
+/// texts, so that workers interning different texts seldom wait for each other. The raw UTF-16 text is hashed
+/// once per lookup, and the hash both picks the shard and is the key's hash within the shard.
+/// </summary>
+class TextInternPool
+{
+public:
+    explicit TextInternPool(size_t nShards = 64);
+
+    /// <summary>
+    /// Returns the forms of the text, adding the text to the pool if it isn't in it yet. The text can refer to a
+    /// mapped file; the pool keeps a copy.
+    /// </summary>
+    const internedtext_t& Intern(const utf16view_t& text);
+
+    /// <summary>
+    /// Number of calls to Intern, and number of distinct texts in the pool.
+    /// </summary>
+    uint64_t Lookups() const { return m_nLookups; }
+    size_t Size() const;
+
+private:
+    /// <summary>
+    /// Raw UTF-16 text in a shard's arena, with its hash.
+    /// </summary>
+    struct poolkey_t
+    {
+        const uint16_t* pChars;
+        size_t nChars;
+        uint64_t hash;
+    };
+    struct keyhash_t
+    {
+        size_t operator () (const poolkey_t& key) const { return (size_t)key.hash; }
+    };
+    struct keyequal_t
+    {
+        bool operator () (const poolkey_t& a, const poolkey_t& b) const;
+    };
+    struct shard_t
+    {
+        std::mutex mtx;
+        std::unordered_map<poolkey_t, internedtext_t, keyhash_t, keyequal_t> texts;
+        // The keys and forms of the shard's texts
+        TextArena arena;
+        // Temporary text while a new text's forms are computed
+        TextArena scratch;
+    };
+    std::vector<std::unique_ptr<shard_t>> m_vShards;
+    std::atomic<uint64_t> m_nLookups;
+
+private:
+    // Not implemented
+    TextInternPool(const TextInternPool&) = delete;
+    TextInternPool& operator = (const TextInternPool&) = delete;
+};
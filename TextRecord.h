@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include "ResourceCursor.h"
+#include "ResourceFile.h"
+#include "TextArena.h"
+
+/// <summary>
+/// One item of localized text as a decoder finds it in a resource: a string table string, a message table
+/// message, or the caption or a control of a dialog or menu. The text is as stored in the resource, not escaped.
+///
+/// The text and the window class refer to the resource data in place, in the mapped file, and are valid only
+/// during the ResourceVisitor::Visit call. The exception is a message table entry stored as ANSI or UTF-8 text,
+/// which the decoder converts to UTF-16 in a buffer of its own, valid for the same duration.
+/// </summary>
+struct textview_t
+{
+    /// <summary>
+    /// What identifies the item within its resource.
+    /// </summary>
+    enum class item_t
+    {
+        // String ID, message ID, or control ID
+        eId,
+        // Dialog caption, which has no ID
+        eCaption,
+        // Menu popup, which has no ID
+        ePopup
+    };
+
+    item_t item = item_t::eId;
+    // With item_t::eId, the string ID, message ID, or control ID
+    int64_t id = 0;
+    utf16view_t text;
+    // Dialog control's window class (a predefined class's ordinal, or a class name) and window style, from which
+    // DialogControlType names the control; not set for other items
+    szorord_t windowClass;
+    uint32_t style = 0;
+};
+
+/// <summary>
+/// Receives the items of text that the resource decoders find, each with the resource it's in: its type, name
+/// or ID, and language (see ResourceEntry_t, whose name also refers to the mapped file).
+/// Tab-delimited output, record extraction, and validation are all visitors; a program that embeds the decoders
+/// can implement its own to consume the text in process, without formatting or copying it.
+/// </summary>
+class ResourceVisitor
+{
+public:
+    virtual ~ResourceVisitor() {}
+
+    /// <summary>
+    /// Called before the items of each resource that VisitResources decodes.
+    /// </summary>
+    virtual void BeginResource(const ResourceEntry_t& entry) { (void)entry; }
+
+    /// <summary>
+    /// Called with each item of text in the resource, in the order the decoder finds them.
+    /// </summary>
+    virtual void Visit(const ResourceEntry_t& entry, const textview_t& text) = 0;
+};
+
+/// <summary>
+/// Visitor that writes each item of text to a stream with a function, such as a type's tab-delimited line.
+/// The function takes its temporary text from the arena, which is rewound after each item.
+/// </summary>
+class TextWriterVisitor : public ResourceVisitor
+{
+public:
+    typedef void (*WriteTextFn_t)(const ResourceEntry_t& entry, const textview_t& text, TextArena& arena, std::wostream& out);
+
+    TextWriterVisitor(WriteTextFn_t pfnWriteText, TextArena& arena, std::wostream& out) : m_pfnWriteText(pfnWriteText), m_arena(arena), m_out(out) {}
+
+    void Visit(const ResourceEntry_t& entry, const textview_t& text) override
+    {
+        const TextArena::mark_t mark = m_arena.Mark();
+        m_pfnWriteText(entry, text, m_arena, m_out);
+        m_arena.Rewind(mark);
+    }
+
+private:
+    WriteTextFn_t m_pfnWriteText;
+    TextArena& m_arena;
+    std::wostream& m_out;
+
+private:
+    // Not implemented
+    TextWriterVisitor(const TextWriterVisitor&) = delete;
+    TextWriterVisitor& operator = (const TextWriterVisitor&) = delete;
+};
+
+/// <summary>
+/// One item of localized text, copied out of the resource (see textview_t), so that it can be kept after the
+/// file is closed or handed to another thread.
+/// </summary>
+struct textrecord_t
+{
+    typedef textview_t::item_t item_t;
+
+    item_t item = item_t::eId;
+    // With item_t::eId, the string ID, message ID, or control ID
+    int64_t id = 0;
+    std::wstring sText;
+    // Dialog control type (e.g., "Button"); empty for other items
+    std::wstring sControlType;
+};
+
+/// <summary>
+/// One item of text with the resource it came from. Unlike ResourceEntry_t, doesn't refer to the file's mapping.
+/// </summary>
+struct resourcerecord_t
+{
+    rsrctype_t type = rsrctype_t::eString;
+    uint16_t langId = 0;
+    // Integer ID of the resource; 0 if the resource is named
+    uint16_t resourceId = 0;
+    // Name of the resource; empty if it has an integer ID
+    std::wstring sResourceName;
+    textrecord_t text;
+};
+
+/// <summary>
+/// Callback for record extraction, called with each item of text.
+/// </summary>
+typedef std::function<void(const resourcerecord_t& record)> ResourceRecordCallback_t;
@@ -1,13 +1,77 @@
 ﻿#pragma once
 
-#include <Windows.h>
+#include "PlatformDefs.h"
 #include <iostream>
 #include <string>
 #include <sstream>
-#include <regex>
 #include "StringUtils.h"
+#include "ResourceFile.h"
 
 
+/// <summary>
+/// Indicates whether the text at the position is an East Asian-language accelerator pattern: left parenthesis,
+/// ampersand, capital letter A-Z or digit 0-9, right parenthesis.
+/// </summary>
+inline bool IsAsianAccelerator(const wchar_t* pText, size_t nLength, size_t ix)
+{
+    return
+        ix + 3 < nLength &&
+        L'(' == pText[ix] &&
+        L'&' == pText[ix + 1] &&
+        ((pText[ix + 2] >= L'A' && pText[ix + 2] <= L'Z') || (pText[ix + 2] >= L'0' && pText[ix + 2] <= L'9')) &&
+        L')' == pText[ix + 3];
+}
+
+inline bool IsAsianAccelerator(const std::wstring& sText, size_t ix)
+{
+    return IsAsianAccelerator(sText.data(), sText.length(), ix);
+}
+
+/// <summary>
+/// Writes text to a buffer with accelerator characters (&) removed, leaving escaped ampersands in place,
+/// and with East Asian-language accelerator patterns removed (see the std::wstring overload).
+/// </summary>
+/// <param name="pInput">Input: text from a resource, possibly with accelerator characters</param>
+/// <param name="nLength">Input: number of characters in the text</param>
+/// <param name="pOut">Output: buffer with room for nLength characters; can be the same as pInput</param>
+/// <returns>The number of characters written</returns>
+inline size_t RemoveAccelsFromText(const wchar_t* pInput, size_t nLength, wchar_t* pOut)
+{
+    // Single pass: drop East Asian accelerator patterns, keep escaped ampersands (two consecutive ampersands,
+    // once the patterns are removed), and drop any other ampersand.
+    // The output never gets ahead of the input, so it can be written in place.
+    size_t ixOut = 0;
+    size_t ix = 0;
+    while (ix < nLength)
+    {
+        if (IsAsianAccelerator(pInput, nLength, ix))
+        {
+            ix += 4;
+        }
+        else if (L'&' != pInput[ix])
+        {
+            pOut[ixOut++] = pInput[ix++];
+        }
+        else
+        {
+            size_t ixNext = ix + 1;
+            while (IsAsianAccelerator(pInput, nLength, ixNext))
+                ixNext += 4;
+            if (ixNext < nLength && L'&' == pInput[ixNext])
+            {
+                pOut[ixOut++] = L'&';
+                pOut[ixOut++] = L'&';
+                ix = ixNext + 1;
+            }
+            else
+            {
+                ++ix;
+            }
+        }
+    }
+    return ixOut;
+}
+
 /// <summary>
 /// Remove accelerator characters (&) from text, while leaving escaped ampersands in place.
 /// Also remove East Asian-language accelerator patterns.
@@ -24,48 +88,29 @@ inline std::wstring RemoveAccelsFromText(const std::wstring& sInput)
     // Removing these accelerators from the localized string requires removing the parentheses and the Latin
     // character in addition to the ampersand.
 
-    // Pattern to search for: Left parenthesis character, ampersand character, capital letter A-Z or digit 0-9, right parenthesis character.
-    std::wregex regexAsianAccelerator(L"\\(&[A-Z0-9]\\)");
-    // Remove anything that matches the Asian accelerator pattern:
-    std::wstring sEastAsianAccelsRemoved = std::regex_replace(sInput, regexAsianAccelerator, L"");
+    // Every accelerator pattern includes an ampersand; most text has none.
+    if (std::wstring::npos == sInput.find(L'&'))
+        return sInput;
 
-    // Now, remove any remaining ampersands unless they are escaped (two consecutive ampersands).
-    // Replace escaped ampersands with an unusual string combo, then remove remaining ampersands, and
-    // finally restore the escaped ampersands.
-    const wchar_t* szEscapedAmpersand = L"&&";
-    const std::wstring sTempReplacement = L"~`~";
-    return
-        replaceStringAll(
-            replaceStringAll(
-                replaceStringAll(sEastAsianAccelsRemoved, szEscapedAmpersand, sTempReplacement),
-                L"&", L""),
-            sTempReplacement, szEscapedAmpersand);
+    std::wstring sResult(sInput);
+    sResult.resize(RemoveAccelsFromText(sInput.data(), sInput.length(), &sResult[0]));
+    return sResult;
 }
 
 // --------------------------------------------------------------------------------------------------------------
 
-/// <summary>
-/// Resource IDs can be a name or an integer ID. 
-/// RSRCID_t is a wrapper to simplify passing it to an ostream without having to check IS_INTRESOURCE every time.
-/// </summary>
-struct RSRCID_t
-{
-    RSRCID_t(LPCWSTR lpName) : m_lpName(lpName) {}
-    LPCWSTR m_lpName;
-};
-
 /// <summary>
 /// Output a resource identifier, which can be a name or an integer ID.
 /// </summary>
 inline std::wostream& operator << (std::wostream& os, const RSRCID_t& d)
 {
-    if (IS_INTRESOURCE(d.m_lpName))
+    if (d.IsId())
     {
-        os << (unsigned long long)d.m_lpName;
+        os << d.m_id;
     }
     else
     {
-        os << d.m_lpName;
+        os << WStringFromUtf16(d.m_pName, d.m_cchName);
     }
     return os;
 }
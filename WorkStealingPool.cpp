@@ -0,0 +1,155 @@
+#include "PlatformDefs.h"
+#include <iomanip>
+#include "WorkStealingPool.h"
+
+WorkStealingPool::WorkStealingPool(unsigned int nWorkers) :
+    m_nQueued(0),
+    m_nPending(0),
+    m_elapsed(0)
+{
+    if (0 == nWorkers)
+        nWorkers = std::thread::hardware_concurrency();
+    if (0 == nWorkers)
+        nWorkers = 1;
+    for (unsigned int ixWorker = 0; ixWorker < nWorkers; ++ixWorker)
+        m_vWorkers.emplace_back(new worker_t());
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    Join();
+}
+
+void WorkStealingPool::Push(unsigned int ixWorker, Task_t task)
+{
+    // Counted as pending before any worker can take it, so that the count can't reach zero while it waits.
+    ++m_nPending;
+    worker_t& worker = *m_vWorkers[ixWorker];
+    {
+        std::lock_guard<std::mutex> lock(worker.mtx);
+        worker.tasks.push_front(std::move(task));
+        ++m_nQueued;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mtxIdle);
+    }
+    m_cvIdle.notify_one();
+}
+
+void WorkStealingPool::PushBack(unsigned int ixWorker, Task_t task)
+{
+    ++m_nPending;
+    worker_t& worker = *m_vWorkers[ixWorker];
+    {
+        std::lock_guard<std::mutex> lock(worker.mtx);
+        worker.tasks.push_back(std::move(task));
+        ++m_nQueued;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mtxIdle);
+    }
+    m_cvIdle.notify_one();
+}
+
+void WorkStealingPool::Start()
+{
+    m_start = std::chrono::steady_clock::now();
+    for (unsigned int ixWorker = 0; ixWorker < m_vWorkers.size(); ++ixWorker)
+        m_vWorkers[ixWorker]->thread = std::thread(&WorkStealingPool::Run, this, ixWorker);
+}
+
+void WorkStealingPool::Join()
+{
+    for (const std::unique_ptr<worker_t>& pWorker : m_vWorkers)
+    {
+        if (pWorker->thread.joinable())
+        {
+            pWorker->thread.join();
+            if (pWorker->stats.finished > m_elapsed)
+                m_elapsed = pWorker->stats.finished;
+        }
+    }
+}
+
+/// <summary>
+/// Takes the task at the front of the worker's own deque, or failing that, steals the task at the back of another
+/// worker's deque, starting with the next worker so that the thieves spread out over their victims.
+/// </summary>
+bool WorkStealingPool::TakeTask(unsigned int ixWorker, Task_t& task)
+{
+    worker_t& worker = *m_vWorkers[ixWorker];
+    {
+        std::lock_guard<std::mutex> lock(worker.mtx);
+        if (!worker.tasks.empty())
+        {
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+            --m_nQueued;
+            return true;
+        }
+    }
+
+    const unsigned int nWorkers = (unsigned int)m_vWorkers.size();
+    for (unsigned int ixOffset = 1; ixOffset < nWorkers && m_nQueued > 0; ++ixOffset)
+    {
+        worker_t& victim = *m_vWorkers[(ixWorker + ixOffset) % nWorkers];
+        std::lock_guard<std::mutex> lock(victim.mtx);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+            --m_nQueued;
+            ++worker.stats.nStolen;
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::Run(unsigned int ixWorker)
+{
+    worker_t& worker = *m_vWorkers[ixWorker];
+    for (;;)
+    {
+        Task_t task;
+        if (TakeTask(ixWorker, task))
+        {
+            const auto taskStart = std::chrono::steady_clock::now();
+            task(ixWorker);
+            const auto taskEnd = std::chrono::steady_clock::now();
+            worker.stats.busy += taskEnd - taskStart;
+            worker.stats.finished = taskEnd - m_start;
+            ++worker.stats.nTasks;
+            if (1 == m_nPending--)
+            {
+                std::lock_guard<std::mutex> lock(m_mtxIdle);
+                m_cvIdle.notify_all();
+            }
+            continue;
+        }
+
+        // No tasks anywhere: wait for a running task to add some, or for the last one to finish.
+        std::unique_lock<std::mutex> lock(m_mtxIdle);
+        m_cvIdle.wait(lock, [this]() { return 0 == m_nPending || m_nQueued > 0; });
+        if (0 == m_nPending)
+            break;
+    }
+}
+
+void WorkStealingPool::WriteUtilization(std::wostream& out) const
+{
+    const double seconds = std::chrono::duration<double>(m_elapsed).count();
+    out << L"Workers: " << m_vWorkers.size() << L", " << std::fixed << std::setprecision(3) << seconds << L" s" << std::endl;
+    for (size_t ixWorker = 0; ixWorker < m_vWorkers.size(); ++ixWorker)
+    {
+        const workerstats_t& stats = m_vWorkers[ixWorker]->stats;
+        const double busySeconds = std::chrono::duration<double>(stats.busy).count();
+        const double idleSeconds = std::chrono::duration<double>(m_elapsed - stats.finished).count();
+        out
+            << L"  worker " << ixWorker + 1 << L": "
+            << std::setprecision(1) << (seconds > 0 ? 100.0 * busySeconds / seconds : 0.0) << L"% busy, "
+            << stats.nTasks << L" tasks (" << stats.nStolen << L" stolen), idle for the last "
+            << std::setprecision(3) << idleSeconds << L" s" << std::endl;
+    }
+    out << std::defaultfloat << std::setprecision(6);
+}
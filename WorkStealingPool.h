@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// Pool of worker threads for many tasks of very different sizes, such as the files of a Windows image, where a
+/// few multi-megabyte .mui files sit among tens of thousands of tiny ones.
+///
+/// Each worker has its own deque of tasks. A worker takes tasks from the front of its own deque, and a task can
+/// add more tasks to the front of its worker's deque (e.g., a large file split into parts), which that worker
+/// takes next. A worker whose deque is empty steals from the back of another's, so no worker sits idle while
+/// another still has tasks waiting, and the parts of a large file left until the end are shared out.
+/// The pool records how busy each worker was, to show how evenly the work was spread.
+/// </summary>
+class WorkStealingPool
+{
+public:
+    /// <summary>
+    /// A task, called with the index of the worker that runs it.
+    /// </summary>
+    typedef std::function<void(unsigned int ixWorker)> Task_t;
+
+    /// <summary>
+    /// Time and tasks of one worker.
+    /// </summary>
+    struct workerstats_t
+    {
+        // Time spent running tasks
+        std::chrono::nanoseconds busy = std::chrono::nanoseconds(0);
+        // Time from Start until the worker's last task finished
+        std::chrono::nanoseconds finished = std::chrono::nanoseconds(0);
+        uint64_t nTasks = 0;
+        // Tasks taken from other workers' deques
+        uint64_t nStolen = 0;
+    };
+
+    /// <param name="nWorkers">Input: number of worker threads; 0 for one per hardware thread</param>
+    explicit WorkStealingPool(unsigned int nWorkers);
+    ~WorkStealingPool();
+
+    unsigned int Workers() const { return (unsigned int)m_vWorkers.size(); }
+
+    /// <summary>
+    /// Adds a task to the front of a worker's deque: before Start, to deal out the initial tasks, or from a task
+    /// running on that worker, to add tasks that it takes next unless another worker steals them first.
+    /// </summary>
+    void Push(unsigned int ixWorker, Task_t task);
+
+    /// <summary>
+    /// Adds a task to the back of a worker's deque. Before Start, tasks added this way are taken in the order added.
+    /// </summary>
+    void PushBack(unsigned int ixWorker, Task_t task);
+
+    /// <summary>
+    /// Starts the worker threads, which run until every task, including tasks added by tasks, has finished.
+    /// </summary>
+    void Start();
+
+    /// <summary>
+    /// Waits for the workers to finish every task.
+    /// </summary>
+    void Join();
+
+    /// <summary>
+    /// After Join, the time from Start until the last task finished, and each worker's statistics.
+    /// </summary>
+    std::chrono::nanoseconds Elapsed() const { return m_elapsed; }
+    const workerstats_t& Stats(unsigned int ixWorker) const { return m_vWorkers[ixWorker]->stats; }
+
+    /// <summary>
+    /// After Join, writes each worker's share of the time: the fraction of the elapsed time it was busy, its tasks,
+    /// how many it stole, and how long it was idle at the end, waiting for the last tasks on other workers.
+    /// </summary>
+    void WriteUtilization(std::wostream& out) const;
+
+private:
+    struct worker_t
+    {
+        std::mutex mtx;
+        std::deque<Task_t> tasks;
+        workerstats_t stats;
+        std::thread thread;
+    };
+
+    void Run(unsigned int ixWorker);
+    bool TakeTask(unsigned int ixWorker, Task_t& task);
+
+    std::vector<std::unique_ptr<worker_t>> m_vWorkers;
+    // Tasks waiting in the deques, and tasks waiting or running
+    std::atomic<uint64_t> m_nQueued;
+    std::atomic<uint64_t> m_nPending;
+    // Idle workers wait for tasks to be added, or for the last task to finish.
+    std::mutex m_mtxIdle;
+    std::condition_variable m_cvIdle;
+    std::chrono::steady_clock::time_point m_start;
+    std::chrono::nanoseconds m_elapsed;
+
+private:
+    // Not implemented
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator = (const WorkStealingPool&) = delete;
+};
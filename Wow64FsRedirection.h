@@ -1,9 +1,11 @@
 #pragma once
 
+#include "PlatformDefs.h"
+
 /// <summary>
 /// Class to disable WOW64 file system redirection that automatically cleans up in the destructor;
 /// i.e., when the class instance goes out of scope.
-/// Operative only in a 32-bit process on 64-bit Windows. No-op anyplace else.
+/// Operative only in a 32-bit process on 64-bit Windows. No-op anyplace else, including non-Windows platforms.
 /// 
 /// Class instances can be nested, but they must be reverted in the opposite order of their disabling.
 /// Note that this implementation doesn't count the number of .Disable() calls on a single class instance, 
@@ -17,7 +19,7 @@ public:
 	/// Class constructor; optionally disable WOW64 file system redirection during construction
 	/// </summary>
 	/// <param name="bDisableNow">if true, disables WOW64 redirection immediately</param>
-	explicit Wow64FsRedirection(bool bDisableNow = false) : m_OldValue(NULL), m_bDisabled(false)
+	explicit Wow64FsRedirection(bool bDisableNow = false) : m_OldValue(nullptr), m_bDisabled(false)
 	{
 		if (bDisableNow)
 		{
@@ -38,7 +40,9 @@ public:
 		// Don't disable again if it's currently disabled.
 		if (!m_bDisabled)
 		{
+#ifdef _WIN32
 			Wow64DisableWow64FsRedirection(&m_OldValue);
+#endif
 			m_bDisabled = true;
 		}
 	}
@@ -49,14 +53,16 @@ public:
 	{
 		if (m_bDisabled)
 		{
+#ifdef _WIN32
 			Wow64RevertWow64FsRedirection(m_OldValue);
+#endif
 			m_bDisabled = false;
 		}
-		m_OldValue = NULL;
+		m_OldValue = nullptr;
 	}
 
 private:
-	PVOID m_OldValue;
+	void* m_OldValue;
 	bool m_bDisabled;
 
 private:
@@ -0,0 +1,132 @@
+#include "PlatformDefs.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "CorpusExtraction.h"
+#include "FileEnumeration.h"
+#include "LanguageNames.h"
+#include "StringUtils.h"
+#include "SyntheticFileGenerator.h"
+
+/// <summary>
+/// Generator settings of the tree: two language-neutral files with .mui satellite files in three language
+/// subdirectories, each satellite with nStringsPerFile strings.
+/// </summary>
+static const std::vector<std::wstring> treeSettings =
+{
+    L"files=2", L"langs=en-US,fr-FR,ja-JP", L"mui=1", L"strings=100", L"dialogs=1", L"menus=1", L"messages=1"
+};
+static const size_t nStringsPerFile = 100;
+
+/// <summary>
+/// A corpus extraction of the tree and the string table rows it must output, from the language-neutral files and
+/// from the satellite files extracted on their own (those that the language-neutral files aren't opened with).
+/// </summary>
+struct rowcountcase_t
+{
+    const wchar_t* szName;
+    std::vector<std::wstring> vPreferred;
+    bool bAllLanguages;
+    const wchar_t* szFilter;
+    size_t nNeutralRows;
+    size_t nSatelliteRows;
+};
+
+static const std::vector<rowcountcase_t> rowCountCases =
+{
+    { L"-l en-US", { L"en-US" }, false, L"", 2 * nStringsPerFile, 4 * nStringsPerFile },
+    { L"-l fr-FR", { L"fr-FR" }, false, L"", 2 * nStringsPerFile, 4 * nStringsPerFile },
+    { L"-L *", {}, true, L"", 6 * nStringsPerFile, 0 },
+    { L"-L fr-FR", {}, true, L"fr-FR", 2 * nStringsPerFile, 0 },
+    { L"-L de-DE", {}, true, L"de-DE", 0, 0 },
+};
+
+/// <summary>
+/// Counts the rows of corpus extraction's string table output over a generated tree of language-neutral files and
+/// their .mui satellite files, for several language options: each satellite's text must be output once, either
+/// with its language-neutral file's path or with its own. Exit code is 1 if any count is wrong.
+/// </summary>
+int wmain(int argc, wchar_t** argv)
+{
+    (void)argc;
+    (void)argv;
+    generatoroptions_t options;
+    std::wstring sErrorInfo;
+    for (const std::wstring& sSetting : treeSettings)
+    {
+        if (!ParseGeneratorSetting(sSetting, options, sErrorInfo))
+        {
+            std::wcerr << L"Error: " << sErrorInfo << std::endl;
+            return 1;
+        }
+    }
+    const std::wstring sDirectory = TempDirectoryPath() + L"glr_corpus_rows";
+    std::wostringstream files;
+    if (!GenerateSyntheticFiles(options, sDirectory, files, std::wcerr))
+        return 1;
+    std::vector<std::wstring> vFiles;
+    if (!ExpandFileSpec(sDirectory, vFiles, sErrorInfo))
+    {
+        std::wcerr << L"Error: " << sErrorInfo << std::endl;
+        return 1;
+    }
+
+    int exitCode = 0;
+    for (const rowcountcase_t& rowCountCase : rowCountCases)
+    {
+        languageoptions_t languages;
+        languages.vPreferred = rowCountCase.vPreferred;
+        languages.bAllLanguages = rowCountCase.bAllLanguages;
+        if (0 != *rowCountCase.szFilter && !LangIdsFromNameList(rowCountCase.szFilter, languages.vFilter, sErrorInfo))
+        {
+            std::wcerr << L"Error: " << sErrorInfo << std::endl;
+            return 1;
+        }
+
+        std::wostringstream out, err;
+        if (!CorpusExtraction(vFiles, { rsrctype_t::eString }, languages, 1, nullptr, { &out }, err))
+        {
+            std::wcerr << rowCountCase.szName << L": " << err.str();
+            return 1;
+        }
+        std::vector<std::wstring> vLines;
+        SplitStringToVector(out.str(), L'\n', vLines);
+        size_t nNeutralRows = 0, nSatelliteRows = 0;
+        for (size_t ixLine = 1; ixLine < vLines.size(); ++ixLine)
+        {
+            const std::wstring sFilePath = vLines[ixLine].substr(0, vLines[ixLine].find(L'\t'));
+            if (sFilePath.empty())
+                continue;
+            if (sFilePath.length() > 4 && 0 == sFilePath.compare(sFilePath.length() - 4, 4, L".mui"))
+                ++nSatelliteRows;
+            else
+                ++nNeutralRows;
+        }
+
+        const bool bCorrect = nNeutralRows == rowCountCase.nNeutralRows && nSatelliteRows == rowCountCase.nSatelliteRows;
+        std::wcout
+            << (bCorrect ? L"ok    " : L"FAIL  ") << rowCountCase.szName << L": " << nNeutralRows << L" rows from language-neutral files (expected "
+            << rowCountCase.nNeutralRows << L"), " << nSatelliteRows << L" from satellite files (expected " << rowCountCase.nSatelliteRows << L")" << std::endl;
+        if (!bCorrect)
+            exitCode = 1;
+    }
+    return exitCode;
+}
+
+#ifndef _WIN32
+/// <summary>
+/// Entry point on platforms without wmain: convert the UTF-8 command line to wide characters.
+/// </summary>
+int main(int argc, char** argv)
+{
+    std::vector<std::wstring> vArgs;
+    std::vector<wchar_t*> vArgv;
+    for (int ixArg = 0; ixArg < argc; ++ixArg)
+        vArgs.push_back(Utf8ToWString(argv[ixArg]));
+    for (std::wstring& sArg : vArgs)
+        vArgv.push_back(&sArg[0]);
+    vArgv.push_back(nullptr);
+    return wmain(argc, &vArgv[0]);
+}
+#endif
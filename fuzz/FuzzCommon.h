@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include "ResourceExtraction.h"
+#include "TextArena.h"
+
+/// <summary>
+/// Languages a fuzzer input can give its resource, for the code pages of ANSI message table entries:
+/// Windows-1252, Shift-JIS, Windows-1251, and GBK.
+/// </summary>
+static const uint16_t fuzzLangIds[] = { 0x0409, 0x0411, 0x0419, 0x0804 };
+
+/// <summary>
+/// Number of bytes at the start of a fuzzer input that describe the resource rather than being its data.
+/// </summary>
+const size_t cbFuzzResourceHeader = 2;
+
+/// <summary>
+/// One resource decoded from a fuzzer input. The first byte of the input picks the data's offset from an
+/// 8-byte boundary (bits 0-2) and its language (bits 3-4, an index into fuzzLangIds); the second byte is the
+/// resource's ID less one (string table bundles are numbered from 1); the rest is the resource data.
+///
+/// The data is copied to the end of a buffer of its own, so that AddressSanitizer reports any read past it,
+/// and so that the decoders see the data at every alignment, as in files with misaligned resources.
+/// </summary>
+class FuzzResource
+{
+public:
+    FuzzResource(const uint8_t* pInput, size_t cbInput) : m_entry()
+    {
+        const uint8_t flags = (cbInput > 0) ? pInput[0] : 0;
+        const uint16_t id = (uint16_t)(1 + ((cbInput > 1) ? pInput[1] : 0));
+        const size_t cbData = (cbInput > cbFuzzResourceHeader) ? cbInput - cbFuzzResourceHeader : 0;
+        const size_t cbShift = flags & 7;
+
+        m_pBuffer.reset(new uint8_t[cbShift + cbData]);
+        if (cbData > 0)
+            memcpy(m_pBuffer.get() + cbShift, pInput + cbFuzzResourceHeader, cbData);
+
+        m_entry.name = RSRCID_t(id);
+        m_entry.langId = fuzzLangIds[(flags >> 3) & 3];
+        m_entry.pData = m_pBuffer.get() + cbShift;
+        m_entry.cbData = (uint32_t)cbData;
+    }
+
+    const ResourceEntry_t& Entry() const { return m_entry; }
+
+private:
+    std::unique_ptr<uint8_t[]> m_pBuffer;
+    ResourceEntry_t m_entry;
+
+private:
+    // Not implemented
+    FuzzResource(const FuzzResource&) = delete;
+    FuzzResource& operator = (const FuzzResource&) = delete;
+};
+
+/// <summary>
+/// Decodes a fuzzer input as a resource of the type with the type's extractor, writing each item's line as
+/// extraction does, so that the writers are fuzzed along with the decoder.
+/// </summary>
+inline void DecodeFuzzResource(rsrctype_t type, const uint8_t* pInput, size_t cbInput)
+{
+    const resourceextractor_t& extractor = ResourceExtractor(type);
+    FuzzResource resource(pInput, cbInput);
+    ResourceEntry_t entry = resource.Entry();
+    entry.type = RSRCID_t((uint16_t)type);
+
+    std::wostringstream out, err;
+    TextArena arena;
+    TextWriterVisitor visitor(extractor.pfnWriteText, arena, out);
+    extractor.pfnDecodeResource(entry, visitor, err);
+}
@@ -0,0 +1,71 @@
+#include "PlatformDefs.h"
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "FileEnumeration.h"
+#include "MappedFile.h"
+#include "StringUtils.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* pData, size_t cbData);
+
+/// <summary>
+/// Runs a fuzz target over files, for builds without libFuzzer (GLR_FUZZ off): e.g., to replay a corpus or a crash
+/// input under a debugger, or under the sanitizers with a compiler that has no libFuzzer.
+/// Each argument is a file or a directory, searched recursively.
+/// </summary>
+int wmain(int argc, wchar_t** argv)
+{
+    if (argc < 2)
+    {
+        std::wcerr << L"Usage: " << argv[0] << L" file|directory ..." << std::endl;
+        return 1;
+    }
+
+    std::vector<std::wstring> vFiles;
+    std::wstring sErrorInfo;
+    for (int ixArg = 1; ixArg < argc; ++ixArg)
+    {
+        if (!ExpandFileSpec(argv[ixArg], vFiles, sErrorInfo))
+        {
+            std::wcerr << sErrorInfo << std::endl;
+            return 1;
+        }
+    }
+
+    for (const std::wstring& sFilePath : vFiles)
+    {
+        // Each input is copied into a buffer of its own size, so that AddressSanitizer reports reads past its end.
+        // (An empty file can't be mapped; it's an empty input.)
+        MappedFile file;
+        if (!file.Open(sFilePath, sErrorInfo) && !IsFilePath(sFilePath))
+        {
+            std::wcerr << sErrorInfo << std::endl;
+            return 1;
+        }
+        std::unique_ptr<uint8_t[]> pInput(new uint8_t[file.Size()]);
+        if (file.IsOpen())
+            memcpy(pInput.get(), file.Data(), file.Size());
+        LLVMFuzzerTestOneInput(pInput.get(), file.Size());
+    }
+    std::wcout << L"Ran " << vFiles.size() << L" inputs" << std::endl;
+    return 0;
+}
+
+#ifndef _WIN32
+/// <summary>
+/// Entry point on platforms without wmain: convert the UTF-8 command line to wide characters.
+/// </summary>
+int main(int argc, char** argv)
+{
+    std::vector<std::wstring> vArgs;
+    std::vector<wchar_t*> vArgv;
+    for (int ixArg = 0; ixArg < argc; ++ixArg)
+        vArgs.push_back(Utf8ToWString(argv[ixArg]));
+    for (std::wstring& sArg : vArgs)
+        vArgv.push_back(&sArg[0]);
+    vArgv.push_back(nullptr);
+    return wmain(argc, &vArgv[0]);
+}
+#endif
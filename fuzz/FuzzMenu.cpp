@@ -0,0 +1,10 @@
+#include "FuzzCommon.h"
+
+/// <summary>
+/// Fuzzes the menu decoder (MENU and MENUEX templates) with one resource per input; see FuzzResource.
+/// </summary>
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* pData, size_t cbData)
+{
+    DecodeFuzzResource(rsrctype_t::eMenu, pData, cbData);
+    return 0;
+}
@@ -0,0 +1,16 @@
+#include "FuzzCommon.h"
+#include "MessageTableExtraction.h"
+
+/// <summary>
+/// Fuzzes the message table decoders with one resource per input; see FuzzResource. The input goes to both the
+/// extraction decoder and DecodeMessageTableResource, which the catalog and lookups use.
+/// </summary>
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* pData, size_t cbData)
+{
+    DecodeFuzzResource(rsrctype_t::eMessageTable, pData, cbData);
+
+    FuzzResource resource(pData, cbData);
+    std::wstring sErrorInfo;
+    DecodeMessageTableResource(resource.Entry(), [](uint32_t, const std::wstring&) {}, sErrorInfo);
+    return 0;
+}
@@ -0,0 +1,73 @@
+#include "PlatformDefs.h"
+#include <sstream>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+#include "FileEnumeration.h"
+#include "FileOutput.h"
+#include "ResourceExtraction.h"
+#include "ResourceFile.h"
+#include "TextArena.h"
+
+/// <summary>
+/// Path of the file each input is written to: ResourceFile maps files, and has no way to open a buffer.
+/// Named for the process, so that parallel fuzzing jobs don't share one.
+/// </summary>
+static const std::wstring& FuzzFilePath()
+{
+#ifdef _WIN32
+    static const std::wstring sFilePath = TempDirectoryPath() + L"glr_fuzz_" + std::to_wstring(GetCurrentProcessId()) + L".dll";
+#else
+    static const std::wstring sFilePath = TempDirectoryPath() + L"glr_fuzz_" + std::to_wstring((unsigned long)getpid()) + L".dll";
+#endif
+    return sFilePath;
+}
+
+/// <summary>
+/// Decodes every resource of the extractable types in the file, with each type's decoder and writer.
+/// </summary>
+static void DecodeAllResources(const ResourceFile& rsrcFile)
+{
+    std::wostringstream out, err;
+    TextArena arena;
+    std::wstring sErrorInfo;
+    rsrcFile.EnumResources(
+        AllExtractableTypes(),
+        [&](const ResourceEntry_t& entry)
+        {
+            const resourceextractor_t& extractor = ResourceExtractor((rsrctype_t)entry.type.m_id);
+            TextWriterVisitor visitor(extractor.pfnWriteText, arena, out);
+            extractor.pfnDecodeResource(entry, visitor, err);
+            return true;
+        },
+        sErrorInfo);
+}
+
+/// <summary>
+/// Fuzzes the PE parser and the resource directory walk (type, name, language) with one file per input: opens it
+/// for a preferred language and for all languages, enumerates and decodes its resources, and looks some up by ID.
+/// </summary>
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* pData, size_t cbData)
+{
+    const std::wstring& sFilePath = FuzzFilePath();
+    std::wstring sErrorInfo;
+    if (!WriteBinaryFile(sFilePath, std::vector<uint8_t>(pData, pData + cbData), sErrorInfo))
+        return 0;
+
+    ResourceFile rsrcFile;
+    if (rsrcFile.Open(sFilePath, { L"de-DE" }, sErrorInfo))
+    {
+        DecodeAllResources(rsrcFile);
+        for (rsrctype_t type : AllExtractableTypes())
+        {
+            ResourceEntry_t entry;
+            rsrcFile.Find(type, 1, entry);
+        }
+    }
+    rsrcFile.Close();
+
+    if (rsrcFile.OpenAllLanguages(sFilePath, std::vector<uint16_t>(), sErrorInfo))
+        DecodeAllResources(rsrcFile);
+    rsrcFile.Close();
+    return 0;
+}
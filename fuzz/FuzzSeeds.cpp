@@ -0,0 +1,197 @@
+#include "PlatformDefs.h"
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "FileOutput.h"
+#include "FuzzCommon.h"
+#include "MappedFile.h"
+#include "ResourceFile.h"
+#include "StringUtils.h"
+#include "SyntheticFileGenerator.h"
+
+#ifdef _WIN32
+static const wchar_t chPathSep = L'\\';
+#else
+static const wchar_t chPathSep = L'/';
+#endif
+
+/// <summary>
+/// Generator settings (see ParseGeneratorSetting) of each set of synthetic files that seeds are taken from:
+/// both PE formats, both forms of dialog and menu, every message encoding, named resources, misaligned data,
+/// .mui satellite files, deep menus, and code pages of several of fuzzLangIds. Kept small, since the fuzzers
+/// mutate the seeds rather than needing many of them.
+/// </summary>
+static const std::vector<std::vector<std::wstring>> seedSettings =
+{
+    { L"seed=1", L"pe=pe32+", L"langs=en-US,ja-JP", L"dialogform=extended", L"menuform=extended", L"encoding=mixed" },
+    { L"seed=2", L"pe=pe32", L"langs=ru-RU", L"dialogform=classic", L"menuform=classic", L"encoding=ansi", L"named=1" },
+    { L"seed=3", L"langs=zh-CN", L"encoding=utf8", L"misalign=1" },
+    { L"seed=4", L"langs=de-DE,fr-FR", L"encoding=unicode", L"mui=1" },
+    { L"seed=5", L"strings=16", L"dialogs=1", L"messages=4", L"menus=2", L"menupopups=2", L"menuitems=2", L"menudepth=8" },
+};
+
+/// <summary>
+/// Settings added to each set, to keep the files small.
+/// </summary>
+static const std::vector<std::wstring> smallSettings =
+{
+    L"strings=40", L"dialogs=3", L"controls=4", L"menus=3", L"menupopups=2", L"menuitems=3", L"messages=20"
+};
+
+/// <summary>
+/// Name of the seed corpus subdirectory for a resource type's fuzz target.
+/// </summary>
+static const wchar_t* CorpusName(uint16_t type)
+{
+    switch ((rsrctype_t)type)
+    {
+    case rsrctype_t::eDialog:
+        return L"dialog";
+    case rsrctype_t::eMenu:
+        return L"menu";
+    case rsrctype_t::eMessageTable:
+        return L"messagetable";
+    default:
+        return L"stringtable";
+    }
+}
+
+/// <summary>
+/// Writes a fuzzer input: header bytes (see FuzzResource) or none, then the data.
+/// </summary>
+static bool WriteSeed(
+    const std::wstring& sOutDirectory, const wchar_t* szCorpus, size_t ixSet, size_t& nSeeds,
+    const std::vector<uint8_t>& vHeader, const uint8_t* pData, size_t cbData, std::wostream& err)
+{
+    std::wstringstream strFilePath;
+    strFilePath << sOutDirectory << chPathSep << szCorpus << chPathSep << L"seed" << (ixSet + 1) << L'-' << std::setw(4) << std::setfill(L'0') << ++nSeeds;
+    std::vector<uint8_t> vSeed(vHeader);
+    vSeed.insert(vSeed.end(), pData, pData + cbData);
+    std::wstring sErrorInfo;
+    if (!WriteBinaryFile(strFilePath.str(), vSeed, sErrorInfo))
+    {
+        err << L"Error: " << sErrorInfo << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/// <summary>
+/// Writes seed corpora for the fuzz targets from files of the synthetic file generator (-G): each file as a seed
+/// for the resource directory target, and each of its resources, with the header that FuzzResource expects, as a
+/// seed for its type's target. The corpora go into subdirectories of the output directory named for the targets:
+/// directory, dialog, menu, messagetable, and stringtable. The generated files are left in "generated".
+/// </summary>
+int wmain(int argc, wchar_t** argv)
+{
+    if (2 != argc)
+    {
+        std::wcerr << L"Usage: " << argv[0] << L" outdir" << std::endl;
+        return 1;
+    }
+    const std::wstring sOutDirectory = argv[1];
+    std::wstring sErrorInfo;
+    for (const wchar_t* szCorpus : { L"directory", L"dialog", L"menu", L"messagetable", L"stringtable" })
+    {
+        if (!CreateDirectoryPath(sOutDirectory + chPathSep + szCorpus, sErrorInfo))
+        {
+            std::wcerr << L"Error: " << sErrorInfo << std::endl;
+            return 1;
+        }
+    }
+
+    size_t nSeeds = 0;
+    for (size_t ixSet = 0; ixSet < seedSettings.size(); ++ixSet)
+    {
+        generatoroptions_t options;
+        std::vector<std::wstring> vSettings(smallSettings);
+        vSettings.insert(vSettings.end(), seedSettings[ixSet].begin(), seedSettings[ixSet].end());
+        for (const std::wstring& sSetting : vSettings)
+        {
+            if (!ParseGeneratorSetting(sSetting, options, sErrorInfo))
+            {
+                std::wcerr << L"Error: " << sErrorInfo << std::endl;
+                return 1;
+            }
+        }
+
+        std::wostringstream files, generatorErr;
+        const std::wstring sGenerated = sOutDirectory + chPathSep + L"generated" + chPathSep + std::to_wstring(ixSet + 1);
+        if (!GenerateSyntheticFiles(options, sGenerated, files, generatorErr))
+        {
+            std::wcerr << generatorErr.str();
+            return 1;
+        }
+        std::vector<std::wstring> vFiles;
+        SplitStringToVector(files.str(), L'\n', vFiles);
+
+        for (const std::wstring& sFilePath : vFiles)
+        {
+            if (sFilePath.empty())
+                continue;
+            MappedFile file;
+            if (!file.Open(sFilePath, sErrorInfo))
+            {
+                std::wcerr << L"Error: " << sErrorInfo << std::endl;
+                return 1;
+            }
+            if (!WriteSeed(sOutDirectory, L"directory", ixSet, nSeeds, std::vector<uint8_t>(), file.Data(), file.Size(), std::wcerr))
+                return 1;
+
+            // A language-neutral file's resources come from its satellites, which are opened along with it.
+            if (sFilePath.length() > 4 && 0 == sFilePath.compare(sFilePath.length() - 4, 4, L".mui"))
+                continue;
+            ResourceFile rsrcFile;
+            bool bWritten = true;
+            if (!rsrcFile.OpenAllLanguages(sFilePath, std::vector<uint16_t>(), sErrorInfo))
+            {
+                std::wcerr << L"Error: " << sErrorInfo << std::endl;
+                return 1;
+            }
+            const bool bEnumerated = rsrcFile.EnumResources(
+                AllExtractableTypes(),
+                [&](const ResourceEntry_t& entry)
+                {
+                    uint8_t flags = 0;
+                    for (uint8_t ixLang = 0; ixLang < sizeof(fuzzLangIds) / sizeof(fuzzLangIds[0]); ++ixLang)
+                    {
+                        if (fuzzLangIds[ixLang] == entry.langId)
+                            flags = (uint8_t)(ixLang << 3);
+                    }
+                    const uint8_t id = (uint8_t)(entry.name.IsId() ? entry.name.m_id - 1 : 0);
+                    bWritten = WriteSeed(sOutDirectory, CorpusName(entry.type.m_id), ixSet, nSeeds, { flags, id }, entry.pData, entry.cbData, std::wcerr);
+                    return bWritten;
+                },
+                sErrorInfo);
+            if (!bWritten)
+                return 1;
+            if (!bEnumerated)
+            {
+                std::wcerr << L"Error: " << sErrorInfo << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    std::wcout << L"Wrote " << nSeeds << L" seeds into " << sOutDirectory << std::endl;
+    return 0;
+}
+
+#ifndef _WIN32
+/// <summary>
+/// Entry point on platforms without wmain: convert the UTF-8 command line to wide characters.
+/// </summary>
+int main(int argc, char** argv)
+{
+    std::vector<std::wstring> vArgs;
+    std::vector<wchar_t*> vArgv;
+    for (int ixArg = 0; ixArg < argc; ++ixArg)
+        vArgs.push_back(Utf8ToWString(argv[ixArg]));
+    for (std::wstring& sArg : vArgs)
+        vArgv.push_back(&sArg[0]);
+    vArgv.push_back(nullptr);
+    return wmain(argc, &vArgv[0]);
+}
+#endif
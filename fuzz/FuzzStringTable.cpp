@@ -0,0 +1,16 @@
+#include "FuzzCommon.h"
+#include "StringTableExtraction.h"
+
+/// <summary>
+/// Fuzzes the string table decoders with one bundle of 16 strings per input; see FuzzResource. The input goes to
+/// both the extraction decoder and DecodeStringBundle, which lookups use.
+/// </summary>
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* pData, size_t cbData)
+{
+    DecodeFuzzResource(rsrctype_t::eString, pData, cbData);
+
+    FuzzResource resource(pData, cbData);
+    std::vector<std::wstring> vStrings;
+    DecodeStringBundle(resource.Entry(), vStrings);
+    return 0;
+}